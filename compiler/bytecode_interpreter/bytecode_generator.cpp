@@ -518,8 +518,6 @@ static bcgen_body_t bcgen_for_statement(bcgenerator_t& gen_acc, const statement_
 	auto body_acc = body;
 	const auto& types = gen_acc._ast_imm->_tree._types;
 
-	const auto existing_instructions = get_count(body._instrs);
-
 	const auto start_expr = bcgen_expression(gen_acc, {}, statement._start_expression, body_acc);
 	body_acc = start_expr._body;
 
@@ -544,7 +542,8 @@ static bcgen_body_t bcgen_for_statement(bcgenerator_t& gen_acc, const statement_
 
 	// Reuse start value as our counter.
 	// Notice: we need to store iterator value in body's first register.
-	int leave_pc = existing_instructions + 1 + body_instr_count + 2;
+	//	The instruction after the loop: past the branch below, the body, k_add_int and the closing branch.
+	int leave_pc = get_count(body_acc._instrs) + 1 + body_instr_count + 2;
 
 	//	Skip entire loop?
 	body_acc._instrs.push_back(bcgen_instruction_t(condition_opcode1, end_expr._out, counter_reg, make_imm_int(leave_pc - get_count(body_acc._instrs))));
@@ -1922,6 +1921,387 @@ static bc_static_frame_t make_frame(const types_t& types, const bcgen_body_t& bo
 	return bc_static_frame_t(types, instrs2, symbols2, args);
 }
 
+
+//////////////////////////////////////		PEEPHOLE
+
+/*
+	Rewrites a function's finished instructions. The sequences to fuse are the most common pairs in the opcode
+	histogram, see BC_OPCODE_HISTOGRAM:
+
+	- k_comparison_*_int + k_branch_false_bool / k_branch_true_bool => k_branch_*_int
+	- k_add_int / k_subtract_int with a constant => k_add_int_imm
+	- k_add_int_imm 1 + k_branch_smaller(_or_equal)_int => k_increment_branch_smaller(_or_equal)_int, the end of for-loops
+	- k_load_global_external_value + k_call => k_call_global
+	- k_branch_always to the next instruction is removed
+
+	A temporary is only fused away when no other instruction uses it, and an instruction that is the target of a
+	branch is never merged into the instruction before it. Afterwards, registers that no instruction uses are removed
+	from the frame, so open_frame() / close_frame() has less to do.
+
+	There are no register-to-register moves to fold into the instruction that produced the value: copy_value() is
+	only used for real variables, expressions already write to their destination register.
+*/
+
+static reg_flags_t get_reg_flags(bc_opcode opcode){
+	return encoding_to_reg_flags(k_opcode_info.at(opcode)._encoding);
+}
+
+static std::vector<int> count_register_uses(const std::vector<bc_instruction_t>& instructions, int register_count){
+	std::vector<int> result(register_count, 0);
+	for(const auto& e: instructions){
+		const auto reg_flags = get_reg_flags(e._opcode);
+		if(reg_flags._a){
+			result[e._a]++;
+		}
+		if(reg_flags._b){
+			result[e._b]++;
+		}
+		if(reg_flags._c){
+			result[e._c]++;
+		}
+	}
+	return result;
+}
+
+//	Returns the pc the instruction at pc may branch to, or -1 if it's not a branch.
+static int get_branch_target(const bc_instruction_t& instruction, int pc){
+	switch(instruction._opcode){
+		case bc_opcode::k_branch_false_bool:
+		case bc_opcode::k_branch_true_bool:
+		case bc_opcode::k_branch_zero_int:
+		case bc_opcode::k_branch_notzero_int:
+			return pc + instruction._b;
+
+		case bc_opcode::k_branch_smaller_int:
+		case bc_opcode::k_branch_smaller_or_equal_int:
+		case bc_opcode::k_branch_equal_int:
+		case bc_opcode::k_branch_notequal_int:
+		case bc_opcode::k_increment_branch_smaller_int:
+		case bc_opcode::k_increment_branch_smaller_or_equal_int:
+			return pc + instruction._c;
+
+		case bc_opcode::k_branch_always:
+			return pc + instruction._a;
+
+		default:
+			return -1;
+	}
+}
+
+//	The instruction at pc, changed to branch to target.
+static bc_instruction_t set_branch_target(const bc_instruction_t& instruction, int pc, int target){
+	const auto offset = target - pc;
+	QUARK_ASSERT(offset >= INT16_MIN && offset <= INT16_MAX);
+
+	const auto offset16 = static_cast<int16_t>(offset);
+	switch(instruction._opcode){
+		case bc_opcode::k_branch_false_bool:
+		case bc_opcode::k_branch_true_bool:
+		case bc_opcode::k_branch_zero_int:
+		case bc_opcode::k_branch_notzero_int:
+			return bc_instruction_t(instruction._opcode, instruction._a, offset16, instruction._c);
+
+		case bc_opcode::k_branch_smaller_int:
+		case bc_opcode::k_branch_smaller_or_equal_int:
+		case bc_opcode::k_branch_equal_int:
+		case bc_opcode::k_branch_notequal_int:
+		case bc_opcode::k_increment_branch_smaller_int:
+		case bc_opcode::k_increment_branch_smaller_or_equal_int:
+			return bc_instruction_t(instruction._opcode, instruction._a, instruction._b, offset16);
+
+		case bc_opcode::k_branch_always:
+			return bc_instruction_t(instruction._opcode, offset16, instruction._b, instruction._c);
+
+		default:
+			QUARK_ASSERT(false);
+			quark::throw_exception();
+	}
+}
+
+//	A local that only holds a value from one instruction to another: exactly two instructions uses it.
+static bool is_single_use_temp(const bc_static_frame_t& frame, const std::vector<int>& uses, int reg){
+	return reg >= frame._args.size() && uses[reg] == 2 && frame._symbols[reg].second._const_value._type.is_undefined();
+}
+
+//	Returns { true, value } if reg is an immutable int constant that fits in an immediate.
+static std::pair<bool, int16_t> get_int16_constant(const types_t& types, const bc_static_frame_t& frame, int reg){
+	const auto& symbol = frame._symbols[reg].second;
+	if(
+		symbol._symbol_type == bc_symbol_t::type::immutable
+		&& symbol._const_value._type.is_undefined() == false
+		&& peek2(types, symbol._value_type).is_int()
+	){
+		const auto value = symbol._const_value.get_int_value();
+		if(value >= INT16_MIN && value <= INT16_MAX){
+			return { true, static_cast<int16_t>(value) };
+		}
+	}
+	return { false, 0 };
+}
+
+//	Global functions are stored once, when the globals are initialized.
+static bool is_immutable_global_function(const types_t& types, const bc_static_frame_t& globals, int global_index){
+	const auto& symbol = globals._symbols[global_index].second;
+	return symbol._symbol_type == bc_symbol_t::type::immutable && peek2(types, symbol._value_type).is_function();
+}
+
+//	Returns the branch that tests the result of comparison, or k_nop if we have no such branch.
+static bc_instruction_t fuse_comparison_and_branch(const bc_instruction_t& comparison, bool branch_if_true, int16_t offset){
+	const auto lhs = comparison._b;
+	const auto rhs = comparison._c;
+	switch(comparison._opcode){
+		case bc_opcode::k_comparison_smaller_int:
+			return branch_if_true
+				? bc_instruction_t(bc_opcode::k_branch_smaller_int, lhs, rhs, offset)
+				: bc_instruction_t(bc_opcode::k_branch_smaller_or_equal_int, rhs, lhs, offset);
+		case bc_opcode::k_comparison_smaller_or_equal_int:
+			return branch_if_true
+				? bc_instruction_t(bc_opcode::k_branch_smaller_or_equal_int, lhs, rhs, offset)
+				: bc_instruction_t(bc_opcode::k_branch_smaller_int, rhs, lhs, offset);
+		case bc_opcode::k_logical_equal_int:
+			return bc_instruction_t(branch_if_true ? bc_opcode::k_branch_equal_int : bc_opcode::k_branch_notequal_int, lhs, rhs, offset);
+		case bc_opcode::k_logical_nonequal_int:
+			return bc_instruction_t(branch_if_true ? bc_opcode::k_branch_notequal_int : bc_opcode::k_branch_equal_int, lhs, rhs, offset);
+		default:
+			return bc_instruction_t(bc_opcode::k_nop, 0, 0, 0);
+	}
+}
+
+//	Replaces the instructions that are fused away with k_nop, so no pc changes yet.
+static std::vector<bc_instruction_t> fuse_instructions(const types_t& types, const bc_static_frame_t& globals, const bc_static_frame_t& frame){
+	auto instrs = frame._instructions;
+	const auto size = static_cast<int>(instrs.size());
+	const auto uses = count_register_uses(instrs, static_cast<int>(frame._symbols.size()));
+
+	std::vector<bool> is_branch_target(size + 1, false);
+	for(int pc = 0 ; pc < size ; pc++){
+		const auto target = get_branch_target(instrs[pc], pc);
+		if(target != -1){
+			QUARK_ASSERT(target >= 0 && target <= size);
+			is_branch_target[target] = true;
+		}
+	}
+
+	//	k_load_global_external_value + k_call => k_call_global. The k_call is usually a few instructions later, after the arguments are pushed.
+	for(int pc = 0 ; pc < size ; pc++){
+		const auto load = instrs[pc];
+		if(
+			load._opcode == bc_opcode::k_load_global_external_value
+			&& is_single_use_temp(frame, uses, load._a)
+			&& is_immutable_global_function(types, globals, load._b)
+		){
+			for(int call_pc = pc + 1 ; call_pc < size ; call_pc++){
+				const auto call = instrs[call_pc];
+				if(call._opcode == bc_opcode::k_call && call._b == load._a){
+					instrs[call_pc] = bc_instruction_t(bc_opcode::k_call_global, call._a, load._b, call._c);
+					instrs[pc] = bc_instruction_t(bc_opcode::k_nop, 0, 0, 0);
+					break;
+				}
+			}
+		}
+	}
+
+	//	Arithmetic with a constant => k_add_int_imm.
+	for(int pc = 0 ; pc < size ; pc++){
+		const auto e = instrs[pc];
+		if(e._opcode == bc_opcode::k_add_int){
+			const auto c = get_int16_constant(types, frame, e._c);
+			const auto b = get_int16_constant(types, frame, e._b);
+			if(c.first){
+				instrs[pc] = bc_instruction_t(bc_opcode::k_add_int_imm, e._a, e._b, c.second);
+			}
+			else if(b.first){
+				instrs[pc] = bc_instruction_t(bc_opcode::k_add_int_imm, e._a, e._c, b.second);
+			}
+		}
+		else if(e._opcode == bc_opcode::k_subtract_int){
+			const auto c = get_int16_constant(types, frame, e._c);
+			if(c.first && c.second != INT16_MIN){
+				instrs[pc] = bc_instruction_t(bc_opcode::k_add_int_imm, e._a, e._b, static_cast<int16_t>(-c.second));
+			}
+		}
+	}
+
+	//	Pairs of instructions.
+	for(int pc = 0 ; pc + 1 < size ; pc++){
+		const auto first = instrs[pc];
+		const auto second = instrs[pc + 1];
+		if(is_branch_target[pc + 1] == false){
+
+			const auto branch = fuse_comparison_and_branch(first, second._opcode == bc_opcode::k_branch_true_bool, 0);
+
+			//	Comparison + branch on its result.
+			if(
+				branch._opcode != bc_opcode::k_nop
+				&& (second._opcode == bc_opcode::k_branch_false_bool || second._opcode == bc_opcode::k_branch_true_bool)
+				&& second._a == first._a
+				&& is_single_use_temp(frame, uses, first._a)
+			){
+				instrs[pc] = set_branch_target(branch, pc, get_branch_target(second, pc + 1));
+				instrs[pc + 1] = bc_instruction_t(bc_opcode::k_nop, 0, 0, 0);
+			}
+
+			//	Loop counter + 1, then loop again if counter < end.
+			else if(
+				first._opcode == bc_opcode::k_add_int_imm
+				&& first._a == first._b
+				&& first._c == 1
+				&& (second._opcode == bc_opcode::k_branch_smaller_int || second._opcode == bc_opcode::k_branch_smaller_or_equal_int)
+				&& second._a == first._a
+			){
+				const auto target = get_branch_target(second, pc + 1);
+				const auto opcode = second._opcode == bc_opcode::k_branch_smaller_int
+					? bc_opcode::k_increment_branch_smaller_int
+					: bc_opcode::k_increment_branch_smaller_or_equal_int;
+				instrs[pc] = set_branch_target(bc_instruction_t(opcode, first._a, second._b, 0), pc, target);
+				instrs[pc + 1] = bc_instruction_t(bc_opcode::k_nop, 0, 0, 0);
+			}
+		}
+	}
+
+	//	Jumps to the next instruction, left after if-statements without else.
+	for(int pc = 0 ; pc < size ; pc++){
+		if(instrs[pc]._opcode == bc_opcode::k_branch_always && instrs[pc]._a == 1){
+			instrs[pc] = bc_instruction_t(bc_opcode::k_nop, 0, 0, 0);
+		}
+	}
+
+	return instrs;
+}
+
+static std::vector<bc_instruction_t> remove_nops(const std::vector<bc_instruction_t>& instructions){
+	const auto size = static_cast<int>(instructions.size());
+
+	//	Where each instruction ends up. A removed instruction maps to the instruction after it.
+	std::vector<int> new_pcs(size + 1, 0);
+	int count = 0;
+	for(int pc = 0 ; pc < size ; pc++){
+		new_pcs[pc] = count;
+		if(instructions[pc]._opcode != bc_opcode::k_nop){
+			count++;
+		}
+	}
+	new_pcs[size] = count;
+
+	std::vector<bc_instruction_t> result;
+	for(int pc = 0 ; pc < size ; pc++){
+		const auto& e = instructions[pc];
+		if(e._opcode != bc_opcode::k_nop){
+			const auto target = get_branch_target(e, pc);
+			result.push_back(target == -1 ? e : set_branch_target(e, new_pcs[pc], new_pcs[target]));
+		}
+	}
+	return result;
+}
+
+static bc_static_frame_t remove_unused_registers(const types_t& types, const std::vector<bc_instruction_t>& instructions, const bc_static_frame_t& frame){
+	const auto uses = count_register_uses(instructions, static_cast<int>(frame._symbols.size()));
+
+	std::vector<int16_t> new_regs(frame._symbols.size(), -1);
+	std::vector<std::pair<std::string, bc_symbol_t>> symbols2;
+	for(int reg = 0 ; reg < frame._symbols.size() ; reg++){
+		if(reg < frame._args.size() || uses[reg] > 0){
+			new_regs[reg] = static_cast<int16_t>(symbols2.size());
+			symbols2.push_back(frame._symbols[reg]);
+		}
+	}
+
+	std::vector<bc_instruction_t> instrs2;
+	for(const auto& e: instructions){
+		const auto reg_flags = get_reg_flags(e._opcode);
+		instrs2.push_back(bc_instruction_t(
+			e._opcode,
+			reg_flags._a ? new_regs[e._a] : e._a,
+			reg_flags._b ? new_regs[e._b] : e._b,
+			reg_flags._c ? new_regs[e._c] : e._c
+		));
+	}
+	return bc_static_frame_t(types, instrs2, symbols2, frame._args);
+}
+
+//	Only for function frames: the globals frame's registers are the globals themselves.
+static bc_static_frame_t optimize_frame(const types_t& types, const bc_static_frame_t& globals, const bc_static_frame_t& frame){
+	QUARK_ASSERT(types.check_invariant());
+	QUARK_ASSERT(frame.check_invariant());
+
+	const auto instructions = remove_nops(fuse_instructions(types, globals, frame));
+	return remove_unused_registers(types, instructions, frame);
+}
+
+static std::pair<std::string, bc_symbol_t> make_test_symbol(const std::string& name, const type_t& type, const bc_value_t& const_value){
+	return { name, bc_symbol_t{ bc_symbol_t::type::immutable, type, const_value } };
+}
+
+QUARK_TEST("", "optimize_frame()", "comparison + branch_false_bool", "branch_smaller_int, temp removed"){
+	types_t types;
+	const auto int_type = type_t::make_int();
+	const bc_static_frame_t globals(types, {}, {}, {});
+	const bc_static_frame_t frame(
+		types,
+		{
+			bc_instruction_t(bc_opcode::k_comparison_smaller_or_equal_int, 2, 0, 1),
+			bc_instruction_t(bc_opcode::k_branch_false_bool, 2, 2, 0),
+			bc_instruction_t(bc_opcode::k_return, 0, 0, 0),
+			bc_instruction_t(bc_opcode::k_return, 1, 0, 0)
+		},
+		{
+			make_test_symbol("n", int_type, bc_value_t::make_undefined()),
+			make_test_symbol("literal constant", int_type, bc_value_t::make_int(1)),
+			make_test_symbol("temp: comparison flag", type_t::make_bool(), bc_value_t::make_undefined())
+		},
+		{ int_type }
+	);
+
+	//	if(n <= 1) ... becomes "branch if 1 < n".
+	const auto result = optimize_frame(types, globals, frame);
+	QUARK_VERIFY(result._symbols.size() == 2);
+	QUARK_VERIFY(result._instructions.size() == 3);
+	QUARK_VERIFY(result._instructions[0]._opcode == bc_opcode::k_branch_smaller_int);
+	QUARK_VERIFY(result._instructions[0]._a == 1);
+	QUARK_VERIFY(result._instructions[0]._b == 0);
+	QUARK_VERIFY(result._instructions[0]._c == 2);
+}
+
+QUARK_TEST("", "optimize_frame()", "for-loop", "increment_branch_smaller_int, branches retargeted"){
+	types_t types;
+	const auto int_type = type_t::make_int();
+	const bc_static_frame_t globals(types, {}, {}, {});
+	const bc_static_frame_t frame(
+		types,
+		{
+			bc_instruction_t(bc_opcode::k_copy_reg_inplace_value, 3, 1, 0),
+			bc_instruction_t(bc_opcode::k_branch_smaller_or_equal_int, 0, 3, 5),
+			bc_instruction_t(bc_opcode::k_branch_always, 1, 0, 0),
+			bc_instruction_t(bc_opcode::k_add_int, 3, 3, 2),
+			bc_instruction_t(bc_opcode::k_branch_smaller_int, 3, 0, -2),
+			bc_instruction_t(bc_opcode::k_nop, 0, 0, 0),
+			bc_instruction_t(bc_opcode::k_return, 3, 0, 0)
+		},
+		{
+			make_test_symbol("count", int_type, bc_value_t::make_undefined()),
+			make_test_symbol("literal constant", int_type, bc_value_t::make_int(0)),
+			make_test_symbol("integer 1, to decrement with", int_type, bc_value_t::make_int(1)),
+			make_test_symbol("i", int_type, bc_value_t::make_undefined())
+		},
+		{ int_type }
+	);
+
+	const auto result = optimize_frame(types, globals, frame);
+	QUARK_VERIFY(result._symbols.size() == 3);
+	QUARK_VERIFY(result._instructions.size() == 4);
+
+	//	Skipping the loop still lands on k_return.
+	QUARK_VERIFY(result._instructions[1]._opcode == bc_opcode::k_branch_smaller_or_equal_int);
+	QUARK_VERIFY(result._instructions[1]._c == 2);
+
+	QUARK_VERIFY(result._instructions[2]._opcode == bc_opcode::k_increment_branch_smaller_int);
+	QUARK_VERIFY(result._instructions[2]._a == 2);
+	QUARK_VERIFY(result._instructions[2]._b == 0);
+	QUARK_VERIFY(result._instructions[2]._c == 0);
+	QUARK_VERIFY(result._instructions[3]._opcode == bc_opcode::k_return);
+}
+
+
 bc_program_t generate_bytecode(const semantic_ast_t& ast){
 	QUARK_ASSERT(ast.check_invariant());
 
@@ -1968,7 +2348,21 @@ bc_program_t generate_bytecode(const semantic_ast_t& ast){
 		}
 	}
 
-	const auto globals2 = make_frame(types, a._globals, std::vector<type_t>{});
+	//	Let the function values know their function index so do_call() won't have to look them up by name.
+	const auto function_indexes = make_function_indexes(function_defs2, ast.intrinsic_signatures);
+	const auto globals2 = resolve_function_values(
+		types,
+		make_frame(types, a._globals, std::vector<type_t>{}),
+		function_indexes
+	);
+	for(auto& e: function_defs2){
+		if(e.second._frame_ptr){
+			e.second._frame_ptr = std::make_shared<bc_static_frame_t>(
+				optimize_frame(types, globals2, resolve_function_values(types, *e.second._frame_ptr, function_indexes))
+			);
+		}
+	}
+
 	const auto result = bc_program_t{
 		globals2,
 		function_defs2,
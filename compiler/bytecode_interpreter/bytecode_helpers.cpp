@@ -79,12 +79,12 @@ value_t bc_to_value(const types_t& types, const bc_value_t& value){
 		std::vector<value_t> vec2;
 		const bool vector_w_inplace_elements = encode_as_vector_w_inplace_elements(types, type);
 		if(vector_w_inplace_elements){
-			for(const auto e: value._pod._external->_vector_w_inplace_elements){
+			for(const auto e: value._pod._external->get_vector_w_inplace_elements()){
 				vec2.push_back(bc_to_value(types, bc_value_t(element_type, e)));
 			}
 		}
 		else{
-			for(const auto& e: value._pod._external->_vector_w_external_elements){
+			for(const auto& e: value._pod._external->get_vector_w_external_elements()){
 				QUARK_ASSERT(e.check_invariant());
 				vec2.push_back(bc_to_value(types, bc_value_t(element_type, e)));
 			}
@@ -96,12 +96,12 @@ value_t bc_to_value(const types_t& types, const bc_value_t& value){
 		const bool dict_w_inplace_values = encode_as_dict_w_inplace_values(types, type);
 		std::map<std::string, value_t> entries2;
 		if(dict_w_inplace_values){
-			for(const auto& e: value._pod._external->_dict_w_inplace_values){
+			for(const auto& e: value._pod._external->get_dict_w_inplace_values()){
 				entries2.insert({ e.first, bc_to_value(types, bc_value_t(value_type, e.second)) });
 			}
 		}
 		else{
-			for(const auto& e: value._pod._external->_dict_w_external_values){
+			for(const auto& e: value._pod._external->get_dict_w_external_values()){
 				entries2.insert({ e.first, bc_to_value(types, bc_value_t(value_type, e.second)) });
 			}
 		}
@@ -16,6 +16,7 @@
 #include "types.h"
 
 #include <algorithm>
+#include <set>
 
 
 namespace floyd {
@@ -26,7 +27,7 @@ void release_pod_external(bc_pod_value_t& value){
 
 	value._external->_rc--;
 	if(value._external->_rc == 0){
-		delete value._external;
+		delete_external(value._external);
 		value._external = nullptr;
 	}
 }
@@ -190,13 +191,13 @@ bc_value_t bc_value_t::make_string(const std::string& v){
 std::string bc_value_t::get_string_value() const{
 	QUARK_ASSERT(check_invariant());
 
-	return _pod._external->_string;
+	return _pod._external->get_string();
 }
 bc_value_t::bc_value_t(const std::string& value) :
 	_type(type_t::make_string()),
 	_encode_as_external(encode_as_external(value_encoding::k_external__string))
 {
-	_pod._external = new bc_external_value_t{value};
+	_pod._external = new bc_external_string_t(_type, value);
 	QUARK_ASSERT(check_invariant());
 }
 
@@ -210,7 +211,7 @@ bc_value_t bc_value_t::make_json(const json_t& v){
 json_t bc_value_t::get_json() const{
 	QUARK_ASSERT(check_invariant());
 
-	return *_pod._external->_json.get();
+	return *_pod._external->get_json();
 }
 bc_value_t::bc_value_t(const std::shared_ptr<json_t>& value) :
 	_type(type_t::make_json()),
@@ -219,7 +220,7 @@ bc_value_t::bc_value_t(const std::shared_ptr<json_t>& value) :
 	QUARK_ASSERT(value);
 	QUARK_ASSERT(value->check_invariant());
 
-	_pod._external = new bc_external_value_t{value};
+	_pod._external = new bc_external_json_t(_type, value);
 
 	QUARK_ASSERT(check_invariant());
 }
@@ -234,7 +235,7 @@ bc_value_t bc_value_t::make_typeid_value(const type_t& type_id){
 type_t bc_value_t::get_typeid_value() const {
 	QUARK_ASSERT(check_invariant());
 
-	return _pod._external->_typeid_value;
+	return _pod._external->get_typeid_value();
 }
 bc_value_t::bc_value_t(const type_t& type_id) :
 	_type(type_desc_t::make_typeid()),
@@ -242,7 +243,7 @@ bc_value_t::bc_value_t(const type_t& type_id) :
 {
 	QUARK_ASSERT(type_id.check_invariant());
 
-	_pod._external = new bc_external_value_t{type_id};
+	_pod._external = new bc_external_typeid_t(_type, type_id);
 
 	QUARK_ASSERT(check_invariant());
 }
@@ -259,7 +260,7 @@ const std::vector<bc_value_t>& bc_value_t::get_struct_value() const {
 	QUARK_ASSERT(check_invariant());
 //	QUARK_ASSERT(_type.is_struct());
 
-	return _pod._external->_struct_members;
+	return _pod._external->get_struct_members();
 }
 bc_value_t::bc_value_t(const type_t& struct_type, const std::vector<bc_value_t>& values, bool struct_tag) :
 	_type(struct_type),
@@ -272,7 +273,7 @@ bc_value_t::bc_value_t(const type_t& struct_type, const std::vector<bc_value_t>&
 	}
 #endif
 
-	_pod._external = new bc_external_value_t{ struct_type, values, true };
+	_pod._external = new bc_external_struct_t(struct_type, values);
 	QUARK_ASSERT(check_invariant());
 }
 
@@ -280,21 +281,22 @@ bc_value_t::bc_value_t(const type_t& struct_type, const std::vector<bc_value_t>&
 //////////////////////////////////////		function
 
 
-bc_value_t bc_value_t::make_function_value(const type_t& function_type, const function_id_t& function_id){
-	return bc_value_t{ function_type, function_id, true };
+bc_value_t bc_value_t::make_function_value(const type_t& function_type, const function_id_t& function_id, int function_index){
+	return bc_value_t{ function_type, function_id, function_index, true };
 }
 function_id_t bc_value_t::get_function_value() const{
 	QUARK_ASSERT(check_invariant());
 
-	return _pod._external->_function_id;
+	return _pod._external->get_function()._function_id;
 }
-bc_value_t::bc_value_t(const type_t& function_type, const function_id_t& function_id, bool dummy) :
+bc_value_t::bc_value_t(const type_t& function_type, const function_id_t& function_id, int function_index, bool dummy) :
 	_type(function_type),
 	_encode_as_external(encode_as_external(value_encoding::k_external__function))
 {
 	QUARK_ASSERT(function_type.check_invariant());
+	QUARK_ASSERT(function_index >= k_no_function_index);
 
-	_pod._external = new bc_external_value_t(function_type, function_id);
+	_pod._external = new bc_external_function_t(function_type, bc_function_ref_t{ function_id, function_index });
 
 	QUARK_ASSERT(check_invariant());
 }
@@ -364,7 +366,7 @@ bc_value_t::bc_value_t(const type_t& type, mode mode) :
 	QUARK_ASSERT(type.check_invariant());
 
 	//	Allocate a dummy external value.
-	auto temp = new bc_external_value_t{"UNWRITTEN EXT VALUE"};
+	auto temp = new bc_external_string_t(type, "UNWRITTEN EXT VALUE");
 #if DEBUG
 	temp->_debug__is_unwritten_external_value = true;
 #endif
@@ -431,7 +433,7 @@ bc_external_handle_t::~bc_external_handle_t(){
 
 	_external->_rc--;
 	if(_external->_rc == 0){
-		delete _external;
+		delete_external(_external);
 		_external = nullptr;
 	}
 }
@@ -562,248 +564,79 @@ bool encode_as_external(const bc_value_t& value){
 	return value._encode_as_external;
 }
 
+bc_external_value_t::bc_external_value_t(bc_external_kind kind, const type_t& debug_type) :
+	_rc(1),
+	_kind(kind)
+#if DEBUG
+	,
+	_debug_type(debug_type)
+#endif
+{
+	QUARK_ASSERT(debug_type.check_invariant());
+}
+
 #if DEBUG
 bool bc_external_value_t::check_invariant() const{
-//	QUARK_ASSERT(encode_as_external(_debug_type));
 	QUARK_ASSERT(_rc > 0);
 	QUARK_ASSERT(_debug_type.check_invariant());
-	QUARK_ASSERT(_typeid_value.check_invariant());
 
 //	QUARK_ASSERT(check_external_deep(_debug_type, this));
 
-	QUARK_ASSERT(_vector_w_external_elements.impl().check_tree());
-	QUARK_ASSERT(_vector_w_inplace_elements.impl().check_tree());
-
-//	QUARK_ASSERT(_dict_w_external_values.impl().check_tree());
-//	QUARK_ASSERT(_dict_w_inplace_values.impl().check_tree());
-
-#if 0
-//	const auto encoding = type_to_encoding(_debug_type);
-	if(encoding == value_encoding::k_external__string){
-//				QUARK_ASSERT(_string);
-		QUARK_ASSERT(_json == nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-		QUARK_ASSERT(_vector_w_inplace_elements.empty());
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
-	}
-	else if(encoding == value_encoding::k_external__json){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json != nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-		QUARK_ASSERT(_vector_w_inplace_elements.empty());
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
-
-		QUARK_ASSERT(_json->check_invariant());
-	}
-	else if(encoding == value_encoding::k_external__typeid){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json == nullptr);
-//		QUARK_ASSERT(_typeid_value != make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-		QUARK_ASSERT(_vector_w_inplace_elements.empty());
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
-
-		QUARK_ASSERT(_typeid_value.check_invariant());
-	}
-	else if(encoding == value_encoding::k_external__struct){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json == nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-//				QUARK_ASSERT(_struct != nullptr);
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-		QUARK_ASSERT(_vector_w_inplace_elements.empty());
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
-
-		for(const auto& e: _struct_members){
-			QUARK_ASSERT(e.check_invariant());
-		}
+	if(_kind == bc_external_kind::k_json){
+		QUARK_ASSERT(get_json() != nullptr);
 	}
-	else if(encoding == value_encoding::k_external__vector){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json == nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-
-		for(const auto& e: _vector_w_external_elements){
-			QUARK_ASSERT(e.check_invariant());
-		}
-
-		QUARK_ASSERT(_vector_w_inplace_elements.empty());
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
+	else if(_kind == bc_external_kind::k_typeid){
+		QUARK_ASSERT(get_typeid_value().check_invariant());
 	}
-
-	else if(encoding == value_encoding::k_external__vector_pod64){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json == nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
-	}
-
-	//???	Notice: dicts only have external values right now.
-	//??? remove term "pod64" -- use
-	else if(encoding == value_encoding::k_external__dict){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json == nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-		QUARK_ASSERT(_vector_w_inplace_elements.empty());
-
-		for(const auto& e: _dict_w_external_values){
-			QUARK_ASSERT(e.second.check_invariant());
-		}
-		for(const auto& e: _dict_w_inplace_values){
-		}
+	else if(_kind == bc_external_kind::k_vector_w_external_elements){
+		QUARK_ASSERT(get_vector_w_external_elements().impl().check_tree());
 	}
-	else if(encoding == value_encoding::k_external__function){
-		QUARK_ASSERT(_string.empty());
-		QUARK_ASSERT(_json == nullptr);
-		QUARK_ASSERT(_typeid_value == make_undefined());
-		QUARK_ASSERT(_struct_members.empty());
-		QUARK_ASSERT(_vector_w_external_elements.empty());
-		QUARK_ASSERT(_dict_w_external_values.size() == 0);
-		QUARK_ASSERT(_dict_w_inplace_values.size() == 0);
+	else if(_kind == bc_external_kind::k_vector_w_inplace_elements){
+		QUARK_ASSERT(get_vector_w_inplace_elements().impl().check_tree());
 	}
-	else {
-		QUARK_ASSERT(false);
-		quark::throw_exception();
+	else if(_kind == bc_external_kind::k_function){
+		QUARK_ASSERT(get_function()._function_index >= k_no_function_index);
 	}
-#endif
 	return true;
 }
 #endif
 
-bc_external_value_t::bc_external_value_t(const std::string& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type_t::make_string()),
-#endif
-	_string(s)
-{
-	QUARK_ASSERT(check_invariant());
-}
-
-bc_external_value_t::bc_external_value_t(const std::shared_ptr<json_t>& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type_t::make_json()),
-#endif
-	_json(s)
-{
-	QUARK_ASSERT(s->check_invariant());
-	QUARK_ASSERT(check_invariant());
-}
-
-
-bc_external_value_t::bc_external_value_t(const type_t& type, const function_id_t& function_id) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type),
-#endif
-	_function_id(function_id)
-{
-	QUARK_ASSERT(check_invariant());
-}
-
-bc_external_value_t::bc_external_value_t(const type_t& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type_desc_t::make_typeid()),
-#endif
-	_typeid_value(s)
-{
-	QUARK_ASSERT(s.check_invariant());
-
-	QUARK_ASSERT(check_invariant());
-}
-
-bc_external_value_t::bc_external_value_t(const type_t& type, const std::vector<bc_value_t>& s, bool struct_tag) :
-		_rc(1),
-#if DEBUG
-	_debug_type(type),
-#endif
-	_struct_members(s)
-{
-	QUARK_ASSERT(type.check_invariant());
-	#if QUARK_ASSERT_ON
-		for(const auto& e: s){
-			QUARK_ASSERT(e.check_invariant());
-		}
-	#endif
-
-	QUARK_ASSERT(check_invariant());
-}
-bc_external_value_t::bc_external_value_t(const type_t& type, const immer::vector<bc_external_handle_t>& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type),
-#endif
-	_vector_w_external_elements(s)
-{
-	QUARK_ASSERT(type.check_invariant());
-	#if QUARK_ASSERT_ON
-		for(const auto& e: s){
-			QUARK_ASSERT(e.check_invariant());
-		}
-	#endif
-
-	QUARK_ASSERT(check_invariant());
-}
-bc_external_value_t::bc_external_value_t(const type_t& type, const immer::vector<bc_inplace_value_t>& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type),
-#endif
-	_vector_w_inplace_elements(s)
-{
-	QUARK_ASSERT(type.check_invariant());
+void delete_external(const bc_external_value_t* ext){
+	QUARK_ASSERT(ext != nullptr);
+	QUARK_ASSERT(ext->_rc == 0);
 
-	QUARK_ASSERT(check_invariant());
-}
-bc_external_value_t::bc_external_value_t(const type_t& type, const immer::map<std::string, bc_external_handle_t>& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type),
-#endif
-	_dict_w_external_values(s)
-{
-	QUARK_ASSERT(type.check_invariant());
-	#if QUARK_ASSERT_ON
-		for(const auto& e: s){
-			QUARK_ASSERT(e.first.size() > 0);
-			QUARK_ASSERT(e.second.check_invariant());
-		}
-	#endif
-	QUARK_ASSERT(check_invariant());
-}
-bc_external_value_t::bc_external_value_t(const type_t& type, const immer::map<std::string, bc_inplace_value_t>& s) :
-	_rc(1),
-#if DEBUG
-	_debug_type(type),
-#endif
-	_dict_w_inplace_values(s)
-{
-	QUARK_ASSERT(type.check_invariant());
-	#if QUARK_ASSERT_ON
-		for(const auto& e: s){
-			QUARK_ASSERT(e.first.size() > 0);
-		}
-	#endif
-	QUARK_ASSERT(check_invariant());
+	switch(ext->_kind){
+		case bc_external_kind::k_string:
+			delete static_cast<const bc_external_string_t*>(ext);
+			break;
+		case bc_external_kind::k_json:
+			delete static_cast<const bc_external_json_t*>(ext);
+			break;
+		case bc_external_kind::k_typeid:
+			delete static_cast<const bc_external_typeid_t*>(ext);
+			break;
+		case bc_external_kind::k_struct:
+			delete static_cast<const bc_external_struct_t*>(ext);
+			break;
+		case bc_external_kind::k_vector_w_external_elements:
+			delete static_cast<const bc_external_vector_w_external_elements_t*>(ext);
+			break;
+		case bc_external_kind::k_vector_w_inplace_elements:
+			delete static_cast<const bc_external_vector_w_inplace_elements_t*>(ext);
+			break;
+		case bc_external_kind::k_dict_w_external_values:
+			delete static_cast<const bc_external_dict_w_external_values_t*>(ext);
+			break;
+		case bc_external_kind::k_dict_w_inplace_values:
+			delete static_cast<const bc_external_dict_w_inplace_values_t*>(ext);
+			break;
+		case bc_external_kind::k_function:
+			delete static_cast<const bc_external_function_t*>(ext);
+			break;
+		default:
+			QUARK_ASSERT(false);
+			quark::throw_exception();
+	}
 }
 
 
@@ -819,14 +652,14 @@ bool check_external_deep(const types_t& types, const type_t& type0, const bc_ext
 	const auto basetype = peek.get_base_type();
 
 	if(basetype == base_type::k_struct){
-		for(const auto& e: ext->_struct_members){
+		for(const auto& e: ext->get_struct_members()){
 			QUARK_ASSERT(e.check_invariant());
 		}
 	}
 	else if(basetype == base_type::k_vector){
 		const auto& element_type  = peek.get_vector_element_type(types);
 		if(encode_as_external(types, element_type)){
-			for(const auto& e: ext->_vector_w_external_elements){
+			for(const auto& e: ext->get_vector_w_external_elements()){
 				QUARK_ASSERT(e.check_invariant());
 			}
 			return true;
@@ -838,8 +671,8 @@ bool check_external_deep(const types_t& types, const type_t& type0, const bc_ext
 	else if(basetype == base_type::k_dict){
 		const auto& element_type  = peek.get_dict_value_type(types);
 		if(encode_as_external(types, element_type)){
-			for(const auto& e: ext->_vector_w_external_elements){
-				QUARK_ASSERT(e.check_invariant());
+			for(const auto& e: ext->get_dict_w_external_values()){
+				QUARK_ASSERT(e.second.check_invariant());
 			}
 			return true;
 		}
@@ -876,7 +709,7 @@ const immer::vector<bc_value_t> get_vector(const types_t& types, const bc_value_
 
 	if(encode_as_vector_w_inplace_elements(types, value._type)){
 		immer::vector<bc_value_t> result;
-		for(const auto& e: value._pod._external->_vector_w_inplace_elements){
+		for(const auto& e: value._pod._external->get_vector_w_inplace_elements()){
 			bc_value_t temp(element_type, e);
 			result = result.push_back(temp);
 		}
@@ -884,7 +717,7 @@ const immer::vector<bc_value_t> get_vector(const types_t& types, const bc_value_
 	}
 	else{
 		immer::vector<bc_value_t> result;
-		for(const auto& e: value._pod._external->_vector_w_external_elements){
+		for(const auto& e: value._pod._external->get_vector_w_external_elements()){
 			bc_value_t temp(element_type, e);
 			result = result.push_back(temp);
 		}
@@ -902,7 +735,7 @@ const immer::vector<bc_external_handle_t>* get_vector_external_elements(const ty
 	QUARK_ASSERT(peek.is_vector());
 	QUARK_ASSERT(encode_as_vector_w_inplace_elements(types, peek) == false);
 
-	return &value._pod._external->_vector_w_external_elements;
+	return &value._pod._external->get_vector_w_external_elements();
 }
 
 const immer::vector<bc_inplace_value_t>* get_vector_inplace_elements(const types_t& types, const bc_value_t& value){
@@ -913,7 +746,7 @@ const immer::vector<bc_inplace_value_t>* get_vector_inplace_elements(const types
 	QUARK_ASSERT(peek.is_vector());
 	QUARK_ASSERT(encode_as_vector_w_inplace_elements(types, peek) == true);
 
-	return &value._pod._external->_vector_w_inplace_elements;
+	return &value._pod._external->get_vector_w_inplace_elements();
 }
 
 bc_value_t make_vector(const types_t& types, const type_t& element_type, const immer::vector<bc_value_t>& elements){
@@ -934,7 +767,7 @@ bc_value_t make_vector(const types_t& types, const type_t& element_type, const i
 
 		bc_value_t temp;
 		temp._type = vector_type;
-		temp._pod._external = new bc_external_value_t{vector_type, elements2};
+		temp._pod._external = new bc_external_vector_w_inplace_elements_t(vector_type, elements2);
 		QUARK_ASSERT(temp.check_invariant());
 		return temp;
 	}
@@ -946,7 +779,7 @@ bc_value_t make_vector(const types_t& types, const type_t& element_type, const i
 
 		bc_value_t temp;
 		temp._type = vector_type;
-		temp._pod._external = new bc_external_value_t{vector_type, elements2};
+		temp._pod._external = new bc_external_vector_w_external_elements_t(vector_type, elements2);
 		QUARK_ASSERT(temp.check_invariant());
 		return temp;
 	}
@@ -966,7 +799,7 @@ bc_value_t make_vector(const types_t& types, const type_t& element_type, const i
 
 	bc_value_t temp;
 	temp._type = vector_type;
-	temp._pod._external = new bc_external_value_t{vector_type, elements};
+	temp._pod._external = new bc_external_vector_w_external_elements_t(vector_type, elements);
 	QUARK_ASSERT(temp.check_invariant());
 	return temp;
 }
@@ -980,7 +813,7 @@ bc_value_t make_vector(const types_t& types, const type_t& element_type, const i
 
 	bc_value_t temp;
 	temp._type = vector_type;
-	temp._pod._external = new bc_external_value_t{vector_type, elements};
+	temp._pod._external = new bc_external_vector_w_inplace_elements_t(vector_type, elements);
 	QUARK_ASSERT(temp.check_invariant());
 	return temp;
 }
@@ -991,13 +824,13 @@ const immer::map<std::string, bc_external_handle_t>& get_dict_external_values(co
 	QUARK_ASSERT(value.check_invariant());
 	QUARK_ASSERT(encode_as_dict_w_inplace_values(types, value._type) == false);
 
-	return value._pod._external->_dict_w_external_values;
+	return value._pod._external->get_dict_w_external_values();
 }
 const immer::map<std::string, bc_inplace_value_t>& get_dict_inplace_values(const types_t& types, const bc_value_t& value){
 	QUARK_ASSERT(value.check_invariant());
 	QUARK_ASSERT(encode_as_dict_w_inplace_values(types, value._type) == true);
 
-	return value._pod._external->_dict_w_inplace_values;
+	return value._pod._external->get_dict_w_inplace_values();
 }
 
 bc_value_t make_dict(const types_t& types, const type_t& value_type, const immer::map<std::string, bc_external_handle_t>& entries){
@@ -1011,7 +844,7 @@ bc_value_t make_dict(const types_t& types, const type_t& value_type, const immer
 
 	bc_value_t temp;
 	temp._type = make_dict(types, value_type);
-	temp._pod._external = new bc_external_value_t{ temp._type, entries };
+	temp._pod._external = new bc_external_dict_w_external_values_t(temp._type, entries);
 	QUARK_ASSERT(temp.check_invariant());
 	return temp;
 }
@@ -1021,7 +854,7 @@ bc_value_t make_dict(const types_t& types, const type_t& value_type, const immer
 
 	bc_value_t temp;
 	temp._type = make_dict(types, value_type);
-	temp._pod._external = new bc_external_value_t{ temp._type, entries };
+	temp._pod._external = new bc_external_dict_w_inplace_values_t(temp._type, entries);
 	QUARK_ASSERT(temp.check_invariant());
 	return temp;
 }
@@ -1083,6 +916,18 @@ QUARK_TEST("", "", "", ""){
 	QUARK_ASSERT(immer_intkey_map_size == 16);
 }
 
+//	Each kind of external value only pays for its own payload.
+QUARK_TEST("", "", "", ""){
+	//	Payloads are 8-byte aligned.
+	const auto header_size = (sizeof(bc_external_value_t) + 7) & ~size_t(7);
+	QUARK_ASSERT(sizeof(bc_external_string_t) <= header_size + sizeof(std::string));
+	QUARK_ASSERT(sizeof(bc_external_json_t) <= header_size + sizeof(std::shared_ptr<json_t>));
+	QUARK_ASSERT(sizeof(bc_external_struct_t) <= header_size + sizeof(std::vector<bc_value_t>));
+	QUARK_ASSERT(sizeof(bc_external_vector_w_inplace_elements_t) <= header_size + sizeof(immer::vector<bc_inplace_value_t>));
+	QUARK_ASSERT(sizeof(bc_external_dict_w_inplace_values_t) <= header_size + sizeof(immer::map<std::string, bc_inplace_value_t>));
+	QUARK_ASSERT(sizeof(bc_external_function_t) <= header_size + sizeof(bc_function_ref_t));
+}
+
 
 
 
@@ -1188,7 +1033,7 @@ bc_value_t update_vector_element(interpreter_t& vm, const bc_value_t vec, int64_
 
 	const auto element_type = peek.get_vector_element_type(types);
 	if(encode_as_vector_w_inplace_elements(types, peek)){
-		auto v2 = vec._pod._external->_vector_w_inplace_elements;
+		auto v2 = vec._pod._external->get_vector_w_inplace_elements();
 
 		if(lookup_index < 0 || lookup_index >= v2.size()){
 			quark::throw_runtime_error("Vector lookup out of bounds.");
@@ -1236,7 +1081,7 @@ bc_value_t update_dict_entry(interpreter_t& vm, const bc_value_t dict, const std
 	const auto value_type = peek.get_dict_value_type(types);
 
 	if(encode_as_dict_w_inplace_values(types, dict._type)){
-		auto entries2 = dict._pod._external->_dict_w_inplace_values.set(key, value._pod._inplace);
+		auto entries2 = dict._pod._external->get_dict_w_inplace_values().set(key, value._pod._inplace);
 		const auto value2 = make_dict(types, value_type, entries2);
 		return value2;
 	}
@@ -1802,13 +1647,13 @@ int bc_compare_value_true_deep(const types_t& types, const bc_value_t& left, con
 		if(false){
 		}
 		else if(element_type_peek.is_bool()){
-			return bc_compare_vectors_bool(left._pod._external->_vector_w_inplace_elements, right._pod._external->_vector_w_inplace_elements);
+			return bc_compare_vectors_bool(left._pod._external->get_vector_w_inplace_elements(), right._pod._external->get_vector_w_inplace_elements());
 		}
 		else if(element_type_peek.is_int()){
-			return bc_compare_vectors_int(left._pod._external->_vector_w_inplace_elements, right._pod._external->_vector_w_inplace_elements);
+			return bc_compare_vectors_int(left._pod._external->get_vector_w_inplace_elements(), right._pod._external->get_vector_w_inplace_elements());
 		}
 		else if(element_type_peek.is_double()){
-			return bc_compare_vectors_double(left._pod._external->_vector_w_inplace_elements, right._pod._external->_vector_w_inplace_elements);
+			return bc_compare_vectors_double(left._pod._external->get_vector_w_inplace_elements(), right._pod._external->get_vector_w_inplace_elements());
 		}
 		else{
 			const auto& left_vec = get_vector_external_elements(types, left);
@@ -1821,13 +1666,13 @@ int bc_compare_value_true_deep(const types_t& types, const bc_value_t& left, con
 		if(false){
 		}
 		else if(dict_value_peek.is_bool()){
-			return bc_compare_dicts_bool(left._pod._external->_dict_w_inplace_values, right._pod._external->_dict_w_inplace_values);
+			return bc_compare_dicts_bool(left._pod._external->get_dict_w_inplace_values(), right._pod._external->get_dict_w_inplace_values());
 		}
 		else if(dict_value_peek.is_int()){
-			return bc_compare_dicts_int(left._pod._external->_dict_w_inplace_values, right._pod._external->_dict_w_inplace_values);
+			return bc_compare_dicts_int(left._pod._external->get_dict_w_inplace_values(), right._pod._external->get_dict_w_inplace_values());
 		}
 		else if(dict_value_peek.is_double()){
-			return bc_compare_dicts_double(left._pod._external->_dict_w_inplace_values, right._pod._external->_dict_w_inplace_values);
+			return bc_compare_dicts_double(left._pod._external->get_dict_w_inplace_values(), right._pod._external->get_dict_w_inplace_values());
 		}
 		else  {
 			QUARK_ASSERT(encode_as_dict_w_inplace_values(types, type) == false);
@@ -1880,10 +1725,12 @@ extern const std::map<bc_opcode, opcode_info_t> k_opcode_info = {
 	{ bc_opcode::k_pushback_string, { "pushback_string", opcode_info_t::encoding::k_o_0rrr } },
 
 	{ bc_opcode::k_call, { "call", opcode_info_t::encoding::k_s_0rri } },
+	{ bc_opcode::k_call_global, { "call_global", opcode_info_t::encoding::k_t_0rii } },
 
 	{ bc_opcode::k_add_bool, { "add_bool", opcode_info_t::encoding::k_o_0rrr } },
 	{ bc_opcode::k_add_int, { "add_int", opcode_info_t::encoding::k_o_0rrr } },
 	{ bc_opcode::k_add_double, { "add_double", opcode_info_t::encoding::k_o_0rrr } },
+	{ bc_opcode::k_add_int_imm, { "add_int_imm", opcode_info_t::encoding::k_s_0rri } },
 	{ bc_opcode::k_concat_strings, { "concat_strings", opcode_info_t::encoding::k_o_0rrr } },
 	{ bc_opcode::k_concat_vectors_w_external_elements, { "concat_vectors_w_external_elements", opcode_info_t::encoding::k_o_0rrr } },
 	{ bc_opcode::k_concat_vectors_w_inplace_elements, { "concat_vectors_pod64", opcode_info_t::encoding::k_o_0rrr } },
@@ -1939,6 +1786,10 @@ extern const std::map<bc_opcode, opcode_info_t> k_opcode_info = {
 
 	{ bc_opcode::k_branch_smaller_int, { "branch_smaller_int", opcode_info_t::encoding::k_s_0rri } },
 	{ bc_opcode::k_branch_smaller_or_equal_int, { "branch_smaller_or_equal_int", opcode_info_t::encoding::k_s_0rri } },
+	{ bc_opcode::k_branch_equal_int, { "branch_equal_int", opcode_info_t::encoding::k_s_0rri } },
+	{ bc_opcode::k_branch_notequal_int, { "branch_notequal_int", opcode_info_t::encoding::k_s_0rri } },
+	{ bc_opcode::k_increment_branch_smaller_int, { "increment_branch_smaller_int", opcode_info_t::encoding::k_s_0rri } },
+	{ bc_opcode::k_increment_branch_smaller_or_equal_int, { "increment_branch_smaller_or_equal_int", opcode_info_t::encoding::k_s_0rri } },
 
 	{ bc_opcode::k_branch_always, { "branch_always", opcode_info_t::encoding::k_l_00i0 } }
 
@@ -2062,6 +1913,22 @@ bc_static_frame_t::bc_static_frame_t(const types_t& types, const std::vector<bc_
 		}
 	}
 
+	//	Each push instruction is popped again before the instructions of its statement are done, so counting
+	//	every push once is enough, even inside loops.
+	_stack_entry_count = static_cast<int>(_locals.size());
+	for(const auto& e: _instructions){
+		if(e._opcode == bc_opcode::k_push_frame_ptr){
+			_stack_entry_count += k_frame_overhead;
+		}
+		else if(e._opcode == bc_opcode::k_push_inplace_value || e._opcode == bc_opcode::k_push_external_value){
+			_stack_entry_count++;
+		}
+	}
+
+#if BC_THREADED_DISPATCH
+	_threaded_instructions = make_threaded_instructions(_instructions);
+#endif
+
 	QUARK_ASSERT(check_invariant());
 }
 
@@ -2113,10 +1980,136 @@ bool bc_function_definition_t::check_invariant() const {
 
 
 
+//////////////////////////////////////////		function index
+
+
+
+std::unordered_map<std::string, int> make_function_indexes(
+	const std::map<function_id_t, bc_function_definition_t>& function_defs,
+	const intrinsic_signatures_t& intrinsics
+){
+	std::unordered_map<std::string, int> result;
+	for(const auto& e: function_defs){
+		result.insert({ e.first.name, static_cast<int>(result.size()) });
+	}
+	for(const auto& e: intrinsics.vec){
+		result.insert({ e.name, static_cast<int>(result.size()) });
+	}
+	return result;
+}
+
+bc_static_frame_t resolve_function_values(
+	const types_t& types,
+	const bc_static_frame_t& frame,
+	const std::unordered_map<std::string, int>& function_indexes
+){
+	QUARK_ASSERT(types.check_invariant());
+	QUARK_ASSERT(frame.check_invariant());
+
+	auto symbols2 = frame._symbols;
+	for(auto& e: symbols2){
+		const auto& value = e.second._const_value;
+		if(value._type.is_undefined() == false && peek2(types, value._type).is_function()){
+			const auto function_id = value.get_function_value();
+			const auto it = function_indexes.find(function_id.name);
+			if(it != function_indexes.end()){
+				e.second._const_value = bc_value_t::make_function_value(value._type, function_id, it->second);
+			}
+		}
+	}
+	return bc_static_frame_t(types, frame._instructions, symbols2, frame._args);
+}
+
+QUARK_TEST("make_function_indexes()", "", "", "function defs first, then intrinsics"){
+	types_t types;
+	const auto intrinsics = make_intrinsic_signatures(types);
+	const auto function_type = make_function(types, type_t::make_int(), {}, epure::pure);
+	const auto f = bc_function_definition_t{ types, function_type, {}, nullptr, function_id_t { "f" } };
+	const auto g = bc_function_definition_t{ types, function_type, {}, nullptr, function_id_t { "g" } };
+
+	const auto result = make_function_indexes({ { g._function_id, g }, { f._function_id, f } }, intrinsics);
+	QUARK_VERIFY(result.size() == 2 + intrinsics.vec.size());
+	QUARK_VERIFY(result.at("f") == 0);
+	QUARK_VERIFY(result.at("g") == 1);
+	QUARK_VERIFY(result.at(intrinsics.vec[0].name) == 2);
+	QUARK_VERIFY(result.at(intrinsics.vec.back().name) == 1 + intrinsics.vec.size());
+}
+
+std::vector<bc_callee_t> make_callees(
+	const bc_program_t& program,
+	const std::map<function_id_t, BC_NATIVE_FUNCTION_PTR>& native_functions
+){
+	QUARK_ASSERT(program.check_invariant());
+
+	const auto& types = program._types;
+
+	const auto make_callee = [&](const function_id_t& function_id, const type_t& function_type, const bc_static_frame_t* frame_ptr){
+		const auto native_it = native_functions.find(function_id);
+		const auto function_type_peek = peek2(types, function_type);
+		const auto arg_types = function_type_peek.get_function_args(types);
+		const auto arg_is_any = mapf<bool>(arg_types, [&](const auto& e){ return peek2(types, e).is_any(); });
+		const auto return_type = function_type_peek.get_function_return(types);
+
+		return bc_callee_t {
+			function_id,
+			function_type,
+			frame_ptr,
+			frame_ptr == nullptr && native_it != native_functions.end() ? native_it->second : nullptr,
+			arg_types,
+			arg_is_any,
+			static_cast<int>(std::count(arg_is_any.begin(), arg_is_any.end(), true)),
+			peek2(types, return_type).is_void(),
+			encode_as_external(types, return_type)
+		};
+	};
+
+	std::vector<bc_callee_t> result;
+	std::set<std::string> names;
+	for(const auto& e: program._function_defs){
+		result.push_back(make_callee(e.first, e.second._function_type, e.second._frame_ptr.get()));
+		names.insert(e.first.name);
+	}
+	for(const auto& e: program.intrinsic_signatures.vec){
+		if(names.insert(e.name).second){
+			result.push_back(make_callee(function_id_t { e.name }, e._function_type, nullptr));
+		}
+	}
+	return result;
+}
+
+
+
 //////////////////////////////////////////		interpreter_stack_t
 
 
 
+interpreter_stack_limits_t make_default_interpreter_stack_limits(){
+	return interpreter_stack_limits_t{ 1024, 4 * 1024 * 1024, 6 * 1024 * 1024 };
+}
+
+void interpreter_stack_t::grow(size_t min_count){
+	QUARK_ASSERT(check_invariant());
+	QUARK_ASSERT(min_count > _allocated_count);
+
+	const auto max_count = static_cast<size_t>(_limits._max_entry_count);
+	if(min_count > max_count){
+		quark::throw_runtime_error("Stack overflow.");
+	}
+	const auto new_count = std::min(std::max(_allocated_count * 2, min_count), max_count);
+
+	//	Entries are pods and the stack owns their RCs, so a plain copy moves them.
+	auto new_entries = new bc_pod_value_t[new_count];
+	std::copy(&_entries[0], &_entries[_stack_size], &new_entries[0]);
+	const auto frame_pos = _current_frame_entry_ptr - &_entries[0];
+
+	delete[] _entries;
+	_entries = new_entries;
+	_allocated_count = new_count;
+	_current_frame_entry_ptr = &_entries[frame_pos];
+
+	QUARK_ASSERT(check_invariant());
+}
+
 frame_pos_t interpreter_stack_t::read_prev_frame(int frame_pos) const{
 //	QUARK_ASSERT(vm.check_invariant());
 	QUARK_ASSERT(frame_pos >= k_frame_overhead);
@@ -2238,11 +2231,33 @@ json_t interpreter_stack_t::stack_to_json(const types_t& types) const{
 //////////////////////////////////////////		GLOBAL FUNCTIONS
 
 
-const bc_function_definition_t& get_function_def(const interpreter_t& vm, function_id_t function_id){
-	QUARK_ASSERT(vm.check_invariant());
+//	Function values from the program know their function index. Function values made at runtime, from a value_t
+//	for example, don't and are looked up by name.
+static const bc_callee_t& resolve_callee(const interpreter_t& vm, const bc_external_value_t* f){
+	QUARK_ASSERT(f != nullptr);
+
+	const auto& callees = vm._imm->_callees;
+	const auto& ref = f->get_function();
+	if(ref._function_index != k_no_function_index){
+		QUARK_ASSERT(ref._function_index >= 0 && ref._function_index < callees.size());
+		QUARK_ASSERT(callees[ref._function_index]._function_id == ref._function_id);
+
+		return callees[ref._function_index];
+	}
+	else{
+		const auto it = vm._imm->_function_indexes.find(ref._function_id.name);
+		if(it == vm._imm->_function_indexes.end()){
+			quark::throw_runtime_error("Attempting to calling unimplemented function.");
+		}
+		return callees[it->second];
+	}
+}
 
-	const auto& function_def = vm._imm->_program._function_defs.at(function_id);
-	return function_def;
+static BC_NATIVE_FUNCTION_PTR get_native_function_ptr(const bc_callee_t& callee){
+	if(callee._native_function_ptr == nullptr){
+		quark::throw_runtime_error("Attempting to calling unimplemented function.");
+	}
+	return callee._native_function_ptr;
 }
 
 
@@ -2256,11 +2271,9 @@ bc_value_t call_function_bc(interpreter_t& vm, const bc_value_t& f, const bc_val
 	QUARK_ASSERT(peek2(types, f._type).is_function());
 #endif
 
-	const auto& function_def = get_function_def(vm, f.get_function_value());
-	if(function_def._frame_ptr == nullptr){
-		const auto function_id = function_def._function_id;
-
-		const auto& native_function_ptr = vm._imm->_native_functions.at(function_id);
+	const auto& callee = resolve_callee(vm, f._pod._external);
+	if(callee._frame_ptr == nullptr){
+		const auto native_function_ptr = get_native_function_ptr(callee);
 
 		//	arity
 	//	QUARK_ASSERT(args.size() == host_function._function_type.get_function_args().size());
@@ -2283,6 +2296,7 @@ bc_value_t call_function_bc(interpreter_t& vm, const bc_value_t& f, const bc_val
 #endif
 
 		vm._stack.save_frame();
+		vm._stack.reserve(arg_count);
 
 		//??? use exts-info inside function_def.
 		//	We push the values to the stack = the stack will take RC ownership of the values.
@@ -2299,9 +2313,9 @@ bc_value_t call_function_bc(interpreter_t& vm, const bc_value_t& f, const bc_val
 			}
 		}
 
-		vm._stack.open_frame(*function_def._frame_ptr, arg_count);
-		const auto& result = execute_instructions(vm, function_def._frame_ptr->_instructions);
-		vm._stack.close_frame(*function_def._frame_ptr);
+		vm._stack.open_frame(*callee._frame_ptr, arg_count);
+		const auto& result = execute_instructions(vm, callee._frame_ptr->_instructions);
+		vm._stack.close_frame(*callee._frame_ptr);
 		vm._stack.pop_batch(exts);
 		vm._stack.restore_frame();
 
@@ -2367,20 +2381,20 @@ json_t bcvalue_to_json(const types_t& types, const bc_value_t& v){
 
 		std::vector<json_t> result;
 		if(element_type_peek.is_bool()){
-			for(int i = 0 ; i < v._pod._external->_vector_w_inplace_elements.size() ; i++){
-				const auto element_value2 = v._pod._external->_vector_w_inplace_elements[i].bool_value;
+			for(int i = 0 ; i < v._pod._external->get_vector_w_inplace_elements().size() ; i++){
+				const auto element_value2 = v._pod._external->get_vector_w_inplace_elements()[i].bool_value;
 				result.push_back(json_t(element_value2));
 			}
 		}
 		else if(element_type_peek.is_int()){
-			for(int i = 0 ; i < v._pod._external->_vector_w_inplace_elements.size() ; i++){
-				const auto element_value2 = v._pod._external->_vector_w_inplace_elements[i].int64_value;
+			for(int i = 0 ; i < v._pod._external->get_vector_w_inplace_elements().size() ; i++){
+				const auto element_value2 = v._pod._external->get_vector_w_inplace_elements()[i].int64_value;
 				result.push_back(json_t(element_value2));
 			}
 		}
 		else if(element_type_peek.is_double()){
-			for(int i = 0 ; i < v._pod._external->_vector_w_inplace_elements.size() ; i++){
-				const auto element_value2 = v._pod._external->_vector_w_inplace_elements[i].double_value;
+			for(int i = 0 ; i < v._pod._external->get_vector_w_inplace_elements().size() ; i++){
+				const auto element_value2 = v._pod._external->get_vector_w_inplace_elements()[i].double_value;
 				result.push_back(json_t(element_value2));
 			}
 		}
@@ -2442,11 +2456,12 @@ static json_t bcvalue_and_type_to_json(const types_t& types, const bc_value_t& v
 
 
 
-interpreter_t::interpreter_t(const bc_program_t& program, runtime_handler_i* handler) :
-	_stack(program._types, nullptr),
+interpreter_t::interpreter_t(const bc_program_t& program, bc_runtime_handler_i* handler, const interpreter_stack_limits_t& stack_limits) :
+	_stack(program._types, nullptr, stack_limits),
 	_handler(handler)
 {
 	QUARK_ASSERT(program.check_invariant());
+	QUARK_ASSERT(stack_limits.check_invariant());
 
 	const auto start_time = std::chrono::high_resolution_clock::now();
 
@@ -2462,9 +2477,16 @@ interpreter_t::interpreter_t(const bc_program_t& program, runtime_handler_i* han
 	host_functions.insert(corelib_calls.begin(), corelib_calls.end());
 
 
-	_imm = std::make_shared<interpreter_imm_t>(interpreter_imm_t{start_time, program, host_functions });
+	_imm = std::make_shared<interpreter_imm_t>(interpreter_imm_t{
+		start_time,
+		program,
+		host_functions,
+		make_callees(program, host_functions),
+		make_function_indexes(program._function_defs, program.intrinsic_signatures)
+	});
+	QUARK_ASSERT(_imm->_callees.size() == _imm->_function_indexes.size());
 
-	interpreter_stack_t temp(program._types, &_imm->_program._globals);
+	interpreter_stack_t temp(program._types, &_imm->_program._globals, stack_limits);
 	temp.swap(_stack);
 	_stack.save_frame();
 	_stack.open_frame(_imm->_program._globals, 0);
@@ -2473,6 +2495,10 @@ interpreter_t::interpreter_t(const bc_program_t& program, runtime_handler_i* han
 	/*const auto& r =*/ execute_instructions(*this, _imm->_program._globals._instructions);
 	QUARK_ASSERT(check_invariant());
 }
+interpreter_t::interpreter_t(const bc_program_t& program, bc_runtime_handler_i* handler) :
+	interpreter_t(program, handler, make_default_interpreter_stack_limits())
+{
+}
 interpreter_t::interpreter_t(const bc_program_t& program) : interpreter_t(program, nullptr) {}
 
 void interpreter_t::swap(interpreter_t& other) throw(){
@@ -2480,6 +2506,9 @@ void interpreter_t::swap(interpreter_t& other) throw(){
 	std::swap(other._handler, this->_handler);
 	other._stack.swap(this->_stack);
 	other._print_output.swap(this->_print_output);
+#if BC_OPCODE_HISTOGRAM
+	std::swap(other._opcode_histogram, this->_opcode_histogram);
+#endif
 }
 
 #if DEBUG
@@ -2671,42 +2700,25 @@ void execute_new_struct(interpreter_t& vm, int16_t dest_reg, int16_t target_ityp
 /*
 	??? Make stub bc_static_frame_t for each host function to make call conventions same as Floyd functions.
 */
-//	??? Very slow
 //	Notice: host calls and floyd calls have the same type -- we cannot detect host calls until we have a callee value.
-static void call_native(interpreter_t& vm, const bc_instruction_t& i, const type_t& function_type){
+static void call_native(interpreter_t& vm, const bc_instruction_t& i, const bc_callee_t& callee){
 	QUARK_ASSERT(vm.check_invariant());
 	QUARK_ASSERT(i.check_invariant());
-	QUARK_ASSERT(function_type.check_invariant());
 
-	const auto& types = vm._imm->_program._types;
 	interpreter_stack_t& stack = vm._stack;
-	bc_pod_value_t* regs = stack._current_frame_entry_ptr;
-
-	QUARK_ASSERT(stack.check_reg_function(i._b));
 
-	const function_id_t function_id = regs[i._b]._external->_function_id;
+	const auto host_function_ptr = get_native_function_ptr(callee);
 	const int callee_arg_count = i._c;
 
-	const auto native_it = vm._imm->_native_functions.find(function_id);
-	if(native_it == vm._imm->_native_functions.end()){
-		quark::throw_runtime_error("Attempting to calling unimplemented function.");
-	}
-	const auto& host_function_ptr = native_it->second;
-
-	const auto function_type_peek = peek2(types, function_type);
-
-	const auto temp_args = function_type_peek.get_function_args(types);
-	const auto function_def_dynamic_arg_count = std::count_if(temp_args.begin(), temp_args.end(), [&](const auto& e){ return peek2(types, e).is_any(); } );
-
-	const int arg0_stack_pos = stack.size() - (function_def_dynamic_arg_count + callee_arg_count);
+	const int arg0_stack_pos = stack.size() - (callee._dyn_arg_count + callee_arg_count);
 	int stack_pos = arg0_stack_pos;
 
 	//	Notice that dynamic functions will have each DYN argument with a leading itype as an extra argument.
-	const auto function_def_arg_count = temp_args.size();
+	const auto function_def_arg_count = callee._arg_types.size();
 	std::vector<bc_value_t> arg_values;
+	arg_values.reserve(function_def_arg_count);
 	for(int a = 0 ; a < function_def_arg_count ; a++){
-		const auto func_arg_type = temp_args[a];
-		if(peek2(types, func_arg_type).is_any()){
+		if(callee._arg_is_any[a]){
 			const auto arg_itype = stack.load_intq(stack_pos);
 			const auto& arg_type = lookup_full_type(vm, static_cast<int16_t>(arg_itype));
 			const auto arg_value = stack.load_value(stack_pos + 1, arg_type);
@@ -2714,99 +2726,297 @@ static void call_native(interpreter_t& vm, const bc_instruction_t& i, const type
 			stack_pos += k_frame_overhead;
 		}
 		else{
-			const auto arg_value = stack.load_value(stack_pos + 0, func_arg_type);
+			const auto arg_value = stack.load_value(stack_pos + 0, callee._arg_types[a]);
 			arg_values.push_back(arg_value);
 			stack_pos++;
 		}
 	}
 
-	const auto& result = (host_function_ptr)(vm, &arg_values[0], static_cast<int>(arg_values.size()));
-	const auto bc_result = result;
-
-	const auto& function_return_type = function_type_peek.get_function_return(types);
-	const auto function_return_type_peek = peek2(types, function_return_type);
-	if(function_return_type_peek.is_void() == true){
+	const auto& result = (host_function_ptr)(vm, arg_values.data(), static_cast<int>(arg_values.size()));
+	if(callee._return_is_void == false){
+		stack.write_register(i._a, result);
 	}
-	else if(function_return_type_peek.is_any()){
-		stack.write_register(i._a, bc_result);
+}
+
+//	Throws "Stack overflow." when nested execute_instructions() have used more than _max_native_stack_size bytes
+//	of C++ stack. Assumes the C++ stack grows downwards.
+struct native_stack_guard_t {
+	explicit native_stack_guard_t(interpreter_stack_t& stack) :
+		_stack(stack),
+		_is_outermost(false)
+	{
+		const char local = 0;
+		const char* pos = &local;
+		if(_stack._native_stack_base == nullptr){
+			_stack._native_stack_base = pos;
+			_is_outermost = true;
+		}
+		else if(_stack._native_stack_base - pos > _stack._limits._max_native_stack_size){
+			quark::throw_runtime_error("Stack overflow.");
+		}
 	}
-	else{
-		stack.write_register(i._a, bc_result);
+
+	~native_stack_guard_t(){
+		if(_is_outermost){
+			_stack._native_stack_base = nullptr;
+		}
 	}
-}
+
+	interpreter_stack_t& _stack;
+	bool _is_outermost;
+};
+
+#if BC_THREADED_DISPATCH == 0
 
 //	We need to examine the callee, since we support magic argument lists of varying size.
-static void do_call(interpreter_t& vm, const bc_instruction_t& i){
+static void do_call(interpreter_t& vm, const bc_instruction_t& i, const bc_callee_t& callee){
 	QUARK_ASSERT(vm.check_invariant());
 	QUARK_ASSERT(i.check_invariant());
 
 	interpreter_stack_t& stack = vm._stack;
-	bc_pod_value_t* regs = stack._current_frame_entry_ptr;
+	const int callee_arg_count = i._c;
 
+	//	No frame_ptr: this is a native function or an intrinsic.
+	if(callee._frame_ptr == nullptr){
+		call_native(vm, i, callee);
+	}
 
-	QUARK_ASSERT(stack.check_reg_function(i._b));
+	//	This is a floyd function, with a frame_ptr to execute.
+	else{
+		QUARK_ASSERT(callee._arg_types.size() == callee_arg_count);
+		QUARK_ASSERT(callee._dyn_arg_count == 0);
 
-	const function_id_t function_id = regs[i._b]._external->_function_id;
-	const int callee_arg_count = i._c;
+		//	We need to remember the global pos where to store return value, since we're switching frame to call function.
+		int result_reg_pos = static_cast<int>(stack._current_frame_entry_ptr - &stack._entries[0]) + i._a;
 
-	const auto function_def_it = vm._imm->_program._function_defs.find(function_id);
+		stack.open_frame(*callee._frame_ptr, callee_arg_count);
+		const auto& result = execute_instructions(vm, callee._frame_ptr->_instructions);
+		stack.close_frame(*callee._frame_ptr);
 
-	//	Can't find this functions -- it could be an intrinsic.
-	if(function_def_it != vm._imm->_program._function_defs.end() == false){
-		const auto& intrinsics = vm._imm->_program.intrinsic_signatures;
+		if(callee._return_is_void == false){
 
-		//	Find function
-		const auto it = std::find_if(intrinsics.vec.begin(), intrinsics.vec.end(), [&](const intrinsic_signature_t& e) { return e.name == function_id.name; } );
-		QUARK_ASSERT(it != intrinsics.vec.end());
-		const auto& function_type = it->_function_type;
-		call_native(vm, i, function_type);
+			//	Cannot store via register, we have not yet executed k_pop_frame_ptr that restores our frame.
+			if(callee._return_is_ext){
+				stack.replace_external_value(result_reg_pos, result.second);
+			}
+			else{
+				stack.replace_inplace_value(result_reg_pos, result.second);
+			}
+		}
 	}
-	else{
-		const auto& function_def = function_def_it->second;
+}
 
-		//	There is a function def but it has no frame_ptr: this is a native function.
-		if(function_def._frame_ptr == nullptr){
-			call_native(vm, i, function_def._function_type);
-		}
+#endif
+
+
+#if BC_THREADED_DISPATCH
 
-		//	This is a floyd function, with a frame_ptr to execute.
+//	Where an inlined call to a Floyd function continues when the callee returns.
+struct bc_return_address_t {
+	const bc_threaded_instruction_t* _code;
+	int _pc;
+	const bc_callee_t* _callee;
+	int _result_reg_pos;
+};
+
+//	Does what do_call() does after the callee's execute_instructions() returns, but moves the result's pod
+//	straight into the caller's result register instead of going via a bc_value_t.
+//	result: the callee's return register or nullptr for k_stop. The caller owns one RC of an external result.
+static void return_from_inlined_call(
+	interpreter_stack_t& stack,
+	const bc_static_frame_t& frame,
+	const bc_return_address_t& return_address,
+	const bc_pod_value_t* result
+){
+	const auto& callee = *return_address._callee;
+	QUARK_ASSERT(result != nullptr || callee._return_is_void);
+
+	bc_pod_value_t result_pod;
+	if(result != nullptr){
+		result_pod = *result;
+		if(callee._return_is_ext){
+			result_pod._external->_rc++;
+		}
+	}
+
+	stack.close_frame(frame);
+
+	if(callee._return_is_void == false){
+		//	Cannot store via register, we have not yet executed k_pop_frame_ptr that restores our frame.
+		auto& dest = stack._entries[return_address._result_reg_pos];
+		if(callee._return_is_ext){
+			auto prev_copy = dest;
+			dest = result_pod;
+			release_pod_external(prev_copy);
+		}
 		else{
-			QUARK_ASSERT(function_def._args.size() == callee_arg_count);
+			dest = result_pod;
+		}
+	}
+}
 
-			const auto& types = vm._imm->_program._types;
+#define BC_CASE(opcode) L_##opcode: QUARK_ASSERT(i._opcode == bc_opcode::opcode); BC_COUNT_OPCODE(opcode)
+#define BC_NEXT() { pc++; i = code[pc]._instruction; BC_CHECK_NEXT(); goto *code[pc]._handler; }
+#define BC_INVALID_OPCODE L_invalid_opcode:
 
-			const int function_def_dynamic_arg_count = function_def._dyn_arg_count;
-			const auto& function_return_type = peek2(types, function_def._function_type).get_function_return(types);
+//	Floyd functions continue with the callee's instructions in this loop, its k_return / k_stop comes back here.
+#define BC_CALL(callee) \
+	if(callee._frame_ptr == nullptr){ \
+		call_native(vm, i, callee); \
+	} \
+	else{ \
+		QUARK_ASSERT(callee._arg_types.size() == i._c); \
+		QUARK_ASSERT(callee._dyn_arg_count == 0); \
+		\
+		const int result_reg_pos = static_cast<int>(regs - &stack._entries[0]) + i._a; \
+		return_addresses.push_back(bc_return_address_t{ code, pc, &callee, result_reg_pos }); \
+		\
+		stack.open_frame(*callee._frame_ptr, i._c); \
+		code = callee._frame_ptr->_threaded_instructions.data(); \
+		pc = -1; \
+	} \
+	BC_AFTER_CALL()
 
-			QUARK_ASSERT(function_def_dynamic_arg_count == 0);
+#else
 
-			//	We need to remember the global pos where to store return value, since we're switching frame to call function.
-			int result_reg_pos = static_cast<int>(stack._current_frame_entry_ptr - &stack._entries[0]) + i._a;
+#define BC_CASE(opcode) case bc_opcode::opcode: BC_COUNT_OPCODE(opcode)
+#define BC_NEXT() break
+#define BC_INVALID_OPCODE default:
 
-			stack.open_frame(*function_def._frame_ptr, callee_arg_count);
-			const auto& result = execute_instructions(vm, function_def._frame_ptr->_instructions);
-			stack.close_frame(*function_def._frame_ptr);
+#define BC_CALL(callee) \
+	do_call(vm, i, callee); \
+	BC_AFTER_CALL()
 
-			//	Update our cached pointers.
+#endif
 
-			const auto function_return_type_peek = peek2(types, function_return_type);
+#if BC_OPCODE_HISTOGRAM
+#define BC_COUNT_OPCODE(opcode) { count_opcode(vm._opcode_histogram, prev_opcode, bc_opcode::opcode); prev_opcode = bc_opcode::opcode; }
+#else
+#define BC_COUNT_OPCODE(opcode)
+#endif
 
-			if(function_return_type_peek.is_void() == false){
+//	The end of BC_CALL(): the current frame is now the callee's, or still ours after a native call.
+//	The call may have reallocated the stack, so regs and globals are reloaded too.
+#define BC_AFTER_CALL() \
+	frame_ptr = stack._current_frame_ptr; \
+	regs = stack._current_frame_entry_ptr; \
+	globals = &stack._entries[k_frame_overhead]; \
+	QUARK_ASSERT(vm.check_invariant()); \
+	BC_NEXT();
+
+#define BC_CHECK_NEXT() \
+	QUARK_ASSERT(pc >= 0); \
+	QUARK_ASSERT(vm.check_invariant()); \
+	QUARK_ASSERT(i.check_invariant()); \
+	QUARK_ASSERT(frame_ptr == stack._current_frame_ptr); \
+	QUARK_ASSERT(regs == stack._current_frame_entry_ptr); \
+	QUARK_ASSERT(globals == &stack._entries[k_frame_overhead]);
+
+
+#if BC_THREADED_DISPATCH
+
+//	Only this function can take the addresses of its labels: make_threaded_instructions() calls it with
+//	vm_ptr == nullptr to get the dispatch table. noinline / noclone since a copy of the function would have its own labels.
+#if defined(__clang__)
+__attribute__((noinline))
+#else
+__attribute__((noinline, noclone))
+#endif
+static std::pair<bc_typeid_t, bc_value_t> execute_instructions__threaded(interpreter_t* vm_ptr, const void* const** dispatch_table_out){
+	//	Indexed by bc_opcode.
+	static const void* const k_dispatch_table[] = {
+		&&L_k_nop,
+		&&L_k_load_global_external_value,
+		&&L_k_load_global_inplace_value,
+		&&L_k_store_global_external_value,
+		&&L_k_store_global_inplace_value,
+		&&L_k_copy_reg_inplace_value,
+		&&L_k_copy_reg_external_value,
+		&&L_k_get_struct_member,
+		&&L_k_lookup_element_string,
+		&&L_k_lookup_element_json,
+		&&L_k_lookup_element_vector_w_external_elements,
+		&&L_k_lookup_element_vector_w_inplace_elements,
+		&&L_k_lookup_element_dict_w_external_values,
+		&&L_k_lookup_element_dict_w_inplace_values,
+		&&L_k_get_size_vector_w_external_elements,
+		&&L_k_get_size_vector_w_inplace_elements,
+		&&L_k_get_size_dict_w_external_values,
+		&&L_k_get_size_dict_w_inplace_values,
+		&&L_k_get_size_string,
+		&&L_k_get_size_jsonvalue,
+		&&L_k_pushback_vector_w_external_elements,
+		&&L_k_pushback_vector_w_inplace_elements,
+		&&L_k_pushback_string,
+		&&L_k_call,
+		&&L_k_call_global,
+		&&L_k_add_bool,
+		&&L_k_add_int,
+		&&L_k_add_double,
+		&&L_k_add_int_imm,
+		&&L_k_concat_strings,
+		&&L_k_concat_vectors_w_external_elements,
+		&&L_k_concat_vectors_w_inplace_elements,
+		&&L_k_subtract_double,
+		&&L_k_subtract_int,
+		&&L_k_multiply_double,
+		&&L_k_multiply_int,
+		&&L_k_divide_double,
+		&&L_k_divide_int,
+		&&L_invalid_opcode,
+		&&L_k_remainder_int,
+		&&L_k_logical_and_bool,
+		&&L_k_logical_and_int,
+		&&L_k_logical_and_double,
+		&&L_k_logical_or_bool,
+		&&L_k_logical_or_int,
+		&&L_k_logical_or_double,
+		&&L_k_comparison_smaller_or_equal,
+		&&L_k_comparison_smaller_or_equal_int,
+		&&L_k_comparison_smaller,
+		&&L_k_comparison_smaller_int,
+		&&L_k_logical_equal,
+		&&L_k_logical_equal_int,
+		&&L_k_logical_nonequal,
+		&&L_k_logical_nonequal_int,
+		&&L_k_new_1,
+		&&L_k_new_vector_w_external_elements,
+		&&L_k_new_vector_w_inplace_elements,
+		&&L_k_new_dict_w_external_values,
+		&&L_k_new_dict_w_inplace_values,
+		&&L_k_new_struct,
+		&&L_k_return,
+		&&L_k_stop,
+		&&L_k_push_frame_ptr,
+		&&L_k_pop_frame_ptr,
+		&&L_k_push_inplace_value,
+		&&L_k_push_external_value,
+		&&L_k_popn,
+		&&L_k_branch_false_bool,
+		&&L_k_branch_true_bool,
+		&&L_k_branch_zero_int,
+		&&L_k_branch_notzero_int,
+		&&L_k_branch_smaller_int,
+		&&L_k_branch_smaller_or_equal_int,
+		&&L_k_branch_equal_int,
+		&&L_k_branch_notequal_int,
+		&&L_k_increment_branch_smaller_int,
+		&&L_k_increment_branch_smaller_or_equal_int,
+		&&L_k_branch_always
+	};
+	static_assert(sizeof(k_dispatch_table) / sizeof(k_dispatch_table[0]) == k_bc_opcode_count, "");
 
-				//	Cannot store via register, we have not yet executed k_pop_frame_ptr that restores our frame.
-				if(function_def._return_is_ext){
-					stack.replace_external_value(result_reg_pos, result.second);
-				}
-				else{
-					stack.replace_inplace_value(result_reg_pos, result.second);
-				}
-			}
-		}
+	if(vm_ptr == nullptr){
+		*dispatch_table_out = k_dispatch_table;
+		return { false, bc_value_t::make_undefined() };
 	}
-}
-
 
+	interpreter_t& vm = *vm_ptr;
+	const auto& instructions = vm._stack._current_frame_ptr->_instructions;
+#else
 std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const std::vector<bc_instruction_t>& instructions){
+	const native_stack_guard_t native_stack_guard(vm._stack);
+#endif
 	QUARK_ASSERT(vm.check_invariant());
 	QUARK_ASSERT(instructions.empty() == true || (instructions.back()._opcode == bc_opcode::k_return || instructions.back()._opcode == bc_opcode::k_stop));
 
@@ -2822,29 +3032,38 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 //	QUARK_TRACE_SS("STACK:  " << json_to_pretty_string(stack.stack_to_json()));
 
 	int pc = 0;
+#if BC_OPCODE_HISTOGRAM
+	bc_opcode prev_opcode = bc_opcode::k_nop;
+#endif
+#if BC_THREADED_DISPATCH
+	const bc_threaded_instruction_t* code = frame_ptr->_threaded_instructions.data();
+	std::vector<bc_return_address_t> return_addresses;
+
+	QUARK_ASSERT(instructions.empty() == false);
+	bc_instruction_t i = code[pc]._instruction;
+	BC_CHECK_NEXT();
+	goto *code[pc]._handler;
+	{
+		{
+#else
 	while(true){
-		QUARK_ASSERT(pc >= 0);
 		QUARK_ASSERT(pc < instructions.size());
 		const auto i = instructions[pc];
-
-		QUARK_ASSERT(vm.check_invariant());
-		QUARK_ASSERT(i.check_invariant());
-
-		QUARK_ASSERT(frame_ptr == stack._current_frame_ptr);
-		QUARK_ASSERT(regs == stack._current_frame_entry_ptr);
-
+		BC_CHECK_NEXT();
 
 		const auto opcode = i._opcode;
 		switch(opcode){
+#endif
 
-		case bc_opcode::k_nop:
-			break;
+
+		BC_CASE(k_nop)
+			BC_NEXT();
 
 
 		//////////////////////////////////////////		ACCESS GLOBALS
 
 
-		case bc_opcode::k_load_global_external_value: {
+		BC_CASE(k_load_global_external_value) {
 			QUARK_ASSERT(stack.check_reg__external_value(i._a));
 			QUARK_ASSERT(stack.check_global_access_obj(i._b));
 
@@ -2852,17 +3071,17 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto& new_value_pod = globals[i._b];
 			regs[i._a] = new_value_pod;
 			new_value_pod._external->_rc++;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_load_global_inplace_value: {
+		BC_CASE(k_load_global_inplace_value) {
 			QUARK_ASSERT(stack.check_reg__inplace_value(i._a));
 
 			regs[i._a] = globals[i._b];
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_store_global_external_value: {
+		BC_CASE(k_store_global_external_value) {
 			QUARK_ASSERT(stack.check_global_access_obj(i._a));
 			QUARK_ASSERT(stack.check_reg__external_value(i._b));
 
@@ -2870,28 +3089,28 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto& new_value_pod = regs[i._b];
 			globals[i._a] = new_value_pod;
 			new_value_pod._external->_rc++;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_store_global_inplace_value: {
+		BC_CASE(k_store_global_inplace_value) {
 			QUARK_ASSERT(stack.check_global_access_intern(i._a));
 			QUARK_ASSERT(stack.check_reg__inplace_value(i._b));
 
 			globals[i._a] = regs[i._b];
-			break;
+			BC_NEXT();
 		}
 
 
 		//////////////////////////////////////////		ACCESS LOCALS
 
 
-		case bc_opcode::k_copy_reg_inplace_value: {
+		BC_CASE(k_copy_reg_inplace_value) {
 			QUARK_ASSERT(stack.check_reg__inplace_value(i._a));
 			QUARK_ASSERT(stack.check_reg__inplace_value(i._b));
 
 			regs[i._a] = regs[i._b];
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_copy_reg_external_value: {
+		BC_CASE(k_copy_reg_external_value) {
 			QUARK_ASSERT(stack.check_reg__external_value(i._a));
 			QUARK_ASSERT(stack.check_reg__external_value(i._b));
 
@@ -2899,30 +3118,57 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto& new_value_pod = regs[i._b];
 			regs[i._a] = new_value_pod;
 			new_value_pod._external->_rc++;
-			break;
+			BC_NEXT();
 		}
 
 
 		//////////////////////////////////////////		STACK
 
 
-		case bc_opcode::k_return: {
+		BC_CASE(k_return) {
 			bool is_ext = frame_ptr->_exts[i._a];
 			QUARK_ASSERT(
 				(is_ext && stack.check_reg__external_value(i._a))
 				|| (!is_ext && stack.check_reg__inplace_value(i._a))
 			);
 
+#if BC_THREADED_DISPATCH
+			if(return_addresses.empty() == false){
+				const auto return_address = return_addresses.back();
+				return_addresses.pop_back();
+				QUARK_ASSERT(is_ext == return_address._callee->_return_is_ext);
+				return_from_inlined_call(stack, *frame_ptr, return_address, &regs[i._a]);
+
+				frame_ptr = stack._current_frame_ptr;
+				regs = stack._current_frame_entry_ptr;
+				code = return_address._code;
+				pc = return_address._pc;
+				BC_NEXT();
+			}
+#endif
 			return { true, bc_value_t(frame_ptr->_symbols[i._a].second._value_type, regs[i._a], is_ext) };
 		}
 
-		case bc_opcode::k_stop: {
+		BC_CASE(k_stop) {
+#if BC_THREADED_DISPATCH
+			if(return_addresses.empty() == false){
+				const auto return_address = return_addresses.back();
+				return_addresses.pop_back();
+				return_from_inlined_call(stack, *frame_ptr, return_address, nullptr);
+
+				frame_ptr = stack._current_frame_ptr;
+				regs = stack._current_frame_entry_ptr;
+				code = return_address._code;
+				pc = return_address._pc;
+				BC_NEXT();
+			}
+#endif
 			return { false, bc_value_t::make_undefined() };
 		}
 
-		case bc_opcode::k_push_frame_ptr: {
+		BC_CASE(k_push_frame_ptr) {
 			QUARK_ASSERT(vm.check_invariant());
-			QUARK_ASSERT((stack._stack_size + k_frame_overhead) < stack._allocated_count)
+			QUARK_ASSERT((stack._stack_size + k_frame_overhead) <= stack._allocated_count)
 
 			stack._entries[stack._stack_size + 0]._inplace.int64_value = static_cast<int64_t>(stack._current_frame_entry_ptr - &stack._entries[0]);
 			stack._entries[stack._stack_size + 1]._inplace._frame_ptr = frame_ptr;
@@ -2932,10 +3178,10 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			stack._debug_types.push_back(type_t::make_void());
 #endif
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_pop_frame_ptr: {
+		BC_CASE(k_pop_frame_ptr) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack._stack_size >= k_frame_overhead);
 
@@ -2957,10 +3203,10 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			QUARK_ASSERT(frame_ptr == stack._current_frame_ptr);
 			QUARK_ASSERT(regs == stack._current_frame_entry_ptr);
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_push_inplace_value: {
+		BC_CASE(k_push_inplace_value) {
 			QUARK_ASSERT(stack.check_reg__inplace_value(i._a));
 #if DEBUG
 			const auto debug_type = stack._debug_types[stack.get_current_frame_start() + i._a];
@@ -2972,9 +3218,9 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			stack._debug_types.push_back(debug_type);
 #endif
 			QUARK_ASSERT(stack.check_invariant());
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_push_external_value: {
+		BC_CASE(k_push_external_value) {
 			QUARK_ASSERT(stack.check_reg__external_value(i._a));
 
 #if DEBUG
@@ -2988,10 +3234,10 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 #if DEBUG
 			stack._debug_types.push_back(debug_type);
 #endif
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_popn: {
+		BC_CASE(k_popn) {
 			QUARK_ASSERT(vm.check_invariant());
 
 			const uint32_t n = i._a;
@@ -3019,61 +3265,97 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			stack._stack_size -= n;
 
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
 
 		//////////////////////////////////////////		BRANCHING
 
 
-		case bc_opcode::k_branch_false_bool: {
+		BC_CASE(k_branch_false_bool) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = regs[i._a]._inplace.bool_value ? pc : pc + i._b - 1;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_branch_true_bool: {
+		BC_CASE(k_branch_true_bool) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = regs[i._a]._inplace.bool_value ? pc + i._b - 1: pc;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_branch_zero_int: {
+		BC_CASE(k_branch_zero_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = regs[i._a]._inplace.int64_value == 0 ? pc + i._b - 1 : pc;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_branch_notzero_int: {
+		BC_CASE(k_branch_notzero_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = regs[i._a]._inplace.int64_value == 0 ? pc : pc + i._b - 1;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_branch_smaller_int: {
+		BC_CASE(k_branch_smaller_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = regs[i._a]._inplace.int64_value < regs[i._b]._inplace.int64_value ? pc + i._c - 1 : pc;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_branch_smaller_or_equal_int: {
+		BC_CASE(k_branch_smaller_or_equal_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = regs[i._a]._inplace.int64_value <= regs[i._b]._inplace.int64_value ? pc + i._c - 1 : pc;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_branch_always: {
+		BC_CASE(k_branch_equal_int) {
+			QUARK_ASSERT(stack.check_reg_int(i._a));
+			QUARK_ASSERT(stack.check_reg_int(i._b));
+
+			//	Notice that pc will be incremented too, hence the - 1.
+			pc = regs[i._a]._inplace.int64_value == regs[i._b]._inplace.int64_value ? pc + i._c - 1 : pc;
+			BC_NEXT();
+		}
+		BC_CASE(k_branch_notequal_int) {
+			QUARK_ASSERT(stack.check_reg_int(i._a));
+			QUARK_ASSERT(stack.check_reg_int(i._b));
+
+			//	Notice that pc will be incremented too, hence the - 1.
+			pc = regs[i._a]._inplace.int64_value != regs[i._b]._inplace.int64_value ? pc + i._c - 1 : pc;
+			BC_NEXT();
+		}
+		BC_CASE(k_increment_branch_smaller_int) {
+			QUARK_ASSERT(stack.check_reg_int(i._a));
+			QUARK_ASSERT(stack.check_reg_int(i._b));
+
+			const auto counter = ++regs[i._a]._inplace.int64_value;
+
+			//	Notice that pc will be incremented too, hence the - 1.
+			pc = counter < regs[i._b]._inplace.int64_value ? pc + i._c - 1 : pc;
+			BC_NEXT();
+		}
+		BC_CASE(k_increment_branch_smaller_or_equal_int) {
+			QUARK_ASSERT(stack.check_reg_int(i._a));
+			QUARK_ASSERT(stack.check_reg_int(i._b));
+
+			const auto counter = ++regs[i._a]._inplace.int64_value;
+
+			//	Notice that pc will be incremented too, hence the - 1.
+			pc = counter <= regs[i._b]._inplace.int64_value ? pc + i._c - 1 : pc;
+			BC_NEXT();
+		}
+		BC_CASE(k_branch_always) {
 			//	Notice that pc will be incremented too, hence the - 1.
 			pc = pc + i._a - 1;
-			break;
+			BC_NEXT();
 		}
 
 
@@ -3081,12 +3363,12 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 
 
 		//??? Make obj/intern version.
-		case bc_opcode::k_get_struct_member: {
+		BC_CASE(k_get_struct_member) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_any(i._a));
 			QUARK_ASSERT(stack.check_reg_struct(i._b));
 
-			const auto& value_pod = regs[i._b]._external->_struct_members[i._c]._pod;
+			const auto& value_pod = regs[i._b]._external->get_struct_members()[i._c]._pod;
 			bool ext = frame_ptr->_exts[i._a];
 			if(ext){
 				release_pod_external(regs[i._a]);
@@ -3094,16 +3376,16 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			}
 			regs[i._a] = value_pod;
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_lookup_element_string: {
+		BC_CASE(k_lookup_element_string) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_string(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
-			const auto& s = regs[i._b]._external->_string;
+			const auto& s = regs[i._b]._external->get_string();
 			const auto lookup_index = regs[i._c]._inplace.int64_value;
 			if(lookup_index < 0 || lookup_index >= s.size()){
 				quark::throw_runtime_error("Lookup in string: out of bounds.");
@@ -3112,11 +3394,11 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				regs[i._a]._inplace.int64_value = s[lookup_index];
 			}
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
 		//	??? Simple JSON-values should not require ext. null, int, bool, empty object, empty array.
-		case bc_opcode::k_lookup_element_json: {
+		BC_CASE(k_lookup_element_json) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_json(i._a));
 			QUARK_ASSERT(stack.check_reg_json(i._b));
@@ -3124,12 +3406,12 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			// reg c points to different types depending on the runtime-type of the json.
 			QUARK_ASSERT(stack.check_reg_any(i._c));
 
-			const auto& parent_json = regs[i._b]._external->_json;
+			const auto& parent_json = regs[i._b]._external->get_json();
 
 			if(parent_json->is_object()){
 				QUARK_ASSERT(stack.check_reg_string(i._c));
 
-				const auto& lookup_key = regs[i._c]._external->_string;
+				const auto& lookup_key = regs[i._c]._external->get_string();
 
 				//	get_object_element() throws if key can't be found.
 				const auto& value = parent_json->get_object_element(lookup_key);
@@ -3164,16 +3446,16 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				quark::throw_runtime_error("Lookup using [] on json only works on objects and arrays.");
 			}
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_lookup_element_vector_w_external_elements: {
+		BC_CASE(k_lookup_element_vector_w_external_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg__external_value(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
-			const auto& vec = regs[i._b]._external->_vector_w_external_elements;
+			const auto& vec = regs[i._b]._external->get_vector_w_external_elements();
 			const auto lookup_index = regs[i._c]._inplace.int64_value;
 			if(lookup_index < 0 || lookup_index >= vec.size()){
 				quark::throw_runtime_error("Lookup in vector: out of bounds.");
@@ -3185,15 +3467,15 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				regs[i._a]._external = handle._external;
 			}
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_lookup_element_vector_w_inplace_elements: {
+		BC_CASE(k_lookup_element_vector_w_inplace_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
-			const auto& vec = regs[i._b]._external->_vector_w_inplace_elements;
+			const auto& vec = regs[i._b]._external->get_vector_w_inplace_elements();
 			const auto lookup_index = regs[i._c]._inplace.int64_value;
 			if(lookup_index < 0 || lookup_index >= vec.size()){
 				quark::throw_runtime_error("Lookup in vector: out of bounds.");
@@ -3202,16 +3484,16 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				regs[i._a]._inplace = vec[lookup_index];
 			}
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_lookup_element_dict_w_external_values: {
+		BC_CASE(k_lookup_element_dict_w_external_values) {
 			QUARK_ASSERT(stack.check_reg__external_value(i._a));
 			QUARK_ASSERT(stack.check_reg_dict_w_external_values(i._b));
 			QUARK_ASSERT(stack.check_reg_string(i._c));
 
-			const auto& entries = regs[i._b]._external->_dict_w_external_values;
-			const auto& lookup_key = regs[i._c]._external->_string;
+			const auto& entries = regs[i._b]._external->get_dict_w_external_values();
+			const auto& lookup_key = regs[i._c]._external->get_string();
 			const auto found_ptr = entries.find(lookup_key);
 			if(found_ptr == nullptr){
 				quark::throw_runtime_error("Lookup in dict: key not found.");
@@ -3222,15 +3504,15 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				release_pod_external(regs[i._a]);
 				regs[i._a]._external = handle._external;
 			}
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_lookup_element_dict_w_inplace_values: {
+		BC_CASE(k_lookup_element_dict_w_inplace_values) {
 			QUARK_ASSERT(stack.check_reg_any(i._a));
 			QUARK_ASSERT(stack.check_reg_dict_w_inplace_values(i._b));
 			QUARK_ASSERT(stack.check_reg_string(i._c));
 
-			const auto& entries = regs[i._b]._external->_dict_w_inplace_values;
-			const auto& lookup_key = regs[i._c]._external->_string;
+			const auto& entries = regs[i._b]._external->get_dict_w_inplace_values();
+			const auto& lookup_key = regs[i._c]._external->get_string();
 			const auto found_ptr = entries.find(lookup_key);
 			if(found_ptr == nullptr){
 				quark::throw_runtime_error("Lookup in dict: key not found.");
@@ -3238,71 +3520,71 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			else{
 				regs[i._a]._inplace = *found_ptr;
 			}
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_get_size_vector_w_external_elements: {
+		BC_CASE(k_get_size_vector_w_external_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._b));
 			QUARK_ASSERT(i._c == 0);
 
-			regs[i._a]._inplace.int64_value = regs[i._b]._external->_vector_w_external_elements.size();
+			regs[i._a]._inplace.int64_value = regs[i._b]._external->get_vector_w_external_elements().size();
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_get_size_vector_w_inplace_elements: {
+		BC_CASE(k_get_size_vector_w_inplace_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._b));
 			QUARK_ASSERT(i._c == 0);
 
-			regs[i._a]._inplace.int64_value = regs[i._b]._external->_vector_w_inplace_elements.size();
+			regs[i._a]._inplace.int64_value = regs[i._b]._external->get_vector_w_inplace_elements().size();
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_get_size_dict_w_external_values: {
+		BC_CASE(k_get_size_dict_w_external_values) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_dict_w_external_values(i._b));
 			QUARK_ASSERT(i._c == 0);
 
-			regs[i._a]._inplace.int64_value = regs[i._b]._external->_dict_w_external_values.size();
+			regs[i._a]._inplace.int64_value = regs[i._b]._external->get_dict_w_external_values().size();
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_get_size_dict_w_inplace_values: {
+		BC_CASE(k_get_size_dict_w_inplace_values) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_dict_w_inplace_values(i._b));
 			QUARK_ASSERT(i._c == 0);
 
-			regs[i._a]._inplace.int64_value = regs[i._b]._external->_dict_w_inplace_values.size();
+			regs[i._a]._inplace.int64_value = regs[i._b]._external->get_dict_w_inplace_values().size();
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_get_size_string: {
+		BC_CASE(k_get_size_string) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_string(i._b));
 			QUARK_ASSERT(i._c == 0);
 
-			regs[i._a]._inplace.int64_value = regs[i._b]._external->_string.size();
+			regs[i._a]._inplace.int64_value = regs[i._b]._external->get_string().size();
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_get_size_jsonvalue: {
+		BC_CASE(k_get_size_jsonvalue) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_json(i._b));
 			QUARK_ASSERT(i._c == 0);
 
-			const auto& json = *regs[i._b]._external->_json;
+			const auto& json = *regs[i._b]._external->get_json();
 			if(json.is_object()){
 				regs[i._a]._inplace.int64_value = json.get_object_size();
 			}
@@ -3316,11 +3598,11 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				quark::throw_runtime_error("Calling size() on unsupported type of value.");
 			}
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_pushback_vector_w_external_elements: {
+		BC_CASE(k_pushback_vector_w_external_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._b));
@@ -3329,14 +3611,14 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto peek = peek2(types, frame_ptr->_symbols[i._a].second._value_type);
 			const auto& element_type = peek.get_vector_element_type(types);
 
-			auto elements2 = regs[i._b]._external->_vector_w_external_elements.push_back(bc_external_handle_t(regs[i._c]._external));
+			auto elements2 = regs[i._b]._external->get_vector_w_external_elements().push_back(bc_external_handle_t(regs[i._c]._external));
 			//??? always allocates a new bc_external_value_t!
 			const auto vec2 = make_vector(types, element_type, elements2);
 			vm._stack.write_register__external_value(i._a, vec2);
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_pushback_vector_w_inplace_elements: {
+		BC_CASE(k_pushback_vector_w_inplace_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._b));
@@ -3347,20 +3629,20 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 
 			//??? optimize - bypass bc_value_t
 			//??? always allocates a new bc_external_value_t!
-			auto elements2 = regs[i._b]._external->_vector_w_inplace_elements.push_back(regs[i._c]._inplace);
+			auto elements2 = regs[i._b]._external->get_vector_w_inplace_elements().push_back(regs[i._c]._inplace);
 			const auto vec = make_vector(types, element_type, elements2);
 			vm._stack.write_register__external_value(i._a, vec);
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_pushback_string: {
+		BC_CASE(k_pushback_string) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_string(i._a));
 			QUARK_ASSERT(stack.check_reg_string(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
-			std::string str2 = regs[i._b]._external->_string;
+			std::string str2 = regs[i._b]._external->get_string();
 			const auto ch = regs[i._c]._inplace.int64_value;
 			str2.push_back(static_cast<char>(ch));
 
@@ -3369,26 +3651,27 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto str3 = bc_value_t::make_string(str2);
 			vm._stack.write_register__external_value(i._a, str3);
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_call: {
+		//	k_call and k_call_global only differ in where they read the function value.
+		BC_CASE(k_call) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_function(i._b));
 
-			do_call(vm, i);
-
-			frame_ptr = stack._current_frame_ptr;
-			regs = stack._current_frame_entry_ptr;
-
-			QUARK_ASSERT(frame_ptr == stack._current_frame_ptr);
-			QUARK_ASSERT(regs == stack._current_frame_entry_ptr);
+			const auto& callee = resolve_callee(vm, regs[i._b]._external);
+			BC_CALL(callee);
+		}
+		BC_CASE(k_call_global) {
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			QUARK_ASSERT(stack.check_global_access_obj(i._b));
+
+			const auto& callee = resolve_callee(vm, globals[i._b]._external);
+			BC_CALL(callee);
 		}
 
-		case bc_opcode::k_new_1: {
+		BC_CASE(k_new_1) {
 			QUARK_ASSERT(stack.check_reg(i._a));
 
 			const auto dest_reg = i._a;
@@ -3397,10 +3680,10 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto& target_type = lookup_full_type(vm, target_itype);
 			QUARK_ASSERT(peek2(types, target_type).is_vector() == false && peek2(types, target_type).is_dict() == false && peek2(types, target_type).is_struct() == false);
 			execute_new_1(vm, dest_reg, target_itype, source_itype);
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_new_vector_w_external_elements: {
+		BC_CASE(k_new_vector_w_external_elements) {
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._a));
 			QUARK_ASSERT(i._b >= 0);
 			QUARK_ASSERT(i._c >= 0);
@@ -3413,10 +3696,10 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			QUARK_ASSERT(encode_as_vector_w_inplace_elements(types, vector_type) == false);
 
 			execute_new_vector_obj(vm, dest_reg, target_itype, arg_count);
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_new_vector_w_inplace_elements: {
+		BC_CASE(k_new_vector_w_inplace_elements) {
 			QUARK_ASSERT(vm.check_invariant());
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._a));
 			QUARK_ASSERT(i._b == 0);
@@ -3440,10 +3723,10 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			vm._stack.write_register__external_value(dest_reg, result);
 
 			QUARK_ASSERT(vm.check_invariant());
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_new_dict_w_external_values: {
+		BC_CASE(k_new_dict_w_external_values) {
 			const auto dest_reg = i._a;
 			const auto target_itype = i._b;
 			const auto arg_count = i._c;
@@ -3451,32 +3734,32 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			const auto peek = peek2(types, target_type);
 			QUARK_ASSERT(peek.is_dict());
 			execute_new_dict_obj(vm, dest_reg, target_itype, arg_count);
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_new_dict_w_inplace_values: {
+		BC_CASE(k_new_dict_w_inplace_values) {
 			const auto dest_reg = i._a;
 			const auto target_itype = i._b;
 			const auto arg_count = i._c;
 			const auto& target_type = lookup_full_type(vm, target_itype);
 			QUARK_ASSERT(peek2(types, target_type).is_dict());
 			execute_new_dict_pod64(vm, dest_reg, target_itype, arg_count);
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_new_struct: {
+		BC_CASE(k_new_struct) {
 			const auto dest_reg = i._a;
 			const auto target_itype = i._b;
 			const auto arg_count = i._c;
 			const auto& target_type = lookup_full_type(vm, target_itype);
 			QUARK_ASSERT(peek2(types, target_type).is_struct());
 			execute_new_struct(vm, dest_reg, target_itype, arg_count);
-			break;
+			BC_NEXT();
 		}
 
 
 		//////////////////////////////		COMPARISON
 
 
-		case bc_opcode::k_comparison_smaller_or_equal: {
+		BC_CASE(k_comparison_smaller_or_equal) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_any(i._b));
 			QUARK_ASSERT(stack.check_reg_any(i._c));
@@ -3489,18 +3772,18 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			long diff = bc_compare_value_true_deep(types, left, right, type);
 
 			regs[i._a]._inplace.bool_value = diff <= 0;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_comparison_smaller_or_equal_int: {
+		BC_CASE(k_comparison_smaller_or_equal_int) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.int64_value <= regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_comparison_smaller: {
+		BC_CASE(k_comparison_smaller) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_any(i._b));
 			QUARK_ASSERT(stack.check_reg_any(i._c));
@@ -3512,17 +3795,17 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			long diff = bc_compare_value_true_deep(types, left, right, type);
 
 			regs[i._a]._inplace.bool_value = diff < 0;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_comparison_smaller_int:
+		BC_CASE(k_comparison_smaller_int)
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.int64_value < regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
 
-		case bc_opcode::k_logical_equal: {
+		BC_CASE(k_logical_equal) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_any(i._b));
 			QUARK_ASSERT(stack.check_reg_any(i._c));
@@ -3534,18 +3817,18 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			long diff = bc_compare_value_true_deep(types, left, right, type);
 
 			regs[i._a]._inplace.bool_value = diff == 0;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_logical_equal_int: {
+		BC_CASE(k_logical_equal_int) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.int64_value == regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_logical_nonequal: {
+		BC_CASE(k_logical_nonequal) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_any(i._b));
 			QUARK_ASSERT(stack.check_reg_any(i._c));
@@ -3557,15 +3840,15 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			long diff = bc_compare_value_true_deep(types, left, right, type);
 
 			regs[i._a]._inplace.bool_value = diff != 0;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_logical_nonequal_int: {
+		BC_CASE(k_logical_nonequal_int) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.int64_value != regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
 		}
 
 
@@ -3573,46 +3856,53 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 
 
 		//??? Replace by a | b opcode.
-		case bc_opcode::k_add_bool: {
+		BC_CASE(k_add_bool) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_bool(i._b));
 			QUARK_ASSERT(stack.check_reg_bool(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.bool_value + regs[i._c]._inplace.bool_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_add_int: {
+		BC_CASE(k_add_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.int64_value = regs[i._b]._inplace.int64_value + regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
+		}
+		BC_CASE(k_add_int_imm) {
+			QUARK_ASSERT(stack.check_reg_int(i._a));
+			QUARK_ASSERT(stack.check_reg_int(i._b));
+
+			regs[i._a]._inplace.int64_value = regs[i._b]._inplace.int64_value + i._c;
+			BC_NEXT();
 		}
-		case bc_opcode::k_add_double: {
+		BC_CASE(k_add_double) {
 			QUARK_ASSERT(stack.check_reg_double(i._a));
 			QUARK_ASSERT(stack.check_reg_double(i._b));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
 
 			regs[i._a]._inplace.double_value = regs[i._b]._inplace.double_value + regs[i._c]._inplace.double_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_concat_strings: {
+		BC_CASE(k_concat_strings) {
 			QUARK_ASSERT(stack.check_reg_string(i._a));
 			QUARK_ASSERT(stack.check_reg_string(i._b));
 			QUARK_ASSERT(stack.check_reg_string(i._c));
 
 			//	??? No need to create bc_value_t here.
-			const auto s = regs[i._b]._external->_string + regs[i._c]._external->_string;
+			const auto s = regs[i._b]._external->get_string() + regs[i._c]._external->get_string();
 			const auto value = bc_value_t::make_string(s);
 			auto prev_copy = regs[i._a];
 			value._pod._external->_rc++;
 			regs[i._a] = value._pod;
 			release_pod_external(prev_copy);
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_concat_vectors_w_external_elements: {
+		BC_CASE(k_concat_vectors_w_external_elements) {
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._b));
 			QUARK_ASSERT(stack.check_reg_vector_w_external_elements(i._c));
@@ -3623,17 +3913,17 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			QUARK_ASSERT(encode_as_vector_w_inplace_elements(types, vector_type) == false);
 
 			//	Copy left into new vector.
-			immer::vector<bc_external_handle_t> elements2 = regs[i._b]._external->_vector_w_external_elements;
+			immer::vector<bc_external_handle_t> elements2 = regs[i._b]._external->get_vector_w_external_elements();
 
-			const auto& right_elements = regs[i._c]._external->_vector_w_external_elements;
+			const auto& right_elements = regs[i._c]._external->get_vector_w_external_elements();
 			for(const auto& e: right_elements){
 				elements2 = elements2.push_back(e);
 			}
 			const auto& value2 = make_vector(types, element_type, elements2);
 			stack.write_register__external_value(i._a, value2);
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_concat_vectors_w_inplace_elements: {
+		BC_CASE(k_concat_vectors_w_inplace_elements) {
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._a));
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._b));
 			QUARK_ASSERT(stack.check_reg_vector_w_inplace_elements(i._c));
@@ -3644,50 +3934,50 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 			QUARK_ASSERT(encode_as_vector_w_inplace_elements(types, vector_type) == true);
 
 			//	Copy left into new vector.
-			auto elements2 = regs[i._b]._external->_vector_w_inplace_elements;
+			auto elements2 = regs[i._b]._external->get_vector_w_inplace_elements();
 
-			const auto& right_elements = regs[i._c]._external->_vector_w_inplace_elements;
+			const auto& right_elements = regs[i._c]._external->get_vector_w_inplace_elements();
 			for(const auto& e: right_elements){
 				elements2 = elements2.push_back(e);
 			}
 			const auto& value2 = make_vector(types, element_type, elements2);
 			stack.write_register__external_value(i._a, value2);
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_subtract_double: {
+		BC_CASE(k_subtract_double) {
 			QUARK_ASSERT(stack.check_reg_double(i._a));
 			QUARK_ASSERT(stack.check_reg_double(i._b));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
 
 			regs[i._a]._inplace.double_value = regs[i._b]._inplace.double_value - regs[i._c]._inplace.double_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_subtract_int: {
+		BC_CASE(k_subtract_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.int64_value = regs[i._b]._inplace.int64_value - regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_multiply_double: {
+		BC_CASE(k_multiply_double) {
 			QUARK_ASSERT(stack.check_reg_double(i._a));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
 
 			regs[i._a]._inplace.double_value = regs[i._b]._inplace.double_value * regs[i._c]._inplace.double_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_multiply_int: {
+		BC_CASE(k_multiply_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.int64_value = regs[i._b]._inplace.int64_value * regs[i._c]._inplace.int64_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_divide_double: {
+		BC_CASE(k_divide_double) {
 			QUARK_ASSERT(stack.check_reg_double(i._a));
 			QUARK_ASSERT(stack.check_reg_double(i._b));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
@@ -3697,9 +3987,9 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				quark::throw_runtime_error("EEE_DIVIDE_BY_ZERO");
 			}
 			regs[i._a]._inplace.double_value = regs[i._b]._inplace.double_value / right;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_divide_int: {
+		BC_CASE(k_divide_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
@@ -3709,9 +3999,9 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				quark::throw_runtime_error("EEE_DIVIDE_BY_ZERO");
 			}
 			regs[i._a]._inplace.int64_value = regs[i._b]._inplace.int64_value / right;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_remainder_int: {
+		BC_CASE(k_remainder_int) {
 			QUARK_ASSERT(stack.check_reg_int(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
@@ -3721,73 +4011,108 @@ std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const
 				quark::throw_runtime_error("EEE_DIVIDE_BY_ZERO");
 			}
 			regs[i._a]._inplace.int64_value = regs[i._b]._inplace.int64_value % right;
-			break;
+			BC_NEXT();
 		}
 
 
-		case bc_opcode::k_logical_and_bool: {
+		BC_CASE(k_logical_and_bool) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_bool(i._b));
 			QUARK_ASSERT(stack.check_reg_bool(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.bool_value  && regs[i._c]._inplace.bool_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_logical_and_int: {
+		BC_CASE(k_logical_and_int) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.bool_value = (regs[i._b]._inplace.int64_value != 0) && (regs[i._c]._inplace.int64_value != 0);
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_logical_and_double: {
+		BC_CASE(k_logical_and_double) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_double(i._b));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
 
 			regs[i._a]._inplace.bool_value = (regs[i._b]._inplace.double_value != 0) && (regs[i._c]._inplace.double_value != 0);
-			break;
+			BC_NEXT();
 		}
 
-		case bc_opcode::k_logical_or_bool: {
+		BC_CASE(k_logical_or_bool) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_bool(i._b));
 			QUARK_ASSERT(stack.check_reg_bool(i._c));
 
 			regs[i._a]._inplace.bool_value = regs[i._b]._inplace.bool_value || regs[i._c]._inplace.bool_value;
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_logical_or_int: {
+		BC_CASE(k_logical_or_int) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_int(i._b));
 			QUARK_ASSERT(stack.check_reg_int(i._c));
 
 			regs[i._a]._inplace.bool_value = (regs[i._b]._inplace.int64_value != 0) || (regs[i._c]._inplace.int64_value != 0);
-			break;
+			BC_NEXT();
 		}
-		case bc_opcode::k_logical_or_double: {
+		BC_CASE(k_logical_or_double) {
 			QUARK_ASSERT(stack.check_reg_bool(i._a));
 			QUARK_ASSERT(stack.check_reg_double(i._b));
 			QUARK_ASSERT(stack.check_reg_double(i._c));
 
 			regs[i._a]._inplace.bool_value = (regs[i._b]._inplace.double_value != 0.0f) || (regs[i._c]._inplace.double_value != 0.0f);
-			break;
+			BC_NEXT();
 		}
 
 
 		//////////////////////////////		NONE
 
 
-		default:
+		BC_INVALID_OPCODE
 			QUARK_ASSERT(false);
 			quark::throw_exception();
 		}
+#if BC_THREADED_DISPATCH == 0
 		pc++;
+#endif
 	}
 	return { false, bc_value_t::make_undefined() };
 }
 
+#undef BC_CASE
+#undef BC_NEXT
+#undef BC_INVALID_OPCODE
+#undef BC_CHECK_NEXT
+#undef BC_COUNT_OPCODE
+#undef BC_CALL
+#undef BC_AFTER_CALL
+
+#if BC_THREADED_DISPATCH
+
+std::pair<bc_typeid_t, bc_value_t> execute_instructions(interpreter_t& vm, const std::vector<bc_instruction_t>& instructions){
+	QUARK_ASSERT(&instructions == &vm._stack._current_frame_ptr->_instructions);
+
+	const native_stack_guard_t native_stack_guard(vm._stack);
+	return execute_instructions__threaded(&vm, nullptr);
+}
+
+std::vector<bc_threaded_instruction_t> make_threaded_instructions(const std::vector<bc_instruction_t>& instructions){
+	const void* const* dispatch_table = nullptr;
+	execute_instructions__threaded(nullptr, &dispatch_table);
+	QUARK_ASSERT(dispatch_table != nullptr);
+
+	return mapf<bc_threaded_instruction_t>(
+		instructions,
+		[&](const bc_instruction_t& e){
+			QUARK_ASSERT(static_cast<int>(e._opcode) <= static_cast<int>(bc_opcode::k_branch_always));
+			return bc_threaded_instruction_t{ dispatch_table[static_cast<int>(e._opcode)], e };
+		}
+	);
+}
+
+#endif
+
 
 //////////////////////////////////////////		FUNCTIONS
 
@@ -3829,6 +4154,77 @@ std::string opcode_to_string(bc_opcode opcode){
 	return k_opcode_info.at(opcode)._as_text;
 }
 
+json_t opcode_histogram_to_json(const bc_opcode_histogram_t& histogram, int max_rows){
+	QUARK_ASSERT(max_rows >= 0);
+
+	const auto sorted_indexes = [&](const std::vector<uint64_t>& counts){
+		std::vector<int> result;
+		for(int index = 0 ; index < counts.size() ; index++){
+			if(counts[index] > 0){
+				result.push_back(index);
+			}
+		}
+		std::stable_sort(result.begin(), result.end(), [&](int a, int b){ return counts[a] > counts[b]; });
+		if(result.size() > max_rows){
+			result.resize(max_rows);
+		}
+		return result;
+	};
+
+	std::vector<json_t> opcodes;
+	for(const auto index: sorted_indexes(histogram._counts)){
+		opcodes.push_back(json_t::make_array({
+			opcode_to_string(static_cast<bc_opcode>(index)),
+			static_cast<double>(histogram._counts[index])
+		}));
+	}
+
+	std::vector<json_t> pairs;
+	for(const auto index: sorted_indexes(histogram._pair_counts)){
+		const auto prev = static_cast<bc_opcode>(index / k_bc_opcode_count);
+		const auto opcode = static_cast<bc_opcode>(index % k_bc_opcode_count);
+		pairs.push_back(json_t::make_array({
+			opcode_to_string(prev) + " -> " + opcode_to_string(opcode),
+			static_cast<double>(histogram._pair_counts[index])
+		}));
+	}
+
+	return json_t::make_object({
+		{ "opcodes", json_t::make_array(opcodes) },
+		{ "pairs", json_t::make_array(pairs) }
+	});
+}
+
+QUARK_TEST("", "opcode_histogram_to_json()", "", ""){
+	bc_opcode_histogram_t histogram;
+	count_opcode(histogram, bc_opcode::k_nop, bc_opcode::k_comparison_smaller_int);
+	count_opcode(histogram, bc_opcode::k_comparison_smaller_int, bc_opcode::k_branch_false_bool);
+	count_opcode(histogram, bc_opcode::k_branch_false_bool, bc_opcode::k_add_int);
+	count_opcode(histogram, bc_opcode::k_add_int, bc_opcode::k_comparison_smaller_int);
+	count_opcode(histogram, bc_opcode::k_comparison_smaller_int, bc_opcode::k_branch_false_bool);
+
+	ut_verify(
+		QUARK_POS,
+		opcode_histogram_to_json(histogram, 2),
+		json_t::make_object({
+			{
+				"opcodes",
+				json_t::make_array({
+					json_t::make_array({ "comparison_smaller_int", 2.0 }),
+					json_t::make_array({ "branch_false_bool", 2.0 })
+				})
+			},
+			{
+				"pairs",
+				json_t::make_array({
+					json_t::make_array({ "comparison_smaller_int -> branch_false_bool", 2.0 }),
+					json_t::make_array({ "nop -> comparison_smaller_int", 1.0 })
+				})
+			}
+		})
+	);
+}
+
 json_t interpreter_to_json(const interpreter_t& vm){
 	std::vector<json_t> callstack;
 	QUARK_ASSERT(vm.check_invariant());
@@ -31,6 +31,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <atomic>
 #include <chrono>
 
@@ -38,13 +39,45 @@
 
 namespace floyd {
 
+
+////////////////////////////////	CONFIGURATION
+
+
+/*
+	How execute_instructions() dispatches instructions:
+	0: a switch() per instruction, each call to a Floyd function recurses into execute_instructions().
+	1: direct-threaded code: each frame's instructions are translated to the addresses of their handlers and
+	execute_instructions() jumps straight between them using computed goto. Calls to Floyd functions run in the
+	same loop, using an explicit stack of return addresses. Needs GCC or Clang.
+*/
+#ifndef BC_THREADED_DISPATCH
+	#if defined(__GNUC__)
+		#define BC_THREADED_DISPATCH 1
+	#else
+		#define BC_THREADED_DISPATCH 0
+	#endif
+#endif
+
+/*
+	1: execute_instructions() counts every instruction it executes, and every pair of consecutive instructions, in
+	interpreter_t::_opcode_histogram. This is what decides which sequences the bytecode generator fuses into
+	superinstructions. Slows down the interpreter.
+*/
+#ifndef BC_OPCODE_HISTOGRAM
+	#define BC_OPCODE_HISTOGRAM 0
+#endif
+
+
+////////////////////////////////	FORWARD DECL
+
+
 struct type_t;
 struct types_t;
 
 struct interpreter_t;
 struct bc_program_t;
 struct bc_static_frame_t;
-struct runtime_handler_i;
+struct bc_runtime_handler_i;
 
 struct bc_value_t;
 union bc_pod_value_t;
@@ -55,6 +88,8 @@ struct bc_external_handle_t;
 typedef bc_value_t (*BC_NATIVE_FUNCTION_PTR)(interpreter_t& vm, const bc_value_t args[], int arg_count);
 typedef int16_t bc_typeid_t;
 
+const int k_no_function_index = -1;
+
 
 //////////////////////////////////////		bc_inplace_value_t
 
@@ -209,9 +244,10 @@ struct bc_value_t {
 
 
 	//////////////////////////////////////		function
-	public: static bc_value_t make_function_value(const type_t& function_type, const function_id_t& function_id);
+	//	function_index: see bc_function_ref_t::_function_index.
+	public: static bc_value_t make_function_value(const type_t& function_type, const function_id_t& function_id, int function_index = k_no_function_index);
 	public: function_id_t get_function_value() const;
-	private: explicit bc_value_t(const type_t& function_type, const function_id_t& function_id, bool dummy);
+	private: explicit bc_value_t(const type_t& function_type, const function_id_t& function_id, int function_index, bool dummy);
 
 
 	//	Bumps RC if needed.
@@ -268,29 +304,56 @@ bool check_external_deep(const types_t& types, const type_t& type, const bc_exte
 	This object contains the internals of values too big to be stored inplace inside bc_value_t / bc_pod_value_t.
 	The bc_external_value_t:s are allocated on the heap and are reference counted.
 
-	TODO: Right now wastes resouces by containing *all* types of external values! Should use std::variant.
+	bc_external_value_t is only the header. Each kind of external value is a bc_external_payload_t<> that stores
+	its payload right after the header, in the same allocation, so a string doesn't pay for a dict etc.
+	Read the payload using the get_*() functions, they assert that the value has that kind.
+	Free using delete_external(), it knows the kind's real type.
 */
 
-struct bc_external_value_t {
-	public: bc_external_value_t(const std::string& s);
-	public: bc_external_value_t(const std::shared_ptr<json_t>& s);
-	public: bc_external_value_t(const type_t& type, const function_id_t& function_id);
+enum class bc_external_kind: uint8_t {
+	k_string,
+	k_json,
+	k_typeid,
+	k_struct,
+	k_vector_w_external_elements,
+	k_vector_w_inplace_elements,
+	k_dict_w_external_values,
+	k_dict_w_inplace_values,
+	k_function
+};
 
-	public: bc_external_value_t(const type_t& s);
-	public: bc_external_value_t(const type_t& type, const std::vector<bc_value_t>& s, bool struct_tag);
-	public: bc_external_value_t(const type_t& type, const immer::vector<bc_external_handle_t>& s);
-	public: bc_external_value_t(const type_t& type, const immer::vector<bc_inplace_value_t>& s);
-	public: bc_external_value_t(const type_t& type, const immer::map<std::string, bc_external_handle_t>& s);
-	public: bc_external_value_t(const type_t& type, const immer::map<std::string, bc_inplace_value_t>& s);
+//	The payload of a function value.
+struct bc_function_ref_t {
+	function_id_t _function_id;
+
+	//	Index into interpreter_imm_t::_callees, set by the bytecode generator for function values it knows about.
+	//	k_no_function_index for function values made at runtime: do_call() then looks up _function_id instead.
+	int _function_index;
+};
+
+struct bc_external_value_t {
+	protected: bc_external_value_t(bc_external_kind kind, const type_t& debug_type);
+	public: bc_external_value_t(const bc_external_value_t& other) = delete;
+	public: bc_external_value_t& operator=(const bc_external_value_t& other) = delete;
 
 #if DEBUG
 	public: bool check_invariant() const;
 #endif
-	public: bool operator==(const bc_external_value_t& other) const;
+
+	public: inline const std::string& get_string() const;
+	public: inline const std::shared_ptr<json_t>& get_json() const;
+	public: inline const type_t& get_typeid_value() const;
+	public: inline const std::vector<bc_value_t>& get_struct_members() const;
+	public: inline const immer::vector<bc_external_handle_t>& get_vector_w_external_elements() const;
+	public: inline const immer::vector<bc_inplace_value_t>& get_vector_w_inplace_elements() const;
+	public: inline const immer::map<std::string, bc_external_handle_t>& get_dict_w_external_values() const;
+	public: inline const immer::map<std::string, bc_inplace_value_t>& get_dict_w_inplace_values() const;
+	public: inline const bc_function_ref_t& get_function() const;
 
 
 	//////////////////////////////////////		STATE
 	public: mutable std::atomic<int> _rc;
+	public: const bc_external_kind _kind;
 #if DEBUG
 	public: bool _debug__is_unwritten_external_value = false;
 #endif
@@ -298,17 +361,70 @@ struct bc_external_value_t {
 	public: type_t _debug_type;
 //	public: value_encoding _debug_encoding;
 #endif
-	public: std::string _string;
-	public: std::shared_ptr<json_t> _json;
-	public: function_id_t _function_id;
-	public: type_t _typeid_value = make_undefined();
-	public: std::vector<bc_value_t> _struct_members;
-	public: immer::vector<bc_external_handle_t> _vector_w_external_elements;
-	public: immer::vector<bc_inplace_value_t> _vector_w_inplace_elements;
-	public: immer::map<std::string, bc_external_handle_t> _dict_w_external_values;
-	public: immer::map<std::string, bc_inplace_value_t> _dict_w_inplace_values;
 };
 
+template <typename T, bc_external_kind KIND> struct bc_external_payload_t : public bc_external_value_t {
+	public: bc_external_payload_t(const type_t& debug_type, const T& payload) :
+		bc_external_value_t(KIND, debug_type),
+		_payload(payload)
+	{
+	}
+
+	//////////////////////////////////////		STATE
+	public: const T _payload;
+};
+
+typedef bc_external_payload_t<std::string, bc_external_kind::k_string> bc_external_string_t;
+typedef bc_external_payload_t<std::shared_ptr<json_t>, bc_external_kind::k_json> bc_external_json_t;
+typedef bc_external_payload_t<type_t, bc_external_kind::k_typeid> bc_external_typeid_t;
+typedef bc_external_payload_t<std::vector<bc_value_t>, bc_external_kind::k_struct> bc_external_struct_t;
+typedef bc_external_payload_t<immer::vector<bc_external_handle_t>, bc_external_kind::k_vector_w_external_elements> bc_external_vector_w_external_elements_t;
+typedef bc_external_payload_t<immer::vector<bc_inplace_value_t>, bc_external_kind::k_vector_w_inplace_elements> bc_external_vector_w_inplace_elements_t;
+typedef bc_external_payload_t<immer::map<std::string, bc_external_handle_t>, bc_external_kind::k_dict_w_external_values> bc_external_dict_w_external_values_t;
+typedef bc_external_payload_t<immer::map<std::string, bc_inplace_value_t>, bc_external_kind::k_dict_w_inplace_values> bc_external_dict_w_inplace_values_t;
+typedef bc_external_payload_t<bc_function_ref_t, bc_external_kind::k_function> bc_external_function_t;
+
+//	Call when the RC has reached 0.
+void delete_external(const bc_external_value_t* ext);
+
+
+inline const std::string& bc_external_value_t::get_string() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_string);
+	return static_cast<const bc_external_string_t*>(this)->_payload;
+}
+inline const std::shared_ptr<json_t>& bc_external_value_t::get_json() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_json);
+	return static_cast<const bc_external_json_t*>(this)->_payload;
+}
+inline const type_t& bc_external_value_t::get_typeid_value() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_typeid);
+	return static_cast<const bc_external_typeid_t*>(this)->_payload;
+}
+inline const std::vector<bc_value_t>& bc_external_value_t::get_struct_members() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_struct);
+	return static_cast<const bc_external_struct_t*>(this)->_payload;
+}
+inline const immer::vector<bc_external_handle_t>& bc_external_value_t::get_vector_w_external_elements() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_vector_w_external_elements);
+	return static_cast<const bc_external_vector_w_external_elements_t*>(this)->_payload;
+}
+inline const immer::vector<bc_inplace_value_t>& bc_external_value_t::get_vector_w_inplace_elements() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_vector_w_inplace_elements);
+	return static_cast<const bc_external_vector_w_inplace_elements_t*>(this)->_payload;
+}
+inline const immer::map<std::string, bc_external_handle_t>& bc_external_value_t::get_dict_w_external_values() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_dict_w_external_values);
+	return static_cast<const bc_external_dict_w_external_values_t*>(this)->_payload;
+}
+inline const immer::map<std::string, bc_inplace_value_t>& bc_external_value_t::get_dict_w_inplace_values() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_dict_w_inplace_values);
+	return static_cast<const bc_external_dict_w_inplace_values_t*>(this)->_payload;
+}
+inline const bc_function_ref_t& bc_external_value_t::get_function() const {
+	QUARK_ASSERT(_kind == bc_external_kind::k_function);
+	return static_cast<const bc_external_function_t*>(this)->_payload;
+}
+
 
 ////////////////////////////////////////////			FREE
 
@@ -461,6 +577,14 @@ enum class bc_opcode: uint8_t {
 	*/
 	k_call,
 
+	/*
+		Superinstruction: k_load_global_external_value + k_call.
+		A: Register: tells where to put function return
+		B: IMMEDIATE: global index of the function value to call. Only immutable globals.
+		C: IMMEDIATE: argument count, like k_call.
+	*/
+	k_call_global,
+
 	/*
 		A: Register: where to put result
 		B: Register: lhs
@@ -470,6 +594,14 @@ enum class bc_opcode: uint8_t {
 	k_add_int,
 	k_add_double,
 
+	/*
+		Superinstruction: k_add_int / k_subtract_int with a constant.
+		A: Register: where to put result
+		B: Register: lhs
+		C: IMMEDIATE: rhs
+	*/
+	k_add_int_imm,
+
 	k_concat_strings,
 	k_concat_vectors_w_external_elements,
 	k_concat_vectors_w_inplace_elements,
@@ -673,6 +805,24 @@ enum class bc_opcode: uint8_t {
 	k_branch_smaller_int,
 	k_branch_smaller_or_equal_int,
 
+	/*
+		Superinstructions: k_logical_equal_int / k_logical_nonequal_int + k_branch_true_bool / k_branch_false_bool.
+		A: Register: lhs
+		B: Register: rhs
+		C: IMMEDIATE: branch offset (added to PC) on branch.
+	*/
+	k_branch_equal_int,
+	k_branch_notequal_int,
+
+	/*
+		Superinstructions for the end of a for-loop: increments A by 1, then branches if A < B / A <= B.
+		A: Register: loop counter
+		B: Register: end value
+		C: IMMEDIATE: branch offset (added to PC) on branch.
+	*/
+	k_increment_branch_smaller_int,
+	k_increment_branch_smaller_or_equal_int,
+
 	/*
 		A: ---
 		B: IMMEDIATE: branch offset (added to PC) on branch.
@@ -727,6 +877,34 @@ struct reg_flags_t {
 reg_flags_t encoding_to_reg_flags(opcode_info_t::encoding e);
 
 
+//////////////////////////////////////		bc_opcode_histogram_t
+
+//	How many times each opcode was executed, and how many times each opcode was directly followed by another.
+
+const int k_bc_opcode_count = static_cast<int>(bc_opcode::k_branch_always) + 1;
+
+struct bc_opcode_histogram_t {
+	bc_opcode_histogram_t() :
+		_counts(k_bc_opcode_count, 0),
+		_pair_counts(k_bc_opcode_count * k_bc_opcode_count, 0)
+	{
+	}
+
+	std::vector<uint64_t> _counts;
+
+	//	Indexed by prev * k_bc_opcode_count + opcode.
+	std::vector<uint64_t> _pair_counts;
+};
+
+inline void count_opcode(bc_opcode_histogram_t& histogram, bc_opcode prev, bc_opcode opcode){
+	histogram._counts[static_cast<int>(opcode)]++;
+	histogram._pair_counts[static_cast<int>(prev) * k_bc_opcode_count + static_cast<int>(opcode)]++;
+}
+
+//	The most executed opcodes and pairs, most common first.
+json_t opcode_histogram_to_json(const bc_opcode_histogram_t& histogram, int max_rows);
+
+
 //////////////////////////////////////		bc_instruction_t
 
 //	The byte code instruction itself, as executed by the interpreter.
@@ -748,6 +926,23 @@ struct bc_instruction_t {
 };
 
 
+#if BC_THREADED_DISPATCH
+
+//////////////////////////////////////		bc_threaded_instruction_t
+
+//	An instruction translated to direct-threaded code: the address of its handler inside execute_instructions()
+//	and the original instruction, for its operands.
+
+struct bc_threaded_instruction_t {
+	const void* _handler;
+	bc_instruction_t _instruction;
+};
+
+std::vector<bc_threaded_instruction_t> make_threaded_instructions(const std::vector<bc_instruction_t>& instructions);
+
+#endif
+
+
 //////////////////////////////////////		bc_static_frame_t
 
 /*
@@ -782,6 +977,15 @@ struct bc_static_frame_t {
 	//	This doesn't count arguments.
 	std::vector<bool> _locals_exts;
 	std::vector<bc_value_t> _locals;
+
+	//	Max number of stack entries the frame needs on top of its arguments: its locals plus everything its
+	//	push instructions can have on the stack at once. open_frame() reserves this so pushes don't check.
+	int _stack_entry_count;
+
+#if BC_THREADED_DISPATCH
+	//	_instructions translated to direct-threaded code, one entry per instruction.
+	std::vector<bc_threaded_instruction_t> _threaded_instructions;
+#endif
 };
 
 
@@ -845,6 +1049,27 @@ struct bc_program_t {
 json_t bcprogram_to_json(const bc_program_t& program);
 
 
+//////////////////////////////////////		function index
+
+/*
+	Function values and k_call find their function using a dense function index instead of by name:
+	first all of bc_program_t::_function_defs in map order, then all intrinsics not already among them.
+	The generator stores the indexes in the function values of the program, the interpreter builds
+	interpreter_imm_t::_callees in the same order.
+*/
+std::unordered_map<std::string, int> make_function_indexes(
+	const std::map<function_id_t, bc_function_definition_t>& function_defs,
+	const intrinsic_signatures_t& intrinsics
+);
+
+//	Returns a copy of frame where all function values among the symbols have their _function_index set.
+bc_static_frame_t resolve_function_values(
+	const types_t& types,
+	const bc_static_frame_t& frame,
+	const std::unordered_map<std::string, int>& function_indexes
+);
+
+
 //////////////////////////////////////		frame_pos_t
 
 
@@ -889,18 +1114,46 @@ enum {
 	9	[local3]
 */
 
+//	Limits of one interpreter's stack. Going past any of them throws a "Stack overflow." runtime error.
+struct interpreter_stack_limits_t {
+	bool check_invariant() const {
+		QUARK_ASSERT(_initial_entry_count >= k_frame_overhead);
+		QUARK_ASSERT(_max_entry_count >= _initial_entry_count);
+		QUARK_ASSERT(_max_native_stack_size > 0);
+		return true;
+	}
+
+	//	Entries allocated up front. The stack doubles its allocation when a new frame doesn't fit.
+	int64_t _initial_entry_count;
+
+	//	The stack never grows past this many entries.
+	int64_t _max_entry_count;
+
+	//	Max bytes of C++ stack used by nested execute_instructions(), counted from the outermost one.
+	//	Floyd functions called from native code like map() recurse on the C++ stack, with BC_THREADED_DISPATCH = 0
+	//	all Floyd calls do. Keep it well below the thread's stack size: a DEBUG build at -O0 uses up to 1 MB per level.
+	int64_t _max_native_stack_size;
+};
+
+interpreter_stack_limits_t make_default_interpreter_stack_limits();
+
+
 struct interpreter_stack_t {
-	public: interpreter_stack_t(const types_t& types, const bc_static_frame_t* global_frame) :
+	public: interpreter_stack_t(const types_t& types, const bc_static_frame_t* global_frame, const interpreter_stack_limits_t& limits) :
 		_types(types),
+		_limits(limits),
 		_current_frame_ptr(nullptr),
 		_current_frame_entry_ptr(nullptr),
 		_global_frame(global_frame),
 		_entries(nullptr),
 		_allocated_count(0),
-		_stack_size(0)
+		_stack_size(0),
+		_native_stack_base(nullptr)
 	{
-		_entries = new bc_pod_value_t[8192];
-		_allocated_count = 8192;
+		QUARK_ASSERT(limits.check_invariant());
+
+		_entries = new bc_pod_value_t[limits._initial_entry_count];
+		_allocated_count = limits._initial_entry_count;
 		_current_frame_entry_ptr = &_entries[0];
 
 		QUARK_ASSERT(check_invariant());
@@ -917,6 +1170,7 @@ struct interpreter_stack_t {
 		QUARK_ASSERT(_types.check_invariant());
 		QUARK_ASSERT(_entries != nullptr);
 		QUARK_ASSERT(_stack_size >= 0 && _stack_size <= _allocated_count);
+		QUARK_ASSERT(_allocated_count <= _limits._max_entry_count);
 
 		QUARK_ASSERT(_current_frame_entry_ptr >= &_entries[0]);
 
@@ -937,9 +1191,11 @@ struct interpreter_stack_t {
 		QUARK_ASSERT(other.check_invariant());
 
 		std::swap(other._types, _types);
+		std::swap(other._limits, _limits);
 		std::swap(other._entries, _entries);
 		std::swap(other._allocated_count, _allocated_count);
 		std::swap(other._stack_size, _stack_size);
+		std::swap(other._native_stack_base, _native_stack_base);
 #if DEBUG
 		other._debug_types.swap(_debug_types);
 #endif
@@ -958,6 +1214,18 @@ struct interpreter_stack_t {
 		return static_cast<int>(_stack_size);
 	}
 
+	//	Makes room for count more entries, reallocating the stack if needed.
+	//	Reallocating moves all entries: only keep stack positions, not pointers, across calls that can get here.
+	public: inline void reserve(int64_t count){
+		QUARK_ASSERT(check_invariant());
+		QUARK_ASSERT(count >= 0);
+
+		if(_stack_size + count > _allocated_count){
+			grow(_stack_size + count);
+		}
+	}
+	private: void grow(size_t min_count);
+
 
 	//////////////////////////////////////		GLOBAL VARIABLES
 
@@ -998,6 +1266,8 @@ struct interpreter_stack_t {
 		//	The stack frame already has symbols/registers mapped for those parameters.
 		const auto new_frame_pos = stack_end - parameter_count;
 
+		reserve(frame._stack_entry_count);
+
 		for(int i = 0 ; i < frame._locals.size() ; i++){
 			bool ext = frame._locals_exts[i];
 			const auto& local = frame._locals[i];
@@ -1197,6 +1467,8 @@ struct interpreter_stack_t {
 #endif
 
 	public: void save_frame(){
+		reserve(k_frame_overhead);
+
 		const auto frame_pos = bc_value_t::make_int(get_current_frame_start());
 		push_inplace_value(frame_pos);
 
@@ -1230,6 +1502,7 @@ struct interpreter_stack_t {
 #if DEBUG
 		QUARK_ASSERT(encode_as_external(_types, value._type) == true);
 #endif
+		QUARK_ASSERT(_stack_size < _allocated_count);
 
 		value._pod._external->_rc++;
 		_entries[_stack_size] = value._pod;
@@ -1247,6 +1520,7 @@ struct interpreter_stack_t {
 #if DEBUG
 		QUARK_ASSERT(encode_as_external(_types, value._type) == false);
 #endif
+		QUARK_ASSERT(_stack_size < _allocated_count);
 
 		_entries[_stack_size] = value._pod;
 		_stack_size++;
@@ -1359,10 +1633,14 @@ struct interpreter_stack_t {
 	////////////////////////		STATE
 
 	public: types_t _types;
+	public: interpreter_stack_limits_t _limits;
 	public: bc_pod_value_t* _entries;
 	public: size_t _allocated_count;
 	public: size_t _stack_size;
 
+	//	Where the outermost execute_instructions() started on the C++ stack, nullptr when none is running.
+	public: const char* _native_stack_base;
+
 #if DEBUG
 	//	These are DEEP copies = do not share RC with non-debug values.
 	//	These are parallell with _entries, one elementfor each entry on the stack.
@@ -1378,6 +1656,34 @@ struct interpreter_stack_t {
 
 
 
+//////////////////////////////////////		bc_callee_t
+
+//	Everything needed to call a function, resolved once when the interpreter is created.
+
+struct bc_callee_t {
+	function_id_t _function_id;
+	type_t _function_type;
+
+	//	Floyd function: the frame to execute. nullptr for native functions.
+	const bc_static_frame_t* _frame_ptr;
+
+	//	Native function: nullptr if the interpreter has no implementation of it.
+	BC_NATIVE_FUNCTION_PTR _native_function_ptr;
+
+	std::vector<type_t> _arg_types;
+	std::vector<bool> _arg_is_any;
+	int _dyn_arg_count;
+	bool _return_is_void;
+	bool _return_is_ext;
+};
+
+//	Makes one bc_callee_t per function index, see make_function_indexes().
+std::vector<bc_callee_t> make_callees(
+	const bc_program_t& program,
+	const std::map<function_id_t, BC_NATIVE_FUNCTION_PTR>& native_functions
+);
+
+
 //////////////////////////////////////		interpreter_imm_t
 
 //	Holds static = immutable state the interpreter wants to keep around.
@@ -1386,6 +1692,12 @@ struct interpreter_imm_t {
 	public: const std::chrono::time_point<std::chrono::high_resolution_clock> _start_time;
 	public: const bc_program_t _program;
 	public: const std::map<function_id_t, BC_NATIVE_FUNCTION_PTR> _native_functions;
+
+	//	Indexed by function index.
+	public: const std::vector<bc_callee_t> _callees;
+
+	//	Function name -> function index, for function values without a _function_index.
+	public: const std::unordered_map<std::string, int> _function_indexes;
 };
 
 
@@ -1409,6 +1721,21 @@ struct value_entry_t {
 };
 
 
+//////////////////////////////////////		bc_runtime_handler_i
+
+/*
+	This is a callback from the running Floyd process.
+	that allows the interpreter to indirectly control the outside runtime that hosts the interpreter.
+	FUTURE: Needs neater solution than this.
+*/
+struct bc_runtime_handler_i {
+	virtual ~bc_runtime_handler_i(){};
+
+	//	message can be any type. bc_value_t is immutable and RC:ed, so the runtime keeps a copy instead of serializing it.
+	virtual void on_send(const std::string& process_id, const bc_value_t& message) = 0;
+};
+
+
 //////////////////////////////////////		interpreter_t
 
 /*
@@ -1419,7 +1746,8 @@ struct value_entry_t {
 
 struct interpreter_t {
 	public: explicit interpreter_t(const bc_program_t& program);
-	public: explicit interpreter_t(const bc_program_t& program, runtime_handler_i* handler);
+	public: explicit interpreter_t(const bc_program_t& program, bc_runtime_handler_i* handler);
+	public: explicit interpreter_t(const bc_program_t& program, bc_runtime_handler_i* handler, const interpreter_stack_limits_t& stack_limits);
 	public: interpreter_t(const interpreter_t& other) = delete;
 	public: const interpreter_t& operator=(const interpreter_t& other)= delete;
 #if DEBUG
@@ -1430,12 +1758,16 @@ struct interpreter_t {
 
 	////////////////////////		STATE
 	public: std::shared_ptr<interpreter_imm_t> _imm;
-	public: runtime_handler_i* _handler;
+	public: bc_runtime_handler_i* _handler;
 
 	//	Holds all values for all environments.
 	//	Notice: stack holds refs to RC-counted objects!
 	public: interpreter_stack_t _stack;
 	public: std::vector<std::string> _print_output;
+
+#if BC_OPCODE_HISTOGRAM
+	public: bc_opcode_histogram_t _opcode_histogram;
+#endif
 };
 
 
@@ -117,7 +117,7 @@ bc_value_t bc_intrinsic__update(interpreter_t& vm, const bc_value_t args[], int
 	}
 	else if(obj._type.is_vector()){
 		if(encode_as_vector_w_inplace_elements(obj._type)){
-			const auto size = obj._pod._external->_vector_w_inplace_elements.size();
+			const auto size = obj._pod._external->get_vector_w_inplace_elements().size();
 			return bc_value_t::make_int(static_cast<int>(size));
 		}
 		else{
@@ -127,7 +127,7 @@ bc_value_t bc_intrinsic__update(interpreter_t& vm, const bc_value_t args[], int
 	}
 	else if(obj._type.is_dict()){
 		if(encode_as_dict_w_inplace_values(obj._type)){
-			const auto size = obj._pod._external->_dict_w_inplace_values.size();
+			const auto size = obj._pod._external->get_dict_w_inplace_values().size();
 			return bc_value_t::make_int(static_cast<int>(size));
 		}
 		else{
@@ -165,7 +165,7 @@ bc_value_t bc_intrinsic__find(interpreter_t& vm, const bc_value_t args[], int ar
 		QUARK_ASSERT(wanted._type == element_type);
 
 		if(element_type_peek.is_bool()){
-			const auto& vec = obj._pod._external->_vector_w_inplace_elements;
+			const auto& vec = obj._pod._external->get_vector_w_inplace_elements();
 			int index = 0;
 			const auto size = vec.size();
 			while(index < size && vec[index].bool_value != wanted._pod._inplace.bool_value){
@@ -175,7 +175,7 @@ bc_value_t bc_intrinsic__find(interpreter_t& vm, const bc_value_t args[], int ar
 			return bc_value_t::make_int(result);
 		}
 		else if(element_type_peek.is_int()){
-			const auto& vec = obj._pod._external->_vector_w_inplace_elements;
+			const auto& vec = obj._pod._external->get_vector_w_inplace_elements();
 			int index = 0;
 			const auto size = vec.size();
 			while(index < size && vec[index].int64_value != wanted._pod._inplace.int64_value){
@@ -185,7 +185,7 @@ bc_value_t bc_intrinsic__find(interpreter_t& vm, const bc_value_t args[], int ar
 			return bc_value_t::make_int(result);
 		}
 		else if(element_type_peek.is_double()){
-			const auto& vec = obj._pod._external->_vector_w_inplace_elements;
+			const auto& vec = obj._pod._external->get_vector_w_inplace_elements();
 			int index = 0;
 			const auto size = vec.size();
 			while(index < size && vec[index].double_value != wanted._pod._inplace.double_value){
@@ -229,7 +229,7 @@ bc_value_t bc_intrinsic__exists(interpreter_t& vm, const bc_value_t args[], int
 	const auto key_string = key.get_string_value();
 
 	if(encode_as_dict_w_inplace_values(types, obj._type)){
-		const auto found_ptr = obj._pod._external->_dict_w_inplace_values.find(key_string);
+		const auto found_ptr = obj._pod._external->get_dict_w_inplace_values().find(key_string);
 		return bc_value_t::make_bool(found_ptr != nullptr);
 	}
 	else{
@@ -256,7 +256,7 @@ bc_value_t bc_intrinsic__erase(interpreter_t& vm, const bc_value_t args[], int a
 
 	const auto value_type = obj_type_peek.get_dict_value_type(types);
 	if(encode_as_dict_w_inplace_values(types, obj._type)){
-		auto entries2 = obj._pod._external->_dict_w_inplace_values.erase(key_string);
+		auto entries2 = obj._pod._external->get_dict_w_inplace_values().erase(key_string);
 		const auto value2 = make_dict(types, value_type, entries2);
 		return value2;
 	}
@@ -279,7 +279,7 @@ bc_value_t bc_intrinsic__get_keys(interpreter_t& vm, const bc_value_t args[], in
 
 	std::vector<value_t> keys;
 	if(encode_as_dict_w_inplace_values(vm._imm->_program._types, obj._type)){
-		const auto& entries = obj._pod._external->_dict_w_inplace_values;
+		const auto& entries = obj._pod._external->get_dict_w_inplace_values();
 		for(const auto& e: entries){
 			const auto& key = e.first;
 			const auto key2 = value_t::make_string(key);
@@ -323,7 +323,7 @@ bc_value_t bc_intrinsic__push_back(interpreter_t& vm, const bc_value_t args[], i
 			quark::throw_runtime_error("Type mismatch.");
 		}
 		else if(encode_as_vector_w_inplace_elements(obj._type)){
-			auto elements2 = obj._pod._external->_vector_w_inplace_elements.push_back(element._pod._pod64);
+			auto elements2 = obj._pod._external->get_vector_w_inplace_elements().push_back(element._pod._pod64);
 			const auto v = make_vector(element_type, elements2);
 			return v;
 		}
@@ -375,7 +375,7 @@ bc_value_t bc_intrinsic__subset(interpreter_t& vm, const bc_value_t args[], int
 	else if(obj_type_peek.is_vector()){
 		if(encode_as_vector_w_inplace_elements(types, obj._type)){
 			const auto& element_type = obj_type_peek.get_vector_element_type(types);
-			const auto& vec = obj._pod._external->_vector_w_inplace_elements;
+			const auto& vec = obj._pod._external->get_vector_w_inplace_elements();
 			const auto start2 = std::min(start, static_cast<int64_t>(vec.size()));
 			const auto end2 = std::min(end, static_cast<int64_t>(vec.size()));
 			immer::vector<bc_inplace_value_t> elements2;
@@ -386,7 +386,7 @@ bc_value_t bc_intrinsic__subset(interpreter_t& vm, const bc_value_t args[], int
 			return v;
 		}
 		else{
-			const auto& vec = obj._pod._external->_vector_w_external_elements;
+			const auto& vec = obj._pod._external->get_vector_w_external_elements();
 			const auto element_type = obj_type_peek.get_vector_element_type(types);
 			const auto start2 = std::min(start, static_cast<int64_t>(vec.size()));
 			const auto end2 = std::min(end, static_cast<int64_t>(vec.size()));
@@ -439,11 +439,11 @@ bc_value_t bc_intrinsic__replace(interpreter_t& vm, const bc_value_t args[], int
 	}
 	else if(obj_type_peek.is_vector()){
 		if(encode_as_vector_w_inplace_elements(types, obj._type)){
-			const auto& vec = obj._pod._external->_vector_w_inplace_elements;
+			const auto& vec = obj._pod._external->get_vector_w_inplace_elements();
 			const auto element_type = obj_type_peek.get_vector_element_type(types);
 			const auto start2 = std::min(start, static_cast<int64_t>(vec.size()));
 			const auto end2 = std::min(end, static_cast<int64_t>(vec.size()));
-			const auto& new_bits = args[3]._pod._external->_vector_w_inplace_elements;
+			const auto& new_bits = args[3]._pod._external->get_vector_w_inplace_elements();
 
 			auto result = immer::vector<bc_inplace_value_t>(vec.begin(), vec.begin() + start2);
 			for(int i = 0 ; i < new_bits.size() ; i++){
@@ -456,11 +456,11 @@ bc_value_t bc_intrinsic__replace(interpreter_t& vm, const bc_value_t args[], int
 			return v;
 		}
 		else{
-			const auto& vec = obj._pod._external->_vector_w_external_elements;
+			const auto& vec = obj._pod._external->get_vector_w_external_elements();
 			const auto element_type = obj_type_peek.get_vector_element_type(types);
 			const auto start2 = std::min(start, static_cast<int64_t>(vec.size()));
 			const auto end2 = std::min(end, static_cast<int64_t>(vec.size()));
-			const auto& new_bits = args[3]._pod._external->_vector_w_external_elements;
+			const auto& new_bits = args[3]._pod._external->get_vector_w_external_elements();
 
 			auto result = immer::vector<bc_external_handle_t>(vec.begin(), vec.begin() + start2);
 			for(int i = 0 ; i < new_bits.size() ; i++){
@@ -663,9 +663,9 @@ bc_value_t bc_intrinsic__map_dag(interpreter_t& vm, const bc_value_t args[], int
 		const auto parent_index = e.get_int_value();
 
 		const auto count = static_cast<int64_t>(elements2.size());
-		QUARK_ASSERT(parent_index >= -1);
-		QUARK_ASSERT(parent_index < count);
-
+		if(parent_index < -1 || parent_index >= count){
+			quark::throw_runtime_error("map_dag() parent index out of range.");
+		}
 		if(parent_index != -1){
 			rcs[parent_index]++;
 		}
@@ -1011,14 +1011,12 @@ bc_value_t bc_intrinsic__send(interpreter_t& vm, const bc_value_t args[], int ar
 
 	const auto& types = vm._imm->_program._types;
 	QUARK_ASSERT(peek2(types, args[0]._type).is_string());
-	QUARK_ASSERT(peek2(types, args[1]._type).is_json());
 
 	const auto& process_id = args[0].get_string_value();
-	const auto& message_json = args[1].get_json();
 
-//	QUARK_TRACE_SS("send(\"" << process_id << "\"," << json_to_pretty_string(message_json) <<")");
+//	QUARK_TRACE_SS("send(\"" << process_id << "\"," << json_to_pretty_string(bcvalue_to_json(types, args[1])) <<")");
 
-	vm._handler->on_send(process_id, message_json);
+	vm._handler->on_send(process_id, args[1]);
 
 	return bc_value_t::make_undefined();
 }
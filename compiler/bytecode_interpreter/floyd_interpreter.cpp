@@ -15,6 +15,10 @@
 #include "bytecode_helpers.h"
 #include "semantic_ast.h"
 #include "utils.h"
+#include "process_inbox.h"
+#include "process_scheduler.h"
+#include "thread_team.h"
+#include "hardware_caps.h"
 
 #include <thread>
 #include <deque>
@@ -128,39 +132,42 @@ std::packaged_task
 //	https://en.cppreference.com/w/cpp/thread/condition_variable/wait
 
 
-struct process_interface {
-	virtual ~process_interface(){};
-	virtual void on_message(const json_t& message) = 0;
-	virtual void on_init() = 0;
-};
-
-
-//	NOTICE: Each process inbox has its own mutex + condition variable. No mutex protects cout.
+//	NOTICE: Each process inbox is a lock-free queue. The process_scheduler_t decides which thread runs the clock bus next. No mutex protects cout.
 struct bc_process_t {
-	std::condition_variable _inbox_condition_variable;
-	std::mutex _inbox_mutex;
-	std::deque<json_t> _inbox;
+	//	Any thread sends, only the thread running the process's clock bus receives.
+	mpsc_queue_t<bc_value_t> _inbox;
 
 	std::string _name_key;
 	std::string _function_key;
-	std::thread::id _thread_id;
 
 	std::shared_ptr<interpreter_t> _interpreter;
 	std::shared_ptr<value_entry_t> _init_function;
 	std::shared_ptr<value_entry_t> _process_function;
 	value_t _process_state;
 
+	//	The type of the message argument of _process_function. json for processes that accept any message.
+	type_t _message_type;
+
+	int _bus_index = -1;
+
+	//	Set after running the process's init function.
+	bool _started = false;
+
+	//	The process's init function or message handler is on the call stack. Synchronous sends can't re-enter it.
+	bool _running = false;
 
-	std::shared_ptr<process_interface> _processor;
+	//	Read by senders on any thread.
+	std::atomic<bool> _stopped { false };
 };
 
 struct bc_process_runtime_t {
 	container_t _container;
-	std::map<std::string, std::string> _process_infos;
-	std::thread::id _main_thread_id;
 
 	std::vector<std::shared_ptr<bc_process_t>> _processes;
-	std::vector<std::thread> _worker_threads;
+
+	//	Process indexes, one vector per clock bus. The scheduler schedules clock buses, not processes.
+	std::vector<std::vector<int>> _bus_processes;
+	std::unique_ptr<process_scheduler_t> _scheduler;
 };
 
 
@@ -169,78 +176,163 @@ struct bc_process_runtime_t {
 ??? Separate system-interpreter (all processes and many clock busses) vs ONE thread of execution?
 */
 
-static void send_message(bc_process_runtime_t& runtime, int process_id, const json_t& message){
-	auto& process = *runtime._processes[process_id];
+//	Which clock bus this thread is running right now, if any.
+struct running_bus_t {
+	const bc_process_runtime_t* runtime;
+	int bus_index;
+};
+static thread_local running_bus_t t_running_bus { nullptr, -1 };
 
-    {
-        std::lock_guard<std::mutex> lk(process._inbox_mutex);
-        process._inbox.push_front(message);
-        if(k_trace_messaging){
-        	QUARK_TRACE("Notifying...");
-		}
-    }
-    process._inbox_condition_variable.notify_one();
-//    process._inbox_condition_variable.notify_all();
+static bool is_stop_message(const types_t& types, const bc_value_t& message){
+	const auto peek = peek2(types, message._type);
+	if(peek.is_string()){
+		return message.get_string_value() == "stop";
+	}
+	else if(peek.is_json()){
+		const auto json = message.get_json();
+		return json.is_string() && json.get_string() == "stop";
+	}
+	else{
+		return false;
+	}
 }
 
-static void process_process(bc_process_runtime_t& runtime, int process_id){
-	auto& process = *runtime._processes[process_id];
-	bool stop = false;
-
-	const auto thread_name = get_current_thread_name();
-
-	if(process._processor){
-		process._processor->on_init();
-	}
+static void start_process(bc_process_t& process){
+	QUARK_ASSERT(process._started == false);
 
 	if(process._init_function != nullptr){
+		process._running = true;
 		const std::vector<value_t> args = {};
 		process._process_state = call_function(*process._interpreter, bc_to_value(process._interpreter->_imm->_program._types, process._init_function->_value), args);
+		process._running = false;
 	}
+	process._started = true;
+}
 
-	while(stop == false){
-		json_t message;
-		{
-			std::unique_lock<std::mutex> lk(process._inbox_mutex);
+//	Runs the process's message handler. Stops the process on "stop".
+static void handle_message(bc_process_t& process, const bc_value_t& message){
+	QUARK_ASSERT(process._started && process._running == false);
+	const auto& types = process._interpreter->_imm->_program._types;
 
-			if(k_trace_messaging){
-				QUARK_TRACE_SS(thread_name << ": waiting......");
-			}
-			process._inbox_condition_variable.wait(lk, [&]{ return process._inbox.empty() == false; });
-			if(k_trace_messaging){
-				QUARK_TRACE_SS(thread_name << ": continue");
-			}
+	if(k_trace_messaging){
+		QUARK_TRACE_SS(get_current_thread_name() << " RECEIVED: " << json_to_pretty_string(bcvalue_to_json(types, message)));
+	}
 
-			//	Pop message.
-			QUARK_ASSERT(process._inbox.empty() == false);
-			message = process._inbox.back();
-			process._inbox.pop_back();
+	if(is_stop_message(types, message)){
+		if(k_trace_messaging){
+			QUARK_TRACE_SS(get_current_thread_name() << ": STOP");
 		}
+		process._stopped = true;
+	}
+	else if(process._process_function != nullptr){
+		process._running = true;
+		const bc_value_t args[] = { value_to_bc(types, process._process_state), message };
+		const auto state2 = call_function_bc(*process._interpreter, process._process_function->_value, args, 2);
+		process._process_state = bc_to_value(types, state2);
+		process._running = false;
+	}
+}
+
+/*
+	If the sender runs on the receiver's clock bus, the receiver handles the message right away, like a function
+	call. It can't do that if the receiver is busy further up the call stack, hasn't been inited yet or has older
+	messages waiting -- then the message goes into the inbox like any other.
+
+	bc_value_t is immutable and RC:ed: messages of the process's message type go into the inbox without a copy.
+*/
+static void send_message(bc_process_runtime_t& runtime, int process_id, const bc_value_t& message){
+	auto& process = *runtime._processes[process_id];
+	const auto& types = process._interpreter->_imm->_program._types;
+
+	if(process._stopped){
+		return;
+	}
+
+	bc_value_t message2;
+	if(message._type == process._message_type || is_stop_message(types, message)){
+		message2 = message;
+	}
+	//	Processes that take json get any value converted to json, like send() always did.
+	else if(peek2(types, process._message_type).is_json()){
+		message2 = bc_value_t::make_json(value_to_ast_json(types, bc_to_value(types, message)));
+	}
+	else{
+		quark::throw_runtime_error("send(): message type doesn't match the process's message type.");
+	}
+
+	const bool synchronous =
+		t_running_bus.runtime == &runtime
+		&& t_running_bus.bus_index == process._bus_index
+		&& process._started
+		&& process._running == false
+		&& process._inbox.empty();
+	if(synchronous){
+		handle_message(process, message2);
+	}
+	else{
+		process._inbox.push(message2);
 		if(k_trace_messaging){
-			QUARK_TRACE_SS("RECEIVED: " << json_to_pretty_string(message));
+			QUARK_TRACE("Notifying...");
 		}
+		notify_process(*runtime._scheduler, process._bus_index);
+	}
+}
 
-		if(message.is_string() && message.get_string() == "stop"){
-			stop = true;
-			if(k_trace_messaging){
-        		QUARK_TRACE_SS(thread_name << ": STOP");
-			}
+static bool bus_has_messages(bc_process_runtime_t& runtime, int bus_index){
+	for(const auto process_id: runtime._bus_processes[bus_index]){
+		const auto& process = *runtime._processes[process_id];
+		if(process._stopped == false && process._inbox.empty() == false){
+			return true;
 		}
-		else{
-			if(process._processor){
-				process._processor->on_message(message);
-			}
+	}
+	return false;
+}
 
-			if(process._process_function != nullptr){
-				const std::vector<value_t> args = { process._process_state, value_t::make_json(message) };
-				const auto& state2 = call_function(*process._interpreter, bc_to_value(process._interpreter->_imm->_program._types, process._process_function->_value), args);
-				process._process_state = state2;
-			}
+//	Handles a batch of the process's messages.
+static void run_process_slice(bc_process_t& process){
+	//	Drain one slice worth of messages in one go.
+	std::vector<bc_value_t> messages;
+	process._inbox.pop_batch(messages, k_process_slice_message_count);
+	for(const auto& message: messages){
+		handle_message(process, message);
+		if(process._stopped){
+			return;
+		}
+	}
+}
+
+/*
+	Runs one slice of every process on the clock bus. Only the scheduler thread running the bus gets here.
+	The first slice inits all the bus's processes. Returns true when all of them have stopped.
+*/
+static bool run_bus_slice(bc_process_runtime_t& runtime, int bus_index){
+	struct running_bus_scope_t {
+		running_bus_scope_t(const running_bus_t& bus) : prev(t_running_bus) { t_running_bus = bus; }
+		~running_bus_scope_t(){ t_running_bus = prev; }
+		running_bus_t prev;
+	};
+	running_bus_scope_t scope(running_bus_t { &runtime, bus_index });
+
+	const auto& process_ids = runtime._bus_processes[bus_index];
+	for(const auto process_id: process_ids){
+		auto& process = *runtime._processes[process_id];
+		if(process._started == false){
+			start_process(process);
+		}
+	}
+
+	bool all_stopped = true;
+	for(const auto process_id: process_ids){
+		auto& process = *runtime._processes[process_id];
+		if(process._stopped == false){
+			run_process_slice(process);
 		}
+		all_stopped = all_stopped && process._stopped;
 	}
+	return all_stopped;
 }
 
-static std::map<std::string, value_t> run_floyd_processes(const interpreter_t& vm, const std::vector<std::string>& args){
+static std::map<std::string, value_t> run_floyd_processes(const interpreter_t& vm, const std::vector<std::string>& args, const config_t& config){
 	const auto& container_def = vm._imm->_program._container_def;
 
 	if(container_def._clock_busses.empty()){
@@ -248,7 +340,6 @@ static std::map<std::string, value_t> run_floyd_processes(const interpreter_t& v
 	}
 	else{
 		bc_process_runtime_t runtime;
-		runtime._main_thread_id = std::this_thread::get_id();
 
 	/*
 		if(program._software_system._name == ""){
@@ -258,16 +349,10 @@ static std::map<std::string, value_t> run_floyd_processes(const interpreter_t& v
 
 		runtime._container = container_def;
 
-		runtime._process_infos = reduce(runtime._container._clock_busses, std::map<std::string, std::string>(), [](const std::map<std::string, std::string>& acc, const std::pair<std::string, clock_bus_t>& e){
-			auto acc2 = acc;
-			acc2.insert(e.second._processes.begin(), e.second._processes.end());
-			return acc2;
-		});
-
-		struct my_interpreter_handler_t : public runtime_handler_i {
+		struct my_interpreter_handler_t : public bc_runtime_handler_i {
 			my_interpreter_handler_t(bc_process_runtime_t& runtime) : _runtime(runtime) {}
 
-			virtual void on_send(const std::string& process_id, const json_t& message){
+			virtual void on_send(const std::string& process_id, const bc_value_t& message){
 				const auto it = std::find_if(_runtime._processes.begin(), _runtime._processes.end(), [&](const std::shared_ptr<bc_process_t>& process){ return process->_name_key == process_id; });
 				if(it != _runtime._processes.end()){
 					const auto process_index = it - _runtime._processes.begin();
@@ -280,40 +365,38 @@ static std::map<std::string, value_t> run_floyd_processes(const interpreter_t& v
 		auto my_interpreter_handler = my_interpreter_handler_t{runtime};
 
 
-		for(const auto& t: runtime._process_infos){
-			auto process = std::make_shared<bc_process_t>();
-			process->_name_key = t.first;
-			process->_function_key = t.second;
-			process->_interpreter = std::make_shared<interpreter_t>(vm._imm->_program, &my_interpreter_handler);
-			process->_init_function = find_global_symbol2(*process->_interpreter, t.second + "__init");
-			process->_process_function = find_global_symbol2(*process->_interpreter, t.second);
-
-			runtime._processes.push_back(process);
-		}
-
-		//	Remember that current thread (main) is also a thread, no need to create a worker thread for one process.
-		runtime._processes[0]->_thread_id = runtime._main_thread_id;
+		for(const auto& bus: runtime._container._clock_busses){
+			const auto bus_index = static_cast<int>(runtime._bus_processes.size());
+			runtime._bus_processes.push_back({});
 
-		for(int process_id = 1 ; process_id < runtime._processes.size() ; process_id++){
-			runtime._worker_threads.push_back(std::thread([&](int process_id){
+			for(const auto& t: bus.second._processes){
+				auto process = std::make_shared<bc_process_t>();
+				process->_name_key = t.first;
+				process->_function_key = t.second;
+				process->_bus_index = bus_index;
+				process->_interpreter = std::make_shared<interpreter_t>(vm._imm->_program, &my_interpreter_handler, vm._stack._limits);
+				process->_init_function = find_global_symbol2(*process->_interpreter, t.second + "__init");
+				process->_process_function = find_global_symbol2(*process->_interpreter, t.second);
 
-	//			const auto native_thread = thread::native_handle();
+				const auto& types = process->_interpreter->_imm->_program._types;
+				const auto process_args = process->_process_function != nullptr ? peek2(types, process->_process_function->_value._type).get_function_args(types) : std::vector<type_t>{};
+				process->_message_type = process_args.size() == 2 ? process_args[1] : type_t::make_json();
 
-				std::stringstream thread_name;
-				thread_name << std::string() << "process " << process_id << " thread";
-	#if QUARK_MAC
-				pthread_setname_np(/*pthread_self(),*/ thread_name.str().c_str());
-	#endif
-
-				process_process(runtime, process_id);
-			}, process_id));
+				runtime._bus_processes.back().push_back(static_cast<int>(runtime._processes.size()));
+				runtime._processes.push_back(process);
+			}
 		}
 
-		process_process(runtime, 0);
-
-		for(auto &t: runtime._worker_threads){
-			t.join();
-		}
+		//	M:N -- all clock buses share a few OS threads. The current thread (main) is one of them.
+		const auto bus_count = runtime._bus_processes.size();
+		const auto max_threads = config.thread_count > 0 ? static_cast<size_t>(config.thread_count) : get_thread_team_size(read_hardware_caps());
+		runtime._scheduler = std::make_unique<process_scheduler_t>(bus_count);
+		run_process_scheduler(
+			*runtime._scheduler,
+			std::min(bus_count, max_threads),
+			[&](int bus_index){ return run_bus_slice(runtime, bus_index); },
+			[&](int bus_index){ return bus_has_messages(runtime, bus_index); }
+		);
 
 	#if 0
 		const auto result_vec = mapf<pair<string, value_t>>(
@@ -359,7 +442,7 @@ static int64_t bc_call_main(interpreter_t& interpreter, const floyd::value_t& f,
 	}
 }
 
-run_output_t run_program_bc(interpreter_t& vm, const std::vector<std::string>& main_args){
+run_output_t run_program_bc(interpreter_t& vm, const std::vector<std::string>& main_args, const config_t& config){
 	const auto& main_function = find_global_symbol2(vm, "main");
 	if(main_function != nullptr){
 		const auto main_result_int = bc_call_main(vm, bc_to_value(vm._imm->_program._types, main_function->_value), main_args);
@@ -367,7 +450,7 @@ run_output_t run_program_bc(interpreter_t& vm, const std::vector<std::string>& m
 		return { main_result_int, {} };
 	}
 	else{
-		const auto output = run_floyd_processes(vm, main_args);
+		const auto output = run_floyd_processes(vm, main_args, config);
 		print_vm_printlog(vm);
 		return run_output_t(0, output);
 	}
@@ -375,6 +458,74 @@ run_output_t run_program_bc(interpreter_t& vm, const std::vector<std::string>& m
 
 
 
+//////////////////////////////////////		interpreter_stack_t
+
+
+static const std::string k_recursion_program = R"(
+	let k = 1
+
+	func int depth(int n){
+		if(n == 0){
+			return 0
+		}
+		return depth(n - 1) + k
+	}
+
+	func int depth_via_map(int n, int c){
+		if(n == 0){
+			return 0
+		}
+		return map([ n - 1 ], depth_via_map, 0)[0] + k
+	}
+)";
+
+static value_t call_recursion(const interpreter_stack_limits_t& limits, const std::string& function_name, int64_t n){
+	const auto program = compile_to_bytecode(make_compilation_unit_nolib(k_recursion_program, ""));
+	interpreter_t vm(program, nullptr, limits);
+	const auto f = find_global_symbol(vm, function_name);
+	return function_name == "depth"
+		? call_function(vm, f, { value_t::make_int(n) })
+		: call_function(vm, f, { value_t::make_int(n), value_t::make_int(0) });
+}
+
+static std::string get_recursion_exception(const interpreter_stack_limits_t& limits, const std::string& function_name, int64_t n){
+	try {
+		call_recursion(limits, function_name, n);
+		return "";
+	}
+	catch(const std::runtime_error& e){
+		return e.what();
+	}
+}
+
+QUARK_TEST("interpreter_stack_t", "open_frame()", "recursion deeper than the initial stack", "stack grows"){
+	auto limits = make_default_interpreter_stack_limits();
+	limits._initial_entry_count = 16;
+	const auto result = call_recursion(limits, "depth", 10);
+	ut_verify_auto(QUARK_POS, result.get_int_value(), static_cast<int64_t>(10));
+}
+
+QUARK_TEST("interpreter_stack_t", "open_frame()", "recursion via native map()", "stack grows"){
+	auto limits = make_default_interpreter_stack_limits();
+	limits._initial_entry_count = 16;
+	const auto result = call_recursion(limits, "depth_via_map", 3);
+	ut_verify_auto(QUARK_POS, result.get_int_value(), static_cast<int64_t>(3));
+}
+
+QUARK_TEST("interpreter_stack_t", "open_frame()", "recursion past _max_entry_count", "Stack overflow."){
+	auto limits = make_default_interpreter_stack_limits();
+	limits._initial_entry_count = 16;
+	limits._max_entry_count = 64;
+	const auto what = get_recursion_exception(limits, "depth", 5000);
+	ut_verify_auto(QUARK_POS, what, std::string("Stack overflow."));
+}
+
+QUARK_TEST("interpreter_stack_t", "execute_instructions()", "recursion via native map() past _max_native_stack_size", "Stack overflow."){
+	auto limits = make_default_interpreter_stack_limits();
+	limits._max_native_stack_size = 64 * 1024;
+	const auto what = get_recursion_exception(limits, "depth_via_map", 5000);
+	ut_verify_auto(QUARK_POS, what, std::string("Stack overflow."));
+}
 
 
 
@@ -51,7 +51,8 @@ std::pair<std::shared_ptr<interpreter_t>, value_t> bc_run_main(
 );
 
 
-run_output_t run_program_bc(interpreter_t& vm, const std::vector<std::string>& main_args);
+//	config.thread_count sets how many threads run the processes, like the LLVM backend.
+run_output_t run_program_bc(interpreter_t& vm, const std::vector<std::string>& main_args, const config_t& config);
 
 void print_vm_printlog(const interpreter_t& vm);
 
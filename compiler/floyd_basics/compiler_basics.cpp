@@ -21,7 +21,7 @@ const location_t k_no_location(std::numeric_limits<std::size_t>::max());
 
 
 config_t make_default_config(){
-	return config_t { vector_backend::hamt, dict_backend::hamt, false } ;
+	return config_t { vector_backend::hamt, dict_backend::hamt, false, heap_backend::pool, 0 } ;
 }
  
 compiler_settings_t make_default_compiler_settings(){
@@ -100,8 +100,8 @@ type_t make_process_init_type(types_t& types, const type_t& t){
 	return make_function3(types, t, {}, epure::impure, return_dyn_type::none);
 }
 
-type_t make_process_message_handler_type(types_t& types, const type_t& t){
-	return make_function3(types, t, { t, type_t::make_json() }, epure::impure, return_dyn_type::none);
+type_t make_process_message_handler_type(types_t& types, const type_t& t, const type_t& message_type){
+	return make_function3(types, t, { t, message_type }, epure::impure, return_dyn_type::none);
 }
 
 
@@ -525,8 +525,9 @@ bool check_stable_sort_func_type(types_t& types, const type_t& elements, const t
 intrinsic_signature_t make_print_signature(types_t& types){
 	return make_intrinsic("print", make_function(types, type_t::make_void(), { ANY_TYPE }, epure::pure) );
 }
+//	void send(string process_key, M message)
 intrinsic_signature_t make_send_signature(types_t& types){
-	return make_intrinsic("send", make_function(types, type_t::make_void(), { type_t::make_string(), type_t::make_json() }, epure::impure) );
+	return make_intrinsic("send", make_function(types, type_t::make_void(), { type_t::make_string(), ANY_TYPE }, epure::impure) );
 }
 
 
@@ -72,8 +72,9 @@ inline type_t get_main_signature_no_arg_pure(types_t& types){
 //	T x_init() impure
 type_t make_process_init_type(types_t& types, const type_t& t);
 
-//	T x(T state, json message) impure
-type_t make_process_message_handler_type(types_t& types, const type_t& t);
+//	T x(T state, M message) impure
+//	M is the process's message type. Processes that take any message use json.
+type_t make_process_message_handler_type(types_t& types, const type_t& t, const type_t& message_type);
 
 
 
@@ -408,11 +409,23 @@ struct compilation_unit_t {
 
 enum class vector_backend {
 	carray,
-	hamt
+	hamt,
+
+	//	Like carray, but vectors of POD structs store their members column-wise, see VECTOR_SOA_T.
+	soa
 };
 enum class dict_backend {
 	cppmap,
-	hamt
+	hamt,
+
+	//	Open addressing hash table, see quadratic_probing_hash_table_t.
+	hash
+};
+
+//	How heap_t gets memory for each alloc_64(): straight malloc() or size-class slab pools.
+enum class heap_backend {
+	malloc,
+	pool
 };
 
 struct config_t {
@@ -424,12 +437,21 @@ struct config_t {
 	vector_backend vector_backend_mode;
 	dict_backend dict_backend_mode;
 	bool trace_allocs;
+	heap_backend heap_backend_mode = heap_backend::pool;
+
+	//	Threads used by map(), filter(), map_dag() and stable_sort(), and by the process scheduler of both backends.
+	//	0 = one per logical processor. 1 = run on the calling thread.
+	int64_t thread_count = 0;
 };
 
 inline bool operator==(const config_t& lhs, const config_t& rhs){
 	QUARK_ASSERT(lhs.check_invariant());
 	QUARK_ASSERT(rhs.check_invariant());
-	return lhs.vector_backend_mode == rhs.vector_backend_mode && lhs.dict_backend_mode == rhs.dict_backend_mode && lhs.trace_allocs == rhs.trace_allocs;
+	return lhs.vector_backend_mode == rhs.vector_backend_mode
+		&& lhs.dict_backend_mode == rhs.dict_backend_mode
+		&& lhs.trace_allocs == rhs.trace_allocs
+		&& lhs.heap_backend_mode == rhs.heap_backend_mode
+		&& lhs.thread_count == rhs.thread_count;
 }
 
 
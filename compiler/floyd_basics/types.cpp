@@ -1557,6 +1557,93 @@ int find_struct_member_index(const struct_type_desc_t& desc, const std::string&
 
 
 
+static std::size_t combine_hash(std::size_t acc, std::size_t h){
+	return acc ^ (h + 0x9e3779b97f4a7c15 + (acc << 6) + (acc >> 2));
+}
+
+//	Hashes everything operator==() compares, except the name. Named nodes are in name_index instead.
+static uint32_t hash_node(const type_node_t& node){
+	std::size_t result = std::hash<int>{}((int)node.bt);
+	for(const auto& e: node.child_types){
+		result = combine_hash(result, std::hash<int32_t>{}(e.get_data()));
+	}
+	for(const auto& e: node.struct_desc._members){
+		result = combine_hash(result, std::hash<int32_t>{}(e._type.get_data()));
+		result = combine_hash(result, std::hash<std::string>{}(e._name));
+	}
+	result = combine_hash(result, std::hash<int>{}((int)node.func_pure));
+	result = combine_hash(result, std::hash<int>{}((int)node.func_return_dyn_type));
+	result = combine_hash(result, std::hash<std::string>{}(node.identifier_str));
+	return (uint32_t)(result ^ (result >> 32));
+}
+
+static uint32_t hash_name(const type_name_t& name){
+	std::size_t result = 0;
+	for(const auto& e: name.lexical_path){
+		result = combine_hash(result, std::hash<std::string>{}(e));
+	}
+	return (uint32_t)(result ^ (result >> 32));
+}
+
+//	Returns the index into nodes of the first slot with this hash where match(node) is true, or -1.
+template <typename MATCH> static type_lookup_index_t find_in_index(const types_t& types, const type_index_t& table, uint32_t hash, MATCH match){
+	if(table.slots.empty()){
+		return -1;
+	}
+	const auto mask = table.slots.size() - 1;
+	for(auto i = hash & mask ; table.slots[i].index != -1 ; i = (i + 1) & mask){
+		if(table.slots[i].hash == hash && match(types.nodes[table.slots[i].index])){
+			return table.slots[i].index;
+		}
+	}
+	return -1;
+}
+
+static void insert_in_index(type_index_t& table, uint32_t hash, type_lookup_index_t index){
+	if((table.count + 1) * 2 > table.slots.size()){
+		type_index_t temp { std::vector<type_index_t::slot_t>(std::max<std::size_t>(table.slots.size() * 2, 64), { 0, -1 }), 0 };
+		for(const auto& e: table.slots){
+			if(e.index != -1){
+				insert_in_index(temp, e.hash, e.index);
+			}
+		}
+		table = std::move(temp);
+	}
+
+	const auto mask = table.slots.size() - 1;
+	auto i = hash & mask;
+	while(table.slots[i].index != -1){
+		i = (i + 1) & mask;
+	}
+	table.slots[i] = { hash, index };
+	table.count++;
+}
+
+//	Returns -1 if there is no such unnamed node.
+static type_lookup_index_t find_node(const types_t& types, const type_node_t& node){
+	QUARK_ASSERT(node.optional_name.lexical_path.empty());
+
+	return find_in_index(types, types.node_index, hash_node(node), [&](const type_node_t& e){ return e == node; });
+}
+
+//	Returns -1 if there is no node with this name.
+static type_lookup_index_t find_named_node(const types_t& types, const type_name_t& name){
+	return find_in_index(types, types.name_index, hash_name(name), [&](const type_node_t& e){ return e.optional_name == name; });
+}
+
+//	Records nodes[index] in node_index or name_index. Call after each push_back() to nodes.
+static void index_node(types_t& types, type_lookup_index_t index){
+	const auto& node = types.nodes[index];
+	if(node.optional_name.lexical_path.empty()){
+		if(find_node(types, node) == -1){
+			insert_in_index(types.node_index, hash_node(node), index);
+		}
+	}
+	else{
+		insert_in_index(types.name_index, hash_name(node.optional_name), index);
+	}
+}
+
 static type_node_t make_entry(const base_type& bt){
 	return type_node_t{
 		make_empty_type_name(),
@@ -1593,11 +1680,18 @@ types_t::types_t(){
 	nodes.push_back(make_entry(base_type::k_symbol_ref));
 	nodes.push_back(make_entry(base_type::k_undefined));
 
+	for(type_lookup_index_t i = 0 ; i < nodes.size() ; i++){
+		index_node(*this, i);
+	}
+
 	QUARK_ASSERT(check_invariant());
 }
 
 bool types_t::check_invariant() const {
 	QUARK_ASSERT(nodes.size() < INT_MAX);
+	QUARK_ASSERT((node_index.slots.size() & (node_index.slots.size() - 1)) == 0);
+	QUARK_ASSERT((name_index.slots.size() & (name_index.slots.size() - 1)) == 0);
+	QUARK_ASSERT(node_index.count + name_index.count <= nodes.size());
 
 	QUARK_ASSERT(nodes[(type_lookup_index_t)base_type::k_undefined] == make_entry(base_type::k_undefined));
 	QUARK_ASSERT(nodes[(type_lookup_index_t)base_type::k_any] == make_entry(base_type::k_any));
@@ -1630,14 +1724,9 @@ bool types_t::check_invariant() const {
 static type_t lookup_node(const types_t& types, const type_node_t& node){
 	QUARK_ASSERT(types.check_invariant());
 
-	const auto it = std::find_if(
-		types.nodes.begin(),
-		types.nodes.end(),
-		[&](const auto& e){ return e == node; }
-	);
-
-	if(it != types.nodes.end()){
-		return lookup_type_from_index_it(types, it - types.nodes.begin());
+	const auto index = find_node(types, node);
+	if(index != -1){
+		return lookup_type_from_index_it(types, index);
 	}
 	else{
 		throw std::exception();
@@ -1650,14 +1739,9 @@ static type_t lookup_node(const types_t& types, const type_node_t& node){
 static type_t intern_node(types_t& types, const type_node_t& node){
 	QUARK_ASSERT(types.check_invariant());
 
-	const auto it = std::find_if(
-		types.nodes.begin(),
-		types.nodes.end(),
-		[&](const auto& e){ return e == node; }
-	);
-
-	if(it != types.nodes.end()){
-		return lookup_type_from_index_it(types, it - types.nodes.begin());
+	const auto index = find_node(types, node);
+	if(index != -1){
+		return lookup_type_from_index_it(types, index);
 	}
 
 	//	New type, store it.
@@ -1665,6 +1749,7 @@ static type_t intern_node(types_t& types, const type_node_t& node){
 
 		//	All child type are guaranteed to have types already since those are specified using types_t:s.
 		types.nodes.push_back(node);
+		index_node(types, (type_lookup_index_t)(types.nodes.size() - 1));
 		return lookup_type_from_index_it(types, types.nodes.size() - 1);
 	}
 }
@@ -1679,12 +1764,8 @@ type_t make_named_type(types_t& types, const type_name_t& n, const type_t& desti
 
 	if(false) trace_types(types);
 
-	const auto it = std::find_if(
-		types.nodes.begin(),
-		types.nodes.end(),
-		[&](const auto& e){ return e.optional_name == n; }
-	);
-	if(it != types.nodes.end()){
+	//	An empty name matches all the unnamed nodes.
+	if(n.lexical_path.empty() || find_named_node(types, n) != -1){
 		throw std::exception();
 	}
 
@@ -1702,6 +1783,7 @@ type_t make_named_type(types_t& types, const type_name_t& n, const type_t& desti
 
 	//	Can't use intern_node() since we have a tag.
 	types.nodes.push_back(node);
+	index_node(types, (type_lookup_index_t)(types.nodes.size() - 1));
 	return lookup_type_from_index_it(types, types.nodes.size() - 1);
 }
 
@@ -1727,16 +1809,12 @@ type_t lookup_type_from_name(const types_t& types, const type_name_t& tag){
 		throw std::exception();
 	}
 	else{
-		const auto it = std::find_if(
-			types.nodes.begin(),
-			types.nodes.end(),
-			[&](const auto& e){ return e.optional_name == tag; }
-		);
-		if(it == types.nodes.end()){
+		const auto index = find_named_node(types, tag);
+		if(index == -1){
 			throw std::exception();
 		}
 
-		return lookup_type_from_index_it(types, it - types.nodes.begin());
+		return lookup_type_from_index_it(types, index);
 	}
 }
 
@@ -2580,6 +2658,64 @@ QUARK_TEST("Types", "update_named_type()", "", ""){
 	QUARK_ASSERT(is_wellformed(types, b));
 }
 
+QUARK_TEST("Types", "make_struct()", "same members twice", "same type"){
+	types_t types;
+	const auto a = make_struct(types, struct_type_desc_t( { member_t(type_t::make_int(), "f") } ));
+	const auto count = types.nodes.size();
+	const auto b = make_struct(types, struct_type_desc_t( { member_t(type_t::make_int(), "f") } ));
+	QUARK_VERIFY(a == b);
+	QUARK_VERIFY(types.nodes.size() == count);
+}
+
+QUARK_TEST("Types", "make_struct()", "different member name", "different types"){
+	types_t types;
+	const auto a = make_struct(types, struct_type_desc_t( { member_t(type_t::make_int(), "f") } ));
+	const auto b = make_struct(types, struct_type_desc_t( { member_t(type_t::make_int(), "g") } ));
+	QUARK_VERIFY(a != b);
+}
+
+QUARK_TEST("Types", "make_vector()", "1000 element types", "each found again, also in a copy"){
+	types_t types;
+	std::vector<type_t> vecs;
+	for(int i = 0 ; i < 1000 ; i++){
+		const auto s = make_struct(types, struct_type_desc_t( { member_t(type_t::make_int(), std::to_string(i)) } ));
+		vecs.push_back(make_vector(types, s));
+	}
+
+	const types_t copy = types;
+	for(int i = 0 ; i < 1000 ; i++){
+		const auto s = make_struct(copy, struct_type_desc_t( { member_t(type_t::make_int(), std::to_string(i)) } ));
+		QUARK_VERIFY(make_vector(copy, s) == vecs[i]);
+	}
+}
+
+QUARK_TEST("Types", "make_symbol_ref()", "\"\"", "the built-in symbol ref node"){
+	types_t types;
+	const auto count = types.nodes.size();
+	const auto a = make_symbol_ref(types, "");
+	QUARK_VERIFY(a.get_lookup_index() == (type_lookup_index_t)base_type::k_symbol_ref);
+	QUARK_VERIFY(types.nodes.size() == count);
+}
+
+QUARK_TEST("Types", "lookup_type_from_name()", "", "finds the named type"){
+	types_t types;
+	const auto name = unpack_type_name("/a/b");
+	const auto a = make_named_type(types, name, type_t::make_int());
+	QUARK_VERIFY(lookup_type_from_name(types, name) == a);
+}
+
+QUARK_TEST("Types", "make_named_type()", "name already used", "exception"){
+	types_t types;
+	const auto name = unpack_type_name("/a/b");
+	make_named_type(types, name, type_t::make_int());
+	try{
+		make_named_type(types, name, type_t::make_int());
+		QUARK_VERIFY(false);
+	}
+	catch(const std::exception& e){
+	}
+}
+
 
 
 }	// floyd
@@ -924,6 +924,18 @@ inline bool operator==(const type_node_t& lhs, const type_node_t& rhs){
 
 
 
+//	Open addressing hash table of indexes into types_t::nodes, linear probing. slots is empty or a power of
+//	two, at most half full. An empty slot has index -1.
+struct type_index_t {
+	struct slot_t {
+		uint32_t hash;
+		type_lookup_index_t index;
+	};
+
+	std::vector<slot_t> slots;
+	std::size_t count = 0;
+};
+
 struct types_t {
 	types_t();
 
@@ -935,6 +947,13 @@ struct types_t {
 	//	All types are recorded here, an uniqued. Including named types.
 	//	type uses the INDEX into this array for fast lookups.
 	std::vector<type_node_t> nodes;
+
+	//	Open addressing hash tables of indexes into nodes, so interning a type doesn't scan all nodes.
+	//	node_index holds the unnamed nodes, found from their contents. Only the first of equal nodes is recorded.
+	//	name_index holds the named nodes, found from their name.
+	//	They are flat vectors because the semantic analyser copies types_t a lot.
+	type_index_t node_index;
+	type_index_t name_index;
 };
 
 
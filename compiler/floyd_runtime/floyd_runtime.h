@@ -22,19 +22,6 @@ namespace floyd {
 struct value_t;
 
 
-//////////////////////////////////////		runtime_handler_i
-
-/*
-	This is a callback from the running Floyd process.
-	that allows the interpreter to indirectly control the outside runtime that hosts the interpreter.
-	FUTURE: Needs neater solution than this.
-*/
-struct runtime_handler_i {
-	virtual ~runtime_handler_i(){};
-	virtual void on_send(const std::string& process_id, const json_t& message) = 0;
-};
-
-
 value_t unflatten_json_to_specific_type(types_t& types, const json_t& v, const type_t& target_type);
 
 
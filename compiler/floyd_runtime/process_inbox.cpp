@@ -0,0 +1,96 @@
+//
+//  process_inbox.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-04.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "process_inbox.h"
+
+#include <string>
+#include <thread>
+
+
+namespace floyd {
+
+
+QUARK_TEST("mpsc_queue_t", "pop()", "empty queue", "returns false"){
+	mpsc_queue_t<int> q;
+	int value = 0;
+	QUARK_VERIFY(q.empty());
+	QUARK_VERIFY(q.pop(value) == false);
+}
+
+QUARK_TEST("mpsc_queue_t", "pop()", "one producer", "FIFO order"){
+	mpsc_queue_t<std::string> q;
+	q.push("a");
+	q.push("b");
+	q.push("c");
+	QUARK_VERIFY(q.empty() == false);
+
+	std::string value;
+	QUARK_VERIFY(q.pop(value) && value == "a");
+	QUARK_VERIFY(q.pop(value) && value == "b");
+	QUARK_VERIFY(q.pop(value) && value == "c");
+	QUARK_VERIFY(q.pop(value) == false);
+	QUARK_VERIFY(q.empty());
+}
+
+QUARK_TEST("mpsc_queue_t", "pop_batch()", "5 messages, batch of 3", "takes 3, leaves 2"){
+	mpsc_queue_t<int> q;
+	for(int i = 0 ; i < 5 ; i++){
+		q.push(i);
+	}
+	std::vector<int> batch;
+	QUARK_VERIFY(q.pop_batch(batch, 3) == 3);
+	QUARK_VERIFY((batch == std::vector<int>{ 0, 1, 2 }));
+	QUARK_VERIFY(q.pop_batch(batch, 3) == 2);
+	QUARK_VERIFY((batch == std::vector<int>{ 0, 1, 2, 3, 4 }));
+}
+
+QUARK_TEST("mpsc_queue_t", "~mpsc_queue_t()", "messages left", "no leak"){
+	mpsc_queue_t<std::string> q;
+	q.push(std::string(100, 'x'));
+	q.push(std::string(100, 'y'));
+}
+
+QUARK_TEST("mpsc_queue_t", "push()", "4 producers, 10000 messages each", "consumer gets all, each producer's messages in order"){
+	const int producer_count = 4;
+	const int message_count = 10000;
+	mpsc_queue_t<int> q;
+
+	std::vector<std::thread> producers;
+	for(int p = 0 ; p < producer_count ; p++){
+		producers.push_back(std::thread([&q, p](){
+			for(int i = 0 ; i < message_count ; i++){
+				q.push(p * message_count + i);
+			}
+		}));
+	}
+
+	std::vector<int> next(producer_count, 0);
+	std::vector<int> batch;
+	int received = 0;
+	while(received < producer_count * message_count){
+		batch.clear();
+		q.pop_batch(batch, 16);
+		for(const auto e: batch){
+			const auto p = e / message_count;
+			QUARK_VERIFY(e % message_count == next[p]);
+			next[p]++;
+		}
+		received += static_cast<int>(batch.size());
+		if(batch.empty()){
+			std::this_thread::yield();
+		}
+	}
+
+	for(auto& t: producers){
+		t.join();
+	}
+	QUARK_VERIFY(q.empty());
+}
+
+
+}	//	floyd
@@ -0,0 +1,122 @@
+//
+//  process_inbox.h
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-04.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#ifndef process_inbox_h
+#define process_inbox_h
+
+/*
+	Lock-free multi-producer single-consumer queue, used as the inbox of a Floyd process.
+
+	Any thread can push. Only the thread currently running the process may pop -- process_scheduler_t guarantees
+	that there is only one such thread at a time.
+
+	Linked list of nodes with a dummy node at the tail (Vyukov's MPSC queue). A push is one atomic exchange of head
+	plus one store, no locks and no wakeups. Messages come out in the order the exchanges happened.
+
+	A push that is half done (head exchanged, next not yet linked) isn't visible to pop() yet. This is OK: the
+	sender calls notify_process() after push() returns, which reschedules the process if it went idle.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "quark.h"
+
+namespace floyd {
+
+
+template <typename T> struct mpsc_queue_t {
+	struct node_t {
+		std::atomic<node_t*> next { nullptr };
+		T value;
+	};
+
+	mpsc_queue_t() :
+		head(new node_t()),
+		tail(head.load()),
+		count(0)
+	{
+	}
+
+	~mpsc_queue_t(){
+		auto node = tail;
+		while(node != nullptr){
+			const auto next = node->next.load(std::memory_order_relaxed);
+			delete node;
+			node = next;
+		}
+	}
+
+	mpsc_queue_t(const mpsc_queue_t& other) = delete;
+	mpsc_queue_t& operator=(const mpsc_queue_t& other) = delete;
+
+	bool check_invariant() const {
+		QUARK_ASSERT(tail != nullptr);
+		return true;
+	}
+
+
+	//	Any thread.
+	void push(T value){
+		auto node = new node_t();
+		node->value = std::move(value);
+
+		const auto prev = head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+		count.fetch_add(1, std::memory_order_release);
+	}
+
+	//	Consumer only.
+	bool pop(T& value){
+		const auto next = tail->next.load(std::memory_order_acquire);
+		if(next == nullptr){
+			return false;
+		}
+
+		//	next becomes the new dummy node. Its value has been moved out.
+		value = std::move(next->value);
+		delete tail;
+		tail = next;
+		count.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	//	Consumer only. Moves up to max_count messages to the end of out. Returns how many.
+	size_t pop_batch(std::vector<T>& out, size_t max_count){
+		size_t result = 0;
+		T value;
+		while(result < max_count && pop(value)){
+			out.push_back(std::move(value));
+			result++;
+		}
+		return result;
+	}
+
+	//	Any thread. Can be out of date by the time it returns, but sees every push() that has returned.
+	bool empty() const {
+		return count.load(std::memory_order_acquire) <= 0;
+	}
+
+
+	////////////////////////////////		STATE
+
+	//	Newest node. Producers race on this.
+	std::atomic<node_t*> head;
+
+	//	Dummy node, owned by the consumer. The oldest message is in tail->next.
+	node_t* tail;
+
+	//	Can go briefly negative when the consumer pops a message before its producer has counted it.
+	std::atomic<int64_t> count;
+};
+
+
+}	//	floyd
+
+#endif /* process_inbox_h */
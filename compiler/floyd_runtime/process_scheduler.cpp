@@ -0,0 +1,305 @@
+//
+//  process_scheduler.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-03.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "process_scheduler.h"
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "quark.h"
+
+
+namespace floyd {
+
+
+process_scheduler_t::process_scheduler_t(size_t process_count) :
+	process_count(process_count),
+	process_states(new std::atomic<eprocess_state>[process_count]),
+	stopped_count(0),
+	queued_count(static_cast<int64_t>(process_count)),
+	done_flag(false),
+	parked_count(0)
+{
+	//	All processes start scheduled so they get their first slice.
+	for(size_t i = 0 ; i < process_count ; i++){
+		process_states[i].store(eprocess_state::scheduled);
+		run_queue.push_back(static_cast<int>(i));
+	}
+
+	QUARK_ASSERT(check_invariant());
+}
+
+bool process_scheduler_t::check_invariant() const {
+	QUARK_ASSERT(stopped_count <= process_count);
+	return true;
+}
+
+void notify_process(process_scheduler_t& scheduler, int process_id){
+	QUARK_ASSERT(process_id >= 0 && process_id < scheduler.process_count);
+
+	auto expected = process_scheduler_t::eprocess_state::idle;
+	if(scheduler.process_states[process_id].compare_exchange_strong(expected, process_scheduler_t::eprocess_state::scheduled)){
+		bool wake = false;
+		{
+			std::lock_guard<std::mutex> lock(scheduler.run_queue_mutex);
+			scheduler.run_queue.push_back(process_id);
+			scheduler.queued_count.fetch_add(1, std::memory_order_release);
+			wake = scheduler.parked_count > 0;
+		}
+		if(wake){
+			scheduler.run_queue_condition.notify_one();
+		}
+	}
+}
+
+static bool is_scheduler_done(const process_scheduler_t& scheduler){
+	return scheduler.done_flag.load();
+}
+
+//	Call with run_queue_mutex locked.
+static void set_scheduler_done(process_scheduler_t& scheduler){
+	scheduler.done_flag.store(true);
+}
+
+static void spin_for_work(const process_scheduler_t& scheduler){
+	for(int i = 0 ; i < k_scheduler_spin_count ; i++){
+		if(scheduler.queued_count.load(std::memory_order_acquire) > 0 || is_scheduler_done(scheduler)){
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+static void run_scheduler_thread(
+	process_scheduler_t& scheduler,
+	const std::function<bool (int process_id)>& run_slice,
+	const std::function<bool (int process_id)>& has_messages
+){
+	while(true){
+		spin_for_work(scheduler);
+
+		int process_id = -1;
+		{
+			std::unique_lock<std::mutex> lock(scheduler.run_queue_mutex);
+			if(is_scheduler_done(scheduler) == false && scheduler.run_queue.empty()){
+				scheduler.parked_count++;
+				scheduler.run_queue_condition.wait(lock, [&](){ return is_scheduler_done(scheduler) || scheduler.run_queue.empty() == false; });
+				scheduler.parked_count--;
+			}
+			if(is_scheduler_done(scheduler)){
+				return;
+			}
+			process_id = scheduler.run_queue.front();
+			scheduler.run_queue.pop_front();
+			scheduler.queued_count.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		bool stopped = false;
+		try {
+			stopped = run_slice(process_id);
+		}
+		catch(...){
+			{
+				std::lock_guard<std::mutex> lock(scheduler.run_queue_mutex);
+				if(!scheduler.error){
+					scheduler.error = std::current_exception();
+				}
+				set_scheduler_done(scheduler);
+			}
+			scheduler.run_queue_condition.notify_all();
+			return;
+		}
+
+		if(stopped){
+			scheduler.process_states[process_id].store(process_scheduler_t::eprocess_state::stopped);
+			bool done = false;
+			{
+				std::lock_guard<std::mutex> lock(scheduler.run_queue_mutex);
+				scheduler.stopped_count++;
+				done = scheduler.stopped_count == scheduler.process_count;
+				if(done){
+					set_scheduler_done(scheduler);
+				}
+			}
+			if(done){
+				scheduler.run_queue_condition.notify_all();
+			}
+		}
+		else{
+			//	A sender that saw "scheduled" didn't queue us. Go idle first, then check the inbox, so no message is missed.
+			scheduler.process_states[process_id].store(process_scheduler_t::eprocess_state::idle);
+			if(has_messages(process_id)){
+				notify_process(scheduler, process_id);
+			}
+		}
+	}
+}
+
+void run_process_scheduler(
+	process_scheduler_t& scheduler,
+	size_t thread_count,
+	const std::function<bool (int process_id)>& run_slice,
+	const std::function<bool (int process_id)>& has_messages
+){
+	QUARK_ASSERT(scheduler.check_invariant());
+	QUARK_ASSERT(thread_count >= 1);
+
+	std::vector<std::thread> worker_threads;
+	for(size_t i = 1 ; i < thread_count ; i++){
+		worker_threads.push_back(std::thread([&](){ run_scheduler_thread(scheduler, run_slice, has_messages); }));
+	}
+	run_scheduler_thread(scheduler, run_slice, has_messages);
+
+	for(auto& t: worker_threads){
+		t.join();
+	}
+
+	if(scheduler.error){
+		std::rethrow_exception(scheduler.error);
+	}
+}
+
+
+
+//	Minimal process runtime for the tests: an inbox of ints per process, -1 = stop.
+struct test_processes_t {
+	test_processes_t(size_t count) :
+		scheduler(count),
+		inbox_mutexes(count),
+		inboxes(count),
+		handled_counts(count, 0)
+	{
+	}
+
+	void send(int process_id, int message){
+		{
+			std::lock_guard<std::mutex> lock(inbox_mutexes[process_id]);
+			inboxes[process_id].push_back(message);
+		}
+		notify_process(scheduler, process_id);
+	}
+
+	bool pop(int process_id, int& message){
+		std::lock_guard<std::mutex> lock(inbox_mutexes[process_id]);
+		if(inboxes[process_id].empty()){
+			return false;
+		}
+		message = inboxes[process_id].front();
+		inboxes[process_id].pop_front();
+		return true;
+	}
+
+	bool has_messages(int process_id){
+		std::lock_guard<std::mutex> lock(inbox_mutexes[process_id]);
+		return inboxes[process_id].empty() == false;
+	}
+
+	process_scheduler_t scheduler;
+	std::vector<std::mutex> inbox_mutexes;
+	std::vector<std::deque<int>> inboxes;
+
+	//	Only touched by the thread running the process.
+	std::vector<int> handled_counts;
+};
+
+QUARK_TEST("process_scheduler_t", "run_process_scheduler()", "200 processes pass a token around 3 times, 4 threads", "each process handles 3 messages then stops"){
+	const int process_count = 200;
+	test_processes_t t(process_count);
+
+	//	Message = hop count. Process 0 starts the token in its first slice.
+	std::vector<uint8_t> started(process_count, 0);
+	const auto run_slice = [&](int process_id){
+		if(started[process_id] == 0){
+			started[process_id] = 1;
+			if(process_id == 0){
+				t.send(1, 1);
+			}
+		}
+
+		int message = 0;
+		for(size_t i = 0 ; i < k_process_slice_message_count && t.pop(process_id, message) ; i++){
+			if(message == -1){
+				return true;
+			}
+			t.handled_counts[process_id]++;
+			const auto hops = message + 1;
+			if(hops <= process_count * 3){
+				t.send((process_id + 1) % process_count, hops);
+			}
+			else{
+				for(int p = 0 ; p < process_count ; p++){
+					t.send(p, -1);
+				}
+			}
+		}
+		return false;
+	};
+
+	run_process_scheduler(t.scheduler, 4, run_slice, [&](int process_id){ return t.has_messages(process_id); });
+
+	for(const auto e: t.handled_counts){
+		QUARK_VERIFY(e == 3);
+	}
+}
+
+QUARK_TEST("process_scheduler_t", "run_process_scheduler()", "busy process", "doesn't starve the others"){
+	test_processes_t t(2);
+
+	//	Process 0 floods itself. Process 1 stops everything the first time it runs after its init-slice.
+	std::vector<uint8_t> started(2, 0);
+	int flood_count = 0;
+	const auto run_slice = [&](int process_id){
+		if(started[process_id] == 0){
+			started[process_id] = 1;
+			if(process_id == 0){
+				t.send(0, 0);
+				t.send(1, 0);
+			}
+			return false;
+		}
+
+		int message = 0;
+		for(size_t i = 0 ; i < k_process_slice_message_count && t.pop(process_id, message) ; i++){
+			if(message == -1){
+				return true;
+			}
+			if(process_id == 0){
+				flood_count++;
+				t.send(0, 0);
+			}
+			else{
+				t.send(0, -1);
+				t.send(1, -1);
+			}
+		}
+		return false;
+	};
+
+	run_process_scheduler(t.scheduler, 1, run_slice, [&](int process_id){ return t.has_messages(process_id); });
+	QUARK_VERIFY(flood_count <= k_process_slice_message_count * 2);
+}
+
+QUARK_TEST("process_scheduler_t", "run_process_scheduler()", "slice throws", "exception reaches caller"){
+	test_processes_t t(3);
+	try {
+		run_process_scheduler(
+			t.scheduler,
+			2,
+			[&](int process_id) -> bool { throw std::runtime_error("bad process"); },
+			[&](int process_id){ return t.has_messages(process_id); }
+		);
+		QUARK_VERIFY(false);
+	}
+	catch(const std::runtime_error& e){
+		QUARK_VERIFY(std::string(e.what()) == "bad process");
+	}
+}
+
+
+}	//	floyd
@@ -0,0 +1,103 @@
+//
+//  process_scheduler.h
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-03.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#ifndef process_scheduler_h
+#define process_scheduler_h
+
+/*
+	M:N scheduling of Floyd processes: any number of processes run on a fixed number of OS threads.
+
+	A process is only ever run by one thread at a time, so its state stays single-threaded. It is scheduled when
+	it has messages, runs one slice (a limited batch of messages) and then goes to the back of the run queue if it
+	has more messages. This keeps one busy process from starving the others.
+
+	The scheduler doesn't know about inboxes or messages -- the runtime supplies run_slice() and has_messages().
+	The runtimes schedule one clock bus per scheduler "process": all Floyd processes on a clock share one
+	execution context, so sends between them can run the receiver synchronously.
+
+	A thread that runs out of work spins for a short while before it parks on run_queue_condition: messages
+	usually arrive in bursts and a wakeup costs much more than a few yields. notify_process() only signals the
+	condition when some thread is actually parked.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace floyd {
+
+
+//	Max number of messages a process handles before it has to let the other processes run.
+const size_t k_process_slice_message_count = 16;
+
+//	How many times an idle scheduler thread yields, looking for work, before it parks.
+const int k_scheduler_spin_count = 64;
+
+struct process_scheduler_t {
+	enum class eprocess_state {
+		idle,
+
+		//	In the run queue or running right now.
+		scheduled,
+
+		stopped
+	};
+
+	explicit process_scheduler_t(size_t process_count);
+	bool check_invariant() const;
+
+	process_scheduler_t(const process_scheduler_t& other) = delete;
+	process_scheduler_t& operator=(const process_scheduler_t& other) = delete;
+
+
+	////////////////////////////////		STATE
+
+	size_t process_count;
+	std::unique_ptr<std::atomic<eprocess_state>[]> process_states;
+
+	std::mutex run_queue_mutex;
+	std::condition_variable run_queue_condition;
+	std::deque<int> run_queue;
+	size_t stopped_count;
+	std::exception_ptr error;
+
+	//	Lets spinning threads check for work without taking run_queue_mutex.
+	std::atomic<int64_t> queued_count;
+	std::atomic<bool> done_flag;
+
+	//	Threads waiting on run_queue_condition. Protected by run_queue_mutex.
+	size_t parked_count;
+};
+
+//	Call after putting a message in the process's inbox. Schedules the process unless it's already scheduled. Thread-safe.
+void notify_process(process_scheduler_t& scheduler, int process_id);
+
+/*
+	Runs all processes on thread_count threads, the calling thread included, until every process has stopped.
+	Every process gets one first slice, even without messages. This is where the runtime calls its init function.
+
+	run_slice(process_id): handle at most k_process_slice_message_count messages. Return true when the process has stopped.
+	has_messages(process_id): true if the process's inbox isn't empty.
+
+	If a slice throws, all threads stop and the exception is rethrown here.
+*/
+void run_process_scheduler(
+	process_scheduler_t& scheduler,
+	size_t thread_count,
+	const std::function<bool (int process_id)>& run_slice,
+	const std::function<bool (int process_id)>& has_messages
+);
+
+
+}	//	floyd
+
+#endif /* process_scheduler_h */
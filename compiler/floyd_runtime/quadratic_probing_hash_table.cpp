@@ -7,3 +7,127 @@
 //
 
 #include "quadratic_probing_hash_table.h"
+
+#include <map>
+
+
+namespace floyd {
+
+
+typedef quadratic_probing_hash_table_t<double> test_table_t;
+
+
+QUARK_TEST("quadratic_probing_hash_table_t", "", "", ""){
+	QUARK_VERIFY(sizeof(test_table_t) == 32);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "find()", "empty table", "nullptr"){
+	const test_table_t t;
+	QUARK_VERIFY(t.size() == 0);
+	QUARK_VERIFY(t.capacity() == 0);
+	QUARK_VERIFY(t.find("a") == nullptr);
+	QUARK_VERIFY(t.begin() == t.end());
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "insert_or_assign()", "3 keys", "all found"){
+	test_table_t t;
+	QUARK_VERIFY(t.insert_or_assign("one", 1.0));
+	QUARK_VERIFY(t.insert_or_assign("two", 2.0));
+	QUARK_VERIFY(t.insert_or_assign("three", 3.0));
+
+	QUARK_VERIFY(t.size() == 3);
+	QUARK_VERIFY(*t.find("one") == 1.0);
+	QUARK_VERIFY(*t.find("two") == 2.0);
+	QUARK_VERIFY(*t.find("three") == 3.0);
+	QUARK_VERIFY(t.find("four") == nullptr);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "insert_or_assign()", "existing key", "replaces value"){
+	test_table_t t;
+	t.insert_or_assign("a", 1.0);
+	QUARK_VERIFY(t.insert_or_assign("a", 2.0) == false);
+	QUARK_VERIFY(t.size() == 1);
+	QUARK_VERIFY(*t.find("a") == 2.0);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "find()", "std::string_view + hash", "same entries as std::string keys"){
+	test_table_t t;
+	t.insert_or_assign("one", 1.0);
+
+	const std::string_view one = "one";
+	const std::string_view two = "two";
+	QUARK_VERIFY(*t.find(one, std::hash<std::string_view>{}(one)) == 1.0);
+	QUARK_VERIFY(t.find(two, std::hash<std::string_view>{}(two)) == nullptr);
+
+	QUARK_VERIFY(t.insert_or_assign(two, std::hash<std::string_view>{}(two), 2.0));
+	QUARK_VERIFY(*t.find("two") == 2.0);
+	QUARK_VERIFY(t.erase(one, std::hash<std::string_view>{}(one)));
+	QUARK_VERIFY(t.find("one") == nullptr);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "erase()", "", "key gone, others kept"){
+	test_table_t t;
+	t.insert_or_assign("a", 1.0);
+	t.insert_or_assign("b", 2.0);
+	QUARK_VERIFY(t.erase("a"));
+	QUARK_VERIFY(t.erase("a") == false);
+	QUARK_VERIFY(t.size() == 1);
+	QUARK_VERIFY(t.find("a") == nullptr);
+	QUARK_VERIFY(*t.find("b") == 2.0);
+
+	QUARK_VERIFY(t.insert_or_assign("a", 3.0));
+	QUARK_VERIFY(*t.find("a") == 3.0);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "insert_or_assign()", "1000 keys, erase every other", "matches std::map"){
+	test_table_t t;
+	std::map<std::string, double> ref;
+	for(int i = 0 ; i < 1000 ; i++){
+		const auto key = "key" + std::to_string(i);
+		t.insert_or_assign(key, i);
+		ref[key] = i;
+	}
+	for(int i = 0 ; i < 1000 ; i += 2){
+		const auto key = "key" + std::to_string(i);
+		t.erase(key);
+		ref.erase(key);
+	}
+	QUARK_VERIFY(t.size() == ref.size());
+	QUARK_VERIFY((t.capacity() & (t.capacity() - 1)) == 0);
+
+	std::map<std::string, double> all;
+	for(const auto& e: t){
+		all.insert(e);
+	}
+	QUARK_VERIFY(all == ref);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "erase()", "insert + erase many times", "tombstones don't make the table grow"){
+	test_table_t t;
+	for(int i = 0 ; i < 10000 ; i++){
+		const auto key = std::to_string(i);
+		t.insert_or_assign(key, i);
+		t.erase(key);
+	}
+	QUARK_VERIFY(t.size() == 0);
+	QUARK_VERIFY(t.capacity() == test_table_t::k_min_capacity);
+}
+
+QUARK_TEST("quadratic_probing_hash_table_t", "quadratic_probing_hash_table_t()", "copy", "copies are independent"){
+	quadratic_probing_hash_table_t<std::string> a;
+	a.insert_or_assign("a", std::string(100, 'a'));
+	a.insert_or_assign("b", "bee");
+
+	auto b = a;
+	b.insert_or_assign("a", "aa");
+	b.erase("b");
+
+	QUARK_VERIFY(a.size() == 2);
+	QUARK_VERIFY(*a.find("a") == std::string(100, 'a'));
+	QUARK_VERIFY(*a.find("b") == "bee");
+	QUARK_VERIFY(b.size() == 1);
+	QUARK_VERIFY(*b.find("a") == "aa");
+}
+
+
+}	//	floyd
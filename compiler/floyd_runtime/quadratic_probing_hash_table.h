@@ -9,45 +9,336 @@
 #ifndef quadratic_probing_hash_table_hpp
 #define quadratic_probing_hash_table_hpp
 
+/*
+	Open addressing hash table with std::string keys, used as the "hash" dictionary backend.
+
+	One heap block holds all slots: first an array of 64 bit hashes, then an array of key-value entries.
+	Lookups probe the hash array only and compare keys when the hashes match, so a miss usually touches one
+	cache line. The hash of each key is cached, growing never rehashes the strings.
+
+	Capacity is a power of two. Probing steps 1, 2, 3... slots (triangular numbers), which visits every slot
+	in a power-of-two table. The table grows when 3/4 of the slots are used, tombstones included.
+
+	Iteration order is the slot order, not sorted, like HAMT.
+
+	The std::string_view overloads take the key's std::hash<std::string_view>. Callers that cache that hash
+	look up keys without making a std::string or hashing the characters again.
+
+	The whole table is 32 bytes so it fits inside heap_alloc_64_t::data.
+
+	https://www.youtube.com/watch?v=7eLDTtbzX4M
+*/
+
+#include <cstring>
+#include <functional>
+#include <new>
 #include <string>
-#include <vector>
+#include <string_view>
+#include <utility>
 
+#include "quark.h"
 
-struct kv_t {
-	std::string key;
-	double value;
-};
+namespace floyd {
+
+
+template <typename V> struct quadratic_probing_hash_table_t {
+	typedef std::pair<std::string, V> entry_t;
 
+	static const uint64_t k_empty = 0;
+	static const uint64_t k_tombstone = 1;
+	static const uint64_t k_min_capacity = 8;
 
+	struct const_iterator {
+		bool operator==(const const_iterator& other) const { return index == other.index; }
+		bool operator!=(const const_iterator& other) const { return index != other.index; }
 
-//	std::size_t h2 = std::hash<std::string>{}(s.last_name);
-//	https://www.youtube.com/watch?v=7eLDTtbzX4M
+		const entry_t& operator*() const { return table->get_entries()[index]; }
+		const entry_t* operator->() const { return &table->get_entries()[index]; }
 
-struct quadratic_probing_hash_table_t {
-	enum class mode {
-		empty,
-		tombstone
+		const_iterator& operator++(){
+			index = table->next_live_slot(index + 1);
+			return *this;
+		}
+
+		const quadratic_probing_hash_table_t* table;
+		uint64_t index;
 	};
 
-	quadratic_probing_hash_table_t(int64_t table_size) :
-		backstore(table_size, std::pair<mode, kv_t>(mode::empty, kv_t { "-", 3.0 }))
+
+	quadratic_probing_hash_table_t() :
+		_hashes(nullptr),
+		_capacity(0),
+		_count(0),
+		_used(0)
+	{
+		QUARK_ASSERT(check_invariant());
+	}
+
+	quadratic_probing_hash_table_t(const quadratic_probing_hash_table_t& other) :
+		_hashes(nullptr),
+		_capacity(0),
+		_count(0),
+		_used(0)
 	{
+		QUARK_ASSERT(other.check_invariant());
+
+		if(other._capacity > 0){
+			_hashes = alloc_slots(other._capacity);
+			_capacity = other._capacity;
+			std::memcpy(_hashes, other._hashes, sizeof(uint64_t) * _capacity);
+
+			const auto source = other.get_entries();
+			const auto dest = get_entries();
+			for(uint64_t i = 0 ; i < _capacity ; i++){
+				if(_hashes[i] > k_tombstone){
+					new (&dest[i]) entry_t(source[i]);
+				}
+			}
+			_count = other._count;
+			_used = other._used;
+		}
+		QUARK_ASSERT(check_invariant());
 	}
 
-	quadratic_probing_hash_table_t(const kv_t values[], int64_t count, int64_t table_size){
+	quadratic_probing_hash_table_t& operator=(const quadratic_probing_hash_table_t& other){
+		QUARK_ASSERT(check_invariant());
+		QUARK_ASSERT(other.check_invariant());
+
+		quadratic_probing_hash_table_t temp(other);
+		swap(temp);
+		return *this;
 	}
 
-	void insert(const kv_t& kv){
-		const auto hash0 = std::hash<std::string>{}(kv.key);
-		(void)hash0;
+	~quadratic_probing_hash_table_t(){
+		QUARK_ASSERT(check_invariant());
+
+		destroy_slots(_hashes, _capacity);
 	}
 
+	bool check_invariant() const {
+		QUARK_ASSERT((_capacity == 0) == (_hashes == nullptr));
+		QUARK_ASSERT((_capacity & (_capacity - 1)) == 0);
+		QUARK_ASSERT(_count <= _used);
+		QUARK_ASSERT(_capacity == 0 || _used < _capacity);
+		return true;
+	}
+
+	void swap(quadratic_probing_hash_table_t& other){
+		std::swap(_hashes, other._hashes);
+		std::swap(_capacity, other._capacity);
+		std::swap(_count, other._count);
+		std::swap(_used, other._used);
+	}
+
+	uint64_t size() const {
+		return _count;
+	}
+
+	uint64_t capacity() const {
+		return _capacity;
+	}
+
+	const_iterator begin() const {
+		return const_iterator{ this, next_live_slot(0) };
+	}
+	const_iterator end() const {
+		return const_iterator{ this, _capacity };
+	}
+
+	//	Returns nullptr if key doesn't exist.
+	const V* find(const std::string& key) const {
+		return find(key, std::hash<std::string_view>{}(key));
+	}
+	const V* find(std::string_view key, std::size_t key_hash) const {
+		QUARK_ASSERT(check_invariant());
+
+		const auto index = find_slot(key, adjust_hash(key_hash));
+		return index == _capacity ? nullptr : &get_entries()[index].second;
+	}
+	V* find_mut(const std::string& key){
+		return const_cast<V*>(static_cast<const quadratic_probing_hash_table_t*>(this)->find(key));
+	}
+	V* find_mut(std::string_view key, std::size_t key_hash){
+		return const_cast<V*>(static_cast<const quadratic_probing_hash_table_t*>(this)->find(key, key_hash));
+	}
+
+	//	Returns true if the key was added, false if an existing value was replaced.
+	bool insert_or_assign(const std::string& key, const V& value){
+		return insert_or_assign(key, std::hash<std::string_view>{}(key), value);
+	}
+
+	//	Only makes a std::string of key if it's added.
+	bool insert_or_assign(std::string_view key, std::size_t key_hash, const V& value){
+		QUARK_ASSERT(check_invariant());
+
+		const auto hash = adjust_hash(key_hash);
+		const auto index = find_slot(key, hash);
+		if(index != _capacity){
+			get_entries()[index].second = value;
+			return false;
+		}
+
+		if((_used + 1) * 4 > _capacity * 3){
+			rehash(calc_capacity(_count + 1));
+		}
+
+		//	The key isn't in the table so the first free slot is OK, even a tombstone.
+		const auto mask = _capacity - 1;
+		auto i = hash & mask;
+		for(uint64_t step = 1 ; _hashes[i] > k_tombstone ; step++){
+			i = (i + step) & mask;
+		}
+		if(_hashes[i] == k_empty){
+			_used++;
+		}
+		_hashes[i] = hash;
+		new (&get_entries()[i]) entry_t(std::string(key), value);
+		_count++;
+
+		QUARK_ASSERT(check_invariant());
+		return true;
+	}
+
+	//	Returns false if the key didn't exist.
+	bool erase(const std::string& key){
+		return erase(key, std::hash<std::string_view>{}(key));
+	}
+	bool erase(std::string_view key, std::size_t key_hash){
+		QUARK_ASSERT(check_invariant());
+
+		const auto index = find_slot(key, adjust_hash(key_hash));
+		if(index == _capacity){
+			return false;
+		}
+		get_entries()[index].~entry_t();
+		_hashes[index] = k_tombstone;
+		_count--;
+
+		QUARK_ASSERT(check_invariant());
+		return true;
+	}
+
+	//	Makes room for count keys without growing.
+	void reserve(uint64_t count){
+		QUARK_ASSERT(check_invariant());
+
+		if((count + 1) * 4 > _capacity * 3){
+			rehash(calc_capacity(count));
+		}
+	}
+
+
+	////////////////////////////////		INTERNALS
+
+
+	//	0 and 1 mark empty slots and tombstones in the hash array.
+	static uint64_t adjust_hash(std::size_t key_hash){
+		const uint64_t hash = key_hash;
+		return hash > k_tombstone ? hash : hash + 2;
+	}
+
+	//	Smallest power of two that keeps count keys under half full.
+	static uint64_t calc_capacity(uint64_t count){
+		uint64_t result = k_min_capacity;
+		while(result < count * 2){
+			result = result * 2;
+		}
+		return result;
+	}
+
+	//	Entries array lives right after the hashes array. Only slots with a hash > k_tombstone hold a constructed entry.
+	static uint64_t* alloc_slots(uint64_t capacity){
+		const auto bytes = capacity * (sizeof(uint64_t) + sizeof(entry_t));
+		auto result = reinterpret_cast<uint64_t*>(::operator new(bytes));
+		std::memset(result, 0, sizeof(uint64_t) * capacity);
+		return result;
+	}
+	static void destroy_slots(uint64_t* hashes, uint64_t capacity){
+		if(hashes != nullptr){
+			auto entries = reinterpret_cast<entry_t*>(hashes + capacity);
+			for(uint64_t i = 0 ; i < capacity ; i++){
+				if(hashes[i] > k_tombstone){
+					entries[i].~entry_t();
+				}
+			}
+			::operator delete(hashes);
+		}
+	}
+
+	const entry_t* get_entries() const {
+		return reinterpret_cast<const entry_t*>(_hashes + _capacity);
+	}
+	entry_t* get_entries(){
+		return reinterpret_cast<entry_t*>(_hashes + _capacity);
+	}
+
+	uint64_t next_live_slot(uint64_t index) const {
+		while(index < _capacity && _hashes[index] <= k_tombstone){
+			index++;
+		}
+		return index;
+	}
+
+	//	Returns _capacity if not found.
+	uint64_t find_slot(std::string_view key, uint64_t hash) const {
+		if(_capacity == 0){
+			return _capacity;
+		}
+
+		const auto mask = _capacity - 1;
+		const auto entries = get_entries();
+		auto i = hash & mask;
+		for(uint64_t step = 1 ; _hashes[i] != k_empty ; step++){
+			if(_hashes[i] == hash && entries[i].first == key){
+				return i;
+			}
+			i = (i + step) & mask;
+		}
+		return _capacity;
+	}
+
+	//	Moves all entries into a new block. Drops the tombstones.
+	void rehash(uint64_t new_capacity){
+		QUARK_ASSERT(new_capacity > _count);
+
+		auto new_hashes = alloc_slots(new_capacity);
+		auto new_entries = reinterpret_cast<entry_t*>(new_hashes + new_capacity);
+		const auto mask = new_capacity - 1;
+
+		auto entries = get_entries();
+		for(uint64_t i = 0 ; i < _capacity ; i++){
+			const auto hash = _hashes[i];
+			if(hash > k_tombstone){
+				auto dest = hash & mask;
+				for(uint64_t step = 1 ; new_hashes[dest] != k_empty ; step++){
+					dest = (dest + step) & mask;
+				}
+				new_hashes[dest] = hash;
+				new (&new_entries[dest]) entry_t(std::move(entries[i]));
+			}
+		}
+
+		destroy_slots(_hashes, _capacity);
+		_hashes = new_hashes;
+		_capacity = new_capacity;
+		_used = _count;
+	}
 
 
 	////////////////////////////////		STATE
 
-	std::vector<std::pair<mode, kv_t>> backstore;
+	//	Block with capacity hashes followed by capacity entries. nullptr when capacity is 0.
+	uint64_t* _hashes;
+	uint64_t _capacity;
+
+	//	Live entries.
+	uint64_t _count;
+
+	//	Live entries + tombstones.
+	uint64_t _used;
 };
 
 
+}	//	floyd
+
 #endif /* quadratic_probing_hash_table_hpp */
@@ -0,0 +1,268 @@
+//
+//  thread_team.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-02.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "thread_team.h"
+
+#include "hardware_caps.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "quark.h"
+
+
+namespace floyd {
+
+
+//	Don't start more threads than this even on huge machines.
+static const size_t k_max_thread_team_size = 256;
+
+
+
+//	Which team and worker queue the current thread belongs to. nullptr for threads outside any team.
+struct team_membership_t {
+	thread_team_t* team;
+	size_t queue_index;
+};
+
+static thread_local team_membership_t t_team_membership { nullptr, 0 };
+
+
+
+static bool pop_back_task(team_queue_t& queue, std::function<void()>& task){
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if(queue.tasks.empty()){
+		return false;
+	}
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+	return true;
+}
+
+static bool pop_front_task(team_queue_t& queue, std::function<void()>& task){
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if(queue.tasks.empty()){
+		return false;
+	}
+	task = std::move(queue.tasks.front());
+	queue.tasks.pop_front();
+	return true;
+}
+
+//	Own deque first (newest task), then the injection queue, then steal the oldest task from another worker.
+static bool find_task(thread_team_t& team, std::function<void()>& task){
+	const auto worker_count = team.worker_queues.size();
+	const bool is_worker = t_team_membership.team == &team;
+	const auto self = is_worker ? t_team_membership.queue_index : worker_count;
+
+	bool found = false;
+	if(is_worker && pop_back_task(*team.worker_queues[self], task)){
+		found = true;
+	}
+	else if(pop_front_task(team.injection_queue, task)){
+		found = true;
+	}
+	else{
+		//	Start with the neighbour so thieves spread out over the victims.
+		for(size_t i = 1 ; i <= worker_count && found == false ; i++){
+			const auto victim = (self + i) % (worker_count + 1);
+			if(victim != self && victim < worker_count && pop_front_task(*team.worker_queues[victim], task)){
+				found = true;
+			}
+		}
+	}
+
+	if(found){
+		team.queued_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return found;
+}
+
+static void run_worker(thread_team_t& team, size_t queue_index){
+	t_team_membership = team_membership_t { &team, queue_index };
+
+	std::function<void()> task;
+	while(true){
+		if(find_task(team, task)){
+			task();
+			task = nullptr;
+		}
+		else{
+			std::unique_lock<std::mutex> lock(team.sleep_mutex);
+			team.wakeup.wait(lock, [&team](){ return team.stop_flag || team.queued_count.load() > 0; });
+			if(team.stop_flag){
+				return;
+			}
+		}
+	}
+}
+
+
+
+thread_team_t::thread_team_t(size_t thread_count) :
+	thread_count(thread_count),
+	queued_count(0),
+	stop_flag(false)
+{
+	QUARK_ASSERT(thread_count >= 1);
+
+	const auto worker_count = thread_count - 1;
+	for(size_t i = 0 ; i < worker_count ; i++){
+		worker_queues.push_back(std::make_unique<team_queue_t>());
+	}
+	for(size_t i = 0 ; i < worker_count ; i++){
+		workers.push_back(std::thread([this, i](){ run_worker(*this, i); }));
+	}
+
+	QUARK_ASSERT(check_invariant());
+}
+
+thread_team_t::~thread_team_t(){
+	QUARK_ASSERT(check_invariant());
+
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stop_flag = true;
+	}
+	wakeup.notify_all();
+	for(auto& t: workers){
+		t.join();
+	}
+}
+
+bool thread_team_t::check_invariant() const {
+	QUARK_ASSERT(thread_count >= 1);
+	QUARK_ASSERT(worker_queues.size() == thread_count - 1);
+	return true;
+}
+
+
+
+size_t get_thread_team_size(const hardware_caps_t& caps){
+	const size_t logical_count = caps._hw_logical_processor_count > 0 ? caps._hw_logical_processor_count : std::thread::hardware_concurrency();
+	return std::max<size_t>(1, std::min<size_t>(logical_count, k_max_thread_team_size));
+}
+
+void spawn_task(thread_team_t& team, task_group_t& group, std::function<void()> task){
+	QUARK_ASSERT(team.check_invariant());
+	QUARK_ASSERT(task);
+
+	group.pending_count.fetch_add(1, std::memory_order_relaxed);
+
+	//	Nothing may touch group after pending_count is decremented: the waiter is free to destroy it then.
+	auto counted_task = [&group, task = std::move(task)](){
+		try {
+			task();
+		}
+		catch(...){
+			std::lock_guard<std::mutex> lock(group.error_mutex);
+			if(!group.error){
+				group.error = std::current_exception();
+			}
+		}
+		group.pending_count.fetch_sub(1, std::memory_order_acq_rel);
+	};
+
+	auto& queue = t_team_membership.team == &team ? *team.worker_queues[t_team_membership.queue_index] : team.injection_queue;
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(counted_task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(team.sleep_mutex);
+		team.queued_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	team.wakeup.notify_one();
+}
+
+void wait_for_tasks(thread_team_t& team, task_group_t& group){
+	QUARK_ASSERT(team.check_invariant());
+
+	std::function<void()> task;
+	while(group.pending_count.load(std::memory_order_acquire) > 0){
+		if(find_task(team, task)){
+			task();
+			task = nullptr;
+		}
+		else{
+			std::this_thread::yield();
+		}
+	}
+
+	if(group.error){
+		std::rethrow_exception(group.error);
+	}
+}
+
+
+
+QUARK_TEST("thread_team_t", "wait_for_tasks()", "1000 tasks", "all run exactly once"){
+	thread_team_t team(4);
+	std::vector<std::atomic<int>> hits(1000);
+	task_group_t group;
+	for(int i = 0 ; i < 1000 ; i++){
+		spawn_task(team, group, [&hits, i](){ hits[i]++; });
+	}
+	wait_for_tasks(team, group);
+	for(const auto& e: hits){
+		QUARK_VERIFY(e.load() == 1);
+	}
+}
+
+QUARK_TEST("thread_team_t", "wait_for_tasks()", "single thread team", "caller runs all tasks"){
+	thread_team_t team(1);
+	int sum = 0;
+	task_group_t group;
+	for(int i = 0 ; i < 100 ; i++){
+		spawn_task(team, group, [&sum, i](){ sum += i; });
+	}
+	wait_for_tasks(team, group);
+	QUARK_VERIFY(sum == 4950);
+}
+
+QUARK_TEST("thread_team_t", "wait_for_tasks()", "tasks spawn and wait on nested groups", "no deadlock"){
+	thread_team_t team(3);
+	std::atomic<int> leaf_count { 0 };
+	task_group_t group;
+	for(int i = 0 ; i < 20 ; i++){
+		spawn_task(team, group, [&team, &leaf_count](){
+			task_group_t inner;
+			for(int j = 0 ; j < 50 ; j++){
+				spawn_task(team, inner, [&leaf_count](){ leaf_count++; });
+			}
+			wait_for_tasks(team, inner);
+		});
+	}
+	wait_for_tasks(team, group);
+	QUARK_VERIFY(leaf_count.load() == 1000);
+}
+
+QUARK_TEST("thread_team_t", "wait_for_tasks()", "task throws", "exception reaches waiter"){
+	thread_team_t team(2);
+	std::atomic<int> run_count { 0 };
+	task_group_t group;
+	for(int i = 0 ; i < 10 ; i++){
+		spawn_task(team, group, [&run_count, i](){
+			run_count++;
+			if(i == 5){
+				throw std::runtime_error("task 5");
+			}
+		});
+	}
+	try {
+		wait_for_tasks(team, group);
+		QUARK_VERIFY(false);
+	}
+	catch(const std::runtime_error& e){
+		QUARK_VERIFY(std::string(e.what()) == "task 5");
+	}
+	QUARK_VERIFY(run_count.load() == 10);
+}
+
+
+}	//	floyd
@@ -0,0 +1,98 @@
+//
+//  thread_team.h
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-02.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#ifndef thread_team_h
+#define thread_team_h
+
+/*
+	A fixed team of OS threads that runs small tasks for map_dag() and friends.
+
+	Work stealing: each worker owns a deque. It pushes and pops its own tasks at the back (newest first = warm
+	caches), idle workers steal from the front of the other workers' deques (oldest = biggest chunks of work).
+	Tasks spawned by threads outside the team go into a shared injection queue.
+
+	A thread waiting for a task group runs tasks itself while it waits. This means a task can spawn and wait on
+	a nested group without deadlocking, and a team of size 1 (no workers) still works.
+*/
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+struct hardware_caps_t;
+
+namespace floyd {
+
+
+////////////////////////////////		task_group_t
+
+
+//	Counts the unfinished tasks of one batch of work. Remembers the first exception thrown by any of them.
+struct task_group_t {
+	std::atomic<int64_t> pending_count { 0 };
+
+	std::mutex error_mutex;
+	std::exception_ptr error;
+};
+
+
+////////////////////////////////		thread_team_t
+
+
+struct team_queue_t {
+	std::mutex mutex;
+	std::deque<std::function<void()>> tasks;
+};
+
+struct thread_team_t {
+	//	thread_count includes the thread that calls wait_for_tasks(), so thread_count - 1 workers are started.
+	explicit thread_team_t(size_t thread_count);
+	~thread_team_t();
+	bool check_invariant() const;
+
+	thread_team_t(const thread_team_t& other) = delete;
+	thread_team_t& operator=(const thread_team_t& other) = delete;
+
+
+	////////////////////////////////		STATE
+
+	size_t thread_count;
+
+	//	One per worker thread.
+	std::vector<std::unique_ptr<team_queue_t>> worker_queues;
+	team_queue_t injection_queue;
+
+	//	Idle workers sleep on wakeup until queued_count > 0.
+	std::mutex sleep_mutex;
+	std::condition_variable wakeup;
+	std::atomic<int64_t> queued_count;
+	bool stop_flag;
+
+	std::vector<std::thread> workers;
+};
+
+//	How many threads a team should use on this machine. Never less than 1.
+size_t get_thread_team_size(const hardware_caps_t& caps);
+
+//	Queues the task. The task is counted in group until it has run.
+void spawn_task(thread_team_t& team, task_group_t& group, std::function<void()> task);
+
+//	Runs queued tasks until every task in group has finished, including tasks spawned into group by other tasks.
+//	Rethrows the first exception thrown by a task in the group.
+void wait_for_tasks(thread_team_t& team, task_group_t& group);
+
+
+}	//	floyd
+
+#endif /* thread_team_h */
@@ -8,8 +8,12 @@
 
 #include "value_backend.h"
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
+#include <set>
+#include <thread>
 
 #include "types.h"
 #include "json_support.h"
@@ -36,13 +40,148 @@ void save_page(const std::string &url){
 
 
 
+////////////////////////////////		heap_pools_t
+
+
+
+static std::atomic<uint64_t> g_heap_serial_generator(1);
+
+static const std::size_t k_heap_slab_bytes = 64 * 1024;
+static const std::size_t k_heap_min_blocks_per_slab = 16;
+
+//	How many blocks to move from the shared free-list to a thread cache in one go.
+static const uint32_t k_heap_cache_refill_count = 32;
+
+//	When a thread cache holds more blocks than this, half of them are moved to the shared free-list.
+static const uint32_t k_heap_cache_max_count = 256;
+
+
+struct heap_cache_slot_t {
+	uint64_t heap_serial;
+	heap_thread_cache_t* cache;
+};
+
+//	Remembers the cache of the heap this thread used last. Almost always a hit.
+static thread_local heap_cache_slot_t t_heap_cache_slot = { 0, nullptr };
+
+
+static inline std::size_t get_pool_block_size(int size_class){
+	QUARK_ASSERT(size_class >= 0 && size_class < k_heap_size_class_count);
+
+	return sizeof(heap_alloc_64_t) + k_heap_size_class_words[size_class] * sizeof(uint64_t);
+}
+
+static inline void* pop_free_block(heap_free_list_t& list){
+	QUARK_ASSERT(list.count > 0 && list.head != nullptr);
+
+	auto block = list.head;
+	list.head = *reinterpret_cast<void**>(block);
+	list.count--;
+	return block;
+}
+
+static inline void push_free_block(heap_free_list_t& list, void* block){
+	QUARK_ASSERT(block != nullptr);
+
+	*reinterpret_cast<void**>(block) = list.head;
+	list.head = block;
+	list.count++;
+}
+
+static heap_thread_cache_t& get_thread_cache(heap_pools_t& pools){
+	if(t_heap_cache_slot.heap_serial == pools.heap_serial){
+		return *t_heap_cache_slot.cache;
+	}
+
+	const auto thread_id = std::this_thread::get_id();
+
+	std::lock_guard<std::mutex> guard(pools.mutex);
+	auto it = std::find_if(
+		pools.thread_caches.begin(),
+		pools.thread_caches.end(),
+		[&](const std::unique_ptr<heap_thread_cache_t>& e){ return e->thread_id == thread_id; }
+	);
+
+	heap_thread_cache_t* cache = nullptr;
+	if(it != pools.thread_caches.end()){
+		cache = it->get();
+	}
+	else{
+		auto temp = std::make_unique<heap_thread_cache_t>();
+		temp->thread_id = thread_id;
+		cache = temp.get();
+		pools.thread_caches.push_back(std::move(temp));
+	}
+
+	t_heap_cache_slot = heap_cache_slot_t{ pools.heap_serial, cache };
+	return *cache;
+}
+
+//	Grabs a batch of blocks from the shared free-list. If it's empty, carves a new slab into blocks.
+static void refill_thread_cache(heap_pools_t& pools, heap_free_list_t& cache_list, int size_class){
+	std::lock_guard<std::mutex> guard(pools.mutex);
+
+	auto& shared = pools.shared_free_lists[size_class];
+	if(shared.count == 0){
+		const auto block_size = get_pool_block_size(size_class);
+		const auto block_count = std::max(k_heap_slab_bytes / block_size, k_heap_min_blocks_per_slab);
+
+		void* slab = std::malloc(block_size * block_count);
+		if(slab == nullptr){
+			throw std::exception();
+		}
+		pools.slabs.push_back(slab);
+
+		//	Push in reverse so blocks are handed out in address order.
+		auto p = static_cast<uint8_t*>(slab);
+		for(auto i = block_count ; i > 0 ; i--){
+			push_free_block(shared, p + (i - 1) * block_size);
+		}
+	}
+
+	for(uint32_t i = 0 ; i < k_heap_cache_refill_count && shared.count > 0 ; i++){
+		push_free_block(cache_list, pop_free_block(shared));
+	}
+}
+
+static void spill_thread_cache(heap_pools_t& pools, heap_free_list_t& cache_list, int size_class){
+	std::lock_guard<std::mutex> guard(pools.mutex);
+
+	auto& shared = pools.shared_free_lists[size_class];
+	while(cache_list.count > k_heap_cache_max_count / 2){
+		push_free_block(shared, pop_free_block(cache_list));
+	}
+}
+
+static inline void* alloc_pool_block(heap_pools_t& pools, int size_class){
+	auto& cache = get_thread_cache(pools);
+	auto& list = cache.free_lists[size_class];
+	if(list.count == 0){
+		refill_thread_cache(pools, list, size_class);
+	}
+	return pop_free_block(list);
+}
+
+static inline void free_pool_block(heap_pools_t& pools, int size_class, void* block){
+	auto& cache = get_thread_cache(pools);
+	auto& list = cache.free_lists[size_class];
+
+	//	Spill before pushing so the block we just got, which is likely still in the CPU cache, is reused first.
+	if(list.count >= k_heap_cache_max_count){
+		spill_thread_cache(pools, list, size_class);
+	}
+	push_free_block(list, block);
+}
+
+
+
 ////////////////////////////////		heap_t
 
 
 
 void trace_alloc(const heap_rec_t& e){
 	QUARK_TRACE_SS(""
-//		<< "used: " << e.in_use
+		<< "alloc_id: " << e.alloc_id
 		<< " rc: " << e.alloc_ptr->rc
 		<< " debug_info: " << get_debug_info(*e.alloc_ptr)
 		<< " data[0]: " << e.alloc_ptr->data[0]
@@ -62,11 +201,9 @@ void trace_heap(const heap_t& heap){
 #if HEAP_MUTEX
 			std::lock_guard<std::recursive_mutex> guard(*heap.alloc_records_mutex);
 #endif
+			std::lock_guard<std::mutex> guard2(heap.live_allocs_mutex);
 
-			for(int i = 0 ; i < heap.alloc_records.size() ; i++){
-				const auto& e = heap.alloc_records[i];
-				trace_alloc(e);
-			}
+			heap.alloc_records.for_each([](const heap_rec_t& e){ trace_alloc(e); });
 		}
 	}
 }
@@ -90,6 +227,22 @@ void detect_leaks(const heap_t& heap){
 }
 
 
+heap_t::heap_t(bool record_allocs_flag, heap_backend backend_mode) :
+	magic(0xf00d1234),
+	allocation_id_generator(1000000),
+	record_allocs_flag(record_allocs_flag),
+	backend_mode(backend_mode)
+{
+#if HEAP_MUTEX
+	alloc_records_mutex = std::make_shared<std::recursive_mutex>();
+#endif
+
+	if(backend_mode == heap_backend::pool){
+		pools = std::make_unique<heap_pools_t>();
+		pools->heap_serial = g_heap_serial_generator++;
+	}
+}
+
 heap_t::~heap_t(){
 	QUARK_ASSERT(check_invariant());
 
@@ -101,6 +254,12 @@ heap_t::~heap_t(){
 	}
 #endif
 
+	if(pools){
+		for(auto slab: pools->slabs){
+			std::free(slab);
+		}
+		pools->slabs.clear();
+	}
 }
 
 #if DEBUG
@@ -139,17 +298,26 @@ heap_alloc_64_t* alloc_64(heap_t& heap, uint64_t allocation_word_count, type_t d
 	std::lock_guard<std::recursive_mutex> guard(*heap.alloc_records_mutex);
 #endif
 
-	const auto malloc_size = header_size + allocation_word_count * sizeof(uint64_t);
-	void* alloc0 = std::malloc(malloc_size);
-	if(alloc0 == nullptr){
-		throw std::exception();
+	const auto size_class = heap.pools ? get_heap_size_class(allocation_word_count) : -1;
+
+	void* alloc0 = nullptr;
+	if(size_class >= 0){
+		alloc0 = alloc_pool_block(*heap.pools, size_class);
+	}
+	else{
+		const auto malloc_size = header_size + allocation_word_count * sizeof(uint64_t);
+		alloc0 = std::malloc(malloc_size);
+		if(alloc0 == nullptr){
+			throw std::exception();
+		}
 	}
 
 	auto alloc = new (alloc0) heap_alloc_64_t(&heap, allocation_word_count, debug_value_type, debug_string);
 	QUARK_ASSERT(alloc->rc == 1);
 	QUARK_ASSERT(alloc->check_invariant());
 	if(heap.record_allocs_flag){
-		heap.alloc_records.push_back({ alloc });
+		std::lock_guard<std::mutex> guard2(heap.live_allocs_mutex);
+		heap.alloc_records.insert(alloc, alloc->alloc_id);
 	}
 
 	QUARK_ASSERT(alloc->check_invariant());
@@ -177,6 +345,18 @@ QUARK_TEST("heap_t", "alloc_64()", "", ""){
 	release_ref(*a);
 }
 
+QUARK_TEST("heap_t", "alloc_64()", "k_rc_offset, k_shared_offset", "match the struct, generated code relies on them"){
+	heap_t heap(false);
+	auto a = alloc_64(heap, 0, make_undefined(), "test");
+	const auto base = reinterpret_cast<const uint8_t*>(a);
+	QUARK_VERIFY(reinterpret_cast<const uint8_t*>(&a->rc) - base == heap_alloc_64_t::k_rc_offset);
+	QUARK_VERIFY(reinterpret_cast<const uint8_t*>(&a->shared) - base == heap_alloc_64_t::k_shared_offset);
+	QUARK_VERIFY(sizeof(a->rc) == sizeof(int32_t));
+	QUARK_VERIFY(sizeof(a->shared) == sizeof(uint8_t));
+
+	release_ref(*a);
+}
+
 QUARK_TEST("heap_t", "add_ref()", "", ""){
 	heap_t heap(false);
 	auto a = alloc_64(heap, 0, make_undefined(), "test");
@@ -199,6 +379,109 @@ QUARK_TEST("heap_t", "release_ref()", "", ""){
 	QUARK_VERIFY(count == 0);
 }
 
+QUARK_TEST("heap_t", "alloc_64()", "pool, reuse disposed block", "same block"){
+	heap_t heap(false, heap_backend::pool);
+	auto a = alloc_64(heap, 3, make_undefined(), "test");
+	release_ref(*a);
+
+	auto b = alloc_64(heap, 3, make_undefined(), "test");
+	QUARK_VERIFY(b == a);
+	QUARK_VERIFY(b->rc == 1);
+	release_ref(*b);
+}
+
+QUARK_TEST("heap_t", "alloc_64()", "pool, all size classes + big", "unique, writable blocks"){
+	heap_t heap(true, heap_backend::pool);
+
+	std::vector<heap_alloc_64_t*> allocs;
+	for(int i = 0 ; i < 2000 ; i++){
+		const uint64_t word_count = i % 40;
+		auto a = alloc_64(heap, word_count, make_undefined(), "test");
+		auto p = static_cast<uint64_t*>(get_alloc_ptr(*a));
+		for(uint64_t w = 0 ; w < word_count ; w++){
+			p[w] = i;
+		}
+		allocs.push_back(a);
+	}
+	QUARK_VERIFY(heap.count_used() == 2000);
+
+	for(int i = 0 ; i < 2000 ; i++){
+		const auto a = allocs[i];
+		QUARK_VERIFY(a->check_invariant());
+		QUARK_VERIFY(a->allocation_word_count == i % 40);
+		const auto p = static_cast<const uint64_t*>(get_alloc_ptr(*a));
+		for(uint64_t w = 0 ; w < a->allocation_word_count ; w++){
+			QUARK_VERIFY(p[w] == i);
+		}
+	}
+	for(auto a: allocs){
+		release_ref(*a);
+	}
+	QUARK_VERIFY(heap.count_used() == 0);
+}
+
+QUARK_TEST("heap_t", "dispose_alloc()", "pool, dispose on other thread", ""){
+	heap_t heap(false, heap_backend::pool);
+
+	std::vector<heap_alloc_64_t*> allocs;
+	for(int i = 0 ; i < 1000 ; i++){
+		allocs.push_back(alloc_64(heap, 2, make_undefined(), "test"));
+	}
+
+	std::thread t([&](){
+		for(auto a: allocs){
+			release_ref(*a);
+		}
+		for(int i = 0 ; i < 1000 ; i++){
+			allocs[i] = alloc_64(heap, 2, make_undefined(), "test");
+		}
+	});
+	t.join();
+
+	for(auto a: allocs){
+		QUARK_VERIFY(a->rc == 1);
+		release_ref(*a);
+	}
+}
+
+QUARK_TEST("heap_t", "count_used()", "record allocs, dispose out of order", "only live allocs counted"){
+	heap_t heap(true);
+
+	std::vector<heap_alloc_64_t*> allocs;
+	for(int i = 0 ; i < 10000 ; i++){
+		allocs.push_back(alloc_64(heap, i % 5, make_undefined(), "test"));
+	}
+	QUARK_VERIFY(heap.count_used() == 10000);
+
+	for(int i = 0 ; i < 10000 ; i += 3){
+		release_ref(*allocs[i]);
+		allocs[i] = nullptr;
+	}
+	QUARK_VERIFY(heap.count_used() == 10000 - 3334);
+
+	//	Reuses the disposed blocks: must not be counted twice.
+	for(int i = 0 ; i < 10000 ; i += 3){
+		allocs[i] = alloc_64(heap, i % 5, make_undefined(), "test");
+	}
+	QUARK_VERIFY(heap.count_used() == 10000);
+
+	for(auto a: allocs){
+		release_ref(*a);
+	}
+	QUARK_VERIFY(heap.count_used() == 0);
+	detect_leaks(heap);
+}
+
+QUARK_TEST("heap_t", "alloc_64()", "malloc backend", ""){
+	heap_t heap(true, heap_backend::malloc);
+	QUARK_VERIFY(heap.pools == nullptr);
+
+	auto a = alloc_64(heap, 3, make_undefined(), "test");
+	QUARK_VERIFY(a->rc == 1);
+	release_ref(*a);
+	QUARK_VERIFY(heap.count_used() == 0);
+}
+
 
 
 void* get_alloc_ptr(heap_alloc_64_t& alloc){
@@ -243,17 +526,21 @@ void dispose_alloc(heap_alloc_64_t& alloc){
 	std::lock_guard<std::recursive_mutex> guard(*alloc.heap->alloc_records_mutex);
 #endif
 
-	if(alloc.heap->record_allocs_flag){
-		auto it = std::find_if(alloc.heap->alloc_records.begin(), alloc.heap->alloc_records.end(), [&](heap_rec_t& e){ return e.alloc_ptr == &alloc; });
-		QUARK_ASSERT(it != alloc.heap->alloc_records.end());
+	auto heap = alloc.heap;
+	const auto size_class = heap->pools ? get_heap_size_class(alloc.allocation_word_count) : -1;
+
+	if(heap->record_allocs_flag){
+		std::lock_guard<std::mutex> guard2(heap->live_allocs_mutex);
 
-//		QUARK_ASSERT(it->in_use);
-//		it->in_use = false;
+		//	The block will be reused by a later alloc_64(), so forget it now.
+		const auto found = heap->alloc_records.erase(&alloc, alloc.alloc_id);
+		QUARK_ASSERT(found);
+		(void)found;
 	}
 	
 	//??? we don't delete the malloc() block in debug version.
 #if DEBUG
-	alloc.magic = 0xdeadbeef;
+	alloc.magic = 0xdead;
 	alloc.data[0] = 0xdeadbeef'00000001;
 	alloc.data[1] = 0xdeadbeef'00000002;
 	alloc.data[2] = 0xdeadbeef'00000003;
@@ -265,7 +552,12 @@ void dispose_alloc(heap_alloc_64_t& alloc){
 	alloc.debug_info = "disposed alloc";
 #endif
 
-	std::free(&alloc);
+	if(size_class >= 0){
+		free_pool_block(*heap->pools, size_class, &alloc);
+	}
+	else{
+		std::free(&alloc);
+	}
 }
 
 
@@ -276,21 +568,15 @@ bool heap_t::check_invariant() const{
 #endif
 
 #if 0
-	for(const auto& e: alloc_records){
+	std::lock_guard<std::mutex> guard2(live_allocs_mutex);
+	QUARK_ASSERT(alloc_records.check_invariant());
+	alloc_records.for_each([&](const heap_rec_t& e){
 		QUARK_ASSERT(e.alloc_ptr != nullptr);
 		QUARK_ASSERT(e.alloc_ptr->heap == this);
 		QUARK_ASSERT(e.alloc_ptr->check_invariant());
-
-/*
-		if(e.in_use){
-			QUARK_ASSERT(e.alloc_ptr->rc > 0);
-		}
-		else{
-			QUARK_ASSERT(e.alloc_ptr->rc == 0);
-		}
-*/
-
-	}
+		QUARK_ASSERT(e.alloc_ptr->alloc_id == e.alloc_id);
+		QUARK_ASSERT(e.alloc_ptr->rc > 0);
+	});
 #endif
 	return true;
 }
@@ -298,17 +584,14 @@ bool heap_t::check_invariant() const{
 int heap_t::count_used() const {
 	QUARK_ASSERT(check_invariant());
 
-	int result = 0;
 #if HEAP_MUTEX
 	std::lock_guard<std::recursive_mutex> guard(*alloc_records_mutex);
 #endif
 	if(record_allocs_flag){
-		for(const auto& e: alloc_records){
-			if(e.alloc_ptr->rc){
-				result = result + 1;
-			}
-		}
-		return result;
+		std::lock_guard<std::mutex> guard2(live_allocs_mutex);
+
+		//	Disposed allocs are removed from alloc_records, so all records are in use.
+		return static_cast<int>(alloc_records.size());
 	}
 	else{
 		return 0;
@@ -317,6 +600,134 @@ int heap_t::count_used() const {
 
 
 
+////////////////////////////////		heap_live_index_t
+
+
+
+//	Fibonacci hashing: the home slot is the *top* log2(slot_count) bits of the product. The low bits of the product
+//	only depend on the low bits of the address, so allocs from a slab with a regular stride would cluster there.
+static inline std::size_t home_slot(const std::vector<heap_rec_t>& slots, const heap_alloc_64_t* alloc_ptr){
+	QUARK_ASSERT(slots.size() >= 2 && (slots.size() & (slots.size() - 1)) == 0);
+
+	const auto shift = 64 - __builtin_ctzll(static_cast<uint64_t>(slots.size()));
+	return static_cast<std::size_t>((reinterpret_cast<uint64_t>(alloc_ptr) * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+static std::size_t find_slot(const std::vector<heap_rec_t>& slots, const heap_alloc_64_t* alloc_ptr){
+	QUARK_ASSERT(slots.empty() == false);
+
+	const auto mask = slots.size() - 1;
+	auto index = home_slot(slots, alloc_ptr);
+	while(slots[index].alloc_ptr != nullptr && slots[index].alloc_ptr != alloc_ptr){
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+bool heap_live_index_t::check_invariant() const {
+	QUARK_ASSERT(slots.empty() || (slots.size() & (slots.size() - 1)) == 0);
+	QUARK_ASSERT(count <= slots.size());
+	return true;
+}
+
+void heap_live_index_t::insert(heap_alloc_64_t* alloc_ptr, int64_t alloc_id){
+	QUARK_ASSERT(alloc_ptr != nullptr);
+
+	//	Keep load factor below 0.75 so probe sequences stay short.
+	if((count + 1) * 4 > slots.size() * 3){
+		std::vector<heap_rec_t> old_slots(std::max<std::size_t>(slots.size() * 2, 1024), heap_rec_t{ nullptr, 0 });
+		old_slots.swap(slots);
+		for(const auto& e: old_slots){
+			if(e.alloc_ptr != nullptr){
+				slots[find_slot(slots, e.alloc_ptr)] = e;
+			}
+		}
+	}
+
+	const auto index = find_slot(slots, alloc_ptr);
+	QUARK_ASSERT(slots[index].alloc_ptr == nullptr);
+
+	slots[index] = heap_rec_t{ alloc_ptr, alloc_id };
+	count++;
+}
+
+bool heap_live_index_t::erase(const heap_alloc_64_t* alloc_ptr, int64_t alloc_id){
+	QUARK_ASSERT(alloc_ptr != nullptr);
+
+	if(slots.empty()){
+		return false;
+	}
+
+	auto hole = find_slot(slots, alloc_ptr);
+	if(slots[hole].alloc_ptr == nullptr || slots[hole].alloc_id != alloc_id){
+		return false;
+	}
+
+	//	Backward-shift deletion: move later entries of the probe run into the hole when their home slot allows it.
+	const auto mask = slots.size() - 1;
+	auto index = hole;
+	while(true){
+		index = (index + 1) & mask;
+		if(slots[index].alloc_ptr == nullptr){
+			break;
+		}
+		const auto home = home_slot(slots, slots[index].alloc_ptr);
+		const bool home_between_hole_and_index = hole <= index
+			? (hole < home && home <= index)
+			: (hole < home || home <= index);
+		if(home_between_hole_and_index == false){
+			slots[hole] = slots[index];
+			hole = index;
+		}
+	}
+	slots[hole] = heap_rec_t{ nullptr, 0 };
+	count--;
+	return true;
+}
+
+QUARK_TEST("heap_live_index_t", "insert() / erase()", "interleaved", "size() tracks live allocs"){
+	heap_live_index_t index;
+
+	//	Fake, aligned addresses. Never dereferenced.
+	std::vector<heap_alloc_64_t*> ptrs;
+	for(uint64_t i = 0 ; i < 5000 ; i++){
+		ptrs.push_back(reinterpret_cast<heap_alloc_64_t*>(0x10000 + i * 64));
+	}
+
+	for(int i = 0 ; i < 5000 ; i++){
+		index.insert(ptrs[i], 1000 + i);
+	}
+	QUARK_VERIFY(index.size() == 5000);
+
+	//	Erase every other.
+	for(int i = 0 ; i < 5000 ; i += 2){
+		QUARK_VERIFY(index.erase(ptrs[i], 1000 + i));
+	}
+	QUARK_VERIFY(index.size() == 2500);
+
+	//	Wrong alloc_id = stale pointer, and already erased.
+	QUARK_VERIFY(index.erase(ptrs[1], 7) == false);
+	QUARK_VERIFY(index.erase(ptrs[0], 1000) == false);
+
+	for(int i = 1 ; i < 5000 ; i += 2){
+		QUARK_VERIFY(index.erase(ptrs[i], 1000 + i));
+	}
+	QUARK_VERIFY(index.size() == 0);
+	QUARK_VERIFY(index.check_invariant());
+}
+
+QUARK_TEST("heap_live_index_t", "home_slot()", "512 allocs, 4096 byte stride", "spread over the slots"){
+	const std::vector<heap_rec_t> slots(1024, heap_rec_t{ nullptr, 0 });
+
+	std::set<std::size_t> homes;
+	for(uint64_t i = 0 ; i < 512 ; i++){
+		homes.insert(home_slot(slots, reinterpret_cast<heap_alloc_64_t*>(0x100000 + i * 4096)));
+	}
+	QUARK_VERIFY(homes.size() > 300);
+}
+
+
+
 
 ////////////////////////////////	runtime_type_t
 
@@ -382,6 +793,10 @@ runtime_value_t make_runtime_vector_hamt(VECTOR_HAMT_T* vector_hamt_ptr){
 	return { .vector_hamt_ptr = vector_hamt_ptr };
 }
 
+runtime_value_t make_runtime_vector_soa(VECTOR_SOA_T* vector_soa_ptr){
+	return { .vector_soa_ptr = vector_soa_ptr };
+}
+
 runtime_value_t make_runtime_dict_cppmap(DICT_CPPMAP_T* dict_cppmap_ptr){
 	return { .dict_cppmap_ptr = dict_cppmap_ptr };
 }
@@ -390,6 +805,10 @@ runtime_value_t make_runtime_dict_hamt(DICT_HAMT_T* dict_hamt_ptr){
 	return { .dict_hamt_ptr = dict_hamt_ptr };
 }
 
+runtime_value_t make_runtime_dict_hash(DICT_HASH_T* dict_hash_ptr){
+	return { .dict_hash_ptr = dict_hash_ptr };
+}
+
 
 
 
@@ -397,11 +816,28 @@ runtime_value_t make_runtime_dict_hamt(DICT_HAMT_T* dict_hamt_ptr){
 
 
 uint64_t get_vec_string_size(runtime_value_t str){
+	if(is_inline_string(str)){
+		return get_inline_string_size(str);
+	}
 	QUARK_ASSERT(str.vector_carray_ptr != nullptr);
 
 	return str.vector_carray_ptr->get_element_count();
 }
 
+void store_string_char(runtime_value_t str, uint64_t index, char ch){
+	QUARK_ASSERT(is_inline_string(str) == false);
+	QUARK_ASSERT(str.vector_carray_ptr != nullptr);
+	QUARK_ASSERT(index < str.vector_carray_ptr->get_allocation_count() * 8);
+
+	auto& element = str.vector_carray_ptr->get_element_ptr()[index >> 3];
+	const auto shift = (index & 7) * 8;
+	const uint64_t word = element.int_value;
+	element.int_value = (word & ~(uint64_t(0xff) << shift)) | (uint64_t(uint8_t(ch)) << shift);
+
+	//	Forget the cached hash, see make_string_key().
+	str.vector_carray_ptr->alloc.data[1] = 0;
+}
+
 void copy_elements(runtime_value_t dest[], runtime_value_t source[], uint64_t count){
 	for(auto i = 0 ; i < count ; i++){
 		dest[i] = source[i];
@@ -476,6 +912,25 @@ void dispose_vector_carray(const runtime_value_t& value){
 	QUARK_ASSERT(heap->check_invariant());
 }
 
+runtime_value_t grow_vector_carray(heap_t& heap, runtime_value_t vec, uint64_t needed_allocation_count, type_t value_type){
+	QUARK_ASSERT(heap.check_invariant());
+	QUARK_ASSERT(vec.check_invariant());
+	QUARK_ASSERT(is_rc_unique(vec.vector_carray_ptr->alloc));
+
+	const auto allocation_count = vec.vector_carray_ptr->get_allocation_count();
+	QUARK_ASSERT(needed_allocation_count >= allocation_count);
+
+	const auto allocation_count2 = std::max(needed_allocation_count, std::max(allocation_count * 2, (uint64_t)4));
+	auto result = alloc_vector_carray(heap, allocation_count2, vec.vector_carray_ptr->get_element_count(), value_type);
+
+	auto dest_ptr = result.vector_carray_ptr->get_element_ptr();
+	std::memcpy(dest_ptr, vec.vector_carray_ptr->get_element_ptr(), allocation_count * sizeof(runtime_value_t));
+	std::memset(dest_ptr + allocation_count, 0, (allocation_count2 - allocation_count) * sizeof(runtime_value_t));
+
+	dispose_vector_carray(vec);
+	return result;
+}
+
 
 
 
@@ -502,6 +957,142 @@ QUARK_TEST("VECTOR_CARRAY_T", "", "", ""){
 	detect_leaks(heap);
 }
 
+QUARK_TEST("VECTOR_CARRAY_T", "grow_vector_carray()", "3 elements", "elements moved, room to grow"){
+	heap_t heap(false);
+	detect_leaks(heap);
+
+	auto v = alloc_vector_carray(heap, 3, 3, make_undefined());
+	for(int i = 0 ; i < 3 ; i++){
+		v.vector_carray_ptr->store(i, make_runtime_int(100 + i));
+	}
+
+	const auto v2 = grow_vector_carray(heap, v, 4, make_undefined());
+	QUARK_VERIFY(v2.vector_carray_ptr->get_element_count() == 3);
+	QUARK_VERIFY(v2.vector_carray_ptr->get_allocation_count() == 6);
+	QUARK_VERIFY(v2.vector_carray_ptr->load_element(0).int_value == 100);
+	QUARK_VERIFY(v2.vector_carray_ptr->load_element(2).int_value == 102);
+
+	if(dec_rc(v2.vector_carray_ptr->alloc) == 0){
+		dispose_vector_carray(v2);
+	}
+
+	QUARK_VERIFY(heap.check_invariant());
+	detect_leaks(heap);
+}
+
+
+
+
+
+////////////////////////////////		VECTOR_SOA_T
+
+
+
+bool VECTOR_SOA_T::check_invariant() const {
+	QUARK_ASSERT(this->alloc.check_invariant());
+	QUARK_ASSERT(get_debug_info(alloc) == "soavec");
+	QUARK_ASSERT(alloc.data[0] <= alloc.data[1]);
+	QUARK_ASSERT(alloc.data[1] * alloc.data[2] <= alloc.allocation_word_count);
+	return true;
+}
+
+runtime_value_t alloc_vector_soa(heap_t& heap, uint64_t capacity, uint64_t element_count, uint64_t member_count, type_t value_type){
+	QUARK_ASSERT(heap.check_invariant());
+	QUARK_ASSERT(element_count <= capacity);
+	QUARK_ASSERT(member_count > 0);
+
+	heap_alloc_64_t* alloc = alloc_64(heap, capacity * member_count, value_type, "soavec");
+	alloc->data[0] = element_count;
+	alloc->data[1] = capacity;
+	alloc->data[2] = member_count;
+	std::memset(get_alloc_ptr(*alloc), 0, capacity * member_count * sizeof(runtime_value_t));
+
+	auto vec = reinterpret_cast<VECTOR_SOA_T*>(alloc);
+
+	QUARK_ASSERT(vec->check_invariant());
+	QUARK_ASSERT(heap.check_invariant());
+	return { .vector_soa_ptr = vec };
+}
+
+void dispose_vector_soa(const runtime_value_t& vec){
+	QUARK_ASSERT(sizeof(VECTOR_SOA_T) == sizeof(heap_alloc_64_t));
+	QUARK_ASSERT(vec.vector_soa_ptr != nullptr);
+	QUARK_ASSERT(vec.vector_soa_ptr->check_invariant());
+
+	auto heap = vec.vector_soa_ptr->alloc.heap;
+	dispose_alloc(vec.vector_soa_ptr->alloc);
+	QUARK_ASSERT(heap->check_invariant());
+}
+
+runtime_value_t grow_vector_soa(heap_t& heap, runtime_value_t vec, uint64_t needed_capacity, type_t value_type){
+	QUARK_ASSERT(heap.check_invariant());
+	QUARK_ASSERT(vec.check_invariant());
+	QUARK_ASSERT(is_rc_unique(vec.vector_soa_ptr->alloc));
+
+	const auto& source = *vec.vector_soa_ptr;
+	const auto capacity = source.get_capacity();
+	QUARK_ASSERT(needed_capacity >= capacity);
+
+	const auto capacity2 = std::max(needed_capacity, std::max(capacity * 2, (uint64_t)4));
+	const auto count = source.get_element_count();
+	const auto member_count = source.get_member_count();
+	auto result = alloc_vector_soa(heap, capacity2, count, member_count, value_type);
+	copy_vector_soa_rows(*result.vector_soa_ptr, 0, source, 0, count);
+
+	dispose_vector_soa(vec);
+	return result;
+}
+
+
+void copy_vector_soa_rows(VECTOR_SOA_T& dest, uint64_t dest_index, const VECTOR_SOA_T& source, uint64_t source_index, uint64_t count){
+	QUARK_ASSERT(dest.check_invariant());
+	QUARK_ASSERT(source.check_invariant());
+	QUARK_ASSERT(dest.get_member_count() == source.get_member_count());
+	QUARK_ASSERT(dest_index + count <= dest.get_capacity());
+	QUARK_ASSERT(source_index + count <= source.get_element_count());
+
+	for(uint64_t m = 0 ; m < source.get_member_count() ; m++){
+		std::memcpy(dest.get_column_ptr(m) + dest_index, source.get_column_ptr(m) + source_index, count * sizeof(runtime_value_t));
+	}
+}
+
+
+QUARK_TEST("VECTOR_SOA_T", "", "", ""){
+	heap_t heap(false);
+	auto v = alloc_vector_soa(heap, 4, 3, 2, make_undefined());
+	const auto base = reinterpret_cast<const uint8_t*>(v.vector_soa_ptr);
+	QUARK_VERIFY(reinterpret_cast<const uint8_t*>(&v.vector_soa_ptr->alloc.data[1]) - base == VECTOR_SOA_T::k_capacity_offset);
+	QUARK_VERIFY(v.vector_soa_ptr->get_element_count() == 3);
+	QUARK_VERIFY(v.vector_soa_ptr->get_column_ptr(1) - v.vector_soa_ptr->get_column_ptr(0) == 4);
+	QUARK_VERIFY(v.vector_soa_ptr->get_column_ptr(1)[3].int_value == 0);
+
+	if(dec_rc(v.vector_soa_ptr->alloc) == 0){
+		dispose_vector_soa(v);
+	}
+	QUARK_VERIFY(heap.count_used() == 0);
+}
+
+QUARK_TEST("VECTOR_SOA_T", "grow_vector_soa()", "3 elements, 2 members", "columns moved, room to grow"){
+	heap_t heap(false);
+	auto v = alloc_vector_soa(heap, 3, 3, 2, make_undefined());
+	for(int i = 0 ; i < 3 ; i++){
+		v.vector_soa_ptr->get_column_ptr(0)[i] = make_runtime_int(100 + i);
+		v.vector_soa_ptr->get_column_ptr(1)[i] = make_runtime_int(200 + i);
+	}
+
+	const auto v2 = grow_vector_soa(heap, v, 4, make_undefined());
+	QUARK_VERIFY(v2.vector_soa_ptr->get_element_count() == 3);
+	QUARK_VERIFY(v2.vector_soa_ptr->get_capacity() == 6);
+	QUARK_VERIFY(v2.vector_soa_ptr->get_column_ptr(0)[2].int_value == 102);
+	QUARK_VERIFY(v2.vector_soa_ptr->get_column_ptr(1)[0].int_value == 200);
+	QUARK_VERIFY(v2.vector_soa_ptr->get_column_ptr(1)[2].int_value == 202);
+
+	if(dec_rc(v2.vector_soa_ptr->alloc) == 0){
+		dispose_vector_soa(v2);
+	}
+	QUARK_VERIFY(heap.count_used() == 0);
+}
+
 
 
 
@@ -510,8 +1101,49 @@ QUARK_TEST("VECTOR_CARRAY_T", "", "", ""){
 
 
 
+static thread_local hamt_element_scope_t* g_hamt_element_scope = nullptr;
+
+hamt_element_scope_t::hamt_element_scope_t(value_backend_t& backend, type_t vector_type) :
+	backend(backend),
+	element_type(lookup_vector_element_type(backend, vector_type)),
+	is_rc(is_rc_value(peek2(backend.types, element_type))),
+	prev(g_hamt_element_scope)
+{
+	g_hamt_element_scope = this;
+}
+
+hamt_element_scope_t::~hamt_element_scope_t(){
+	QUARK_ASSERT(g_hamt_element_scope == this);
+
+	g_hamt_element_scope = prev;
+}
+
+bool has_hamt_element_scope(){
+	return g_hamt_element_scope != nullptr;
+}
+
+void retain_hamt_element(runtime_value_t value){
+	const auto scope = g_hamt_element_scope;
+	QUARK_ASSERT(scope != nullptr);
+
+	if(scope != nullptr && scope->is_rc){
+		retain_value(scope->backend, value, scope->element_type);
+	}
+}
+
+void release_hamt_element(runtime_value_t value){
+	const auto scope = g_hamt_element_scope;
+	QUARK_ASSERT(scope != nullptr);
+
+	if(scope != nullptr && scope->is_rc){
+		release_value(scope->backend, value, scope->element_type);
+	}
+}
+
+
+
 QUARK_TEST("", "", "", ""){
-	const auto vec_size = sizeof(immer::vector<runtime_value_t>);
+	const auto vec_size = sizeof(HAMT_VECTOR);
 	QUARK_VERIFY(vec_size == 32);
 }
 
@@ -534,8 +1166,8 @@ runtime_value_t alloc_vector_hamt(heap_t& heap, uint64_t allocation_count, uint6
 
 	auto vec = reinterpret_cast<VECTOR_HAMT_T*>(alloc_64(heap, 0, value_type, "vechamt"));
 
-	QUARK_ASSERT(sizeof(immer::vector<runtime_value_t>) <= heap_alloc_64_t::k_data_bytes);
-    new (&vec->alloc.data[0]) immer::vector<runtime_value_t>(allocation_count, runtime_value_t{ .int_value = (int64_t)0xdeadbeef12345678 } );
+	QUARK_ASSERT(sizeof(HAMT_VECTOR) <= heap_alloc_64_t::k_data_bytes);
+    new (&vec->alloc.data[0]) HAMT_VECTOR(allocation_count, hamt_element_t());
 
 	QUARK_ASSERT(vec->check_invariant());
 	QUARK_ASSERT(heap.check_invariant());
@@ -550,10 +1182,16 @@ runtime_value_t alloc_vector_hamt(heap_t& heap, const runtime_value_t elements[]
 	heap_alloc_64_t* alloc = alloc_64(heap, 0, value_type, "vechamt");
 
 	auto vec = reinterpret_cast<VECTOR_HAMT_T*>(alloc);
-	auto buffer_ptr = reinterpret_cast<immer::vector<runtime_value_t>*>(&alloc->data[0]);
+	auto buffer_ptr = reinterpret_cast<HAMT_VECTOR*>(&alloc->data[0]);
+
+	//	Moves the elements in, no element is copied.
+	auto temp = HAMT_VECTOR().transient();
+	for(uint64_t i = 0 ; i < element_count ; i++){
+		temp.push_back(hamt_element_t(elements[i]));
+	}
 
-	QUARK_ASSERT(sizeof(immer::vector<runtime_value_t>) <= heap_alloc_64_t::k_data_bytes);
-    auto vec2 = new (buffer_ptr) immer::vector<runtime_value_t>(&elements[0], &elements[element_count]);
+	QUARK_ASSERT(sizeof(HAMT_VECTOR) <= heap_alloc_64_t::k_data_bytes);
+    auto vec2 = new (buffer_ptr) HAMT_VECTOR(std::move(temp).persistent());
 	QUARK_ASSERT(vec2 == buffer_ptr);
 
 	QUARK_ASSERT(vec->check_invariant());
@@ -562,14 +1200,30 @@ runtime_value_t alloc_vector_hamt(heap_t& heap, const runtime_value_t elements[]
 	return { .vector_hamt_ptr = vec };
 }
 
+runtime_value_t alloc_vector_hamt(heap_t& heap, const HAMT_VECTOR& vec, type_t value_type){
+	QUARK_ASSERT(heap.check_invariant());
+
+	heap_alloc_64_t* alloc = alloc_64(heap, 0, value_type, "vechamt");
+
+	auto result = reinterpret_cast<VECTOR_HAMT_T*>(alloc);
+	QUARK_ASSERT(sizeof(HAMT_VECTOR) <= heap_alloc_64_t::k_data_bytes);
+    new (&alloc->data[0]) HAMT_VECTOR(vec);
+
+	QUARK_ASSERT(result->check_invariant());
+	QUARK_ASSERT(heap.check_invariant());
+
+	return { .vector_hamt_ptr = result };
+}
+
 void dispose_vector_hamt(const runtime_value_t& vec){
 	QUARK_ASSERT(vec.check_invariant());
 	QUARK_ASSERT(sizeof(VECTOR_HAMT_T) == sizeof(heap_alloc_64_t));
 	QUARK_ASSERT(vec.vector_hamt_ptr != nullptr);
 	QUARK_ASSERT(vec.vector_hamt_ptr->check_invariant());
+	QUARK_ASSERT(has_hamt_element_scope());
 
 	auto& vec2 = vec.vector_hamt_ptr->get_vecref_mut();
-	vec2.~vector<runtime_value_t>();
+	vec2.~HAMT_VECTOR();
 
 	auto heap = vec.vector_hamt_ptr->alloc.heap;
 	dispose_alloc(vec.vector_hamt_ptr->alloc);
@@ -578,47 +1232,19 @@ void dispose_vector_hamt(const runtime_value_t& vec){
 
 runtime_value_t store_immutable(const runtime_value_t& vec0, const uint64_t index, runtime_value_t value){
 	QUARK_ASSERT(vec0.check_invariant());
+	QUARK_ASSERT(has_hamt_element_scope());
 	const auto& vec1 = *vec0.vector_hamt_ptr;
 	QUARK_ASSERT(index < vec1.get_element_count());
-	auto& heap = *vec1.alloc.heap;
-
-	heap_alloc_64_t* alloc = alloc_64(heap, 0, make_undefined(), "vechamt");
 
-	auto vec = reinterpret_cast<VECTOR_HAMT_T*>(alloc);
-
-	auto buffer_ptr = reinterpret_cast<immer::vector<runtime_value_t>*>(&alloc->data[0]);
-
-	QUARK_ASSERT(sizeof(immer::vector<runtime_value_t>) <= heap_alloc_64_t::k_data_bytes);
-    auto vec2 = new (buffer_ptr) immer::vector<runtime_value_t>();
-
-	const auto& v2 = vec1.get_vecref().set(index, value);
-	*vec2 = v2;
-
-	QUARK_ASSERT(vec->check_invariant());
-	QUARK_ASSERT(heap.check_invariant());
-
-	return { .vector_hamt_ptr = vec };
+	return alloc_vector_hamt(*vec1.alloc.heap, vec1.get_vecref().set(index, hamt_element_t(value)), make_undefined());
 }
 
 runtime_value_t push_back_immutable(const runtime_value_t& vec0, runtime_value_t value){
 	QUARK_ASSERT(vec0.check_invariant());
+	QUARK_ASSERT(has_hamt_element_scope());
 	const auto& vec1 = *vec0.vector_hamt_ptr;
-	auto& heap = *vec1.alloc.heap;
-
-	heap_alloc_64_t* alloc = alloc_64(heap, 0, make_undefined(), "vechamt");
-	auto vec = reinterpret_cast<VECTOR_HAMT_T*>(alloc);
-	auto buffer_ptr = reinterpret_cast<immer::vector<runtime_value_t>*>(&alloc->data[0]);
-
-	QUARK_ASSERT(sizeof(immer::vector<runtime_value_t>) <= heap_alloc_64_t::k_data_bytes);
-    auto vec2 = new (buffer_ptr) immer::vector<runtime_value_t>();
-
-	const auto& v2 = vec1.get_vecref().push_back(value);
-	*vec2 = v2;
-
-	QUARK_ASSERT(vec->check_invariant());
-	QUARK_ASSERT(heap.check_invariant());
 
-	return { .vector_hamt_ptr = vec };
+	return alloc_vector_hamt(*vec1.alloc.heap, vec1.get_vecref().push_back(hamt_element_t(value)), make_undefined());
 }
 
 
@@ -630,11 +1256,12 @@ QUARK_TEST("VECTOR_HAMT_T", "", "", ""){
 }
 
 QUARK_TEST("VECTOR_HAMT_T", "", "", ""){
-	auto backend = make_test_value_backend();
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_int());
+	value_backend_t backend({}, {}, types, make_default_config());
 	detect_leaks(backend.heap);
-
 	const runtime_value_t a[] = { make_runtime_int(1000), make_runtime_int(2000), make_runtime_int(3000) };
-	auto v = alloc_vector_hamt(backend.heap, a, 3, type_t::make_double());
+	auto v = alloc_vector_hamt(backend.heap, a, 3, vec_type);
 	QUARK_VERIFY(v.vector_hamt_ptr != nullptr);
 
 	QUARK_VERIFY(v.vector_hamt_ptr->get_element_count() == 3);
@@ -642,9 +1269,7 @@ QUARK_TEST("VECTOR_HAMT_T", "", "", ""){
 	QUARK_VERIFY(v.vector_hamt_ptr->load_element(1).int_value == 2000);
 	QUARK_VERIFY(v.vector_hamt_ptr->load_element(2).int_value == 3000);
 
-	if(dec_rc(v.vector_hamt_ptr->alloc) == 0){
-		dispose_vector_hamt(v);
-	}
+	release_vec(backend, v, vec_type);
 
 	QUARK_VERIFY(backend.check_invariant());
 	detect_leaks(backend.heap);
@@ -655,6 +1280,7 @@ QUARK_TEST("VECTOR_HAMT_T", "", "", ""){
 
 
 
+
 ////////////////////////////////		DICT_CPPMAP_T
 
 
@@ -769,6 +1395,64 @@ void dispose_dict_hamt(runtime_value_t& d){
 
 
 
+////////////////////////////////		DICT_HASH_T
+
+
+
+QUARK_TEST("", "", "", ""){
+	const auto size = sizeof(HASH_MAP);
+	QUARK_ASSERT(size == 32);
+}
+
+bool DICT_HASH_T::check_invariant() const{
+	QUARK_ASSERT(alloc.check_invariant());
+	QUARK_ASSERT(get_debug_info(alloc) == "hashdic");
+	QUARK_ASSERT(get_map().check_invariant());
+	return true;
+}
+
+uint64_t DICT_HASH_T::size() const {
+	QUARK_ASSERT(check_invariant());
+
+	const auto& d = get_map();
+	return d.size();
+}
+
+runtime_value_t alloc_dict_hash(heap_t& heap, type_t value_type){
+	QUARK_ASSERT(heap.check_invariant());
+
+	heap_alloc_64_t* alloc = alloc_64(heap, 0, value_type, "hashdic");
+	auto dict = reinterpret_cast<DICT_HASH_T*>(alloc);
+
+	auto& m = dict->get_map_mut();
+
+	QUARK_ASSERT(sizeof(HASH_MAP) <= heap_alloc_64_t::k_data_bytes);
+    new (&m) HASH_MAP();
+
+	QUARK_ASSERT(heap.check_invariant());
+	QUARK_ASSERT(dict->check_invariant());
+
+	return runtime_value_t { .dict_hash_ptr = dict };
+}
+
+void dispose_dict_hash(runtime_value_t& d){
+	QUARK_ASSERT(sizeof(DICT_HASH_T) == sizeof(heap_alloc_64_t));
+	QUARK_ASSERT(d.dict_hash_ptr != nullptr);
+	auto& dict = *d.dict_hash_ptr;
+
+	QUARK_ASSERT(dict.check_invariant());
+
+	dict.get_map_mut().~HASH_MAP();
+	auto heap = dict.alloc.heap;
+	dispose_alloc(dict.alloc);
+	QUARK_ASSERT(heap->check_invariant());
+}
+
+
+
+
+
+
 
 
 
@@ -1029,7 +1713,7 @@ value_backend_t::value_backend_t(
 	const types_t& types,
 	const config_t& config
 ) :
-	heap(config.trace_allocs),
+	heap(config.trace_allocs, config.heap_backend_mode),
 	types(types),
 	native_func_lookup(native_func_lookup),
 	struct_layouts(struct_layouts),
@@ -1090,6 +1774,61 @@ const std::pair<type_t, struct_layout_t>& find_struct_layout(const value_backend
 }
 
 
+
+
+runtime_value_t load_vector_soa_element(value_backend_t& backend, runtime_value_t vec, type_t vec_type, uint64_t index){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, vec_type));
+
+	const auto& soa = *vec.vector_soa_ptr;
+	QUARK_ASSERT(index < soa.get_element_count());
+
+	const auto element_type = lookup_vector_element_type(backend, vec_type);
+	const auto& layout = find_struct_layout(backend, element_type).second;
+	QUARK_ASSERT(layout.members.size() == soa.get_member_count());
+
+	auto s = alloc_struct(backend.heap, layout.size, element_type);
+	const auto base_ptr = s->get_data_ptr();
+	for(uint64_t m = 0 ; m < layout.members.size() ; m++){
+		const auto& member = layout.members[m];
+		store_via_ptr2(backend.types, base_ptr + member.offset, member.type, soa.get_column_ptr(m)[index]);
+	}
+	return make_runtime_struct(s);
+}
+
+void store_vector_soa_element(value_backend_t& backend, runtime_value_t vec, type_t vec_type, uint64_t index, runtime_value_t struct_value){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, vec_type));
+
+	auto& soa = *vec.vector_soa_ptr;
+	QUARK_ASSERT(index < soa.get_capacity());
+
+	const auto element_type = lookup_vector_element_type(backend, vec_type);
+	const auto& layout = find_struct_layout(backend, element_type).second;
+	QUARK_ASSERT(layout.members.size() == soa.get_member_count());
+
+	const auto base_ptr = struct_value.struct_ptr->get_data_ptr();
+	for(uint64_t m = 0 ; m < layout.members.size() ; m++){
+		const auto& member = layout.members[m];
+		soa.get_column_ptr(m)[index] = load_via_ptr2(backend.types, base_ptr + member.offset, member.type);
+	}
+}
+
+runtime_value_t alloc_vector_soa(value_backend_t& backend, const runtime_value_t structs[], uint64_t count, type_t vec_type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, vec_type));
+
+	const auto element_type = lookup_vector_element_type(backend, vec_type);
+	const auto member_count = peek2(backend.types, element_type).get_struct(backend.types)._members.size();
+	auto result = alloc_vector_soa(backend.heap, count, count, member_count, vec_type);
+	for(uint64_t i = 0 ; i < count ; i++){
+		store_vector_soa_element(backend, result, vec_type, i, structs[i]);
+	}
+	return result;
+}
+
+
+
 ////////////////////////////////		VALUES
 
 
@@ -1111,6 +1850,10 @@ void retain_vector_carray(value_backend_t& backend, runtime_value_t vec, type_t
 	QUARK_ASSERT(is_rc_value(peek2(backend.types, type)));
 	QUARK_ASSERT(is_vector_carray(backend.types, backend.config, type) || peek2(backend.types, type).is_string());
 
+	//	Inline strings have no RC. Vector pointers are never odd so no need to check the type.
+	if(is_inline_string(vec)){
+		return;
+	}
 	inc_rc(vec.vector_carray_ptr->alloc);
 }
 
@@ -1134,6 +1877,15 @@ void retain_dict_hamt(value_backend_t& backend, runtime_value_t dict, type_t typ
 
 	inc_rc(dict.dict_hamt_ptr->alloc);
 }
+void retain_dict_hash(value_backend_t& backend, runtime_value_t dict, type_t type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(dict.check_invariant());
+	QUARK_ASSERT(type.check_invariant());
+	QUARK_ASSERT(is_rc_value(peek2(backend.types, type)));
+	QUARK_ASSERT(is_dict_hash(backend.types, backend.config, type));
+
+	inc_rc(dict.dict_hash_ptr->alloc);
+}
 
 void retain_struct(value_backend_t& backend, runtime_value_t s, type_t type){
 	QUARK_ASSERT(backend.check_invariant());
@@ -1158,6 +1910,9 @@ void retain_value(value_backend_t& backend, runtime_value_t value, type_t type){
 		else if(is_vector_carray(backend.types, backend.config, type)){
 			retain_vector_carray(backend, value, type);
 		}
+		else if(is_vector_soa(backend.types, backend.config, type)){
+			retain_vector_soa(backend, value, type);
+		}
 		else if(is_vector_hamt(backend.types, backend.config, type)){
 			retain_vector_hamt(backend, value, type);
 		}
@@ -1167,6 +1922,9 @@ void retain_value(value_backend_t& backend, runtime_value_t value, type_t type){
 		else if(is_dict_hamt(backend.types, backend.config, type)){
 			retain_dict_hamt(backend, value, type);
 		}
+		else if(is_dict_hash(backend.types, backend.config, type)){
+			retain_dict_hash(backend, value, type);
+		}
 		else if(type_peek.is_json()){
 			inc_rc(value.json_ptr->alloc);
 		}
@@ -1225,6 +1983,26 @@ void release_dict_hamt(value_backend_t& backend, runtime_value_t dict0, type_t t
 	}
 }
 
+void release_dict_hash(value_backend_t& backend, runtime_value_t dict0, type_t type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(dict0.check_invariant());
+	QUARK_ASSERT(peek2(backend.types, type).is_dict());
+	QUARK_ASSERT(is_dict_hash(backend.types, backend.config, type));
+
+	auto& dict = *dict0.dict_hash_ptr;
+	if(dec_rc(dict.alloc) == 0){
+
+		//	Release all elements.
+		const auto element_type2 = lookup_dict_value_type(backend, type);
+		if(is_rc_value(peek2(backend.types, element_type2))){
+			for(const auto& e: dict.get_map()){
+				release_value(backend, e.second, element_type2);
+			}
+		}
+		dispose_dict_hash(dict0);
+	}
+}
+
 void release_dict(value_backend_t& backend, runtime_value_t dict, type_t type){
 	QUARK_ASSERT(backend.check_invariant());
 	QUARK_ASSERT(dict.check_invariant());
@@ -1236,6 +2014,9 @@ void release_dict(value_backend_t& backend, runtime_value_t dict, type_t type){
 	else if(is_dict_hamt(backend.types, backend.config, type)){
 		release_dict_hamt(backend, dict, type);
 	}
+	else if(is_dict_hash(backend.types, backend.config, type)){
+		release_dict_hash(backend, dict, type);
+	}
 	else{
 		QUARK_ASSERT(false);
 	}
@@ -1258,6 +2039,9 @@ void release_vector_carray_pod(value_backend_t& backend, runtime_value_t vec, ty
 		QUARK_ASSERT(is_rc_value(peek2(backend.types, lookup_vector_element_type(backend, type))) == false);
 	}
 
+	if(is_inline_string(vec)){
+		return;
+	}
 	if(dec_rc(vec.vector_carray_ptr->alloc) == 0){
 		dispose_vector_carray(vec);
 	}
@@ -1285,16 +2069,21 @@ void release_vector_carray_nonpod(value_backend_t& backend, runtime_value_t vec,
 	}
 }
 
-void release_vector_hamt_elements_internal(value_backend_t& backend, runtime_value_t vec, type_t type){
+void retain_vector_soa(value_backend_t& backend, runtime_value_t vec, type_t type){
 	QUARK_ASSERT(backend.check_invariant());
 	QUARK_ASSERT(vec.check_invariant());
-	QUARK_ASSERT(type.check_invariant());
-	QUARK_ASSERT(is_vector_hamt(backend.types, backend.config, type));
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type));
+
+	inc_rc(vec.vector_soa_ptr->alloc);
+}
 
-	const auto element_type = lookup_vector_element_type(backend, type);
-	for(int i = 0 ; i < vec.vector_hamt_ptr->get_element_count() ; i++){
-		const auto& element = vec.vector_hamt_ptr->load_element(i);
-		release_value(backend, element, element_type);
+void release_vector_soa(value_backend_t& backend, runtime_value_t vec, type_t type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(vec.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type));
+
+	if(dec_rc(vec.vector_soa_ptr->alloc) == 0){
+		dispose_vector_soa(vec);
 	}
 }
 
@@ -1307,7 +2096,10 @@ void release_vec(value_backend_t& backend, runtime_value_t vec, type_t type){
 	QUARK_ASSERT(peek.is_string() || peek.is_vector());
 
 	if(peek.is_string()){
-		if(dec_rc(vec.vector_carray_ptr->alloc) == 0){
+		if(is_inline_string(vec)){
+			//	No alloc.
+		}
+		else if(dec_rc(vec.vector_carray_ptr->alloc) == 0){
 			//	String has no elements to release.
 
 			dispose_vector_carray(vec);
@@ -1322,6 +2114,9 @@ void release_vec(value_backend_t& backend, runtime_value_t vec, type_t type){
 			release_vector_carray_pod(backend, vec, type);
 		}
 	}
+	else if(is_vector_soa(backend.types, backend.config, type)){
+		release_vector_soa(backend, vec, type);
+	}
 	else if(is_vector_hamt(backend.types, backend.config, type)){
 		const auto element_type = lookup_vector_element_type(backend, type);
 		if(is_rc_value(peek2(backend.types, element_type))){
@@ -1398,5 +2193,213 @@ void release_value(value_backend_t& backend, runtime_value_t value, type_t type)
 }
 
 
+
+//	Returns true if alloc got shared now, false if it already was.
+static bool mark_shared(heap_alloc_64_t& alloc){
+	QUARK_ASSERT(alloc.check_invariant());
+
+	if(alloc.shared){
+		return false;
+	}
+	alloc.shared = true;
+	return true;
+}
+
+void share_value(value_backend_t& backend, runtime_value_t value, type_t type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(value.check_invariant());
+	QUARK_ASSERT(type.check_invariant());
+
+	const auto& peek = peek2(backend.types, type);
+	if(is_rc_value(peek) == false){
+		return;
+	}
+
+	if(peek.is_string()){
+		if(is_inline_string(value) == false){
+			mark_shared(value.vector_carray_ptr->alloc);
+		}
+	}
+	else if(is_vector_carray(backend.types, backend.config, type)){
+		if(mark_shared(value.vector_carray_ptr->alloc)){
+			const auto element_type = lookup_vector_element_type(backend, type);
+			if(is_rc_value(peek2(backend.types, element_type))){
+				const auto p = value.vector_carray_ptr->get_element_ptr();
+				for(uint64_t i = 0 ; i < value.vector_carray_ptr->get_element_count() ; i++){
+					share_value(backend, p[i], element_type);
+				}
+			}
+		}
+	}
+	else if(is_vector_soa(backend.types, backend.config, type)){
+		mark_shared(value.vector_soa_ptr->alloc);
+	}
+	else if(is_vector_hamt(backend.types, backend.config, type)){
+		if(mark_shared(value.vector_hamt_ptr->alloc)){
+			const auto element_type = lookup_vector_element_type(backend, type);
+			if(is_rc_value(peek2(backend.types, element_type))){
+				for(const auto& e: value.vector_hamt_ptr->get_vecref()){
+					share_value(backend, e.value, element_type);
+				}
+			}
+		}
+	}
+	else if(is_dict_cppmap(backend.types, backend.config, type)){
+		if(mark_shared(value.dict_cppmap_ptr->alloc)){
+			const auto element_type = lookup_dict_value_type(backend, type);
+			if(is_rc_value(peek2(backend.types, element_type))){
+				for(const auto& e: value.dict_cppmap_ptr->get_map()){
+					share_value(backend, e.second, element_type);
+				}
+			}
+		}
+	}
+	else if(is_dict_hamt(backend.types, backend.config, type)){
+		if(mark_shared(value.dict_hamt_ptr->alloc)){
+			const auto element_type = lookup_dict_value_type(backend, type);
+			if(is_rc_value(peek2(backend.types, element_type))){
+				for(const auto& e: value.dict_hamt_ptr->get_map()){
+					share_value(backend, e.second, element_type);
+				}
+			}
+		}
+	}
+	else if(is_dict_hash(backend.types, backend.config, type)){
+		if(mark_shared(value.dict_hash_ptr->alloc)){
+			const auto element_type = lookup_dict_value_type(backend, type);
+			if(is_rc_value(peek2(backend.types, element_type))){
+				for(const auto& e: value.dict_hash_ptr->get_map()){
+					share_value(backend, e.second, element_type);
+				}
+			}
+		}
+	}
+	else if(peek.is_json()){
+		//	json null can be encoded as nullptr, for example the global "null".
+		if(value.json_ptr != nullptr){
+			mark_shared(value.json_ptr->alloc);
+		}
+	}
+	else if(peek.is_struct()){
+		if(mark_shared(value.struct_ptr->alloc)){
+			const auto& struct_def = peek.get_struct(backend.types);
+			const auto struct_base_ptr = value.struct_ptr->get_data_ptr();
+			const auto& struct_layout = find_struct_layout(backend, type);
+
+			int member_index = 0;
+			for(const auto& e: struct_def._members){
+				if(is_rc_value(peek2(backend.types, e._type))){
+					const auto offset = struct_layout.second.members[member_index].offset;
+					const auto member_ptr = reinterpret_cast<const runtime_value_t*>(struct_base_ptr + offset);
+					share_value(backend, *member_ptr, e._type);
+				}
+				member_index++;
+			}
+		}
+	}
+	else{
+		QUARK_ASSERT(false);
+	}
+}
+
+QUARK_TEST("share_value()", "", "new alloc", "local, can mutate in place"){
+	heap_t heap(false);
+	auto v = alloc_vector_carray(heap, 1, 1, make_undefined());
+	QUARK_VERIFY(v.vector_carray_ptr->alloc.shared == false);
+	QUARK_VERIFY(is_rc_unique(v.vector_carray_ptr->alloc));
+
+	QUARK_VERIFY(inc_rc(v.vector_carray_ptr->alloc) == 2);
+	QUARK_VERIFY(is_rc_unique(v.vector_carray_ptr->alloc) == false);
+	QUARK_VERIFY(dec_rc(v.vector_carray_ptr->alloc) == 1);
+	QUARK_VERIFY(dec_rc(v.vector_carray_ptr->alloc) == 0);
+	dispose_vector_carray(v);
+	detect_leaks(heap);
+}
+
+QUARK_TEST("share_value()", "", "[[int]]", "outer and inner vectors shared, never unique"){
+	types_t types;
+	const auto inner_type = make_vector(types, type_t::make_int());
+	const auto outer_type = make_vector(types, inner_type);
+	auto config = make_default_config();
+	config.vector_backend_mode = vector_backend::carray;
+	value_backend_t backend({}, {}, types, config);
+
+	auto inner = alloc_vector_carray(backend.heap, 1, 1, inner_type);
+	inner.vector_carray_ptr->store(0, make_runtime_int(13));
+	auto outer = alloc_vector_carray(backend.heap, 1, 1, outer_type);
+	outer.vector_carray_ptr->store(0, inner);
+
+	share_value(backend, outer, outer_type);
+	QUARK_VERIFY(outer.vector_carray_ptr->alloc.shared);
+	QUARK_VERIFY(inner.vector_carray_ptr->alloc.shared);
+	QUARK_VERIFY(is_rc_unique(outer.vector_carray_ptr->alloc) == false);
+
+	QUARK_VERIFY(inc_rc(inner.vector_carray_ptr->alloc) == 2);
+	QUARK_VERIFY(dec_rc(inner.vector_carray_ptr->alloc) == 1);
+
+	release_vec(backend, outer, outer_type);
+	detect_leaks(backend.heap);
+}
+
+QUARK_TEST("share_value()", "", "int", "nothing to do"){
+	auto backend = make_test_value_backend();
+	share_value(backend, make_runtime_int(3), type_t::make_int());
+}
+
+QUARK_TEST("VECTOR_SOA_T", "load_vector_soa_element()", "[{int, double}]", "members round trip through columns"){
+	types_t types;
+	const auto element_type = make_struct(types, struct_type_desc_t({ member_t(type_t::make_int(), "a"), member_t(type_t::make_double(), "b") }));
+	const auto vec_type = make_vector(types, element_type);
+	auto config = make_default_config();
+	config.vector_backend_mode = vector_backend::soa;
+	value_backend_t backend(
+		{},
+		{ { element_type, struct_layout_t{ { member_info_t{ 0, type_t::make_int() }, member_info_t{ 8, type_t::make_double() } }, 16 } } },
+		types,
+		config
+	);
+	QUARK_VERIFY(is_vector_soa(backend.types, backend.config, vec_type));
+	QUARK_VERIFY(is_vector_carray(backend.types, backend.config, vec_type) == false);
+
+	std::vector<runtime_value_t> structs;
+	for(int i = 0 ; i < 3 ; i++){
+		auto s = alloc_struct(backend.heap, 16, element_type);
+		store_via_ptr2(backend.types, s->get_data_ptr() + 0, type_t::make_int(), make_runtime_int(10 + i));
+		store_via_ptr2(backend.types, s->get_data_ptr() + 8, type_t::make_double(), make_runtime_double(0.5 + i));
+		structs.push_back(make_runtime_struct(s));
+	}
+
+	const auto vec = alloc_vector_soa(backend, &structs[0], structs.size(), vec_type);
+	for(const auto& e: structs){
+		release_value(backend, e, element_type);
+	}
+	QUARK_VERIFY(vec.vector_soa_ptr->get_column_ptr(0)[2].int_value == 12);
+	QUARK_VERIFY(vec.vector_soa_ptr->get_column_ptr(1)[1].double_value == 1.5);
+
+	const auto e1 = load_vector_soa_element(backend, vec, vec_type, 1);
+	QUARK_VERIFY(load_via_ptr2(backend.types, e1.struct_ptr->get_data_ptr() + 0, type_t::make_int()).int_value == 11);
+	QUARK_VERIFY(load_via_ptr2(backend.types, e1.struct_ptr->get_data_ptr() + 8, type_t::make_double()).double_value == 1.5);
+	release_value(backend, e1, element_type);
+
+	share_value(backend, vec, vec_type);
+	QUARK_VERIFY(vec.vector_soa_ptr->alloc.shared);
+
+	release_value(backend, vec, vec_type);
+	detect_leaks(backend.heap);
+}
+
+QUARK_TEST("VECTOR_SOA_T", "is_vector_soa()", "[{string}], [int]", "use carray"){
+	types_t types;
+	const auto s_type = make_struct(types, struct_type_desc_t({ member_t(type_t::make_string(), "a") }));
+	auto config = make_default_config();
+	config.vector_backend_mode = vector_backend::soa;
+
+	QUARK_VERIFY(is_vector_soa(types, config, make_vector(types, s_type)) == false);
+	QUARK_VERIFY(is_vector_carray(types, config, make_vector(types, s_type)));
+	QUARK_VERIFY(is_vector_soa(types, config, make_vector(types, type_t::make_int())) == false);
+	QUARK_VERIFY(is_vector_carray(types, config, make_vector(types, type_t::make_int())));
+}
+
+
 }	//	floyd
 
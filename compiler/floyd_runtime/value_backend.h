@@ -25,18 +25,24 @@
 	- Controlling alignment and letting us address allocations more effectively than 64 bit pointers.
 	- Support never reusing the same allocation pointer/ID.
 
-	NOTICE: Right now each alloc is made using malloc(). In the future we can switch to private heap / arena / pooling.
+	Small allocs are carved from per-size-class slab pools owned by the heap_t, see heap_pools_t. Big allocs and
+	heaps configured with heap_backend::malloc use malloc() directly.
 */
 
 #ifndef value_backend_hpp
 #define value_backend_hpp
 
 #include "immer/vector.hpp"
+#include "immer/vector_transient.hpp"
 #include "immer/map.hpp"
+#include "quadratic_probing_hash_table.h"
 
 #include <atomic>
+#include <cstring>
 #include <map>
 #include <mutex>
+#include <string_view>
+#include <thread>
 #include "ast_value.h"
 #include "types.h"
 #include "ast.h"
@@ -66,12 +72,15 @@ namespace floyd {
 
 struct type_t;
 struct heap_alloc_64_t;
+struct value_backend_t;
 
 
 struct VECTOR_CARRAY_T;
 struct VECTOR_HAMT_T;
+struct VECTOR_SOA_T;
 struct DICT_CPPMAP_T;
 struct DICT_HAMT_T;
+struct DICT_HASH_T;
 struct JSON_T;
 struct STRUCT_T;
 
@@ -99,7 +108,116 @@ runtime_type_t make_runtime_type(type_t type);
 
 struct heap_rec_t {
 	heap_alloc_64_t* alloc_ptr;
-//	bool in_use;
+
+	//	Copy of the alloc's alloc_id when it was recorded. Tells a live alloc from a disposed one that got the
+	//	same address.
+	int64_t alloc_id;
+};
+
+/*
+	Index of all live allocs of a heap, used when record_allocs_flag is set.
+
+	Open addressing hash table keyed on alloc address, linear probing and backward-shift deletion so there are no
+	tombstones. insert() and erase() are O(1) and don't malloc except when growing. Size is proportional to the
+	number of *live* allocs, not to the number of allocs ever made.
+*/
+struct heap_live_index_t {
+	bool check_invariant() const;
+
+	void insert(heap_alloc_64_t* alloc_ptr, int64_t alloc_id);
+
+	//	Returns false if there is no live record of this alloc + alloc_id.
+	bool erase(const heap_alloc_64_t* alloc_ptr, int64_t alloc_id);
+
+	std::size_t size() const {
+		return count;
+	}
+
+	template <typename F> void for_each(const F& f) const {
+		for(const auto& e: slots){
+			if(e.alloc_ptr != nullptr){
+				f(e);
+			}
+		}
+	}
+
+
+	////////////////////////////////		STATE
+
+	//	alloc_ptr == nullptr: empty slot. Size is always 0 or a power of two.
+	std::vector<heap_rec_t> slots;
+	std::size_t count = 0;
+};
+
+
+
+/*
+	Size-class slab pools used by alloc_64() / dispose_alloc().
+
+	Each size class holds blocks big enough for a heap_alloc_64_t header + N allocation words. Blocks are carved
+	out of big slabs and are recycled via free-lists. Slabs are only returned to the OS when the heap_t dies.
+
+	Every thread that touches the heap gets its own heap_thread_cache_t with a short free-list per size class, so
+	the common alloc / dispose needs no locking. Caches refill from and spill to the shared free-lists in batches.
+	A block may be disposed by another thread than the one that allocated it.
+
+	Allocs with more than k_max_pooled_words allocation words go straight to malloc().
+*/
+
+static const int k_heap_size_class_count = 11;
+static const uint64_t k_heap_size_class_words[k_heap_size_class_count] = { 0, 1, 2, 3, 4, 6, 8, 12, 16, 24, 32 };
+static const uint64_t k_max_pooled_words = 32;
+
+//	Returns -1 if the alloc is too big to be pooled.
+inline int get_heap_size_class(uint64_t allocation_word_count){
+	if(allocation_word_count <= 4){
+		return static_cast<int>(allocation_word_count);
+	}
+	else if(allocation_word_count <= 6){
+		return 5;
+	}
+	else if(allocation_word_count <= 8){
+		return 6;
+	}
+	else if(allocation_word_count <= 12){
+		return 7;
+	}
+	else if(allocation_word_count <= 16){
+		return 8;
+	}
+	else if(allocation_word_count <= 24){
+		return 9;
+	}
+	else if(allocation_word_count <= 32){
+		return 10;
+	}
+	else{
+		return -1;
+	}
+}
+
+//	Free blocks are linked using their first 8 bytes.
+struct heap_free_list_t {
+	void* head = nullptr;
+	uint32_t count = 0;
+};
+
+struct heap_thread_cache_t {
+	std::thread::id thread_id;
+	heap_free_list_t free_lists[k_heap_size_class_count];
+};
+
+struct heap_pools_t {
+	std::mutex mutex;
+
+	//	Blocks in these lists can be grabbed by any thread, protected by mutex.
+	heap_free_list_t shared_free_lists[k_heap_size_class_count];
+
+	std::vector<void*> slabs;
+	std::vector<std::unique_ptr<heap_thread_cache_t>> thread_caches;
+
+	//	Unique for each heap_t ever made, used to validate the thread-local cache lookup.
+	uint64_t heap_serial;
 };
 
 
@@ -107,15 +225,7 @@ struct heap_rec_t {
 static const uint64_t HEAP_MAGIC = 0xf00d1234;
 
 struct heap_t {
-	heap_t(bool record_allocs_flag) :
-		magic(0xf00d1234),
-		allocation_id_generator(1000000),
-		record_allocs_flag(record_allocs_flag)
-	{
-#if HEAP_MUTEX
-		alloc_records_mutex = std::make_shared<std::recursive_mutex>();
-#endif
-	}
+	heap_t(bool record_allocs_flag, heap_backend backend_mode = heap_backend::pool);
 	~heap_t();
 	public: bool check_invariant() const;
 	public: int count_used() const;
@@ -126,10 +236,19 @@ struct heap_t {
 #if HEAP_MUTEX
 	std::shared_ptr<std::recursive_mutex> alloc_records_mutex;
 #endif
-	std::vector<heap_rec_t> alloc_records;
 
-	uint64_t allocation_id_generator;
+	//	Only used when record_allocs_flag is set. Protected by live_allocs_mutex.
+	heap_live_index_t alloc_records;
+	mutable std::mutex live_allocs_mutex;
+
+	//	Every alloc gets a unique, increasing alloc_id, also across threads.
+	std::atomic<uint64_t> allocation_id_generator;
 	bool record_allocs_flag;
+
+	heap_backend backend_mode;
+
+	//	nullptr when backend_mode is heap_backend::malloc.
+	std::unique_ptr<heap_pools_t> pools;
 };
 
 
@@ -142,7 +261,7 @@ struct heap_t {
 /*
 64 bytes = 8 x int64_t
 
-[ atomic RC] [ magic: 0xa110a11c	]
+[ RC		] [ magic: 0xa11c ] [ shared ]
 [ data #0							]
 [ data #1							]
 [ data #2							]
@@ -159,7 +278,7 @@ struct heap_t {
 
 struct heap_t;
 
-static const uint64_t ALLOC_64_MAGIC = 0xa110a11c;
+static const uint16_t ALLOC_64_MAGIC = 0xa11c;
 
 //	This header is followed by a number of uint64_t elements in the same heap block.
 //	This header represents a sharepoint of many clients and holds an RC to count clients.
@@ -170,17 +289,23 @@ struct heap_alloc_64_t {
 	static const int k_data_elements = 4;
 	static const size_t k_data_bytes = sizeof(uint64_t) * k_data_elements;
 
+	//	Byte offsets of rc and shared. The LLVM codegen changes RC inline using these, see generate_retain().
+	static const int k_rc_offset = 0;
+	static const int k_shared_offset = 6;
+
 
 	heap_alloc_64_t(heap_t* heap0, uint64_t allocation_word_count, type_t debug_value_type, const char debug_string[]) :
 		rc(1),
 		magic(ALLOC_64_MAGIC),
+		shared(false),
+		pad(0),
 		allocation_word_count(allocation_word_count),
 		heap(heap0)
 #if DEBUG
 		,
 		debug_value_type(debug_value_type)
 #endif
-		,alloc_id(heap->allocation_id_generator++)
+		,alloc_id(heap0->allocation_id_generator.fetch_add(1, std::memory_order_relaxed))
 	{
 		QUARK_ASSERT(heap0 != nullptr);
 		assert(heap0 != nullptr);
@@ -209,7 +334,13 @@ struct heap_alloc_64_t {
 #else
 	mutable int32_t rc;
 #endif
-	uint32_t magic;
+	uint16_t magic;
+
+	//	false: only one thread can reach this alloc, RC is bumped without atomic instructions.
+	//	true: other threads may hold references, RC must be atomic and the alloc is never mutated in place.
+	//	Set by share_value(), never cleared.
+	bool shared;
+	uint8_t pad;
 
 	//	 data_*: 4 x 8 bytes.
 	uint64_t data[4];
@@ -232,7 +363,7 @@ std::string get_debug_info(const heap_alloc_64_t& alloc);
 
 
 /*
-	Allocates a block of data using malloc().
+	Allocates a block of data from the heap's size-class pools, or using malloc() for big blocks.
 
 	It consists of two parts: the header and the dynamic elements.
 
@@ -260,8 +391,10 @@ inline uint64_t size_to_allocation_blocks(std::size_t size);
 
 //	Returns updated RC, no need to atomically read it yourself.
 //	If returned RC is 0, there is no way for any other client to bump it up again.
+//	Only allocs marked shared pay for atomic instructions, see share_value().
 inline int32_t dec_rc(const heap_alloc_64_t& alloc);
 inline int32_t inc_rc(const heap_alloc_64_t& alloc);
+inline bool is_rc_unique(const heap_alloc_64_t& alloc);
 
 void dispose_alloc(heap_alloc_64_t& alloc);
 
@@ -275,6 +408,8 @@ void dispose_alloc(heap_alloc_64_t& alloc);
 	Native, runtime value, as used by x86 code when running optimized program. Executing.
 	Usually this is a 64 bit value that holds either an integer / double etc OR a pointer to a separate allocation.
 
+	Strings of up to 7 characters are stored inline, see make_inline_string().
+
 	Future: these can have different sizes. A vector can use SSO and embedd head + some body directly here.
 */
 
@@ -290,9 +425,11 @@ union runtime_value_t {
 
 	VECTOR_CARRAY_T* vector_carray_ptr;
 	VECTOR_HAMT_T* vector_hamt_ptr;
+	VECTOR_SOA_T* vector_soa_ptr;
 
 	DICT_CPPMAP_T* dict_cppmap_ptr;
 	DICT_HAMT_T* dict_hamt_ptr;
+	DICT_HASH_T* dict_hash_ptr;
 
 	JSON_T* json_ptr;
 	STRUCT_T* struct_ptr;
@@ -313,11 +450,16 @@ runtime_value_t make_runtime_typeid(type_t type);
 runtime_value_t make_runtime_struct(STRUCT_T* struct_ptr);
 runtime_value_t make_runtime_vector_carray(VECTOR_CARRAY_T* vector_ptr);
 runtime_value_t make_runtime_vector_hamt(VECTOR_HAMT_T* vector_hamt_ptr);
+runtime_value_t make_runtime_vector_soa(VECTOR_SOA_T* vector_soa_ptr);
 runtime_value_t make_runtime_dict_cppmap(DICT_CPPMAP_T* dict_cppmap_ptr);
 runtime_value_t make_runtime_dict_hamt(DICT_HAMT_T* dict_hamt_ptr);
+runtime_value_t make_runtime_dict_hash(DICT_HASH_T* dict_hash_ptr);
 
 uint64_t get_vec_string_size(runtime_value_t str);
 
+//	Overwrites one character in place. Strings pack 8 characters per element, first character in the lowest byte.
+void store_string_char(runtime_value_t str, uint64_t index, char ch);
+
 void copy_elements(runtime_value_t dest[], runtime_value_t source[], uint64_t count);
 
 
@@ -370,13 +512,15 @@ WIDE_RETURN_T make_wide_return_2x64(runtime_value_t a, runtime_value_t b);
 /*
 	A fixed-size immutable vector with RC. Deep copy everytime = expensive to mutate.
 
-	- Mutation = copy entire vector every time.
+	- Mutation = copy entire vector, unless the caller holds the only reference (RC == 1). Then push_back() and
+		update() mutate the vector in place and grow the allocation geometrically, see grow_vector_carray().
 	- Elements are always runtime_value_t. You need to pack and address other types of data manually.
 
 	Invariant:
-		alloc_count = roundup(element_count * element_bits, 64) / 64
+		alloc_count >= roundup(element_count * element_bits, 64) / 64
 
 	data[0]: element count
+	data[1]: strings only: cached hash of the characters, 0 = not computed yet. See make_string_key().
 */
 struct VECTOR_CARRAY_T {
 	~VECTOR_CARRAY_T();
@@ -438,32 +582,213 @@ struct VECTOR_CARRAY_T {
 runtime_value_t alloc_vector_carray(heap_t& heap, uint64_t allocation_count, uint64_t element_count, type_t value_type);
 void dispose_vector_carray(const runtime_value_t& value);
 
+//	Moves the elements of vec into a new allocation with room for at least needed_allocation_count words, and
+//	some slack so repeated push_back() is amortized O(1). Elements keep their RCs.
+//	vec must have RC 1. Takes over its reference: vec is disposed.
+runtime_value_t grow_vector_carray(heap_t& heap, runtime_value_t vec, uint64_t needed_allocation_count, type_t value_type);
+
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "get_string_view() and inline strings need a little endian CPU."
+#endif
+
+
+
+////////////////////////////////		INLINE STRINGS
+
+
+/*
+	Strings of up to 7 characters are stored inside the runtime_value_t itself: no heap alloc, no RC.
+	Heap pointers are always 8-aligned so bit 0 tells the two encodings apart.
+
+	byte 0: (character count << 1) | 1
+	byte 1 - 7: the characters, then zeros. Equal inline strings have equal bits.
+
+	Heap strings can still be short, code that gets a string must handle both encodings: use get_vec_string_size(),
+	get_string_view() and friends, never str.vector_carray_ptr directly. retain / release skip inline strings.
+*/
+
+static const std::size_t k_inline_string_max = 7;
+
+inline bool is_inline_string(runtime_value_t str){
+	return (str.int_value & 1) != 0;
+}
+
+inline runtime_value_t make_inline_string(std::string_view chars){
+	QUARK_ASSERT(chars.size() <= k_inline_string_max);
+
+	runtime_value_t result;
+	result.int_value = static_cast<int64_t>((chars.size() << 1) | 1);
+	std::memcpy(reinterpret_cast<char*>(&result) + 1, chars.data(), chars.size());
+	return result;
+}
+
+inline uint64_t get_inline_string_size(runtime_value_t str){
+	QUARK_ASSERT(is_inline_string(str));
+
+	return (static_cast<uint64_t>(str.int_value) & 0xff) >> 1;
+}
+
+
+//	A string's characters, without copying them. The first character is in the lowest byte of each element so
+//	on a little endian CPU the elements are the characters in order.
+//	An inline string's characters live inside str, the view is only valid as long as str is.
+inline std::string_view get_string_view(const runtime_value_t& str){
+	if(is_inline_string(str)){
+		return std::string_view(reinterpret_cast<const char*>(&str) + 1, get_inline_string_size(str));
+	}
+	else{
+		QUARK_ASSERT(str.vector_carray_ptr != nullptr);
+
+		const auto& vec = *str.vector_carray_ptr;
+		return std::string_view(reinterpret_cast<const char*>(vec.get_element_ptr()), vec.get_element_count());
+	}
+}
+std::string_view get_string_view(const runtime_value_t&& str) = delete;
+
+/*
+	Looks up a string in a dictionary without making a std::string.
+	hash is std::hash<std::string_view> of the characters, the same hash std::hash<std::string> gives the keys.
+*/
+struct string_key_t {
+	std::string_view chars;
+	std::size_t hash;
+};
+
+//	Hashes heap strings the first time, then uses the hash cached in data[1]. Inline strings are hashed every time.
+inline string_key_t make_string_key(const runtime_value_t& str){
+	const auto chars = get_string_view(str);
+	if(is_inline_string(str)){
+		return { chars, std::hash<std::string_view>{}(chars) };
+	}
+
+	//	Other threads can hash the same shared string at the same time, so the cache is read and written using
+	//	relaxed atomics. Racing threads all store the same value, the cache needs no ordering beyond that.
+	auto cached_hash_ptr = &str.vector_carray_ptr->alloc.data[1];
+	const uint64_t cached_hash = __atomic_load_n(cached_hash_ptr, __ATOMIC_RELAXED);
+	if(cached_hash != 0){
+		return { chars, cached_hash };
+	}
+
+	const uint64_t hash = std::hash<std::string_view>{}(chars);
+	__atomic_store_n(cached_hash_ptr, hash, __ATOMIC_RELAXED);
+	return { chars, hash };
+}
+string_key_t make_string_key(const runtime_value_t&& str) = delete;
+
 
 
 ////////////////////////////////		VECTOR_HAMT_T
 
 
+/*
+	Element of a VECTOR_HAMT_T.
+
+	The elements are owned by the immer nodes that hold them, not by each VECTOR_HAMT_T. push_back() and update()
+	make a new vector that shares all nodes with the old one except the path to the changed slot, so only the
+	elements in the copied leaf get retained: O(log n), not O(n).
+
+	immer copies elements when it copies a node and destroys them when the last vector using the node goes away.
+	The copy constructor and destructor retain / release the value using the innermost hamt_element_scope_t,
+	which knows the element type. 0 = no value, is never retained / released.
+*/
+void retain_hamt_element(runtime_value_t value);
+void release_hamt_element(runtime_value_t value);
+
+struct hamt_element_t {
+	hamt_element_t() :
+		value{ .int_value = 0 }
+	{
+	}
+
+	//	Takes over value's reference.
+	explicit hamt_element_t(runtime_value_t value) :
+		value(value)
+	{
+	}
+
+	hamt_element_t(const hamt_element_t& other) :
+		value(other.value)
+	{
+		if(value.int_value != 0){
+			retain_hamt_element(value);
+		}
+	}
+
+	hamt_element_t(hamt_element_t&& other) :
+		value(other.value)
+	{
+		other.value.int_value = 0;
+	}
+
+	hamt_element_t& operator=(const hamt_element_t& other){
+		hamt_element_t temp(other);
+		std::swap(value, temp.value);
+		return *this;
+	}
+
+	hamt_element_t& operator=(hamt_element_t&& other){
+		std::swap(value, other.value);
+		return *this;
+	}
+
+	~hamt_element_t(){
+		if(value.int_value != 0){
+			release_hamt_element(value);
+		}
+	}
+
+
+	////////////////////////////////		STATE
+	runtime_value_t value;
+};
+
+typedef immer::vector<hamt_element_t> HAMT_VECTOR;
+
+
+/*
+	Tells hamt_element_t how to retain and release the elements of vector_type. Create one on the stack around
+	code that copies, changes or destroys a VECTOR_HAMT_T's immer vector. Scopes nest: releasing an element
+	can dispose a vector of another type.
+*/
+struct hamt_element_scope_t {
+	hamt_element_scope_t(value_backend_t& backend, type_t vector_type);
+	~hamt_element_scope_t();
+
+	hamt_element_scope_t(const hamt_element_scope_t& other) = delete;
+	hamt_element_scope_t& operator=(const hamt_element_scope_t& other) = delete;
+
+
+	////////////////////////////////		STATE
+	value_backend_t& backend;
+	type_t element_type;
+	bool is_rc;
+	hamt_element_scope_t* prev;
+};
+
+bool has_hamt_element_scope();
+
+
+
 /*
 	A fixed-size immutable vector with RC. Use HAMT.
 
-	- Mutation = copy entire vector every time.
+	- Mutation = path copying, see hamt_element_t. With RC 1, push_back() and update() change the immer vector
+		in place.
 	- Elements are always runtime_value_t. You need to pack and address other types of data manually.
 
-	Invariant:
-		alloc_count = roundup(element_count * element_bits, 64) / 64
-
-	data: embeds immer::vector<runtime_value_t>
+	data: embeds HAMT_VECTOR
 */
 
 struct VECTOR_HAMT_T {
 	~VECTOR_HAMT_T();
 	bool check_invariant() const;
 
-	const immer::vector<runtime_value_t>& get_vecref() const {
-		return *reinterpret_cast<const immer::vector<runtime_value_t>*>(&alloc.data[0]);
+	const HAMT_VECTOR& get_vecref() const {
+		return *reinterpret_cast<const HAMT_VECTOR*>(&alloc.data[0]);
 	}
-	immer::vector<runtime_value_t>& get_vecref_mut(){
-		return *reinterpret_cast<immer::vector<runtime_value_t>*>(&alloc.data[0]);
+	HAMT_VECTOR& get_vecref_mut(){
+		return *reinterpret_cast<HAMT_VECTOR*>(&alloc.data[0]);
 	}
 
 	inline uint64_t get_allocation_count() const{
@@ -480,13 +805,13 @@ struct VECTOR_HAMT_T {
 	}
 
 
-	inline immer::vector<runtime_value_t>::const_iterator begin() const {
+	inline HAMT_VECTOR::const_iterator begin() const {
 		QUARK_ASSERT(check_invariant());
 
 		const auto& vecref = get_vecref();
 		return vecref.begin();
 	}
-	inline immer::vector<runtime_value_t>::const_iterator end() const {
+	inline HAMT_VECTOR::const_iterator end() const {
 		QUARK_ASSERT(check_invariant());
 
 		const auto& vecref = get_vecref();
@@ -498,18 +823,17 @@ struct VECTOR_HAMT_T {
 		const auto& vecref = get_vecref();
 		QUARK_ASSERT(index < vecref.size())
 
-		const auto temp = vecref[index];
-		return temp;
+		return vecref[index].value;
 	}
 
 	//	Mutates the VECTOR_HAMT_T implace -- only OK while constructing it when no other observers exists.
+	//	Takes over value's reference.
 	inline void store_mutate(const uint64_t index, runtime_value_t value){
 		QUARK_ASSERT(check_invariant());
 		QUARK_ASSERT(index < get_vecref().size());
 
-		const auto& vecref = get_vecref();
-		const auto v2 = vecref.set(index, value);
-		get_vecref_mut() = v2;
+		auto& vecref = get_vecref_mut();
+		vecref = std::move(vecref).set(index, hamt_element_t(value));
 	}
 
 
@@ -517,24 +841,106 @@ struct VECTOR_HAMT_T {
 	heap_alloc_64_t alloc;
 };
 
+//	Elements are 0 = no value.
 runtime_value_t alloc_vector_hamt(heap_t& heap, uint64_t allocation_count, uint64_t element_count, type_t value_type);
+
+//	Takes over the references of the elements.
 runtime_value_t alloc_vector_hamt(heap_t& heap, const runtime_value_t elements[], uint64_t element_count, type_t value_type);
+
+//	The new VECTOR_HAMT_T shares vec's nodes.
+runtime_value_t alloc_vector_hamt(heap_t& heap, const HAMT_VECTOR& vec, type_t value_type);
+
+//	Needs a hamt_element_scope_t: releases the elements that only this vector's nodes hold.
 void dispose_vector_hamt(const runtime_value_t& vec);
 
+//	Needs a hamt_element_scope_t. Takes over value's reference, does not change vec's RC.
 runtime_value_t store_immutable(const runtime_value_t& vec, const uint64_t index, runtime_value_t value);
 runtime_value_t push_back_immutable(const runtime_value_t& vec0, runtime_value_t value);
 
 
 
+////////////////////////////////		VECTOR_SOA_T
+
+
+/*
+	Vector of POD structs stored column-wise, struct-of-arrays: one column per struct member. See is_vector_soa().
+	Reading one member of many elements only touches that member's column, not one STRUCT_T per element.
+
+	Each member is stored as a runtime_value_t, column i starts at word i * capacity after the header.
+	The elements are not STRUCT_T:s and have no RC. load_vector_soa_element() makes a new STRUCT_T from a
+	row, store_vector_soa_element() copies a STRUCT_T's members into a row.
+
+	data[0]: element count
+	data[1]: capacity, in elements
+	data[2]: member count
+*/
+
+struct VECTOR_SOA_T {
+	//	Byte offset of data[1] from the start of the alloc. The LLVM codegen reads the capacity to find a column.
+	static const int k_capacity_offset = 16;
+
+	bool check_invariant() const;
+
+	inline uint64_t get_element_count() const{
+		QUARK_ASSERT(check_invariant());
+
+		return alloc.data[0];
+	}
+
+	inline uint64_t get_capacity() const{
+		QUARK_ASSERT(check_invariant());
+
+		return alloc.data[1];
+	}
+
+	inline uint64_t get_member_count() const{
+		QUARK_ASSERT(check_invariant());
+
+		return alloc.data[2];
+	}
+
+	inline const runtime_value_t* get_column_ptr(uint64_t member_index) const{
+		QUARK_ASSERT(check_invariant());
+		QUARK_ASSERT(member_index < get_member_count());
+
+		return static_cast<const runtime_value_t*>(get_alloc_ptr(alloc)) + member_index * get_capacity();
+	}
+	inline runtime_value_t* get_column_ptr(uint64_t member_index){
+		QUARK_ASSERT(check_invariant());
+		QUARK_ASSERT(member_index < get_member_count());
+
+		return static_cast<runtime_value_t*>(get_alloc_ptr(alloc)) + member_index * get_capacity();
+	}
+
+
+	////////////////////////////////		STATE
+	heap_alloc_64_t alloc;
+};
+
+//	Elements are zeroed.
+runtime_value_t alloc_vector_soa(heap_t& heap, uint64_t capacity, uint64_t element_count, uint64_t member_count, type_t value_type);
+void dispose_vector_soa(const runtime_value_t& vec);
+
+//	Copies the elements of vec into a new VECTOR_SOA_T with room for at least needed_capacity elements, and some
+//	slack so repeated push_back() is amortized O(1). vec must have RC 1 and is disposed.
+runtime_value_t grow_vector_soa(heap_t& heap, runtime_value_t vec, uint64_t needed_capacity, type_t value_type);
+
+//	Copies count rows, all columns. dest and source must have the same member count.
+void copy_vector_soa_rows(VECTOR_SOA_T& dest, uint64_t dest_index, const VECTOR_SOA_T& source, uint64_t source_index, uint64_t count);
+
+
+
 ////////////////////////////////		DICT_CPPMAP_T
 
 
 /*
 	A std::map<> is stored inplace:
 	data: embeds std::map<std::string, runtime_value_t>
+
+	std::less<> lets find() take the std::string_view of a string_key_t.
 */
 
-typedef std::map<std::string, runtime_value_t> CPPMAP;
+typedef std::map<std::string, runtime_value_t, std::less<>> CPPMAP;
 
 struct DICT_CPPMAP_T {
 	bool check_invariant() const;
@@ -560,11 +966,32 @@ void dispose_dict_cppmap(runtime_value_t& vec);
 ////////////////////////////////		DICT_HAMT_T
 
 
+//	Hashes and compares std::string keys with string_key_t, so HAMT_MAP::find() takes a string_key_t.
+struct string_key_hash_t {
+	typedef void is_transparent;
+
+	std::size_t operator()(const std::string& key) const {
+		return std::hash<std::string_view>{}(key);
+	}
+	std::size_t operator()(const string_key_t& key) const {
+		return key.hash;
+	}
+};
+
+struct string_key_equal_t {
+	bool operator()(const std::string& a, const std::string& b) const {
+		return a == b;
+	}
+	bool operator()(const std::string& a, const string_key_t& b) const {
+		return a == b.chars;
+	}
+};
+
 /*
-	A std::map<> is stored inplace:
-	data: embeds std::map<std::string, runtime_value_t>
+	An immer::map<> is stored inplace:
+	data: embeds immer::map<std::string, runtime_value_t>
 */
-typedef immer::map<std::string, runtime_value_t> HAMT_MAP;
+typedef immer::map<std::string, runtime_value_t, string_key_hash_t, string_key_equal_t> HAMT_MAP;
 
 struct DICT_HAMT_T {
 	bool check_invariant() const;
@@ -587,6 +1014,39 @@ void dispose_dict_hamt(runtime_value_t& vec);
 
 
 
+////////////////////////////////		DICT_HASH_T
+
+
+/*
+	A quadratic_probing_hash_table_t<> is stored inplace:
+	data: embeds quadratic_probing_hash_table_t<runtime_value_t>
+
+	Copy on write: update() and erase() copy the table, unless the argument holds the only reference --
+	then they mutate it in place.
+*/
+typedef quadratic_probing_hash_table_t<runtime_value_t> HASH_MAP;
+
+struct DICT_HASH_T {
+	bool check_invariant() const;
+	uint64_t size() const;
+
+	const HASH_MAP& get_map() const {
+		return *reinterpret_cast<const HASH_MAP*>(&alloc.data[0]);
+	}
+	HASH_MAP& get_map_mut(){
+		return *reinterpret_cast<HASH_MAP*>(&alloc.data[0]);
+	}
+
+
+	////////////////////////////////		STATE
+	heap_alloc_64_t alloc;
+};
+
+runtime_value_t alloc_dict_hash(heap_t& heap, type_t value_type);
+void dispose_dict_hash(runtime_value_t& vec);
+
+
+
 ////////////////////////////////		JSON_T
 
 
@@ -594,8 +1054,6 @@ void dispose_dict_hamt(runtime_value_t& vec);
 	Store a json_t* in data[0]. It need to be new/deletes via C++.
 */
 
-typedef std::map<std::string, runtime_value_t> CPPMAP;
-
 struct JSON_T {
 	bool check_invariant() const;
 
@@ -719,6 +1177,16 @@ inline type_t lookup_dict_value_type(const value_backend_t& backend, type_t type
 const std::pair<type_t, struct_layout_t>& find_struct_layout(const value_backend_t& backend, type_t type);
 
 
+//	Returns a new STRUCT_T, RC 1, with the members of element index.
+runtime_value_t load_vector_soa_element(value_backend_t& backend, runtime_value_t vec, type_t vec_type, uint64_t index);
+
+//	Copies the members of struct_value into element index. Does not change struct_value's RC.
+void store_vector_soa_element(value_backend_t& backend, runtime_value_t vec, type_t vec_type, uint64_t index, runtime_value_t struct_value);
+
+//	New VECTOR_SOA_T, RC 1, holding copies of count STRUCT_T:s. Does not change their RCs.
+runtime_value_t alloc_vector_soa(value_backend_t& backend, const runtime_value_t structs[], uint64_t count, type_t vec_type);
+
+
 
 ////////////////////////////////		REFERENCE COUNTING
 
@@ -734,6 +1202,7 @@ inline void retain_vector_hamt(value_backend_t& backend, runtime_value_t vec, ty
 
 void retain_dict_cppmap(value_backend_t& backend, runtime_value_t dict, type_t type);
 void retain_dict_hamt(value_backend_t& backend, runtime_value_t dict, type_t type);
+void retain_dict_hash(value_backend_t& backend, runtime_value_t dict, type_t type);
 
 void retain_struct(value_backend_t& backend, runtime_value_t s, type_t type);
 
@@ -741,9 +1210,21 @@ void retain_struct(value_backend_t& backend, runtime_value_t s, type_t type);
 
 void release_value(value_backend_t& backend, runtime_value_t value, type_t type);
 
+/*
+	Marks value and all RC values it holds as shared, before another thread can get a reference to it: messages
+	sent to processes, inputs to parallel map() / filter() / map_dag() / sort() and globals. Everything else
+	stays local to the thread that made it and gets cheap non-atomic RC.
+	Already shared allocs are skipped with their children, so sharing the same value again is cheap.
+*/
+void share_value(value_backend_t& backend, runtime_value_t value, type_t type);
+
 void release_vector_carray_pod(value_backend_t& backend, runtime_value_t vec, type_t type);
 void release_vector_carray_nonpod(value_backend_t& backend, runtime_value_t vec, type_t type);
 
+//	The elements have no RC, only the vector itself.
+void retain_vector_soa(value_backend_t& backend, runtime_value_t vec, type_t type);
+void release_vector_soa(value_backend_t& backend, runtime_value_t vec, type_t type);
+
 inline void release_vector_hamt_pod(value_backend_t& backend, runtime_value_t vec, type_t type);
 inline void release_vector_hamt_nonpod(value_backend_t& backend, runtime_value_t vec, type_t type);
 
@@ -752,10 +1233,10 @@ void release_vec(value_backend_t& backend, runtime_value_t vec, type_t type);
 
 void release_dict_cppmap(value_backend_t& backend, runtime_value_t dict0, type_t type);
 void release_dict_hamt(value_backend_t& backend, runtime_value_t dict0, type_t type);
+void release_dict_hash(value_backend_t& backend, runtime_value_t dict0, type_t type);
 void release_dict(value_backend_t& backend, runtime_value_t dict0, type_t type);
 
 
-void release_vector_hamt_elements_internal(value_backend_t& backend, runtime_value_t vec, type_t type);
 void release_struct(value_backend_t& backend, runtime_value_t s, type_t type);
 
 
@@ -764,12 +1245,42 @@ void release_struct(value_backend_t& backend, runtime_value_t s, type_t type);
 
 
 
+//	Vectors of structs with only POD members: int, double, bool, typeid and functions.
+inline bool is_soa_element_type(const types_t& types, type_t element_type){
+	const auto peek = peek2(types, element_type);
+	if(peek.is_struct() == false){
+		return false;
+	}
+	const auto& members = peek.get_struct(types)._members;
+	if(members.empty()){
+		return false;
+	}
+	for(const auto& e: members){
+		if(is_rc_value(peek2(types, e._type))){
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool is_vector_soa(const types_t& types, const config_t& config, type_t t){
+	QUARK_ASSERT(types.check_invariant());
+	QUARK_ASSERT(config.check_invariant());
+	QUARK_ASSERT(t.check_invariant());
+
+	const auto peek = peek2(types, t);
+	return peek.is_vector()
+		&& config.vector_backend_mode == vector_backend::soa
+		&& is_soa_element_type(types, peek.get_vector_element_type(types));
+}
 inline bool is_vector_carray(const types_t& types, const config_t& config, type_t t){
 	QUARK_ASSERT(types.check_invariant());
 	QUARK_ASSERT(config.check_invariant());
 	QUARK_ASSERT(t.check_invariant());
 
-	return peek2(types, t).is_vector() && config.vector_backend_mode == vector_backend::carray;
+	return peek2(types, t).is_vector()
+		&& (config.vector_backend_mode == vector_backend::carray
+			|| (config.vector_backend_mode == vector_backend::soa && is_vector_soa(types, config, t) == false));
 }
 inline bool is_vector_hamt(const types_t& types, const config_t& config, type_t t){
 	QUARK_ASSERT(types.check_invariant());
@@ -793,6 +1304,13 @@ inline bool is_dict_hamt(const types_t& types, const config_t& config, type_t t)
 
 	return peek2(types, t).is_dict() && config.dict_backend_mode == dict_backend::hamt;
 }
+inline bool is_dict_hash(const types_t& types, const config_t& config, type_t t){
+	QUARK_ASSERT(types.check_invariant());
+	QUARK_ASSERT(config.check_invariant());
+	QUARK_ASSERT(t.check_invariant());
+
+	return peek2(types, t).is_dict() && config.dict_backend_mode == dict_backend::hash;
+}
 
 
 
@@ -814,7 +1332,14 @@ inline int32_t dec_rc(const heap_alloc_64_t& alloc){
 	QUARK_ASSERT(alloc.check_invariant());
 
 #if ATOMIC_RC
-	const auto prev_rc = std::atomic_fetch_sub_explicit(&alloc.rc, 1, std::memory_order_relaxed);
+	int32_t prev_rc;
+	if(alloc.shared){
+		prev_rc = std::atomic_fetch_sub_explicit(&alloc.rc, 1, std::memory_order_relaxed);
+	}
+	else{
+		prev_rc = alloc.rc.load(std::memory_order_relaxed);
+		alloc.rc.store(prev_rc - 1, std::memory_order_relaxed);
+	}
 #else
 	const auto prev_rc = alloc.rc;
 	alloc.rc--;
@@ -833,7 +1358,14 @@ inline int32_t inc_rc(const heap_alloc_64_t& alloc){
 	QUARK_ASSERT(alloc.check_invariant());
 
 #if ATOMIC_RC
-	const auto prev_rc = std::atomic_fetch_add_explicit(&alloc.rc, 1, std::memory_order_relaxed);
+	int32_t prev_rc;
+	if(alloc.shared){
+		prev_rc = std::atomic_fetch_add_explicit(&alloc.rc, 1, std::memory_order_relaxed);
+	}
+	else{
+		prev_rc = alloc.rc.load(std::memory_order_relaxed);
+		alloc.rc.store(prev_rc + 1, std::memory_order_relaxed);
+	}
 #else
 	const auto prev_rc = alloc.rc;
 	alloc.rc++;
@@ -842,6 +1374,23 @@ inline int32_t inc_rc(const heap_alloc_64_t& alloc){
 	return rc2;
 }
 
+//	True if the caller holds the only reference. Then nobody else can see the value and it can be mutated in place.
+//	Shared allocs are never unique: their children are shared too and mutating in place would make a local
+//	parent point to them.
+inline bool is_rc_unique(const heap_alloc_64_t& alloc){
+	QUARK_ASSERT(alloc.check_invariant());
+
+	if(alloc.shared){
+		return false;
+	}
+
+#if ATOMIC_RC
+	return alloc.rc.load(std::memory_order_acquire) == 1;
+#else
+	return alloc.rc == 1;
+#endif
+}
+
 
 
 inline void retain_vector_hamt(value_backend_t& backend, runtime_value_t vec, type_t type){
@@ -862,6 +1411,7 @@ inline void release_vector_hamt_pod(value_backend_t& backend, runtime_value_t ve
 	QUARK_ASSERT(is_rc_value(peek2(backend.types, lookup_vector_element_type(backend, type))) == false);
 
 	if(dec_rc(vec.vector_hamt_ptr->alloc) == 0){
+		hamt_element_scope_t scope(backend, type);
 		dispose_vector_hamt(vec);
 	}
 }
@@ -874,7 +1424,8 @@ inline void release_vector_hamt_nonpod(value_backend_t& backend, runtime_value_t
 	QUARK_ASSERT(is_rc_value(peek2(backend.types, lookup_vector_element_type(backend, type))) == true);
 
 	if(dec_rc(vec.vector_hamt_ptr->alloc) == 0){
-		release_vector_hamt_elements_internal(backend, vec, type);
+		//	The immer nodes release the elements they own.
+		hamt_element_scope_t scope(backend, type);
 		dispose_vector_hamt(vec);
 	}
 }
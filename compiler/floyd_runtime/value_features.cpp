@@ -48,10 +48,10 @@ int compare_values(value_backend_t& backend, int64_t op, const runtime_type_t ty
 
 	const auto& value_type = lookup_type_ref(backend, type);
 
-	const auto left_value = from_runtime_value2(backend, lhs, value_type);
-	const auto right_value = from_runtime_value2(backend, rhs, value_type);
-
-	const int result = value_t::compare_value_true_deep(left_value, right_value);
+	//	Strings: compare the characters where they are, inline or on the heap. Only the sign of result is used.
+	const int result = peek2(backend.types, value_type).is_string()
+		? get_string_view(lhs).compare(get_string_view(rhs))
+		: value_t::compare_value_true_deep(from_runtime_value2(backend, lhs, value_type), from_runtime_value2(backend, rhs, value_type));
 //	int result = runtime_compare_value_true_deep((const uint64_t)lhs, (const uint64_t)rhs, vector_type);
 	const auto op2 = static_cast<expression_type>(op);
 	if(op2 == expression_type::k_comparison_smaller_or_equal){
@@ -91,34 +91,66 @@ const runtime_value_t update__vector_carray(value_backend_t& backend, runtime_va
 	const auto vec = unpack_vector_carray_arg(backend, coll_value, coll_type);
 	const auto index2 = index.int_value;
 	const auto element_itype = lookup_vector_element_type(backend, type_t(coll_type));
+	const auto is_rc = is_rc_value(peek2(backend.types, element_itype));
 
 	if(index2 < 0 || index2 >= vec->get_element_count()){
 		quark::throw_runtime_error("Position argument to update() is outside collection span.");
 	}
 
-	auto result = alloc_vector_carray(backend.heap, vec->get_element_count(), vec->get_element_count(), type_t(coll_type));
-	auto dest_ptr = result.vector_carray_ptr->get_element_ptr();
-	auto source_ptr = vec->get_element_ptr();
-	if(is_rc_value(peek2(backend.types, element_itype))){
+	if(is_rc){
 		retain_value(backend, value, element_itype);
-		for(int i = 0 ; i < result.vector_carray_ptr->get_element_count() ; i++){
-			retain_value(backend, source_ptr[i], element_itype);
-			dest_ptr[i] = source_ptr[i];
-		}
+	}
 
-		if(is_rc_value(peek2(backend.types, type_t(coll_type)))){
-			release_value(backend, dest_ptr[index2], type_t(coll_type));
+	//	Nobody else can see the vector: reuse it as the result.
+	if(is_rc_unique(vec->alloc)){
+		if(is_rc){
+			release_value(backend, vec->load_element(index2), element_itype);
 		}
-		dest_ptr[index2] = value;
+		vec->store(index2, value);
+		return coll_value;
 	}
 	else{
+		auto result = alloc_vector_carray(backend.heap, vec->get_element_count(), vec->get_element_count(), type_t(coll_type));
+		auto dest_ptr = result.vector_carray_ptr->get_element_ptr();
+		auto source_ptr = vec->get_element_ptr();
 		for(int i = 0 ; i < result.vector_carray_ptr->get_element_count() ; i++){
 			dest_ptr[i] = source_ptr[i];
+			if(is_rc && i != index2){
+				retain_value(backend, source_ptr[i], element_itype);
+			}
 		}
 		dest_ptr[index2] = value;
+
+		release_vec(backend, coll_value, type_t(coll_type));
+		return result;
 	}
+}
 
-	return result;
+//	value is a STRUCT_T: its members are copied into the row, its RC is not touched.
+const runtime_value_t update__vector_soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(coll_type)));
+
+	const auto& vec = *coll_value.vector_soa_ptr;
+	const auto index2 = index.int_value;
+	if(index2 < 0 || index2 >= vec.get_element_count()){
+		quark::throw_runtime_error("Position argument to update() is outside collection span.");
+	}
+
+	//	Nobody else can see the vector: reuse it as the result.
+	if(is_rc_unique(vec.alloc)){
+		store_vector_soa_element(backend, coll_value, type_t(coll_type), index2, value);
+		return coll_value;
+	}
+	else{
+		const auto count = vec.get_element_count();
+		auto result = alloc_vector_soa(backend.heap, count, count, vec.get_member_count(), type_t(coll_type));
+		copy_vector_soa_rows(*result.vector_soa_ptr, 0, vec, 0, count);
+		store_vector_soa_element(backend, result, type_t(coll_type), index2, value);
+
+		release_vec(backend, coll_value, type_t(coll_type));
+		return result;
+	}
 }
 
 
@@ -128,25 +160,47 @@ const runtime_value_t update__dict_cppmap(value_backend_t& backend, runtime_valu
 	//??? move to compile time
 	const auto& type0 = lookup_type_ref(backend, coll_type);
 
-	const auto key = from_runtime_string2(backend, key_value);
+	const auto key = make_string_key(key_value);
 	const auto dict = unpack_dict_cppmap_arg(backend, coll_value, coll_type);
 
 	//??? compile time
 	const auto value_itype = peek2(backend.types, type0).get_dict_value_type(backend.types);
+	const auto is_rc = is_rc_value(peek2(backend.types, value_itype));
 
-	//	Deep copy dict.
-	auto dict2 = alloc_dict_cppmap(backend.heap, type_t(coll_type));
-	dict2.dict_cppmap_ptr->get_map_mut() = dict->get_map();
+	//	Nobody else can see the dict: reuse it as the result. Only a new key needs a std::string.
+	if(is_rc_unique(dict->alloc)){
+		auto& m = dict->get_map_mut();
+		if(is_rc){
+			retain_value(backend, value, value_itype);
+		}
+		const auto it = m.find(key.chars);
+		if(it != m.end()){
+			if(is_rc){
+				release_value(backend, it->second, value_itype);
+			}
+			it->second = value;
+		}
+		else{
+			m.emplace(std::string(key.chars), value);
+		}
+		return coll_value;
+	}
+	else{
+		//	Deep copy dict.
+		auto dict2 = alloc_dict_cppmap(backend.heap, type_t(coll_type));
+		dict2.dict_cppmap_ptr->get_map_mut() = dict->get_map();
 
-	dict2.dict_cppmap_ptr->get_map_mut().insert_or_assign(key, value);
+		dict2.dict_cppmap_ptr->get_map_mut().insert_or_assign(std::string(key.chars), value);
 
-	if(is_rc_value(peek2(backend.types, value_itype))){
-		for(const auto& e: dict2.dict_cppmap_ptr->get_map()){
-			retain_value(backend, e.second, value_itype);
+		if(is_rc){
+			for(const auto& e: dict2.dict_cppmap_ptr->get_map()){
+				retain_value(backend, e.second, value_itype);
+			}
 		}
-	}
 
-	return dict2;
+		release_dict_cppmap(backend, coll_value, type0);
+		return dict2;
+	}
 }
 
 const runtime_value_t update__dict_hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_value_t value){
@@ -155,25 +209,447 @@ const runtime_value_t update__dict_hamt(value_backend_t& backend, runtime_value_
 	//??? move to compile time
 	const auto& type0 = lookup_type_ref(backend, coll_type);
 
-	const auto key = from_runtime_string2(backend, key_value);
+	const auto key = make_string_key(key_value);
 	const auto dict = coll_value.dict_hamt_ptr;
 
 	//??? compile time
 	const auto value_itype = peek2(backend.types, type0).get_dict_value_type(backend.types);
+	const auto is_rc = is_rc_value(peek2(backend.types, value_itype));
+
+	//	Nobody else can see the dict: reuse it as the result. The HAMT only copies the path to the key.
+	if(is_rc_unique(dict->alloc)){
+		auto& m = dict->get_map_mut();
+		if(is_rc){
+			retain_value(backend, value, value_itype);
+			const auto existing = m.find(key);
+			if(existing != nullptr){
+				release_value(backend, *existing, value_itype);
+			}
+		}
+
+		//	The HAMT stores keys by value: set() always needs a std::string.
+		m = m.set(std::string(key.chars), value);
+		return coll_value;
+	}
+	else{
+		//	Deep copy dict.
+		auto dict2 = alloc_dict_hamt(backend.heap, type_t(coll_type));
+		dict2.dict_hamt_ptr->get_map_mut() = dict->get_map();
+
+		dict2.dict_hamt_ptr->get_map_mut() = dict2.dict_hamt_ptr->get_map_mut().set(std::string(key.chars), value);
+
+		if(is_rc){
+			for(const auto& e: dict2.dict_hamt_ptr->get_map()){
+				retain_value(backend, e.second, value_itype);
+			}
+		}
+
+		release_dict_hamt(backend, coll_value, type0);
+		return dict2;
+	}
+}
+
+const runtime_value_t update__dict_hash(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_value_t value){
+	QUARK_ASSERT(backend.check_invariant());
+
+	const auto& type0 = lookup_type_ref(backend, coll_type);
+
+	const auto key = make_string_key(key_value);
+	auto& dict = *coll_value.dict_hash_ptr;
+	QUARK_ASSERT(dict.check_invariant());
+
+	const auto value_itype = peek2(backend.types, type0).get_dict_value_type(backend.types);
+	const auto is_rc = is_rc_value(peek2(backend.types, value_itype));
+
+	//	Nobody else can see the dict: reuse it as the result.
+	if(is_rc_unique(dict.alloc)){
+		auto& m = dict.get_map_mut();
+		if(is_rc){
+			retain_value(backend, value, value_itype);
+			const auto existing = m.find(key.chars, key.hash);
+			if(existing != nullptr){
+				release_value(backend, *existing, value_itype);
+			}
+		}
+		m.insert_or_assign(key.chars, key.hash, value);
+		return coll_value;
+	}
+	else{
+		//	Deep copy dict.
+		auto dict2 = alloc_dict_hash(backend.heap, type_t(coll_type));
+		auto& m = dict2.dict_hash_ptr->get_map_mut();
+		m = dict.get_map();
+		m.insert_or_assign(key.chars, key.hash, value);
+
+		if(is_rc){
+			for(const auto& e: m){
+				retain_value(backend, e.second, value_itype);
+			}
+		}
+
+		release_dict_hash(backend, coll_value, type0);
+		return dict2;
+	}
+}
+
+static config_t make_hash_dict_config(){
+	auto config = make_default_config();
+	config.dict_backend_mode = dict_backend::hash;
+	return config;
+}
+
+QUARK_TEST("", "update__dict_hash()", "only reference", "updates the dict in place"){
+	types_t types;
+	const auto dict_type = make_dict(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_hash_dict_config());
+
+	const auto dict = alloc_dict_hash(backend.heap, dict_type);
+	const auto result = update__dict_hash(backend, dict, dict_type.get_data(), to_runtime_string2(backend, "a"), to_runtime_string2(backend, "one"));
+
+	QUARK_VERIFY(result.dict_hash_ptr == dict.dict_hash_ptr);
+	QUARK_VERIFY(result.dict_hash_ptr->size() == 1);
+	QUARK_VERIFY(from_runtime_string2(backend, *result.dict_hash_ptr->get_map().find("a")) == "one");
+	release_dict_hash(backend, result, dict_type);
+}
+
+QUARK_TEST("", "update__dict_hash()", "shared dict", "copies, original is unchanged"){
+	types_t types;
+	const auto dict_type = make_dict(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_hash_dict_config());
+
+	const auto dict = alloc_dict_hash(backend.heap, dict_type);
+	dict.dict_hash_ptr->get_map_mut().insert_or_assign("a", to_runtime_string2(backend, "one"));
+	inc_rc(dict.dict_hash_ptr->alloc);
+
+	const auto result = update__dict_hash(backend, dict, dict_type.get_data(), to_runtime_string2(backend, "a"), to_runtime_string2(backend, "two"));
+
+	QUARK_VERIFY(result.dict_hash_ptr != dict.dict_hash_ptr);
+	QUARK_VERIFY(is_rc_unique(dict.dict_hash_ptr->alloc));
+	QUARK_VERIFY(from_runtime_string2(backend, *dict.dict_hash_ptr->get_map().find("a")) == "one");
+	QUARK_VERIFY(from_runtime_string2(backend, *result.dict_hash_ptr->get_map().find("a")) == "two");
+	release_dict_hash(backend, result, dict_type);
+	release_dict_hash(backend, dict, dict_type);
+}
+
+static config_t make_carray_vector_config(){
+	auto config = make_default_config();
+	config.vector_backend_mode = vector_backend::carray;
+	return config;
+}
+
+QUARK_TEST("", "update__vector_carray()", "only reference", "updates the vector in place"){
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_carray_vector_config());
+
+	const auto vec = alloc_vector_carray(backend.heap, 2, 2, vec_type);
+	vec.vector_carray_ptr->store(0, to_runtime_string2(backend, "one"));
+	vec.vector_carray_ptr->store(1, to_runtime_string2(backend, "two"));
+
+	const auto s = to_runtime_string2(backend, "three");
+	const auto result = update__vector_carray(backend, vec, vec_type.get_data(), make_runtime_int(1), s);
+
+	QUARK_VERIFY(result.vector_carray_ptr == vec.vector_carray_ptr);
+	QUARK_VERIFY(from_runtime_string2(backend, result.vector_carray_ptr->load_element(1)) == "three");
+	release_value(backend, s, type_t::make_string());
+	release_vec(backend, result, vec_type);
+}
+
+QUARK_TEST("", "update__vector_carray()", "shared vector", "copies, original is unchanged"){
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_carray_vector_config());
+
+	const auto vec = alloc_vector_carray(backend.heap, 2, 2, vec_type);
+	vec.vector_carray_ptr->store(0, to_runtime_string2(backend, "first element"));
+	vec.vector_carray_ptr->store(1, to_runtime_string2(backend, "two"));
+	inc_rc(vec.vector_carray_ptr->alloc);
 
-	//	Deep copy dict.
-	auto dict2 = alloc_dict_hamt(backend.heap, type_t(coll_type));
-	dict2.dict_hamt_ptr->get_map_mut() = dict->get_map();
+	const auto s = to_runtime_string2(backend, "three");
+	const auto result = update__vector_carray(backend, vec, vec_type.get_data(), make_runtime_int(1), s);
+
+	QUARK_VERIFY(result.vector_carray_ptr != vec.vector_carray_ptr);
+	QUARK_VERIFY(is_rc_unique(vec.vector_carray_ptr->alloc));
+	QUARK_VERIFY(from_runtime_string2(backend, vec.vector_carray_ptr->load_element(1)) == "two");
+	QUARK_VERIFY(from_runtime_string2(backend, result.vector_carray_ptr->load_element(0)) == "first element");
+	QUARK_VERIFY(from_runtime_string2(backend, result.vector_carray_ptr->load_element(1)) == "three");
+
+	//	"first element" is shared by both vectors.
+	QUARK_VERIFY(result.vector_carray_ptr->load_element(0).vector_carray_ptr->alloc.rc == 2);
+
+	release_value(backend, s, type_t::make_string());
+	release_vec(backend, result, vec_type);
+	release_vec(backend, vec, vec_type);
+	QUARK_VERIFY(backend.heap.check_invariant());
+}
+
+//	[{int x; int y;}] with a hand-made layout, test backends have no struct layouts.
+struct soa_test_t {
+	soa_test_t() :
+		types(),
+		element_type(make_struct(types, struct_type_desc_t({ member_t(type_t::make_int(), "x"), member_t(type_t::make_int(), "y") }))),
+		vec_type(make_vector(types, element_type)),
+		backend(
+			{},
+			{ { element_type, struct_layout_t{ { member_info_t{ 0, type_t::make_int() }, member_info_t{ 8, type_t::make_int() } }, 16 } } },
+			types,
+			make_soa_vector_config()
+		)
+	{
+	}
+
+	static config_t make_soa_vector_config(){
+		auto config = make_default_config();
+		config.vector_backend_mode = vector_backend::soa;
+		return config;
+	}
 
-	dict2.dict_hamt_ptr->get_map_mut() = dict2.dict_hamt_ptr->get_map_mut().set(key, value);
+	runtime_value_t make_element(int64_t x, int64_t y){
+		auto s = alloc_struct(backend.heap, 16, element_type);
+		store_via_ptr2(backend.types, s->get_data_ptr() + 0, type_t::make_int(), make_runtime_int(x));
+		store_via_ptr2(backend.types, s->get_data_ptr() + 8, type_t::make_int(), make_runtime_int(y));
+		return make_runtime_struct(s);
+	}
 
-	if(is_rc_value(peek2(backend.types, value_itype))){
-		for(const auto& e: dict2.dict_hamt_ptr->get_map()){
-			retain_value(backend, e.second, value_itype);
+	runtime_value_t make_vec(const std::vector<std::pair<int64_t, int64_t>>& elements){
+		auto result = alloc_vector_soa(backend.heap, elements.size(), elements.size(), 2, vec_type);
+		for(int i = 0 ; i < elements.size() ; i++){
+			result.vector_soa_ptr->get_column_ptr(0)[i] = make_runtime_int(elements[i].first);
+			result.vector_soa_ptr->get_column_ptr(1)[i] = make_runtime_int(elements[i].second);
 		}
+		return result;
+	}
+
+	types_t types;
+	type_t element_type;
+	type_t vec_type;
+	value_backend_t backend;
+};
+
+QUARK_TEST("", "update__vector_soa()", "only reference", "updates the row in place"){
+	soa_test_t t;
+	const auto vec = t.make_vec({ { 1, 2 }, { 3, 4 } });
+	const auto e = t.make_element(30, 40);
+	const auto result = update__vector_soa(t.backend, vec, t.vec_type.get_data(), make_runtime_int(1), e);
+
+	QUARK_VERIFY(result.vector_soa_ptr == vec.vector_soa_ptr);
+	QUARK_VERIFY(result.vector_soa_ptr->get_column_ptr(0)[1].int_value == 30);
+	QUARK_VERIFY(result.vector_soa_ptr->get_column_ptr(1)[1].int_value == 40);
+	release_value(t.backend, e, t.element_type);
+	release_vec(t.backend, result, t.vec_type);
+	detect_leaks(t.backend.heap);
+}
+
+QUARK_TEST("", "update__vector_soa()", "shared vector", "copies, original is unchanged"){
+	soa_test_t t;
+	const auto vec = t.make_vec({ { 1, 2 }, { 3, 4 } });
+	inc_rc(vec.vector_soa_ptr->alloc);
+	const auto e = t.make_element(30, 40);
+	const auto result = update__vector_soa(t.backend, vec, t.vec_type.get_data(), make_runtime_int(0), e);
+
+	QUARK_VERIFY(result.vector_soa_ptr != vec.vector_soa_ptr);
+	QUARK_VERIFY(is_rc_unique(vec.vector_soa_ptr->alloc));
+	QUARK_VERIFY(vec.vector_soa_ptr->get_column_ptr(0)[0].int_value == 1);
+	QUARK_VERIFY(result.vector_soa_ptr->get_column_ptr(0)[0].int_value == 30);
+	QUARK_VERIFY(result.vector_soa_ptr->get_column_ptr(1)[1].int_value == 4);
+	release_value(t.backend, e, t.element_type);
+	release_vec(t.backend, result, t.vec_type);
+	release_vec(t.backend, vec, t.vec_type);
+	detect_leaks(t.backend.heap);
+}
+
+QUARK_TEST("", "find__soa()", "", "compares all members"){
+	soa_test_t t;
+	const auto vec = t.make_vec({ { 1, 2 }, { 1, 4 }, { 3, 4 } });
+	const auto e = t.make_element(1, 4);
+	const auto missing = t.make_element(3, 2);
+
+	QUARK_VERIFY(find__soa(t.backend, vec, t.vec_type.get_data(), e, t.element_type.get_data()) == 1);
+	QUARK_VERIFY(find__soa(t.backend, vec, t.vec_type.get_data(), missing, t.element_type.get_data()) == -1);
+	release_value(t.backend, e, t.element_type);
+	release_value(t.backend, missing, t.element_type);
+	release_vec(t.backend, vec, t.vec_type);
+	detect_leaks(t.backend.heap);
+}
+
+QUARK_TEST("", "subset__soa(), replace__soa(), concat_vector_soa()", "", "rows copied in all columns"){
+	soa_test_t t;
+	const auto a = t.make_vec({ { 1, 2 }, { 3, 4 }, { 5, 6 } });
+	const auto b = t.make_vec({ { 7, 8 } });
+
+	const auto sub = subset__soa(t.backend, a, t.vec_type.get_data(), 1, 3);
+	QUARK_VERIFY(sub.vector_soa_ptr->get_element_count() == 2);
+	QUARK_VERIFY(sub.vector_soa_ptr->get_column_ptr(1)[0].int_value == 4);
+
+	const auto rep = replace__soa(t.backend, a, t.vec_type.get_data(), 0, 2, b, t.vec_type.get_data());
+	QUARK_VERIFY(rep.vector_soa_ptr->get_element_count() == 2);
+	QUARK_VERIFY(rep.vector_soa_ptr->get_column_ptr(0)[0].int_value == 7);
+	QUARK_VERIFY(rep.vector_soa_ptr->get_column_ptr(1)[1].int_value == 6);
+
+	const auto cat = concat_vector_soa(t.backend, t.vec_type, a, b);
+	QUARK_VERIFY(cat.vector_soa_ptr->get_element_count() == 4);
+	QUARK_VERIFY(cat.vector_soa_ptr->get_column_ptr(0)[3].int_value == 7);
+	QUARK_VERIFY(cat.vector_soa_ptr->get_column_ptr(1)[2].int_value == 6);
+
+	for(const auto& e: { a, b, sub, rep, cat }){
+		release_vec(t.backend, e, t.vec_type);
+	}
+	detect_leaks(t.backend.heap);
+}
+
+QUARK_TEST("", "update__string()", "only reference", "updates the string in place"){
+	auto backend = make_test_value_backend();
+
+	const auto s = to_runtime_string2(backend, "hello, world");
+	const auto result = update__string(backend, s, make_runtime_int(7), make_runtime_int('W'));
+	QUARK_VERIFY(result.vector_carray_ptr == s.vector_carray_ptr);
+	QUARK_VERIFY(from_runtime_string2(backend, result) == "hello, World");
+	release_value(backend, result, type_t::make_string());
+}
+
+QUARK_TEST("", "update__string()", "inline string", "new inline string"){
+	auto backend = make_test_value_backend();
+
+	const auto s = to_runtime_string2(backend, "hello");
+	const auto result = update__string(backend, s, make_runtime_int(0), make_runtime_int('j'));
+	QUARK_VERIFY(is_inline_string(result));
+	QUARK_VERIFY(from_runtime_string2(backend, s) == "hello");
+	QUARK_VERIFY(from_runtime_string2(backend, result) == "jello");
+}
+
+QUARK_TEST("", "concat_strings()", "", "inline when it fits"){
+	auto backend = make_test_value_backend();
+
+	const auto a = to_runtime_string2(backend, "abc");
+	const auto b = to_runtime_string2(backend, "defg");
+	const auto ab = concat_strings(backend, a, b);
+	QUARK_VERIFY(is_inline_string(ab));
+	QUARK_VERIFY(from_runtime_string2(backend, ab) == "abcdefg");
+
+	const auto abb = concat_strings(backend, ab, b);
+	QUARK_VERIFY(is_inline_string(abb) == false);
+	QUARK_VERIFY(from_runtime_string2(backend, abb) == "abcdefgdefg");
+	release_value(backend, abb, type_t::make_string());
+}
+
+QUARK_TEST("", "subset__string()", "", "inline and heap results"){
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+
+	const auto s = to_runtime_string2(backend, "hello, world!");
+	const auto a = subset__string(backend, s, itype, 7, 100);
+	QUARK_VERIFY(is_inline_string(a));
+	QUARK_VERIFY(from_runtime_string2(backend, a) == "world!");
+
+	const auto b = subset__string(backend, s, itype, 1, 11);
+	QUARK_VERIFY(from_runtime_string2(backend, b) == "ello, worl");
+	QUARK_VERIFY(from_runtime_string2(backend, subset__string(backend, a, itype, 5, 3)) == "");
+
+	release_value(backend, b, type_t::make_string());
+	release_value(backend, s, type_t::make_string());
+}
+
+QUARK_TEST("", "replace__string()", "", "pieces of both strings"){
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+
+	const auto s = to_runtime_string2(backend, "hello, world!");
+	const auto r = to_runtime_string2(backend, "there");
+	const auto a = replace__string(backend, s, itype, 7, 12, r, itype);
+	QUARK_VERIFY(from_runtime_string2(backend, a) == "hello, there!");
+
+	const auto b = replace__string(backend, r, itype, 0, 100, to_runtime_string2(backend, "x"), itype);
+	QUARK_VERIFY(is_inline_string(b));
+	QUARK_VERIFY(from_runtime_string2(backend, b) == "x");
+
+	release_value(backend, a, type_t::make_string());
+	release_value(backend, s, type_t::make_string());
+}
+
+QUARK_TEST("", "find__string()", "", "position or -1"){
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+
+	const auto s = to_runtime_string2(backend, "the quick brown fox jumps over the lazy dog");
+	QUARK_VERIFY(find__string(backend, s, itype, to_runtime_string2(backend, "fox"), itype) == 16);
+	const auto wanted = to_runtime_string2(backend, "the lazy");
+	QUARK_VERIFY(find__string(backend, s, itype, wanted, itype) == 31);
+	release_value(backend, wanted, type_t::make_string());
+	QUARK_VERIFY(find__string(backend, s, itype, to_runtime_string2(backend, "cat"), itype) == -1);
+	QUARK_VERIFY(find__string(backend, to_runtime_string2(backend, "abc"), itype, to_runtime_string2(backend, "c"), itype) == 2);
+	release_value(backend, s, type_t::make_string());
+}
+
+QUARK_TEST("", "compare_values()", "inline and heap strings", "compares the characters"){
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+	const auto smaller = static_cast<int64_t>(expression_type::k_comparison_smaller);
+	const auto equal = static_cast<int64_t>(expression_type::k_logical_equal);
+
+	const auto a = to_runtime_string2(backend, "abc");
+	const auto b = to_runtime_string2(backend, "abcdefghij");
+	const auto c = to_runtime_string2(backend, "abd");
+	QUARK_VERIFY(compare_values(backend, smaller, itype, a, b) == 1);
+	QUARK_VERIFY(compare_values(backend, smaller, itype, b, c) == 1);
+	QUARK_VERIFY(compare_values(backend, smaller, itype, c, a) == 0);
+	QUARK_VERIFY(compare_values(backend, equal, itype, a, to_runtime_string2(backend, "abc")) == 1);
+	QUARK_VERIFY(compare_values(backend, equal, itype, a, c) == 0);
+	release_value(backend, b, type_t::make_string());
+}
+
+QUARK_TEST("VECTOR_HAMT_T", "push_back_immutable()", "1000 strings", "only the copied nodes retain the elements"){
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_default_config());
+	std::vector<runtime_value_t> elements;
+	for(int i = 0 ; i < 1000 ; i++){
+		elements.push_back(to_runtime_string2(backend, "element " + std::to_string(i)));
 	}
+	auto a = alloc_vector_hamt(backend.heap, elements.data(), elements.size(), vec_type);
 
-	return dict2;
+	const auto s = to_runtime_string2(backend, "new");
+	runtime_value_t b;
+	{
+		hamt_element_scope_t scope(backend, vec_type);
+		b = push_back_immutable(a, s);
+	}
+
+	//	Element 0 lives in a node that a and b share, it isn't retained again.
+	QUARK_VERIFY(b.vector_hamt_ptr->get_element_count() == 1001);
+	QUARK_VERIFY(b.vector_hamt_ptr->load_element(0).vector_carray_ptr->alloc.rc == 1);
+	QUARK_VERIFY(from_runtime_string2(backend, b.vector_hamt_ptr->load_element(1000)) == "new");
+
+	release_vec(backend, a, vec_type);
+	QUARK_VERIFY(from_runtime_string2(backend, b.vector_hamt_ptr->load_element(0)) == "element 0");
+	QUARK_VERIFY(from_runtime_string2(backend, b.vector_hamt_ptr->load_element(999)) == "element 999");
+	release_vec(backend, b, vec_type);
+
+	QUARK_VERIFY(backend.check_invariant());
+}
+
+QUARK_TEST("", "update__vector_hamt_nonpod()", "shared vector", "copies, only the replaced element changes RC"){
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_default_config());
+	const runtime_value_t elements[] = { to_runtime_string2(backend, "first element"), to_runtime_string2(backend, "two") };
+	const auto vec = alloc_vector_hamt(backend.heap, elements, 2, vec_type);
+	inc_rc(vec.vector_hamt_ptr->alloc);
+
+	const auto s = to_runtime_string2(backend, "three");
+	const auto result = update__vector_hamt_nonpod(backend, vec, vec_type.get_data(), make_runtime_int(1), s);
+
+	QUARK_VERIFY(result.vector_hamt_ptr != vec.vector_hamt_ptr);
+	QUARK_VERIFY(is_rc_unique(vec.vector_hamt_ptr->alloc));
+	QUARK_VERIFY(from_runtime_string2(backend, vec.vector_hamt_ptr->load_element(1)) == "two");
+	QUARK_VERIFY(from_runtime_string2(backend, result.vector_hamt_ptr->load_element(1)) == "three");
+
+	//	"first element" is in the copied leaf so both nodes hold it.
+	QUARK_VERIFY(result.vector_hamt_ptr->load_element(0).vector_carray_ptr->alloc.rc == 2);
+
+	release_value(backend, s, type_t::make_string());
+	release_vec(backend, result, vec_type);
+	release_vec(backend, vec, vec_type);
+	QUARK_VERIFY(backend.heap.check_invariant());
 }
 
 
@@ -188,15 +664,12 @@ const runtime_value_t subset__string(value_backend_t& backend, runtime_value_t c
 		quark::throw_runtime_error("subset() requires start and end to be non-negative.");
 	}
 
-	const auto value = from_runtime_string2(backend, coll_value);
-	const auto len = get_vec_string_size(coll_value);
-	const auto end2 = std::min(end, len);
+	const auto value = get_string_view(coll_value);
+	const auto end2 = std::min<uint64_t>(end, value.size());
 	const auto start2 = std::min(start, end2);
 	const auto len2 = end2 - start2;
 
-	const auto s = std::string(&value[start2], &value[start2 + len2]);
-	const auto result = to_runtime_string2(backend, s);
-	return result;
+	return alloc_string_from_pieces(backend, { value.substr(start2, len2) });
 }
 
 const runtime_value_t subset__carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end){
@@ -234,14 +707,15 @@ const runtime_value_t subset__carray(value_backend_t& backend, runtime_value_t c
 	return vec2;
 }
 
-const runtime_value_t subset__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end){
+const runtime_value_t subset__soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end){
 	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(coll_type)));
 
 	if(start < 0 || end < 0){
 		quark::throw_runtime_error("subset() requires start and end to be non-negative.");
 	}
 
-	const auto& vec = *coll_value.vector_hamt_ptr;
+	const auto& vec = *coll_value.vector_soa_ptr;
 	const auto end2 = std::min(end, vec.get_element_count());
 	const auto start2 = std::min(start, end2);
 	const auto len2 = end2 - start2;
@@ -249,22 +723,33 @@ const runtime_value_t subset__hamt(value_backend_t& backend, runtime_value_t col
 		throw std::exception();
 	}
 
-	const auto element_itype = lookup_vector_element_type(backend, type_t(coll_type));
+	auto vec2 = alloc_vector_soa(backend.heap, len2, len2, vec.get_member_count(), type_t(coll_type));
+	copy_vector_soa_rows(*vec2.vector_soa_ptr, 0, vec, start2, len2);
+	return vec2;
+}
 
-	auto vec2 = alloc_vector_hamt(backend.heap, len2, len2, type_t(coll_type));
-	if(is_rc_value(peek2(backend.types, element_itype))){
-		for(int i = 0 ; i < len2 ; i++){
-			const auto& value = vec.load_element(start2 + i);
-			vec2.vector_hamt_ptr->store_mutate(i, value);
-			retain_value(backend, value, element_itype);
-		}
+const runtime_value_t subset__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end){
+	QUARK_ASSERT(backend.check_invariant());
+
+	if(start < 0 || end < 0){
+		quark::throw_runtime_error("subset() requires start and end to be non-negative.");
 	}
-	else{
-		for(int i = 0 ; i < len2 ; i++){
-			const auto& value = vec.load_element(start2 + i);
-			vec2.vector_hamt_ptr->store_mutate(i, value);
-		}
+
+	const auto& vec = *coll_value.vector_hamt_ptr;
+	const auto end2 = std::min(end, vec.get_element_count());
+	const auto start2 = std::min(start, end2);
+	const auto len2 = end2 - start2;
+	if(len2 >= INT64_MAX){
+		throw std::exception();
+	}
+
+	//	Copying a hamt_element_t retains it.
+	hamt_element_scope_t scope(backend, type_t(coll_type));
+	auto temp = HAMT_VECTOR().transient();
+	for(uint64_t i = 0 ; i < len2 ; i++){
+		temp.push_back(vec.get_vecref()[start2 + i]);
 	}
+	const auto vec2 = alloc_vector_hamt(backend.heap, std::move(temp).persistent(), type_t(coll_type));
 	return vec2;
 }
 
@@ -297,24 +782,13 @@ const runtime_value_t replace__string(value_backend_t& backend, runtime_value_t
 
 	QUARK_ASSERT(type3 == type0);
 
-	const auto s = from_runtime_string2(backend, coll_value);
-	const auto replace = from_runtime_string2(backend, replacement_value);
-
-	auto s_len = s.size();
-	auto replace_len = replace.size();
-
-	auto end2 = std::min(end, s_len);
-	auto start2 = std::min(start, end2);
+	const auto s = get_string_view(coll_value);
+	const auto replace = get_string_view(replacement_value);
 
-	const std::size_t len2 = start2 + replace_len + (s_len - end2);
-	auto s2 = reinterpret_cast<char*>(std::malloc(len2 + 1));
-	std::memcpy(&s2[0], &s[0], start2);
-	std::memcpy(&s2[start2], &replace[0], replace_len);
-	std::memcpy(&s2[start2 + replace_len], &s[end2], s_len - end2);
+	const auto end2 = std::min(end, s.size());
+	const auto start2 = std::min(start, end2);
 
-	const std::string ret(s2, &s2[start2 + replace_len + (s_len - end2)]);
-	const auto result2 = to_runtime_string2(backend, ret);
-	return result2;
+	return alloc_string_from_pieces(backend, { s.substr(0, start2), replace, s.substr(end2) });
 }
 
 const runtime_value_t replace__carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type){
@@ -351,6 +825,31 @@ const runtime_value_t replace__carray(value_backend_t& backend, runtime_value_t
 
 	return vec2;
 }
+const runtime_value_t replace__soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(coll_type)));
+
+	check_replace_indexes(start, end);
+
+	QUARK_ASSERT(lookup_type_ref(backend, replacement_type) == lookup_type_ref(backend, coll_type));
+
+	const auto& vec = *coll_value.vector_soa_ptr;
+	const auto& replace_vec = *replacement_value.vector_soa_ptr;
+
+	auto end2 = std::min(end, (size_t)vec.get_element_count());
+	auto start2 = std::min(start, end2);
+
+	const auto section1_len = start2;
+	const auto section2_len = replace_vec.get_element_count();
+	const auto section3_len = vec.get_element_count() - end2;
+
+	const auto len2 = section1_len + section2_len + section3_len;
+	auto vec2 = alloc_vector_soa(backend.heap, len2, len2, vec.get_member_count(), type_t(coll_type));
+	copy_vector_soa_rows(*vec2.vector_soa_ptr, 0, vec, 0, section1_len);
+	copy_vector_soa_rows(*vec2.vector_soa_ptr, section1_len, replace_vec, 0, section2_len);
+	copy_vector_soa_rows(*vec2.vector_soa_ptr, section1_len + section2_len, vec, end2, section3_len);
+	return vec2;
+}
 const runtime_value_t replace__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type){
 	QUARK_ASSERT(backend.check_invariant());
 
@@ -359,8 +858,6 @@ const runtime_value_t replace__hamt(value_backend_t& backend, runtime_value_t co
 	const auto& type0 = lookup_type_ref(backend, coll_type);
 	QUARK_ASSERT(lookup_type_ref(backend, replacement_type) == type0);
 
-	const auto element_itype = lookup_vector_element_type(backend, type_t(coll_type));
-
 	const auto& vec = *coll_value.vector_hamt_ptr;
 	const auto& replace_vec = *replacement_value.vector_hamt_ptr;
 
@@ -371,27 +868,16 @@ const runtime_value_t replace__hamt(value_backend_t& backend, runtime_value_t co
 	const auto section2_len = replace_vec.get_element_count();
 	const auto section3_len = vec.get_element_count() - end2;
 
-	const auto len2 = section1_len + section2_len + section3_len;
-	auto vec2 = alloc_vector_hamt(backend.heap, len2, len2, type_t(coll_type));
-	for(size_t i = 0 ; i < section1_len ; i++){
-		const auto& value = vec.load_element(0 + i);
-		vec2.vector_hamt_ptr->store_mutate(0 + i, value);
-	}
+	//	Shares the nodes of the first section with coll_value. Copying a hamt_element_t retains it.
+	hamt_element_scope_t scope(backend, type_t(coll_type));
+	auto temp = vec.get_vecref().take(section1_len).transient();
 	for(size_t i = 0 ; i < section2_len ; i++){
-		const auto& value = replace_vec.load_element(0 + i);
-		vec2.vector_hamt_ptr->store_mutate(section1_len + i, value);
+		temp.push_back(replace_vec.get_vecref()[i]);
 	}
 	for(size_t i = 0 ; i < section3_len ; i++){
-		const auto& value = vec.load_element(end2 + i);
-		vec2.vector_hamt_ptr->store_mutate(section1_len + section2_len + i, value);
-	}
-
-	if(is_rc_value(peek2(backend.types, element_itype))){
-		for(int i = 0 ; i < len2 ; i++){
-			retain_value(backend, vec2.vector_hamt_ptr->load_element(i), element_itype);
-		}
+		temp.push_back(vec.get_vecref()[end2 + i]);
 	}
-
+	const auto vec2 = alloc_vector_hamt(backend.heap, std::move(temp).persistent(), type_t(coll_type));
 	return vec2;
 }
 
@@ -410,10 +896,9 @@ int64_t find__string(value_backend_t& backend, runtime_value_t coll_value, runti
 
 	QUARK_ASSERT(peek2(backend.types, type1).is_string());
 
-	const auto str = from_runtime_string2(backend, coll_value);
-	const auto wanted2 = from_runtime_string2(backend, value);
-	const auto pos = str.find(wanted2);
-	const auto result = pos == std::string::npos ? -1 : static_cast<int64_t>(pos);
+	//	string_view::find() scans with memchr() + memcmp(), which the C library picks SIMD versions of at load time.
+	const auto pos = get_string_view(coll_value).find(get_string_view(value));
+	const auto result = pos == std::string_view::npos ? -1 : static_cast<int64_t>(pos);
 	return result;
 }
 int64_t find__carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type){
@@ -442,6 +927,33 @@ int64_t find__carray(value_backend_t& backend, runtime_value_t coll_value, runti
 		return pos;
 	}
 }
+//	Compares column by column against the members of value, without making a STRUCT_T per element.
+int64_t find__soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(coll_type)));
+
+	const auto& vec = *coll_value.vector_soa_ptr;
+	const auto& layout = find_struct_layout(backend, type_t(value_type)).second;
+	QUARK_ASSERT(layout.members.size() == vec.get_member_count());
+
+	std::vector<runtime_value_t> wanted;
+	for(const auto& member: layout.members){
+		wanted.push_back(load_via_ptr2(backend.types, value.struct_ptr->get_data_ptr() + member.offset, member.type));
+	}
+
+	const auto count = vec.get_element_count();
+	for(int64_t index = 0 ; index < count ; index++){
+		bool equal = true;
+		for(uint64_t m = 0 ; m < wanted.size() && equal ; m++){
+			const auto member_itype = make_runtime_type(layout.members[m].type);
+			equal = compare_values(backend, static_cast<int64_t>(expression_type::k_logical_equal), member_itype, vec.get_column_ptr(m)[index], wanted[m]) == 1;
+		}
+		if(equal){
+			return index;
+		}
+	}
+	return -1;
+}
 int64_t find__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type){
 	QUARK_ASSERT(backend.check_invariant());
 
@@ -565,6 +1077,50 @@ runtime_value_t get_keys__hamtmap_hamt(value_backend_t& backend, runtime_value_t
 	}
 	return result_vec;
 }
+runtime_value_t get_keys__hashmap_carray(value_backend_t& backend, runtime_value_t dict_value, runtime_type_t dict_type){
+	QUARK_ASSERT(backend.check_invariant());
+
+	const auto& type0 = lookup_type_ref(backend, dict_type);
+
+	QUARK_ASSERT(peek2(backend.types, type0).is_dict());
+
+	const auto& m = dict_value.dict_hash_ptr->get_map();
+	const auto count = (uint64_t)m.size();
+
+	auto result_vec = alloc_vector_carray(backend.heap, count, count, make_vector(backend.types, type_t::make_string()));
+
+	int index = 0;
+	for(const auto& e: m){
+		//	Notice that the internal representation of dictionary keys are std::string, not floyd-strings,
+		//	so we need to create new key-strings from scratch.
+		const auto key = to_runtime_string2(backend, e.first);
+		result_vec.vector_carray_ptr->get_element_ptr()[index] = key;
+		index++;
+	}
+	return result_vec;
+}
+runtime_value_t get_keys__hashmap_hamt(value_backend_t& backend, runtime_value_t dict_value, runtime_type_t dict_type){
+	QUARK_ASSERT(backend.check_invariant());
+
+	const auto& type0 = lookup_type_ref(backend, dict_type);
+
+	QUARK_ASSERT(peek2(backend.types, type0).is_dict());
+
+	const auto& m = dict_value.dict_hash_ptr->get_map();
+	const auto count = (uint64_t)m.size();
+
+	auto result_vec = alloc_vector_hamt(backend.heap, count, count, make_vector(backend.types, type_t::make_string()));
+
+	int index = 0;
+	for(const auto& e: m){
+		//	Notice that the internal representation of dictionary keys are std::string, not floyd-strings,
+		//	so we need to create new key-strings from scratch.
+		const auto key = to_runtime_string2(backend, e.first);
+		result_vec.vector_hamt_ptr->store_mutate(index, key);
+		index++;
+	}
+	return result_vec;
+}
 
 
 
@@ -603,8 +1159,7 @@ runtime_value_t concat_strings(value_backend_t& backend, const runtime_value_t&
 	QUARK_ASSERT(lhs.check_invariant());
 	QUARK_ASSERT(rhs.check_invariant());
 
-	const auto result = from_runtime_string2(backend, lhs) + from_runtime_string2(backend, rhs);
-	return to_runtime_string2(backend, result);
+	return alloc_string_from_pieces(backend, { get_string_view(lhs), get_string_view(rhs) });
 }
 
 runtime_value_t concat_vector_carray(value_backend_t& backend, const type_t& type, const runtime_value_t& lhs, const runtime_value_t& rhs){
@@ -647,46 +1202,34 @@ runtime_value_t concat_vector_carray(value_backend_t& backend, const type_t& typ
 	return result;
 }
 
+runtime_value_t concat_vector_soa(value_backend_t& backend, const type_t& type, const runtime_value_t& lhs, const runtime_value_t& rhs){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type));
+
+	const auto& lhs_vec = *lhs.vector_soa_ptr;
+	const auto& rhs_vec = *rhs.vector_soa_ptr;
+	const auto lhs_count = lhs_vec.get_element_count();
+	const auto count2 = lhs_count + rhs_vec.get_element_count();
+
+	auto result = alloc_vector_soa(backend.heap, count2, count2, lhs_vec.get_member_count(), type);
+	copy_vector_soa_rows(*result.vector_soa_ptr, 0, lhs_vec, 0, lhs_count);
+	copy_vector_soa_rows(*result.vector_soa_ptr, lhs_count, rhs_vec, 0, rhs_vec.get_element_count());
+	return result;
+}
+
 runtime_value_t concat_vector_hamt(value_backend_t& backend, const type_t& type, const runtime_value_t& lhs, const runtime_value_t& rhs){
 	QUARK_ASSERT(backend.check_invariant());
 	QUARK_ASSERT(type.check_invariant());
 	QUARK_ASSERT(lhs.check_invariant());
 	QUARK_ASSERT(rhs.check_invariant());
 
-	const auto lhs_count = lhs.vector_hamt_ptr->get_element_count();
-	const auto rhs_count = rhs.vector_hamt_ptr->get_element_count();
-
-	const auto count2 = lhs_count + rhs_count;
-
-	auto result = alloc_vector_hamt(backend.heap, count2, count2, type);
-
-	//??? warning: assumes element = allocation.
-
-	const auto element_itype = lookup_vector_element_type(backend, type);
-
-	//??? Causes a full path copy for EACH ELEMENT = slow. better to make new hamt in one go.
-	if(is_rc_value(peek2(backend.types, element_itype))){
-		for(int i = 0 ; i < lhs_count ; i++){
-			auto value = lhs.vector_hamt_ptr->load_element(i);
-			retain_value(backend, value, element_itype);
-			result.vector_hamt_ptr->store_mutate(i, value);
-		}
-		for(int i = 0 ; i < rhs_count ; i++){
-			auto value = rhs.vector_hamt_ptr->load_element(i);
-			retain_value(backend, value, element_itype);
-			result.vector_hamt_ptr->store_mutate(lhs_count + i, value);
-		}
-	}
-	else{
-		for(int i = 0 ; i < lhs_count ; i++){
-			auto value = lhs.vector_hamt_ptr->load_element(i);
-			result.vector_hamt_ptr->store_mutate(i, value);
-		}
-		for(int i = 0 ; i < rhs_count ; i++){
-			auto value = rhs.vector_hamt_ptr->load_element(i);
-			result.vector_hamt_ptr->store_mutate(lhs_count + i, value);
-		}
+	//	Shares lhs's nodes, only appends rhs. Copying a hamt_element_t retains it.
+	hamt_element_scope_t scope(backend, type);
+	auto temp = lhs.vector_hamt_ptr->get_vecref().transient();
+	for(const auto& e: rhs.vector_hamt_ptr->get_vecref()){
+		temp.push_back(e);
 	}
+	const auto result = alloc_vector_hamt(backend.heap, std::move(temp).persistent(), type);
 	return result;
 }
 
@@ -27,20 +27,27 @@ int compare_values(value_backend_t& backend, int64_t op, const runtime_type_t ty
 
 
 
+//	The update__xxx() functions take over coll_value's reference. If that is the only reference they mutate the
+//	collection in place and return it, else they return a modified copy and release coll_value.
+//	The LLVM codegen moves the variable into update() for "a = update(a, ...)", so this is the common case.
+
 inline const runtime_value_t update__string(value_backend_t& backend, runtime_value_t s, runtime_value_t key_value, runtime_value_t value);
 
 const runtime_value_t update__vector_carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value);
+const runtime_value_t update__vector_soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value);
 inline const runtime_value_t update__vector_hamt_pod(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value, runtime_type_t value_type);
 inline const runtime_value_t update__vector_hamt_nonpod(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value, runtime_type_t value_type);
 
 const runtime_value_t update__dict_cppmap(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_value_t value);
 const runtime_value_t update__dict_hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_value_t value);
+const runtime_value_t update__dict_hash(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_value_t value);
 
 
 
 
 const runtime_value_t subset__string(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end);
 const runtime_value_t subset__carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end);
+const runtime_value_t subset__soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end);
 const runtime_value_t subset__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, uint64_t start, uint64_t end);
 
 
@@ -48,6 +55,7 @@ const runtime_value_t subset__hamt(value_backend_t& backend, runtime_value_t col
 
 const runtime_value_t replace__string(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type);
 const runtime_value_t replace__carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type);
+const runtime_value_t replace__soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type);
 const runtime_value_t replace__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, size_t start, size_t end, runtime_value_t replacement_value, runtime_type_t replacement_type);
 
 
@@ -56,6 +64,7 @@ const runtime_value_t replace__hamt(value_backend_t& backend, runtime_value_t co
 
 int64_t find__string(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type);
 int64_t find__carray(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type);
+int64_t find__soa(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type);
 int64_t find__hamt(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, const runtime_value_t value, runtime_type_t value_type);
 
 
@@ -66,6 +75,9 @@ runtime_value_t get_keys__cppmap_hamt(value_backend_t& backend, runtime_value_t
 runtime_value_t get_keys__hamtmap_carray(value_backend_t& backend, runtime_value_t dict_value, runtime_type_t dict_type);
 runtime_value_t get_keys__hamtmap_hamt(value_backend_t& backend, runtime_value_t dict_value, runtime_type_t dict_type);
 
+runtime_value_t get_keys__hashmap_carray(value_backend_t& backend, runtime_value_t dict_value, runtime_type_t dict_type);
+runtime_value_t get_keys__hashmap_hamt(value_backend_t& backend, runtime_value_t dict_value, runtime_type_t dict_type);
+
 
 //	Use subset of samples -- assume first sample is warm-up.
 int64_t analyse_samples(const int64_t* samples, int64_t count);
@@ -74,6 +86,7 @@ int64_t analyse_samples(const int64_t* samples, int64_t count);
 
 runtime_value_t concat_strings(value_backend_t& backend, const runtime_value_t& lhs, const runtime_value_t& rhs);
 runtime_value_t concat_vector_carray(value_backend_t& backend, const type_t& type, const runtime_value_t& lhs, const runtime_value_t& rhs);
+runtime_value_t concat_vector_soa(value_backend_t& backend, const type_t& type, const runtime_value_t& lhs, const runtime_value_t& rhs);
 runtime_value_t concat_vector_hamt(value_backend_t& backend, const type_t& type, const runtime_value_t& lhs, const runtime_value_t& rhs);
 
 
@@ -81,24 +94,36 @@ runtime_value_t concat_vector_hamt(value_backend_t& backend, const type_t& type,
 /////////////////////////////////////////		INLINES
 
 
-//??? optimize by copying alloc64_t directly, then overwrite 1 character.
 inline const runtime_value_t update__string(value_backend_t& backend, runtime_value_t s, runtime_value_t key_value, runtime_value_t value){
 	QUARK_ASSERT(backend.check_invariant());
 
-	const auto str = from_runtime_string2(backend, s);
 	const auto i = key_value.int_value;
 	const auto new_char = (char)value.int_value;
 
-	const auto len = str.size();
+	const auto len = get_vec_string_size(s);
 
 	if(i < 0 || i >= len){
 		quark::throw_runtime_error("Position argument to update() is outside collection span.");
 	}
 
-	auto result = str;
-	result[i] = new_char;
-	const auto result2 = to_runtime_string2(backend, result);
-	return result2;
+	if(is_inline_string(s)){
+		//	No alloc to share, change our copy.
+		auto result = s;
+		reinterpret_cast<char*>(&result)[1 + i] = new_char;
+		return result;
+	}
+	else if(is_rc_unique(s.vector_carray_ptr->alloc)){
+		store_string_char(s, i, new_char);
+		return s;
+	}
+	else{
+		//??? optimize by copying alloc64_t directly, then overwrite 1 character.
+		auto result = from_runtime_string2(backend, s);
+		result[i] = new_char;
+		const auto result2 = to_runtime_string2(backend, result);
+		release_vec(backend, s, type_t::make_string());
+		return result2;
+	}
 }
 
 inline const runtime_value_t update__vector_hamt_pod(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value){
@@ -109,8 +134,20 @@ inline const runtime_value_t update__vector_hamt_pod(value_backend_t& backend, r
 	if(i < 0 || i >= vec->get_element_count()){
 		quark::throw_runtime_error("Position argument to update() is outside collection span.");
 	}
-	return store_immutable(coll_value, i, value);
+
+	hamt_element_scope_t scope(backend, type_t(coll_type));
+	if(is_rc_unique(vec->alloc)){
+		auto& vecref = vec->get_vecref_mut();
+		vecref = std::move(vecref).set(i, hamt_element_t(value));
+		return coll_value;
+	}
+
+	const auto result = store_immutable(coll_value, i, value);
+	release_vec(backend, coll_value, type_t(coll_type));
+	return result;
 }
+
+//	Only retains value: the new vector shares all nodes with coll_value except the path to index.
 inline const runtime_value_t update__vector_hamt_nonpod(value_backend_t& backend, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t index, runtime_value_t value){
 	QUARK_ASSERT(backend.check_invariant());
 
@@ -120,15 +157,18 @@ inline const runtime_value_t update__vector_hamt_nonpod(value_backend_t& backend
 		quark::throw_runtime_error("Position argument to update() is outside collection span.");
 	}
 
-	//??? compile time. Provide as a constaint integer arg
-	const auto element_itype = lookup_vector_element_type(backend, type_t(coll_type));
+	hamt_element_scope_t scope(backend, type_t(coll_type));
+	retain_value(backend, value, scope.element_type);
 
-	const auto result = store_immutable(coll_value, i, value);
-
-	for(int x = 0 ; x < result.vector_hamt_ptr->get_element_count() ; x++){
-		auto v = result.vector_hamt_ptr->load_element(x);
-		retain_value(backend, v, element_itype);
+	//	The replaced element is released when its hamt_element_t is destroyed.
+	if(is_rc_unique(vec->alloc)){
+		auto& vecref = vec->get_vecref_mut();
+		vecref = std::move(vecref).set(i, hamt_element_t(value));
+		return coll_value;
 	}
+
+	const auto result = store_immutable(coll_value, i, value);
+	release_vec(backend, coll_value, type_t(coll_type));
 	return result;
 }
 
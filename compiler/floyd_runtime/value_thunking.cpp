@@ -20,23 +20,38 @@ runtime_value_t alloc_carray_8bit(value_backend_t& backend, const uint8_t data[]
 	QUARK_ASSERT(backend.check_invariant());
 	QUARK_ASSERT(data != nullptr || count == 0);
 
-	const auto allocation_count = size_to_allocation_blocks(count);
-	auto result = alloc_vector_carray(backend.heap, allocation_count, count, type_t::make_string());
+	return alloc_string_from_pieces(backend, { std::string_view(reinterpret_cast<const char*>(data), count) });
+}
+
+runtime_value_t alloc_string_from_pieces(value_backend_t& backend, std::initializer_list<std::string_view> pieces){
+	QUARK_ASSERT(backend.check_invariant());
 
-	size_t char_pos = 0;
-	int element_index = 0;
-	uint64_t acc = 0;
-	while(char_pos < count){
-		const uint64_t ch = data[char_pos];
-		const auto x = (char_pos & 7) * 8;
-		acc = acc | (ch << x);
-		char_pos++;
+	std::size_t count = 0;
+	for(const auto& piece: pieces){
+		count += piece.size();
+	}
 
-		if(((char_pos & 7) == 0) || (char_pos == count)){
-			result.vector_carray_ptr->store(element_index, make_runtime_int(static_cast<int64_t>(acc)));
-			element_index = element_index + 1;
-			acc = 0;
+	if(count <= k_inline_string_max){
+		char chars[k_inline_string_max];
+		std::size_t pos = 0;
+		for(const auto& piece: pieces){
+			std::memcpy(chars + pos, piece.data(), piece.size());
+			pos += piece.size();
 		}
+		return make_inline_string(std::string_view(chars, count));
+	}
+
+	//	Characters are packed 8 per element, first character in the lowest byte. On a little endian CPU that's
+	//	the characters in order, see get_string_view(). Unused bytes of the last element are 0.
+	const auto allocation_count = size_to_allocation_blocks(count);
+	auto result = alloc_vector_carray(backend.heap, allocation_count, count, type_t::make_string());
+	auto p = result.vector_carray_ptr->get_element_ptr();
+	p[allocation_count - 1] = make_runtime_int(0);
+
+	auto dest = reinterpret_cast<char*>(p);
+	for(const auto& piece: pieces){
+		std::memcpy(dest, piece.data(), piece.size());
+		dest += piece.size();
 	}
 	return result;
 }
@@ -70,29 +85,8 @@ QUARK_TEST("VECTOR_CARRAY_T", "", "", ""){
 std::string from_runtime_string2(const value_backend_t& backend, runtime_value_t encoded_value){
 	QUARK_ASSERT(backend.check_invariant());
 	QUARK_ASSERT(encoded_value.check_invariant());
-	QUARK_ASSERT(encoded_value.vector_carray_ptr != nullptr);
-
-	const size_t size = get_vec_string_size(encoded_value);
-
-	std::string result;
 
-	//	Read 8 characters at a time.
-	size_t char_pos = 0;
-	const auto begin0 = encoded_value.vector_carray_ptr->begin();
-	const auto end0 = encoded_value.vector_carray_ptr->end();
-	for(auto it = begin0 ; it != end0 ; it++){
-		const size_t copy_chars = std::min(size - char_pos, (size_t)8);
-		const uint64_t element = it->int_value;
-		for(int i = 0 ; i < copy_chars ; i++){
-			const uint64_t x = i * 8;
-			const uint64_t ch = (element >> x) & 0xff;
-			result.push_back(static_cast<char>(ch));
-		}
-		char_pos += copy_chars;
-	}
-
-	QUARK_ASSERT(result.size() == size);
-	return result;
+	return std::string(get_string_view(encoded_value));
 }
 
 QUARK_TEST("VECTOR_CARRAY_T", "", "", ""){
@@ -103,6 +97,79 @@ QUARK_TEST("VECTOR_CARRAY_T", "", "", ""){
 	QUARK_VERIFY(r == "hello, world!");
 }
 
+QUARK_TEST("VECTOR_CARRAY_T", "make_string_key()", "", "view of the characters, same hash as std::string"){
+	auto backend = make_test_value_backend();
+	const auto a = to_runtime_string2(backend, "hello, world!");
+
+	const auto key = make_string_key(a);
+	QUARK_VERIFY(key.chars == "hello, world!");
+	QUARK_VERIFY(key.hash == std::hash<std::string>{}("hello, world!"));
+	QUARK_VERIFY(a.vector_carray_ptr->alloc.data[1] == key.hash);
+
+	//	Changing the string forgets the cached hash.
+	store_string_char(a, 0, 'j');
+	QUARK_VERIFY(make_string_key(a).hash == std::hash<std::string>{}("jello, world!"));
+
+	release_value(backend, a, type_t::make_string());
+}
+
+QUARK_TEST("VECTOR_CARRAY_T", "make_string_key()", "", "finds std::string keys in all dict backends"){
+	auto backend = make_test_value_backend();
+	const auto a = to_runtime_string2(backend, "a key longer than 8 chars");
+	const auto key = make_string_key(a);
+
+	CPPMAP cppmap;
+	cppmap.insert_or_assign("a key longer than 8 chars", make_runtime_int(1));
+	QUARK_VERIFY(cppmap.find(key.chars)->second.int_value == 1);
+
+	const auto hamt = HAMT_MAP().set("a key longer than 8 chars", make_runtime_int(2));
+	QUARK_VERIFY(hamt.find(key)->int_value == 2);
+	QUARK_VERIFY(HAMT_MAP().set("other", make_runtime_int(2)).find(key) == nullptr);
+
+	HASH_MAP hash;
+	hash.insert_or_assign("a key longer than 8 chars", make_runtime_int(3));
+	QUARK_VERIFY(hash.find(key.chars, key.hash)->int_value == 3);
+
+	release_value(backend, a, type_t::make_string());
+}
+
+QUARK_TEST("VECTOR_CARRAY_T", "to_runtime_string2()", "7 chars", "inline, no alloc"){
+	auto backend = make_test_value_backend();
+	const uint64_t alloc_ids = backend.heap.allocation_id_generator;
+	const auto a = to_runtime_string2(backend, "seven!!");
+
+	QUARK_VERIFY(is_inline_string(a));
+	QUARK_VERIFY(backend.heap.allocation_id_generator == alloc_ids);
+	QUARK_VERIFY(get_vec_string_size(a) == 7);
+	QUARK_VERIFY(get_string_view(a) == "seven!!");
+	QUARK_VERIFY(from_runtime_string2(backend, a) == "seven!!");
+	QUARK_VERIFY(make_string_key(a).hash == std::hash<std::string>{}("seven!!"));
+
+	//	No-ops.
+	retain_value(backend, a, type_t::make_string());
+	release_value(backend, a, type_t::make_string());
+}
+
+QUARK_TEST("VECTOR_CARRAY_T", "to_runtime_string2()", "empty string", "inline"){
+	auto backend = make_test_value_backend();
+	const auto a = to_runtime_string2(backend, "");
+
+	QUARK_VERIFY(is_inline_string(a));
+	QUARK_VERIFY(a.vector_carray_ptr != nullptr);
+	QUARK_VERIFY(get_vec_string_size(a) == 0);
+	QUARK_VERIFY(from_runtime_string2(backend, a) == "");
+}
+
+QUARK_TEST("VECTOR_CARRAY_T", "to_runtime_string2()", "8 chars", "heap"){
+	auto backend = make_test_value_backend();
+	const auto a = to_runtime_string2(backend, "eight!!!");
+
+	QUARK_VERIFY(is_inline_string(a) == false);
+	QUARK_VERIFY(a.vector_carray_ptr->get_element_count() == 8);
+	QUARK_VERIFY(from_runtime_string2(backend, a) == "eight!!!");
+	release_value(backend, a, type_t::make_string());
+}
+
 
 
 
@@ -183,6 +250,18 @@ static runtime_value_t to_runtime_vector(value_backend_t& backend, const value_t
 		}
 		return result;
 	}
+	else if(is_vector_soa(backend.types, backend.config, type)){
+		const auto element_type = type_peek.get_vector_element_type(backend.types);
+		const auto member_count = peek2(backend.types, element_type).get_struct(backend.types)._members.size();
+		auto result = alloc_vector_soa(backend.heap, count, count, member_count, type);
+		for(int i = 0 ; i < count ; i++){
+			const auto& members = v0[i].get_struct_value()->_member_values;
+			for(int m = 0 ; m < member_count ; m++){
+				result.vector_soa_ptr->get_column_ptr(m)[i] = to_runtime_value2(backend, members[m]);
+			}
+		}
+		return result;
+	}
 	else if(is_vector_hamt(backend.types, backend.config, type)){
 		std::vector<runtime_value_t> temp;
 		for(int i = 0 ; i < count ; i++){
@@ -222,6 +301,25 @@ static value_t from_runtime_vector(const value_backend_t& backend, const runtime
 		const auto val = value_t::make_vector_value(backend.types, element_type, elements);
 		return val;
 	}
+	else if(is_vector_soa(backend.types, backend.config, type)){
+		const auto element_type = type_peek.get_vector_element_type(backend.types);
+		const auto element_peek = peek2(backend.types, element_type);
+		const auto& struct_def = element_peek.get_struct(backend.types);
+		const auto vec = encoded_value.vector_soa_ptr;
+
+		//	Rebuild each struct from its row, no STRUCT_T needed.
+		std::vector<value_t> elements;
+		const auto count = vec->get_element_count();
+		for(int i = 0 ; i < count ; i++){
+			std::vector<value_t> members;
+			for(int m = 0 ; m < struct_def._members.size() ; m++){
+				members.push_back(from_runtime_value2(backend, vec->get_column_ptr(m)[i], struct_def._members[m]._type));
+			}
+			elements.push_back(value_t::make_struct_value(backend.types, element_peek, members));
+		}
+		const auto val = value_t::make_vector_value(backend.types, element_type, elements);
+		return val;
+	}
 	else if(is_vector_hamt(backend.types, backend.config, type)){
 		const auto element_type = type_peek.get_vector_element_type(backend.types);
 		const auto vec = encoded_value.vector_hamt_ptr;
@@ -276,6 +374,19 @@ static runtime_value_t to_runtime_dict(value_backend_t& backend, const dict_t& e
 		}
 		return result;
 	}
+	else if(is_dict_hash(backend.types, backend.config, type)){
+		const auto& v0 = value.get_dict_value();
+
+		auto result = alloc_dict_hash(backend.heap, type);
+
+		auto& m = result.dict_hash_ptr->get_map_mut();
+		m.reserve(v0.size());
+		for(const auto& e: v0){
+			const auto a = to_runtime_value2(backend, e.second);
+			m.insert_or_assign(e.first, a);
+		}
+		return result;
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -315,6 +426,18 @@ static value_t from_runtime_dict(const value_backend_t& backend, const runtime_v
 		const auto val = value_t::make_dict_value(backend.types, value_type, values);
 		return val;
 	}
+	else if(is_dict_hash(backend.types, backend.config, type)){
+		const auto value_type = type_peek.get_dict_value_type(backend.types);
+		const auto dict = encoded_value.dict_hash_ptr;
+
+		std::map<std::string, value_t> values;
+		for(const auto& e: dict->get_map()){
+			const auto value = from_runtime_value2(backend, e.second, value_type);
+			values.insert({ e.first, value} );
+		}
+		const auto val = value_t::make_dict_value(backend.types, value_type, values);
+		return val;
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
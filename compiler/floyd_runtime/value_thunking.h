@@ -9,7 +9,9 @@
 #ifndef value_thunking_hpp
 #define value_thunking_hpp
 
+#include <initializer_list>
 #include <string>
+#include <string_view>
 
 namespace floyd {
 
@@ -20,6 +22,10 @@ struct type_t;
 
 runtime_value_t alloc_carray_8bit(value_backend_t& backend, const uint8_t data[], std::size_t count);
 
+//	Makes one runtime string of all pieces, the characters are copied straight into it. Pieces may point into
+//	other runtime strings.
+runtime_value_t alloc_string_from_pieces(value_backend_t& backend, std::initializer_list<std::string_view> pieces);
+
 runtime_value_t to_runtime_string2(value_backend_t& backend, const std::string& s);
 std::string from_runtime_string2(const value_backend_t& backend, runtime_value_t encoded_value);
 
@@ -1332,6 +1332,42 @@ FLOYD_LANG_PROOF("Floyd test suite", "return", "return RC-value from nested bloc
 	);
 }
 
+FLOYD_LANG_PROOF("Floyd test suite", "return", "nested calls return into the right caller", ""){
+	ut_verify_printout_nolib(
+		QUARK_POS,
+		R"___(
+
+			func string wrap(string s, int depth){
+				if(depth == 0){
+					return "<" + s + ">"
+				}
+				return "(" + wrap(s, depth - 1) + ")"
+			}
+			func int sum(int n){
+				if(n == 0){
+					return 0
+				}
+				return n + sum(n - 1)
+			}
+			func void say(string s) impure {
+				print(s)
+			}
+			func string say_and_wrap(string s) impure {
+				say(s)
+				let a = wrap(s, 2)
+				say(a)
+				return a + to_string(sum(4))
+			}
+
+			mutable r = "first"
+			r = say_and_wrap("x")
+			print(r)
+
+		)___",
+		{ "x", "((<x>))", "((<x>))10" }
+	);
+}
+
 
 
 
@@ -2303,6 +2339,29 @@ FLOYD_LANG_PROOF("Floyd test suite", "for", "EXPR ... EXPR", ""){
 	);
 }
 
+FLOYD_LANG_PROOF("Floyd test suite", "for", "EXPR ..< EXPR, empty range", "body never runs"){
+	ut_verify_printout_nolib(
+		QUARK_POS,
+		R"(
+
+			func int f(int a, int b){
+				mutable count = 0
+				for (i in a + 0 ..< b + 0) {
+					print(i)
+					count = count + 1
+				}
+				return count
+			}
+
+			assert(f(5, 2) == 0)
+			assert(f(3, 3) == 0)
+			print("done")
+
+		)",
+		{ "done" }
+	);
+}
+
 
 
 FLOYD_LANG_PROOF("Floyd test suite", "for", "nested for loops", ""){
@@ -2716,6 +2775,21 @@ FLOYD_LANG_PROOF("Floyd test suite", "string push_back()", "", ""){
 	)");
 }
 
+FLOYD_LANG_PROOF("Floyd test suite", "string push_back()", "s = push_back(s, ch) in loop", "old string kept in t"){
+	ut_run_closed_nolib(QUARK_POS, R"(
+
+		mutable s = "ab"
+		let t = s
+		for(i in 0 ..< 20){
+			s = push_back(s, 120)
+		}
+		s = update(s, 0, 65)
+		assert(s == "Abxxxxxxxxxxxxxxxxxxxx")
+		assert(t == "ab")
+
+	)");
+}
+
 
 
 FLOYD_LANG_PROOF("Floyd test suite", "string subset()", "string", ""){
@@ -3298,6 +3372,100 @@ FLOYD_LANG_PROOF("Floyd test suite", "vector [int] push_back()", "", ""){
 	);
 }
 
+FLOYD_LANG_PROOF("Floyd test suite", "vector [int] push_back()", "a = push_back(a, x) in loop", "grows in place"){
+	ut_run_closed_nolib(QUARK_POS,
+		R"(
+
+			mutable [int] a = []
+			for(i in 0 ..< 100){
+				a = push_back(a, i * 10)
+			}
+			assert(size(a) == 100)
+			assert(a[0] == 0)
+			assert(a[99] == 990)
+
+		)"
+	);
+}
+
+FLOYD_LANG_PROOF("Floyd test suite", "vector [int] push_back()", "a = push_back(a, x), old a kept in b", "b is unchanged"){
+	ut_run_closed_nolib(QUARK_POS,
+		R"(
+
+			mutable [int] a = [1, 2]
+			let b = a
+			a = push_back(a, 3)
+			a = update(a, 0, 100)
+			assert(a == [100, 2, 3])
+			assert(b == [1, 2])
+
+		)"
+	);
+}
+
+FLOYD_LANG_PROOF("Floyd test suite", "vector [int] update()", "a = update(a, i, a[i] + 1) on a local", "reads a before it is moved"){
+	ut_run_closed_nolib(QUARK_POS,
+		R"(
+
+			func [int] f(){
+				mutable [int] a = [ 10, 20, 30 ]
+				for(i in 0 ..< 30){
+					a = update(a, i % 3, a[i % 3] + 1)
+				}
+				return a
+			}
+
+			func string g(){
+				mutable s = "abc"
+				for(i in 0 ..< 3){
+					s = update(s, i, s[i] + 1)
+				}
+				return s
+			}
+
+			assert(f() == [ 20, 30, 40 ])
+			assert(g() == "bcd")
+
+		)"
+	);
+}
+
+FLOYD_LANG_PROOF("Floyd test suite", "vector [string] update()", "a = update(a, i, a[j])", "value semantics"){
+	ut_run_closed_nolib(QUARK_POS,
+		R"(
+
+			mutable [string] a = ["one", "two"]
+			a = update(a, 0, a[1])
+			a = push_back(a, a[0])
+			assert(a == ["two", "two", "two"])
+
+		)"
+	);
+}
+
+FLOYD_LANG_PROOF("Floyd test suite", "vector [string] update()", "a = update(a, i, s) on a local", "a keeps its own reference to s"){
+	ut_verify_printout_nolib(
+		QUARK_POS,
+		R"(
+
+			func void f() impure {
+				mutable a = [ "one one one", "two two two", "three three three" ]
+				let s = "zwei zwei" + " zwei"
+				a = update(a, 1, "drei drei" + " drei")
+				a = update(a, 2, s)
+				print(a)
+				print(s)
+			}
+			f()
+
+		)",
+		{
+			R"(["one one one", "drei drei drei", "zwei zwei zwei"])",
+			"zwei zwei zwei"
+		}
+	);
+}
+
 FLOYD_LANG_PROOF("Floyd test suite", "vector [int] subset()", "", ""){
 	ut_run_closed_nolib(QUARK_POS, R"(		assert(subset([10,20,30], 0, 3) == [10,20,30])		)");
 }
@@ -5589,6 +5757,47 @@ FLOYD_LANG_PROOF("Floyd test suite", "map_dag()", "complex", ""){
 	)");
 }
 
+//	The tasks run on the thread team, print() must not lose or corrupt lines when several of them print at once.
+FLOYD_LANG_PROOF("Floyd test suite", "map_dag()", "f calls print()", "one line per element"){
+	ut_verify_printout_nolib(
+		QUARK_POS,
+		R"(
+
+			func string f(string v, [string] inputs, string context){
+				print(context)
+				return v
+			}
+
+			mutable [string] elements = []
+			mutable [int] parents = []
+			for(i in 0 ..< 500){
+				elements = push_back(elements, "e")
+				parents = push_back(parents, -1)
+			}
+			let r = map_dag(elements, parents, f, "x")
+			assert(size(r) == 500)
+
+		)",
+		std::vector<std::string>(500, "x")
+	);
+}
+
+FLOYD_LANG_PROOF("Floyd test suite", "map_dag()", "Error: parent index out of range", "exception"){
+	ut_verify_exception_nolib(
+		QUARK_POS,
+		R"(
+
+			func string f(string v, [string] inputs, string context){
+				return v
+			}
+
+			let r = map_dag([ "one", "ring", "to" ], [ 1, 3, -1 ], f, "")
+
+		)",
+		"map_dag() parent index out of range."
+	);
+}
+
 
 
 //////////////////////////////////////////		HIGHER-ORDER INTRINSICS - reduce()
@@ -5752,6 +5961,23 @@ FLOYD_LANG_PROOF("Floyd test suite", "stable_sort()", "[string]", ""){
 	);
 }
 
+FLOYD_LANG_PROOF("Floyd test suite", "stable_sort()", "[int] equal keys keep their order", ""){
+	ut_verify_printout_nolib(
+		QUARK_POS,
+		R"(
+
+			func bool less_f(int left, int right, int m){
+				return (left % m) < (right % m)
+			}
+
+			let a = stable_sort([ 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21 ], less_f, 3)
+			print(a)
+
+		)",
+		{ "[12, 15, 18, 21, 10, 13, 16, 19, 11, 14, 17, 20]" }
+	);
+}
+
 
 #endif	//	RUN_LANG_INTRINSICS_TESTS
 
@@ -6996,6 +7222,206 @@ FLOYD_LANG_PROOF("software-system-def", "run two CONNECTED processes", "", ""){
 	ut_run_closed_nolib(QUARK_POS, program);
 }
 
+FLOYD_LANG_PROOF("software-system-def", "process with typed messages", "", ""){
+	const auto program = R"(
+
+		software-system-def {
+			"name": "My Arcade Game",
+			"desc": "Space shooter for mobile devices, with connection to a server.",
+			"people": {},
+			"connections": [],
+			"containers": [
+				"iphone app"
+			]
+		}
+
+		container-def {
+			"name": "iphone app",
+			"tech": "Swift, iOS, Xcode, Open GL",
+			"desc": "Mobile shooter game for iOS.",
+			"clocks": {
+				"main": {
+					"a": "my_gui",
+					"b": "my_counter",
+				}
+			}
+		}
+
+		struct note_t {
+			string text
+			int value
+		}
+
+
+		////////////////////////////////	my_gui -- process, takes any message as json
+
+		struct my_gui_state_t {
+			int _count
+		}
+
+		func my_gui_state_t my_gui__init() impure {
+			send("b", note_t("add", 3))
+			send("b", note_t("add", 4))
+			send("b", note_t("done", 0))
+			return my_gui_state_t(0)
+		}
+
+		func my_gui_state_t my_gui(my_gui_state_t state, json message) impure {
+			assert(message == "sum=7")
+			send("a", "stop")
+			return update(state, _count, state._count + 1)
+		}
+
+
+		////////////////////////////////	my_counter -- process, only takes note_t messages
+
+		struct my_counter_state_t {
+			int _sum
+		}
+
+		func my_counter_state_t my_counter__init() impure {
+			return my_counter_state_t(0)
+		}
+
+		func my_counter_state_t my_counter(my_counter_state_t state, note_t message) impure {
+			if(message.text == "add"){
+				return update(state, _sum, state._sum + message.value)
+			}
+			else {
+				send("a", "sum=" + to_string(state._sum))
+				send("b", "stop")
+				return state
+			}
+		}
+
+	)";
+
+	ut_run_closed_nolib(QUARK_POS, program);
+}
+
+FLOYD_LANG_PROOF("software-system-def", "process with typed messages", "send() wrong message type", "compiler error"){
+	ut_verify_exception_nolib(
+		QUARK_POS,
+		R"(
+
+			container-def {
+				"name": "iphone app",
+				"tech": "Swift, iOS, Xcode, Open GL",
+				"desc": "Mobile shooter game for iOS.",
+				"clocks": {
+					"main": {
+						"a": "my_gui",
+						"b": "my_counter",
+					}
+				}
+			}
+
+			struct note_t {
+				string text
+				int value
+			}
+
+			func int my_gui__init() impure {
+				send("b", 3)
+				return 0
+			}
+
+			func int my_gui(int state, json message) impure {
+				return state
+			}
+
+			func int my_counter__init() impure {
+				return 0
+			}
+
+			func int my_counter(int state, note_t message) impure {
+				return state
+			}
+
+		)",
+		R"___([Semantics] send(): process "b" takes messages of type note_t, cannot send int. Line: 21 "send("b", 3)")___"
+	);
+}
+
+//	b and a share a clock so b's send to a runs a's handler right away. c is on its own clock and logs the order.
+FLOYD_LANG_PROOF("software-system-def", "processes on the same clock", "send() runs receiver synchronously", ""){
+	const auto program = R"(
+
+		software-system-def {
+			"name": "My Arcade Game",
+			"desc": "Space shooter for mobile devices, with connection to a server.",
+			"people": {},
+			"connections": [],
+			"containers": [
+				"iphone app"
+			]
+		}
+
+		container-def {
+			"name": "iphone app",
+			"tech": "Swift, iOS, Xcode, Open GL",
+			"desc": "Mobile shooter game for iOS.",
+			"clocks": {
+				"main": {
+					"a": "my_a",
+					"b": "my_b"
+				},
+				"log": {
+					"c": "my_log"
+				}
+			}
+		}
+
+		struct count_t {
+			int _count
+		}
+
+		func count_t my_a__init() impure {
+			return count_t(0)
+		}
+
+		func count_t my_a(count_t state, string message) impure {
+			send("c", "a")
+			return update(state, _count, state._count + 1)
+		}
+
+		func count_t my_b__init() impure {
+			send("b", "go")
+			return count_t(0)
+		}
+
+		func count_t my_b(count_t state, string message) impure {
+			send("c", "before")
+			send("a", "x")
+			send("c", "after")
+			return update(state, _count, state._count + 1)
+		}
+
+		struct log_t {
+			string _log
+			int _count
+		}
+
+		func log_t my_log__init() impure {
+			return log_t("", 0)
+		}
+
+		func log_t my_log(log_t state, string message) impure {
+			let state2 = log_t(state._log + message + ",", state._count + 1)
+			if(state2._count == 3){
+				assert(state2._log == "before,a,after,")
+				send("a", "stop")
+				send("b", "stop")
+				send("c", "stop")
+			}
+			return state2
+		}
+
+	)";
+
+	ut_run_closed_nolib(QUARK_POS, program);
+}
+
 #endif	//	RUN_CONTAINER_TESTS
 
 
@@ -102,7 +102,7 @@ static test_report_t run_test_program_bc(const semantic_ast_t& semast, const std
 
 		//	Runs global code.
 		auto interpreter = interpreter_t(exe);
-		auto run_output = run_program_bc(interpreter, main_args);
+		auto run_output = run_program_bc(interpreter, main_args, make_default_config());
 
 		const auto result_variable = find_global_symbol2(interpreter, "result");
 		value_t result_global;
@@ -128,8 +128,12 @@ static test_report_t run_test_program_llvm(const semantic_ast_t& semast, const c
 	QUARK_ASSERT(settings.check_invariant());
 
 	try {
+		//	Record all allocs so we can check that the program released everything.
+		auto settings2 = settings;
+		settings2.config.trace_allocs = true;
+
 		llvm_instance_t llvm_instance;
-		auto exe = generate_llvm_ir_program(llvm_instance, semast, "", settings);
+		auto exe = generate_llvm_ir_program(llvm_instance, semast, "", settings2);
 
 		auto ee = init_llvm_jit(*exe);
 		const auto run_output = run_program(*ee, main_args);
@@ -137,6 +141,14 @@ static test_report_t run_test_program_llvm(const semantic_ast_t& semast, const c
 		const auto result_global0 = bind_global(*ee, "result");
 		const auto result_global = result_global0.first != nullptr ? load_global(*ee, result_global0) : value_t();
 
+		deinit_llvm_jit(*ee);
+		QUARK_ASSERT(ee->backend.heap.check_invariant());
+		const auto leaks = ee->backend.heap.count_used();
+		if(leaks > 0){
+			trace_heap(ee->backend.heap);
+			return test_report_t{ {}, {}, {}, "*** heap leaks: " + std::to_string(leaks) + " allocs ***" };
+		}
+
 		return test_report_t{ result_global.is_undefined() ? json_t() : value_and_type_to_ast_json(exe->type_lookup.state.types, result_global), run_output, ee->_print_output, "" };
 	}
 	catch(const std::runtime_error& e){
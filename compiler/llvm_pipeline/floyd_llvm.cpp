@@ -116,6 +116,197 @@ QUARK_TEST("", "From source: Check that floyd_runtime_init() runs and sets 'resu
 //	QUARK_TRACE_SS("result = " << floyd::print_program(*program));
 }
 
+//	Runs the program's global code and returns how many heap allocs it made.
+static uint64_t count_allocs(const std::string& program_source, floyd::vector_backend vector_backend_mode){
+	const auto cu = floyd::make_compilation_unit_nolib(program_source, "myfile.floyd");
+	const auto sem_ast = compile_to_sematic_ast__errors(cu);
+
+	auto settings = floyd::make_default_compiler_settings();
+	settings.config.vector_backend_mode = vector_backend_mode;
+
+	floyd::llvm_instance_t instance;
+	auto program = generate_llvm_ir_program(instance, sem_ast, "myfile.floyd", settings);
+	auto ee = init_llvm_jit(*program);
+	return ee->backend.heap.allocation_id_generator.load();
+}
+
+//	a is a local with RC 1 the whole loop: push_back() and update() must mutate it in place, not copy it once per
+//	iteration. Growing the carray doubles its capacity, so 2000 more iterations only add a few allocs.
+static std::string make_update_in_place_program(int count){
+	return R"(
+		func [int] f(int count){
+			mutable [int] a = [ 0, 0, 0, 0 ]
+			mutable s = "abcdefghijklmnop"
+			for(i in 0 ..< count){
+				a = push_back(a, i)
+				a = update(a, i % 4, a[i % 4] + i)
+				s = update(s, i % 16, 65)
+				s = push_back(s, 66)
+			}
+			assert(size(s) == 16 + count)
+			return a
+		}
+		let result = size(f()" + std::to_string(count) + R"())
+	)";
+}
+
+QUARK_TEST("LLVM Codegen", "a = push_back(a, x) / a = update(a, i, x)", "RC 1 local, carray", "mutates in place"){
+	const auto small = count_allocs(make_update_in_place_program(10), floyd::vector_backend::carray);
+	const auto big = count_allocs(make_update_in_place_program(2010), floyd::vector_backend::carray);
+	QUARK_VERIFY(big - small < 100);
+}
+
+QUARK_TEST("LLVM Codegen", "a = push_back(a, x) / a = update(a, i, x)", "RC 1 local, hamt", "mutates in place"){
+	const auto small = count_allocs(make_update_in_place_program(10), floyd::vector_backend::hamt);
+	const auto big = count_allocs(make_update_in_place_program(2010), floyd::vector_backend::hamt);
+	QUARK_VERIFY(big - small < 100);
+}
+
+//	g and its strings are shared: their RC goes through the runtime functions. The locals in f() are only reached by
+//	this thread: their RC is changed inline. Both must balance, so the heap is empty after deinit.
+QUARK_TEST("LLVM Codegen", "generate_retain() / generate_release()", "shared and non-shared values", "RC balances"){
+	const auto cu = floyd::make_compilation_unit_nolib(
+		R"(
+			let [string] g = [ "shared string 1", "shared string 2" ]
+
+			func int f([string] v, string s){
+				mutable [string] acc = []
+				for(i in 0 ..< 10){
+					let a = v
+					acc = push_back(acc, a[i % 2])
+					acc = push_back(acc, s)
+				}
+				return size(acc)
+			}
+
+			let result = f(g, g[0]) + f([ "local string 1", "local string 2" ], "local string 3")
+		)",
+		"myfile.floyd"
+	);
+	const auto sem_ast = compile_to_sematic_ast__errors(cu);
+
+	auto settings = floyd::make_default_compiler_settings();
+	settings.config.vector_backend_mode = floyd::vector_backend::carray;
+	settings.config.trace_allocs = true;
+
+	floyd::llvm_instance_t instance;
+	auto program = generate_llvm_ir_program(instance, sem_ast, "myfile.floyd", settings);
+	auto ee = init_llvm_jit(*program);
+
+	const auto result = bind_global(*ee, "result");
+	QUARK_VERIFY(*static_cast<const int64_t*>(result.first) == 40);
+
+	const auto g = *static_cast<const floyd::runtime_value_t*>(bind_global(*ee, "g").first);
+	QUARK_VERIFY(g.vector_carray_ptr->alloc.shared);
+	QUARK_VERIFY(g.vector_carray_ptr->alloc.rc == 1);
+	const auto g0 = g.vector_carray_ptr->get_element_ptr()[0];
+	QUARK_VERIFY(g0.vector_carray_ptr->alloc.shared);
+	QUARK_VERIFY(g0.vector_carray_ptr->alloc.rc == 1);
+
+	deinit_llvm_jit(*ee);
+	QUARK_VERIFY(ee->backend.heap.count_used() == 0);
+}
+
+//	Strings of up to 7 characters live inside their runtime_value_t: making, concatenating and searching them must
+//	not allocate, however many iterations run.
+static std::string make_inline_string_program(int count){
+	return R"(
+		func int f(int count){
+			mutable total = 0
+			for(i in 0 ..< count){
+				let s = "ab" + to_string(i % 10)
+				let t = subset(s + "xyz", 1, 5)
+				assert(t == "b" + to_string(i % 10) + "xy")
+				total = total + size(t) + find(t, "x")
+			}
+			return total
+		}
+		let result = f()" + std::to_string(count) + R"()
+	)";
+}
+
+QUARK_TEST("LLVM Codegen", "inline strings", "strings of up to 7 characters", "no heap allocs"){
+	const auto small = count_allocs(make_inline_string_program(10), floyd::vector_backend::carray);
+	const auto big = count_allocs(make_inline_string_program(1010), floyd::vector_backend::carray);
+	QUARK_VERIFY(big == small);
+}
+
+//	Runs the program's global code with alloc recording on, then deinit(). Returns how many allocs are still alive.
+static int run_and_count_leaks(const std::string& program_source, floyd::vector_backend vector_backend_mode){
+	const auto cu = floyd::make_compilation_unit_nolib(program_source, "myfile.floyd");
+	const auto sem_ast = compile_to_sematic_ast__errors(cu);
+
+	auto settings = floyd::make_default_compiler_settings();
+	settings.config.vector_backend_mode = vector_backend_mode;
+	settings.config.trace_allocs = true;
+
+	floyd::llvm_instance_t instance;
+	auto program = generate_llvm_ir_program(instance, sem_ast, "myfile.floyd", settings);
+	auto ee = init_llvm_jit(*program);
+	deinit_llvm_jit(*ee);
+	return ee->backend.heap.count_used();
+}
+
+//	Covers the soa codegen and intrinsics: a[i].m column loads, push_back(), update(), ==, find(), subset(), concat,
+//	replace() and the callbacks of map(), filter(), reduce() and stable_sort(). The Floyd asserts throw on failure.
+static const std::string k_soa_program = R"(
+	struct pixel_t { double x double y int tag }
+
+	func double sum_x([pixel_t] v){
+		mutable double acc = 0.0
+		for(i in 0 ..< size(v)){
+			acc = acc + v[i].x
+		}
+		return acc
+	}
+
+	func [pixel_t] make(int count){
+		mutable [pixel_t] v = []
+		mutable double x = 0.0
+		for(i in 0 ..< count){
+			v = push_back(v, pixel_t(x, x * 2.0, i))
+			x = x + 1.0
+		}
+		return v
+	}
+
+	func int get_tag2(pixel_t p, int c){ return p.tag * 2 }
+	func bool is_odd(pixel_t p, int c){ return p.tag % 2 == 1 }
+	func int add_tag(int acc, pixel_t p, int c){ return acc + p.tag }
+	func bool greater(pixel_t l, pixel_t r, int c){ return l.tag > r.tag }
+	func pixel_t same(pixel_t p, int c){ return p }
+
+	let a = make(100)
+	let b = update(a, 3, pixel_t(-1.0, -2.0, -3))
+	assert(a[3].tag == 3)
+	assert(b[3] == pixel_t(-1.0, -2.0, -3))
+	assert(size(b) == 100)
+	assert(sum_x(a) == 4950.0)
+	assert(find(a, pixel_t(5.0, 10.0, 5)) == 5)
+
+	let c = subset(a, 10, 20)
+	assert(size(c) == 10 && c[0].tag == 10)
+	let d = a + c
+	assert(size(d) == 110 && d[105].tag == 15)
+	let e = replace(a, 0, 90, [ pixel_t(1.0, 1.0, 1) ])
+	assert(size(e) == 11 && e[1].tag == 90)
+
+	assert(map(a, get_tag2, 0)[7] == 14)
+	let g = filter(a, is_odd, 0)
+	assert(size(g) == 50 && g[0].tag == 1)
+	assert(reduce(a, 0, add_tag, 0) == 4950)
+	assert(stable_sort(a, greater, 0)[0].tag == 99)
+	assert(map(a, same, 0) == a)
+)";
+
+QUARK_TEST("LLVM Codegen", "vector_backend::soa", "[pixel_t]", "runs, no leaks"){
+	QUARK_VERIFY(run_and_count_leaks(k_soa_program, floyd::vector_backend::soa) == 0);
+}
+
+QUARK_TEST("LLVM Codegen", "vector_backend::soa", "[pixel_t], same program with carray", "runs, no leaks"){
+	QUARK_VERIFY(run_and_count_leaks(k_soa_program, floyd::vector_backend::carray) == 0);
+}
+
 //	BROKEN!
 QUARK_TEST("", "From JSON: Simple function call, call print() from floyd_runtime_init()", "", ""){
 	const auto cu = floyd::make_compilation_unit_nolib("print(5)", "myfile.floyd");
@@ -498,14 +498,17 @@ static std::vector<resolved_symbol_t> generate_local_block_symbol_slots(llvm_fun
 
 //	Related: generate_floyd_runtime_deinit(), generate_destruct_scope_locals()
 //	Used for function scope, local scopes. Not used for globals.
-static void generate_destruct_scope_locals(llvm_function_generator_t& gen_acc, const std::vector<resolved_symbol_t>& symbols){
+//	moved_value_ptr: slot of a variable whose value was moved out, it's not released. Can be nullptr.
+static void generate_destruct_scope_locals(llvm_function_generator_t& gen_acc, const std::vector<resolved_symbol_t>& symbols, const llvm::Value* moved_value_ptr = nullptr){
 	QUARK_ASSERT(gen_acc.check_invariant());
 
 	auto& builder = gen_acc.get_builder();
 	const auto& types = gen_acc.gen.type_lookup.state.types;
 
 	for(const auto& e: symbols){
-		if(e.symtype == resolved_symbol_t::esymtype::k_global || e.symtype == resolved_symbol_t::esymtype::k_local){
+		if(moved_value_ptr != nullptr && e.value_ptr == moved_value_ptr){
+		}
+		else if(e.symtype == resolved_symbol_t::esymtype::k_global || e.symtype == resolved_symbol_t::esymtype::k_local){
 			if(e.symbol._symbol_type == symbol_t::symbol_type::named_type){
 			}
 			else{
@@ -571,6 +574,62 @@ static llvm::Value* generate_literal_expression(llvm_function_generator_t& gen_a
 	return generate_constant(gen_acc, literal);
 }
 
+//	Loading a local variable or argument doesn't need the retain + release pair around the use: the variable
+//	holds a reference until its scope ends and no expression can assign it. Borrow the variable's reference
+//	instead. Globals and all other expressions make a new reference that the consumer must release.
+static operand_t generate_operand(llvm_function_generator_t& gen_acc, const expression_t& e){
+	QUARK_ASSERT(gen_acc.check_invariant());
+	QUARK_ASSERT(e.check_invariant());
+
+	const auto load = std::get_if<expression_t::load2_t>(&e._expression_variant);
+	if(load != nullptr && load->address._parent_steps != symbol_pos_t::k_global_scope){
+		const auto s = find_symbol(gen_acc.gen, load->address);
+
+		//	Function arguments are not stored in a slot.
+		if(s.symtype == resolved_symbol_t::esymtype::k_function_argument){
+			return { s.value_ptr, false };
+		}
+		else{
+			return { gen_acc.get_builder().CreateLoad(s.value_ptr, "borrowed"), false };
+		}
+	}
+	else{
+		return { generate_expression(gen_acc, e), true };
+	}
+}
+
+static void generate_release_operand(llvm_function_generator_t& gen_acc, const operand_t& operand, const type_t& type){
+	if(operand.owned){
+		generate_release(gen_acc, *operand.reg, type);
+	}
+}
+
+//	a[i].m where a is a struct-of-arrays vector: loads the member straight from its column, without making a
+//	STRUCT_T for the element. Column m starts m * capacity words after the header. No bounds check, like carray.
+static llvm::Value* generate_resolve_soa_member(llvm_function_generator_t& gen_acc, const expression_t::lookup_t& lookup, int member_index, const type_t& member_type){
+	QUARK_ASSERT(gen_acc.check_invariant());
+
+	auto& builder = gen_acc.get_builder();
+	const auto vec_type = get_expr_output_type(gen_acc.gen, *lookup.parent_address);
+
+	const auto vec = generate_operand(gen_acc, *lookup.parent_address);
+	const auto index = generate_operand(gen_acc, *lookup.lookup_key);
+
+	auto header_ptr_reg = builder.CreateCast(llvm::Instruction::CastOps::BitCast, vec.reg, builder.getInt64Ty()->getPointerTo(), "");
+	auto capacity_ptr_reg = builder.CreateGEP(builder.getInt64Ty(), header_ptr_reg, builder.getInt64(VECTOR_SOA_T::k_capacity_offset / sizeof(uint64_t)), "");
+	auto capacity_reg = builder.CreateLoad(capacity_ptr_reg, "capacity");
+
+	auto column_base_ptr_reg = builder.CreateCast(llvm::Instruction::CastOps::BitCast, generate_get_vec_element_ptr_needs_cast(gen_acc, *vec.reg), builder.getInt64Ty()->getPointerTo(), "");
+	auto offset_reg = builder.CreateAdd(builder.CreateMul(capacity_reg, builder.getInt64(member_index)), index.reg, "");
+	auto member_ptr_reg = builder.CreateGEP(builder.getInt64Ty(), column_base_ptr_reg, offset_reg, "");
+	auto member_value_uint64_reg = builder.CreateLoad(member_ptr_reg, "soa_member");
+	auto result_reg = generate_cast_from_runtime_value(gen_acc.gen, *member_value_uint64_reg, member_type);
+
+	//	Members of soa elements are never RC values.
+	generate_release_operand(gen_acc, vec, vec_type);
+	return result_reg;
+}
+
 static llvm::Value* generate_resolve_member_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::resolve_member_t& details){
 	QUARK_ASSERT(gen_acc.check_invariant());
 	QUARK_ASSERT(e.check_invariant());
@@ -578,8 +637,16 @@ static llvm::Value* generate_resolve_member_expression(llvm_function_generator_t
 //	auto& builder = gen_acc.get_builder();
 	const auto& types = gen_acc.gen.type_lookup.state.types;
 
-	auto struct_ptr_reg = generate_expression(gen_acc, *details.parent_address);
+	const auto lookup = std::get_if<expression_t::lookup_t>(&details.parent_address->_expression_variant);
+	if(lookup != nullptr && is_vector_soa(types, gen_acc.gen.settings.config, get_expr_output_type(gen_acc.gen, *lookup->parent_address))){
+		const auto& struct_def = peek2(types, get_expr_output_type(gen_acc.gen, *details.parent_address)).get_struct(types);
+		int member_index = find_struct_member_index(struct_def, details.member_name);
+		QUARK_ASSERT(member_index != -1);
+		return generate_resolve_soa_member(gen_acc, *lookup, member_index, struct_def._members[member_index]._type);
+	}
 
+	const auto struct_operand = generate_operand(gen_acc, *details.parent_address);
+	auto struct_ptr_reg = struct_operand.reg;
 
 	const auto parent_type = peek2(types, get_expr_output_type(gen_acc.gen, *details.parent_address));
 	QUARK_ASSERT(parent_type.is_struct());
@@ -606,7 +673,7 @@ static llvm::Value* generate_resolve_member_expression(llvm_function_generator_t
 
 	auto member_value_reg = generate_load_struct_member(gen_acc, *struct_ptr_reg, parent_type, member_index);
 	generate_retain(gen_acc, *member_value_reg, member_type);
-	generate_release(gen_acc, *struct_ptr_reg, parent_type);
+	generate_release_operand(gen_acc, struct_operand, get_expr_output_type(gen_acc.gen, *details.parent_address));
 
 	return member_value_reg;
 }
@@ -615,15 +682,15 @@ static llvm::Value* generate_update_member_expression(llvm_function_generator_t&
 	QUARK_ASSERT(gen_acc.check_invariant());
 	QUARK_ASSERT(e.check_invariant());
 
-	auto parent_struct_ptr_reg = generate_expression(gen_acc, *details.parent_address);
-	auto new_value_reg = generate_expression(gen_acc, *details.new_value);
+	const auto parent_struct = generate_operand(gen_acc, *details.parent_address);
+	const auto new_value = generate_operand(gen_acc, *details.new_value);
 
 	const auto struct_type = get_expr_output_type(gen_acc.gen, *details.parent_address);
 	const auto member_type = get_expr_output_type(gen_acc.gen, *details.new_value);
-	auto struct2_ptr_reg = generate_update_struct_member(gen_acc, *parent_struct_ptr_reg, struct_type, details.member_index, *new_value_reg);
+	auto struct2_ptr_reg = generate_update_struct_member(gen_acc, *parent_struct.reg, struct_type, details.member_index, *new_value.reg);
 
-	generate_release(gen_acc, *new_value_reg, member_type);
-	generate_release(gen_acc, *parent_struct_ptr_reg, struct_type);
+	generate_release_operand(gen_acc, new_value, member_type);
+	generate_release_operand(gen_acc, parent_struct, struct_type);
 
 	return struct2_ptr_reg;
 }
@@ -636,8 +703,10 @@ static llvm::Value* generate_lookup_element_expression(llvm_function_generator_t
 	auto& context = builder.getContext();
 	const auto& types = gen_acc.gen.type_lookup.state.types;
 
-	auto parent_reg = generate_expression(gen_acc, *details.parent_address);
-	auto key_reg = generate_expression(gen_acc, *details.lookup_key);
+	const auto parent = generate_operand(gen_acc, *details.parent_address);
+	const auto key = generate_operand(gen_acc, *details.lookup_key);
+	auto parent_reg = parent.reg;
+	auto key_reg = key.reg;
 	const auto key_type = get_expr_output_type(gen_acc.gen, *details.lookup_key);
 	const auto key_type_peek = peek2(types, key_type);
 
@@ -646,15 +715,40 @@ static llvm::Value* generate_lookup_element_expression(llvm_function_generator_t
 	if(parent_type_peek.is_string()){
 		QUARK_ASSERT(key_type_peek.is_int());
 
+		//	Strings of up to 7 characters live inside the pointer itself, bit 0 set. See make_inline_string().
+		llvm::Function* parent_function = builder.GetInsertBlock()->getParent();
+		llvm::BasicBlock* inline_bb = llvm::BasicBlock::Create(context, "inline-string", parent_function);
+		llvm::BasicBlock* heap_bb = llvm::BasicBlock::Create(context, "heap-string", parent_function);
+		llvm::BasicBlock* join_bb = llvm::BasicBlock::Create(context, "string-lookup-join", parent_function);
+
+		auto bits_reg = builder.CreatePtrToInt(parent_reg, builder.getInt64Ty(), "string_bits");
+		auto tag_reg = builder.CreateAnd(bits_reg, builder.getInt64(1), "");
+		auto is_inline_reg = builder.CreateICmpNE(tag_reg, builder.getInt64(0), "is_inline_string");
+		builder.CreateCondBr(is_inline_reg, inline_bb, heap_bb);
+
+		//	Character i is in byte i + 1.
+		builder.SetInsertPoint(inline_bb);
+		auto shift_reg = builder.CreateShl(builder.CreateAdd(key_reg, builder.getInt64(1)), builder.getInt64(3), "");
+		auto inline_8bit_reg = builder.CreateTrunc(builder.CreateLShr(bits_reg, shift_reg), builder.getInt8Ty(), "");
+		llvm::Value* inline_element_reg = builder.CreateSExt(inline_8bit_reg, builder.getInt64Ty(), "char_to_int64");
+		builder.CreateBr(join_bb);
+
+		builder.SetInsertPoint(heap_bb);
 		auto element_ptr_reg = generate_get_vec_element_ptr_needs_cast(gen_acc, *parent_reg);
 		auto char_ptr_reg = gen_acc.get_builder().CreateCast(llvm::Instruction::CastOps::BitCast, element_ptr_reg, builder.getInt8PtrTy(), "");
 
 		const auto gep = std::vector<llvm::Value*>{ key_reg };
 		llvm::Value* element_addr = builder.CreateGEP(llvm::Type::getInt8Ty(context), char_ptr_reg, gep, "element_addr");
 		llvm::Value* value_8bit_reg = builder.CreateLoad(element_addr, "element_tmp");
-		llvm::Value* element_reg = gen_acc.get_builder().CreateCast(llvm::Instruction::CastOps::SExt, value_8bit_reg, builder.getInt64Ty(), "char_to_int64");
+		llvm::Value* heap_element_reg = gen_acc.get_builder().CreateCast(llvm::Instruction::CastOps::SExt, value_8bit_reg, builder.getInt64Ty(), "char_to_int64");
+		builder.CreateBr(join_bb);
+
+		builder.SetInsertPoint(join_bb);
+		llvm::PHINode* element_reg = builder.CreatePHI(builder.getInt64Ty(), 2, "string-element");
+		element_reg->addIncoming(inline_element_reg, inline_bb);
+		element_reg->addIncoming(heap_element_reg, heap_bb);
 
-		generate_release(gen_acc, *parent_reg, parent_type);
+		generate_release_operand(gen_acc, parent, parent_type);
 
 		//	No need to retain/release the element - it's an integer.
 
@@ -674,8 +768,8 @@ static llvm::Value* generate_lookup_element_expression(llvm_function_generator_t
 		};
 		auto result = builder.CreateCall(gen_acc.gen.runtime_functions.floydrt_lookup_json.llvm_codegen_f, args, "");
 
-		generate_release(gen_acc, *parent_reg, parent_type);
-		generate_release(gen_acc, *key_reg, key_type);
+		generate_release_operand(gen_acc, parent, parent_type);
+		generate_release_operand(gen_acc, key, key_type);
 		return result;
 	}
 	else if(is_vector_carray(types, gen_acc.gen.settings.config, parent_type)){
@@ -692,7 +786,7 @@ static llvm::Value* generate_lookup_element_expression(llvm_function_generator_t
 		auto result_reg = generate_cast_from_runtime_value(gen_acc.gen, *element_value_uint64_reg, element_type0);
 
 		generate_retain(gen_acc, *result_reg, element_type0);
-		generate_release(gen_acc, *parent_reg, parent_type);
+		generate_release_operand(gen_acc, parent, parent_type);
 
 		return result_reg;
 	}
@@ -710,24 +804,42 @@ static llvm::Value* generate_lookup_element_expression(llvm_function_generator_t
 		auto result_reg = generate_cast_from_runtime_value(gen_acc.gen, *element_value_uint64_reg, element_type0);
 
 		generate_retain(gen_acc, *result_reg, element_type0);
-		generate_release(gen_acc, *parent_reg, parent_type);
+		generate_release_operand(gen_acc, parent, parent_type);
+
+		generate_release_operand(gen_acc, key, key_type);
+
+		return result_reg;
+	}
+	else if(is_vector_soa(types, gen_acc.gen.settings.config, parent_type)){
+		QUARK_ASSERT(key_type_peek.is_int());
+
+		//	The runtime makes a new STRUCT_T from the row: we already own it.
+		const auto element_type0 = peek2(types, parent_type).get_vector_element_type(types);
+		std::vector<llvm::Value*> args2 = {
+			gen_acc.get_callers_fcp(),
+			parent_reg,
+			generate_itype_constant(gen_acc.gen, parent_type),
+			generate_cast_to_runtime_value(gen_acc.gen, *key_reg, key_type),
+		};
+		auto element_value_uint64_reg = builder.CreateCall(gen_acc.gen.runtime_functions.floydrt_load_vector_element_soa.llvm_codegen_f, args2, "");
+		auto result_reg = generate_cast_from_runtime_value(gen_acc.gen, *element_value_uint64_reg, element_type0);
 
-		//?? not needed, key is always int
-		generate_release(gen_acc, *key_reg, key_type);
+		generate_release_operand(gen_acc, parent, parent_type);
+		generate_release_operand(gen_acc, key, key_type);
 
 		return result_reg;
 	}
-	else if(is_dict_cppmap(types, gen_acc.gen.settings.config, parent_type) || is_dict_hamt(types, gen_acc.gen.settings.config, parent_type)){
+	else if(peek2(types, parent_type).is_dict()){
 		QUARK_ASSERT(key_type_peek.is_string());
 
 		const auto element_type0 = peek2(types, parent_type).get_dict_value_type(types);
-		const auto dict_mode = is_dict_hamt(types, gen_acc.gen.settings.config, parent_type) ? dict_backend::hamt : dict_backend::cppmap;
+		const auto dict_mode = gen_acc.gen.settings.config.dict_backend_mode;
 		auto element_value_uint64_reg = generate_lookup_dict(gen_acc, *parent_reg, parent_type, *key_reg, dict_mode);
 		auto result_reg = generate_cast_from_runtime_value(gen_acc.gen, *element_value_uint64_reg, element_type0);
 
 		generate_retain(gen_acc, *result_reg, element_type0);
-		generate_release(gen_acc, *parent_reg, parent_type);
-		generate_release(gen_acc, *key_reg, key_type);
+		generate_release_operand(gen_acc, parent, parent_type);
+		generate_release_operand(gen_acc, key, key_type);
 
 		return result_reg;
 	}
@@ -747,8 +859,10 @@ static llvm::Value* generate_arithmetic_expression(llvm_function_generator_t& ge
 	const auto type = get_expr_output_type(gen_acc.gen, *details.lhs);
 	const auto type_peek = peek2(types, type);
 
-	auto lhs_temp = generate_expression(gen_acc, *details.lhs);
-	auto rhs_temp = generate_expression(gen_acc, *details.rhs);
+	const auto lhs = generate_operand(gen_acc, *details.lhs);
+	const auto rhs = generate_operand(gen_acc, *details.rhs);
+	auto lhs_temp = lhs.reg;
+	auto rhs_temp = rhs.reg;
 
 	if(type_peek.is_bool()){
 		if(details.op == expression_type::k_arithmetic_add){
@@ -837,8 +951,8 @@ static llvm::Value* generate_arithmetic_expression(llvm_function_generator_t& ge
 			rhs_temp
 		};
 		auto result = gen_acc.get_builder().CreateCall(gen_acc.gen.runtime_functions.floydrt_concatunate_vectors.llvm_codegen_f, args2, "");
-		generate_release(gen_acc, *lhs_temp, get_expr_output_type(gen_acc.gen, *details.lhs));
-		generate_release(gen_acc, *rhs_temp, get_expr_output_type(gen_acc.gen, *details.rhs));
+		generate_release_operand(gen_acc, lhs, get_expr_output_type(gen_acc.gen, *details.lhs));
+		generate_release_operand(gen_acc, rhs, get_expr_output_type(gen_acc.gen, *details.rhs));
 		return result;
 	}
 	else{
@@ -877,8 +991,10 @@ static llvm::Value* generate_comparison_expression(llvm_function_generator_t& ge
 
 	const auto& types = gen_acc.gen.type_lookup.state.types;
 
-	auto lhs_temp = generate_expression(gen_acc, *details.lhs);
-	auto rhs_temp = generate_expression(gen_acc, *details.rhs);
+	const auto lhs = generate_operand(gen_acc, *details.lhs);
+	const auto rhs = generate_operand(gen_acc, *details.rhs);
+	auto lhs_temp = lhs.reg;
+	auto rhs_temp = rhs.reg;
 
 	//	Type is the data the opcode works on -- comparing two ints, comparing two strings etc.
 	const auto type = get_expr_output_type(gen_acc.gen, *details.lhs);
@@ -941,26 +1057,26 @@ static llvm::Value* generate_comparison_expression(llvm_function_generator_t& ge
 	}
 	else if(type_peek.is_string() || type_peek.is_vector()){
 		auto result_reg = generate_compare_values(gen_acc, details.op, type, *lhs_temp, *rhs_temp);
-		generate_release(gen_acc, *lhs_temp, get_expr_output_type(gen_acc.gen, *details.lhs));
-		generate_release(gen_acc, *rhs_temp, get_expr_output_type(gen_acc.gen, *details.rhs));
+		generate_release_operand(gen_acc, lhs, get_expr_output_type(gen_acc.gen, *details.lhs));
+		generate_release_operand(gen_acc, rhs, get_expr_output_type(gen_acc.gen, *details.rhs));
 		return result_reg;
 	}
 	else if(type_peek.is_dict()){
 		auto result_reg = generate_compare_values(gen_acc, details.op, type, *lhs_temp, *rhs_temp);
-		generate_release(gen_acc, *lhs_temp, get_expr_output_type(gen_acc.gen, *details.lhs));
-		generate_release(gen_acc, *rhs_temp, get_expr_output_type(gen_acc.gen, *details.rhs));
+		generate_release_operand(gen_acc, lhs, get_expr_output_type(gen_acc.gen, *details.lhs));
+		generate_release_operand(gen_acc, rhs, get_expr_output_type(gen_acc.gen, *details.rhs));
 		return result_reg;
 	}
 	else if(type_peek.is_struct()){
 		auto result_reg = generate_compare_values(gen_acc, details.op, type, *lhs_temp, *rhs_temp);
-		generate_release(gen_acc, *lhs_temp, get_expr_output_type(gen_acc.gen, *details.lhs));
-		generate_release(gen_acc, *rhs_temp, get_expr_output_type(gen_acc.gen, *details.rhs));
+		generate_release_operand(gen_acc, lhs, get_expr_output_type(gen_acc.gen, *details.lhs));
+		generate_release_operand(gen_acc, rhs, get_expr_output_type(gen_acc.gen, *details.rhs));
 		return result_reg;
 	}
 	else if(type_peek.is_json()){
 		auto result_reg = generate_compare_values(gen_acc, details.op, type, *lhs_temp, *rhs_temp);
-		generate_release(gen_acc, *lhs_temp, get_expr_output_type(gen_acc.gen, *details.lhs));
-		generate_release(gen_acc, *rhs_temp, get_expr_output_type(gen_acc.gen, *details.rhs));
+		generate_release_operand(gen_acc, lhs, get_expr_output_type(gen_acc.gen, *details.lhs));
+		generate_release_operand(gen_acc, rhs, get_expr_output_type(gen_acc.gen, *details.rhs));
 		return result_reg;
 	}
 	else{
@@ -1165,10 +1281,9 @@ static llvm::Value* generate_call_expression(llvm_function_generator_t& gen_acc,
 	const auto resolved_function_type = calc_resolved_function_type(gen_acc.gen, e0, get_expr_output_type(gen_acc.gen, *details.callee), details.args);
 	auto callee_reg = generate_expression(gen_acc, *details.callee);
 
-	std::vector<llvm::Value*> floyd_args;
+	std::vector<operand_t> floyd_args;
 	for(const auto& e: details.args){
-		llvm::Value* arg_value = generate_expression(gen_acc, e);
-		floyd_args.push_back(arg_value);
+		floyd_args.push_back(generate_operand(gen_acc, e));
 	}
 	return generate_floyd_call(gen_acc, callee_function_type, resolved_function_type, *callee_reg, floyd_args);
 }
@@ -1199,16 +1314,20 @@ llvm::Value* generate_fallthrough_intrinsic(llvm_function_generator_t& gen_acc,
 	auto callee_reg = def.llvm_codegen_f;
 	QUARK_ASSERT(callee_reg != nullptr);
 
-	std::vector<llvm::Value*> floyd_args;
+	//	erase() changes the dict in place if it has RC 1, so it must not borrow a variable's reference.
+	const auto may_change_args = details.call_name == get_intrinsic_opcode(intrinsic_signatures.erase);
+
+	std::vector<operand_t> floyd_args;
 	for(const auto& m: details.args){
-		llvm::Value* arg_value = generate_expression(gen_acc, m);
-		floyd_args.push_back(arg_value);
+		floyd_args.push_back(may_change_args ? operand_t { generate_expression(gen_acc, m), true } : generate_operand(gen_acc, m));
 	}
 	return generate_floyd_call(gen_acc, callee_function_type, resolved_call_function_type, *callee_reg, floyd_args);
 }
 
 
-static llvm::Value* generate_push_back_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::intrinsic_t& details){
+//	moved_collection_ptr: address of the variable when the caller moves it into push_back(), else nullptr.
+//	The variable is loaded after the other arguments are evaluated, they may read it.
+static llvm::Value* generate_push_back_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::intrinsic_t& details, llvm::Value* moved_collection_ptr){
 	QUARK_ASSERT(gen_acc.check_invariant());
 	QUARK_ASSERT(e.check_invariant());
 
@@ -1219,9 +1338,16 @@ static llvm::Value* generate_push_back_expression(llvm_function_generator_t& gen
 
 	const auto resolved_call_type = calc_resolved_function_type(gen_acc.gen, e, it->_function_type, details.args);
 	const auto collection_type = get_expr_output_type(gen_acc.gen, details.args[0]);
-	auto vector_reg = generate_expression(gen_acc, details.args[0]);
-	auto element_reg = generate_expression(gen_acc, details.args[1]);
-	return generate_instrinsic_push_back(gen_acc, resolved_call_type, *vector_reg, collection_type, *element_reg);
+	auto vector_reg = moved_collection_ptr == nullptr ? generate_expression(gen_acc, details.args[0]) : nullptr;
+	const auto element = generate_operand(gen_acc, details.args[1]);
+	if(moved_collection_ptr != nullptr){
+		vector_reg = gen_acc.get_builder().CreateLoad(moved_collection_ptr, "moved");
+	}
+
+	//	push_back() consumes the collection but retains the element itself.
+	auto result_reg = generate_instrinsic_push_back(gen_acc, resolved_call_type, *vector_reg, collection_type, *element.reg);
+	generate_release_operand(gen_acc, element, get_expr_output_type(gen_acc.gen, details.args[1]));
+	return result_reg;
 }
 
 static llvm::Value* generate_size_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::intrinsic_t& details){
@@ -1236,11 +1362,15 @@ static llvm::Value* generate_size_expression(llvm_function_generator_t& gen_acc,
 	QUARK_ASSERT(peek2(types, collection_type).is_vector() || peek2(types, collection_type).is_string() || peek2(types, collection_type).is_dict() || peek2(types, collection_type).is_json());
 
 	const auto resolved_call_type = calc_resolved_function_type(gen_acc.gen, e, it->_function_type, details.args);
-	auto collection_reg = generate_expression(gen_acc, details.args[0]);
-	return generate_instrinsic_size(gen_acc, resolved_call_type, *collection_reg, collection_type);
+	const auto collection = generate_operand(gen_acc, details.args[0]);
+	auto result_reg = generate_instrinsic_size(gen_acc, resolved_call_type, *collection.reg, collection_type);
+	generate_release_operand(gen_acc, collection, collection_type);
+	return result_reg;
 }
 
-static llvm::Value* generate_update_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::intrinsic_t& details){
+//	moved_collection_ptr: address of the variable when the caller moves it into update(), else nullptr.
+//	The variable is loaded after the other arguments are evaluated, they may read it.
+static llvm::Value* generate_update_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::intrinsic_t& details, llvm::Value* moved_collection_ptr){
 	QUARK_ASSERT(gen_acc.check_invariant());
 	QUARK_ASSERT(e.check_invariant());
 
@@ -1251,10 +1381,18 @@ static llvm::Value* generate_update_expression(llvm_function_generator_t& gen_ac
 
 	const auto resolved_call_type = calc_resolved_function_type(gen_acc.gen, e, it->_function_type, details.args);
 	const auto collection_type = get_expr_output_type(gen_acc.gen, details.args[0]);
-	auto vector_reg = generate_expression(gen_acc, details.args[0]);
-	auto index_reg = generate_expression(gen_acc, details.args[1]);
-	auto element_reg = generate_expression(gen_acc, details.args[2]);
-	return generate_instrinsic_update(gen_acc, resolved_call_type, *vector_reg, collection_type, *index_reg, *element_reg);
+	auto vector_reg = moved_collection_ptr == nullptr ? generate_expression(gen_acc, details.args[0]) : nullptr;
+	const auto index = generate_operand(gen_acc, details.args[1]);
+	const auto element = generate_operand(gen_acc, details.args[2]);
+	if(moved_collection_ptr != nullptr){
+		vector_reg = gen_acc.get_builder().CreateLoad(moved_collection_ptr, "moved");
+	}
+
+	//	update() consumes the collection but copies the key and retains the element itself.
+	auto result_reg = generate_instrinsic_update(gen_acc, resolved_call_type, *vector_reg, collection_type, *index.reg, *element.reg);
+	generate_release_operand(gen_acc, index, get_expr_output_type(gen_acc.gen, details.args[1]));
+	generate_release_operand(gen_acc, element, get_expr_output_type(gen_acc.gen, details.args[2]));
+	return result_reg;
 }
 
 static llvm::Value* generate_map_expression(llvm_function_generator_t& gen_acc, const expression_t& e, const expression_t::intrinsic_t& details){
@@ -1268,16 +1406,20 @@ static llvm::Value* generate_map_expression(llvm_function_generator_t& gen_acc,
 
 	const auto resolved_call_type = calc_resolved_function_type(gen_acc.gen, e, it->_function_type, details.args);
 
-	auto vector_reg = generate_expression(gen_acc, details.args[0]);
+	//	map() doesn't consume its arguments: release the temporaries when it returns.
+	const auto vector = generate_operand(gen_acc, details.args[0]);
 	const auto collection_type = get_expr_output_type(gen_acc.gen, details.args[0]);
 
 	auto f_reg = generate_expression(gen_acc, details.args[1]);
 	auto f_type = get_expr_output_type(gen_acc.gen, details.args[1]);
 
-	auto context_reg = generate_expression(gen_acc, details.args[2]);
+	const auto context = generate_operand(gen_acc, details.args[2]);
 	auto context_type = get_expr_output_type(gen_acc.gen, details.args[2]);
 
-	return generate_instrinsic_map(gen_acc, resolved_call_type, *vector_reg, collection_type, *f_reg, f_type, *context_reg, context_type);
+	auto result_reg = generate_instrinsic_map(gen_acc, resolved_call_type, *vector.reg, collection_type, *f_reg, f_type, *context.reg, context_type);
+	generate_release_operand(gen_acc, vector, collection_type);
+	generate_release_operand(gen_acc, context, context_type);
+	return result_reg;
 }
 
 
@@ -1301,7 +1443,7 @@ static llvm::Value* generate_intrinsic_expression(llvm_function_generator_t& gen
 	}
 
 	else if(details.call_name == get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.update)){
-		return generate_update_expression(gen_acc, e, details);
+		return generate_update_expression(gen_acc, e, details, nullptr);
 	}
 	else if(details.call_name == get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.size)){
 		return generate_size_expression(gen_acc, e, details);
@@ -1319,7 +1461,7 @@ static llvm::Value* generate_intrinsic_expression(llvm_function_generator_t& gen
 		return generate_fallthrough_intrinsic(gen_acc, e, details);
 	}
 	else if(details.call_name == get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.push_back)){
-		return generate_push_back_expression(gen_acc, e, details);
+		return generate_push_back_expression(gen_acc, e, details, nullptr);
 	}
 	else if(details.call_name == get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.subset)){
 		return generate_fallthrough_intrinsic(gen_acc, e, details);
@@ -1469,6 +1611,20 @@ static llvm::Value* generate_construct_vector(llvm_function_generator_t& gen_acc
 		}
 		return vec_ptr_reg;
 	}
+	else if(is_vector_soa(types, gen_acc.gen.settings.config, construct_type)){
+		auto vec_ptr_reg = generate_allocate_vector(gen_acc, construct_type, element_count, vector_backend::soa);
+		int element_index = 0;
+		for(const auto& element_value: details.elements){
+			auto index_reg = generate_constant(gen_acc, value_t::make_int(element_index));
+			auto element_value_reg = generate_expression(gen_acc, element_value);
+			auto element_value2_reg = generate_cast_to_runtime_value(gen_acc.gen, *element_value_reg, element_type0);
+
+			//	Copies the members into the columns and releases the temp struct.
+			builder.CreateCall(gen_acc.gen.runtime_functions.floydrt_store_vector_element_soa_mutable.llvm_codegen_f, { gen_acc.get_callers_fcp(), vec_ptr_reg, vec_type_reg, index_reg, element_value2_reg }, "");
+			element_index++;
+		}
+		return vec_ptr_reg;
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -1887,18 +2043,69 @@ static llvm::Value* generate_expression(llvm_function_generator_t& gen_acc, cons
 
 
 
+//	Finds "a = push_back(a, x)" and "a = update(a, i, x)". Returns nullptr for other assignments.
+static const expression_t::intrinsic_t* find_update_of_dest(const llvm_function_generator_t& gen_acc, const statement_t::assign2_t& s){
+	const auto intrinsic = std::get_if<expression_t::intrinsic_t>(&s._expression._expression_variant);
+	if(intrinsic == nullptr){
+		return nullptr;
+	}
+	if(intrinsic->call_name != get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.push_back)
+	&& intrinsic->call_name != get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.update)){
+		return nullptr;
+	}
+	const auto load = std::get_if<expression_t::load2_t>(&intrinsic->args[0]._expression_variant);
+	if(load == nullptr || !(load->address == s._dest_variable)){
+		return nullptr;
+	}
+	return intrinsic;
+}
+
+//	Other threads can read globals: a value stored into one must be shared, see share_value().
+static void generate_share_global(llvm_function_generator_t& gen_acc, llvm::Value& value_reg, const type_t& type){
+	gen_acc.get_builder().CreateCall(
+		gen_acc.gen.runtime_functions.floydrt_share_global.llvm_codegen_f,
+		{
+			gen_acc.get_callers_fcp(),
+			generate_cast_to_runtime_value(gen_acc.gen, value_reg, type),
+			generate_itype_constant(gen_acc.gen, type)
+		},
+		""
+	);
+}
+
 static void generate_assign2_statement(llvm_function_generator_t& gen_acc, const statement_t::assign2_t& s){
 	QUARK_ASSERT(gen_acc.check_invariant());
 
 	const auto& types = gen_acc.gen.type_lookup.state.types;
-	llvm::Value* value = generate_expression(gen_acc, s._expression);
 
 	auto dest = find_symbol(gen_acc.gen, s._dest_variable);
 	const auto type = dest.symbol.get_value_type();
+	const auto is_global = s._dest_variable._parent_steps == symbol_pos_t::k_global_scope;
+
+	//	The previous value of the variable is dead after this statement. Move it into push_back() / update()
+	//	instead of retaining it: they take over the reference, so if nobody else has the collection it has RC 1
+	//	and is mutated in place. The variable is loaded only after the other arguments have been evaluated.
+	//	Only locals: a global is shared as soon as it's stored, and shared values are never mutated in place.
+	const auto update_of_dest = is_global == false && is_rc_value(peek2(types, type)) ? find_update_of_dest(gen_acc, s) : nullptr;
+	if(update_of_dest != nullptr){
+		llvm::Value* value = update_of_dest->call_name == get_intrinsic_opcode(gen_acc.gen.intrinsic_signatures.push_back)
+			? generate_push_back_expression(gen_acc, s._expression, *update_of_dest, dest.value_ptr)
+			: generate_update_expression(gen_acc, s._expression, *update_of_dest, dest.value_ptr);
+
+		//	No release of previous value, the call consumed it.
+		gen_acc.get_builder().CreateStore(value, dest.value_ptr);
+		QUARK_ASSERT(gen_acc.check_invariant());
+		return;
+	}
+
+	llvm::Value* value = generate_expression(gen_acc, s._expression);
 
 	if(is_rc_value(peek2(types, type))){
 		auto prev_value = gen_acc.get_builder().CreateLoad(dest.value_ptr);
 		generate_release(gen_acc, *prev_value, type);
+		if(is_global){
+			generate_share_global(gen_acc, *value, type);
+		}
 
 		//	No need to retain new value. generate_expression() takes care of that.
 		gen_acc.get_builder().CreateStore(value, dest.value_ptr);
@@ -2148,16 +2355,30 @@ static void generate_expression_statement(llvm_function_generator_t& gen_acc, co
 }
 
 
+//	"return x" where x is a local variable is x's last use: move its reference to the caller instead of
+//	retaining it here and releasing it when destructing the locals. Returns nullptr if the expression isn't that.
+static llvm::Value* find_moved_return_slot(llvm_function_generator_t& gen_acc, const expression_t& e){
+	const auto load = std::get_if<expression_t::load2_t>(&e._expression_variant);
+	if(load == nullptr || load->address._parent_steps == symbol_pos_t::k_global_scope){
+		return nullptr;
+	}
+	const auto s = find_symbol(gen_acc.gen, load->address);
+	return s.symtype == resolved_symbol_t::esymtype::k_local ? s.value_ptr : nullptr;
+}
+
 static llvm::Value* generate_return_statement(llvm_function_generator_t& gen_acc, const statement_t::return_statement_t& s){
 	QUARK_ASSERT(gen_acc.check_invariant());
 
-	llvm::Value* value = generate_expression(gen_acc, s._expression);
+	const auto moved_value_ptr = find_moved_return_slot(gen_acc, s._expression);
+	llvm::Value* value = moved_value_ptr != nullptr
+		? gen_acc.get_builder().CreateLoad(moved_value_ptr, "moved")
+		: generate_expression(gen_acc, s._expression);
 
 	//	Destruct all local scopes before unwinding.
 	auto path = gen_acc.gen.scope_path;
 	QUARK_ASSERT(path.size() > 0);
 	while(path.size() > 1){
-		generate_destruct_scope_locals(gen_acc, path.back());
+		generate_destruct_scope_locals(gen_acc, path.back(), moved_value_ptr);
 		path.pop_back();
 	}
 
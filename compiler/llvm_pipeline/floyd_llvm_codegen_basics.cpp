@@ -70,7 +70,7 @@ llvm::Value* generate_get_struct_base_ptr(llvm_function_generator_t& gen_acc, ll
 	return ptr3_reg;
 }
 
-llvm::Value* generate_floyd_call(llvm_function_generator_t& gen_acc, const type_t& callee_function_type, const type_t& resolved_function_type, llvm::Value& callee_reg, const std::vector<llvm::Value*> floyd_args){
+llvm::Value* generate_floyd_call(llvm_function_generator_t& gen_acc, const type_t& callee_function_type, const type_t& resolved_function_type, llvm::Value& callee_reg, const std::vector<operand_t>& floyd_args){
 	QUARK_ASSERT(gen_acc.check_invariant());
 	QUARK_ASSERT(callee_function_type.check_invariant());
 	QUARK_ASSERT(resolved_function_type.check_invariant());
@@ -97,19 +97,25 @@ llvm::Value* generate_floyd_call(llvm_function_generator_t& gen_acc, const type_
 		}
 		else if(out_arg.map_type == llvm_arg_mapping_t::map_type::k_known_value_type){
 			QUARK_ASSERT(out_arg.floyd_arg_index >= 0 && out_arg.floyd_arg_index < floyd_args.size());
-			auto floyd_arg_reg = floyd_args[out_arg.floyd_arg_index];
+			const auto& floyd_arg = floyd_args[out_arg.floyd_arg_index];
+			auto floyd_arg_reg = floyd_arg.reg;
 			const auto arg_type = peek2(types, resolved_function_type).get_function_args(types)[out_arg.floyd_arg_index];
 
 			arg_regs.push_back(floyd_arg_reg);
-			destroy.push_back({ floyd_arg_reg, arg_type });
+			if(floyd_arg.owned){
+				destroy.push_back({ floyd_arg_reg, arg_type });
+			}
 		}
 
 		else if(out_arg.map_type == llvm_arg_mapping_t::map_type::k_dyn_value){
 			QUARK_ASSERT(out_arg.floyd_arg_index >= 0 && out_arg.floyd_arg_index < floyd_args.size());
-			auto floyd_arg_reg = floyd_args[out_arg.floyd_arg_index];
+			const auto& floyd_arg = floyd_args[out_arg.floyd_arg_index];
+			auto floyd_arg_reg = floyd_arg.reg;
 			const auto arg_type = peek2(types, resolved_function_type).get_function_args(types)[out_arg.floyd_arg_index];
 
-			destroy.push_back({ floyd_arg_reg, arg_type });
+			if(floyd_arg.owned){
+				destroy.push_back({ floyd_arg_reg, arg_type });
+			}
 
 			// We assume that the next arg in the callee_mapping is the dyn-type and store it too.
 			const auto packed_reg = generate_cast_to_runtime_value(gen_acc.gen, *floyd_arg_reg, arg_type);
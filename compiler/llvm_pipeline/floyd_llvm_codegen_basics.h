@@ -185,9 +185,23 @@ llvm::Value* generate_get_vec_element_ptr_needs_cast(llvm_function_generator_t&
 llvm::Value* generate_get_struct_base_ptr(llvm_function_generator_t& gen_acc, llvm::Value& struct_ptr_reg, const type_t& final_type);
 
 
+/*
+	An operand that the consumer only reads and is done with before the statement ends: struct of a member
+	access, collection + key of a lookup, comparison and concat operands, call arguments.
+
+	owned = false: reg borrows the reference of a local variable or argument, don't release it.
+	owned = true: reg is a new reference, the consumer releases it.
+*/
+struct operand_t {
+	llvm::Value* reg;
+	bool owned;
+};
+
+
 //	Adds argument #0 which is floyd's secret runtime context.
 //	Supports ANY-types by passing TWO arguments: the value then the itype of the value.
-llvm::Value* generate_floyd_call(llvm_function_generator_t& gen_acc, const type_t& callee_function_type, const type_t& resolved_function_type, llvm::Value& callee_reg, const std::vector<llvm::Value*> floyd_args);
+//	The callee borrows the arguments. The owned ones are released after the call.
+llvm::Value* generate_floyd_call(llvm_function_generator_t& gen_acc, const type_t& callee_function_type, const type_t& resolved_function_type, llvm::Value& callee_reg, const std::vector<operand_t>& floyd_args);
 
 }	//	floyd
 
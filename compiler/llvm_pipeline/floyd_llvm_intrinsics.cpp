@@ -20,6 +20,9 @@
 
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 
+#include <exception>
+#include <cstring>
+
 namespace floyd {
 
 
@@ -67,9 +70,11 @@ POD VS NONPOD
 	update_string()				string		string		int			int
 	update_vector_carray()		vec<T>		vec<T>		int			T
 	update_vector_hamt()		vec<T>		vec<T>		int			T
+	update_vector_soa()			vec<T>		vec<T>		int			T
 
 	update_dict_cppmap()		dict<T>		dict<T>		string		T
 	update_dict_hamt()			dict<T>		dict<T>		string		T
+	update_dict_hash()			dict<T>		dict<T>		string		T
 */
 
 enum class eresolved_type {
@@ -80,12 +85,18 @@ enum class eresolved_type {
 	k_vector_hamt_pod,
 	k_vector_hamt_nonpod,
 
+	//	Elements are POD structs, see is_vector_soa().
+	k_vector_soa,
+
 	k_dict_cppmap_pod,
 	k_dict_cppmap_nonpod,
 
 	k_dict_hamt_pod,
 	k_dict_hamt_nonpod,
 
+	k_dict_hash_pod,
+	k_dict_hash_nonpod,
+
 	k_json
 };
 
@@ -121,6 +132,9 @@ static bool matches_specialization(const config_t& config, const types_t& types,
 			return wanted == eresolved_type::k_vector_hamt_pod;
 		}
 	}
+	else if(is_vector_soa(types, config, arg_type)){
+		return wanted == eresolved_type::k_vector_soa;
+	}
 
 	else if(is_dict_cppmap(types, config, arg_type)){
 		const auto is_rc = is_rc_value(peek2(types, arg_type_peek.get_dict_value_type(types)));
@@ -140,6 +154,15 @@ static bool matches_specialization(const config_t& config, const types_t& types,
 			return wanted == eresolved_type::k_dict_hamt_pod;
 		}
 	}
+	else if(is_dict_hash(types, config, arg_type)){
+		const auto is_rc = is_rc_value(peek2(types, arg_type_peek.get_dict_value_type(types)));
+		if(is_rc){
+			return wanted == eresolved_type::k_dict_hash_nonpod;
+		}
+		else{
+			return wanted == eresolved_type::k_dict_hash_pod;
+		}
+	}
 
 	else if(arg_type_peek.is_json()){
 		return wanted == eresolved_type::k_json;
@@ -178,7 +201,10 @@ static void floyd_llvm_intrinsic__assert(floyd_runtime_t* frp, runtime_value_t a
 
 	bool ok = (arg.bool_value & 0x01) == 0 ? false : true;
 	if(!ok){
-		r._print_output.push_back("Assertion failed.");
+		{
+			std::lock_guard<std::mutex> lock(r.print_output_mutex);
+			r._print_output.push_back("Assertion failed.");
+		}
 		quark::throw_runtime_error("Floyd assertion failed.");
 	}
 }
@@ -211,8 +237,10 @@ static runtime_value_t floyd_llvm_intrinsic__erase(floyd_runtime_t* frp, runtime
 		auto& m = dict2.dict_cppmap_ptr->get_map_mut();
 		m = dict->get_map();
 
-		const auto key_string = from_runtime_string(r, key_value);
-		m.erase(key_string);
+		const auto it = m.find(make_string_key(key_value).chars);
+		if(it != m.end()){
+			m.erase(it);
+		}
 
 		if(is_rc_value(peek2(types, value_type))){
 			for(auto& e: m){
@@ -241,6 +269,42 @@ static runtime_value_t floyd_llvm_intrinsic__erase(floyd_runtime_t* frp, runtime
 		}
 		return dict2;
 	}
+	else if(is_dict_hash(types, r.backend.config, type0)){
+		auto& dict = *coll_value.dict_hash_ptr;
+
+		const auto value_type = peek2(types, type0).get_dict_value_type(types);
+		const auto is_rc = is_rc_value(peek2(types, value_type));
+		const auto key = make_string_key(key_value);
+
+		//	The caller releases coll_value after the call. If that is the only reference, erase in place
+		//	and hand the dict back with a new reference.
+		if(is_rc_unique(dict.alloc)){
+			auto& m = dict.get_map_mut();
+			const auto existing = m.find(key.chars, key.hash);
+			if(existing != nullptr){
+				if(is_rc){
+					release_value(r.backend, *existing, value_type);
+				}
+				m.erase(key.chars, key.hash);
+			}
+			inc_rc(dict.alloc);
+			return coll_value;
+		}
+		else{
+			//	Deep copy dict.
+			auto dict2 = alloc_dict_hash(r.backend.heap, type0);
+			auto& m = dict2.dict_hash_ptr->get_map_mut();
+			m = dict.get_map();
+			m.erase(key.chars, key.hash);
+
+			if(is_rc){
+				for(const auto& e: m){
+					retain_value(r.backend, e.second, value_type);
+				}
+			}
+			return dict2;
+		}
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -262,8 +326,9 @@ static runtime_value_t floyd_llvm_intrinsic__get_keys(floyd_runtime_t* frp, runt
 	const auto& type0 = lookup_type_ref(r.backend, coll_type);
 	QUARK_ASSERT(peek2(types, type0).is_dict());
 
+	//	The keys are [string], that's a carray in soa mode too.
 	if(is_dict_cppmap(types, r.backend.config, type0)){
-		if(r.backend.config.vector_backend_mode == vector_backend::carray){
+		if(r.backend.config.vector_backend_mode == vector_backend::carray || r.backend.config.vector_backend_mode == vector_backend::soa){
 			return get_keys__cppmap_carray(r.backend, coll_value, coll_type);
 		}
 		else if(r.backend.config.vector_backend_mode == vector_backend::hamt){
@@ -275,7 +340,7 @@ static runtime_value_t floyd_llvm_intrinsic__get_keys(floyd_runtime_t* frp, runt
 		}
 	}
 	else if(is_dict_hamt(types, r.backend.config, type0)){
-		if(r.backend.config.vector_backend_mode == vector_backend::carray){
+		if(r.backend.config.vector_backend_mode == vector_backend::carray || r.backend.config.vector_backend_mode == vector_backend::soa){
 			return get_keys__hamtmap_carray(r.backend, coll_value, coll_type);
 		}
 		else if(r.backend.config.vector_backend_mode == vector_backend::hamt){
@@ -286,6 +351,18 @@ static runtime_value_t floyd_llvm_intrinsic__get_keys(floyd_runtime_t* frp, runt
 			throw std::exception();
 		}
 	}
+	else if(is_dict_hash(types, r.backend.config, type0)){
+		if(r.backend.config.vector_backend_mode == vector_backend::carray || r.backend.config.vector_backend_mode == vector_backend::soa){
+			return get_keys__hashmap_carray(r.backend, coll_value, coll_type);
+		}
+		else if(r.backend.config.vector_backend_mode == vector_backend::hamt){
+			return get_keys__hashmap_hamt(r.backend, coll_value, coll_type);
+		}
+		else{
+			QUARK_ASSERT(false);
+			throw std::exception();
+		}
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -310,20 +387,24 @@ static uint32_t floyd_llvm_intrinsic__exists(floyd_runtime_t* frp, runtime_value
 
 	if(is_dict_cppmap(types, r.backend.config, type0)){
 		const auto& dict = unpack_dict_cppmap_arg(r.backend, coll_value, coll_type);
-		const auto key_string = from_runtime_string(r, value);
 
 		const auto& m = dict->get_map();
-		const auto it = m.find(key_string);
+		const auto it = m.find(make_string_key(value).chars);
 		return it != m.end() ? 1 : 0;
 	}
 	else if(is_dict_hamt(types, r.backend.config, type0)){
 		const auto& dict = *coll_value.dict_hamt_ptr;
-		const auto key_string = from_runtime_string(r, value);
 
 		const auto& m = dict.get_map();
-		const auto it = m.find(key_string);
+		const auto it = m.find(make_string_key(value));
 		return it != nullptr ? 1 : 0;
 	}
+	else if(is_dict_hash(types, r.backend.config, type0)){
+		const auto& dict = *coll_value.dict_hash_ptr;
+		const auto key = make_string_key(value);
+
+		return dict.get_map().find(key.chars, key.hash) != nullptr ? 1 : 0;
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -350,6 +431,9 @@ static int64_t floyd_llvm_intrinsic__find(floyd_runtime_t* frp, runtime_value_t
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type0)){
 		return find__hamt(r.backend, coll_value, coll_type, value, value_type);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type0)){
+		return find__soa(r.backend, coll_value, coll_type, value, value_type);
+	}
 	else{
 		//	No other types allowed.
 		UNSUPPORTED();
@@ -409,6 +493,85 @@ static runtime_value_t floyd_llvm_intrinsic__from_json(floyd_runtime_t* frp, JSO
 
 
 
+/////////////////////////////////////////		parallel_for_chunks()
+
+
+//	The Floyd callback may be tiny. Never split a chunk smaller than this.
+static const size_t k_parallel_min_grain = 256;
+
+//	Aim for this many chunks per thread so fast threads can steal from slow ones.
+static const size_t k_parallel_chunks_per_thread = 4;
+
+//	Marks the elements and context of a higher-order function shared before other threads get to see them.
+//	Only done when the work really goes to other threads: small inputs keep their cheap non-atomic RC.
+static void share_inputs(value_backend_t& backend, runtime_value_t elements_vec, runtime_type_t elements_vec_type, runtime_value_t context, runtime_type_t context_type){
+	share_value(backend, elements_vec, type_t(elements_vec_type));
+	share_value(backend, context, type_t(context_type));
+}
+
+//	Calls f(start, end) for consecutive chunks covering [0, count). Chunks run in parallel on the engine's thread
+//	team. Short inputs run on the calling thread without touching the team.
+//	Higher-order callbacks are pure by language rule, so they can run on any thread.
+//	share() is called before the first chunk goes to the team.
+template <typename SHARE, typename F> static void parallel_for_chunks(llvm_execution_engine_t& r, size_t count, const SHARE& share, const F& f){
+	if(count < k_parallel_min_grain * 2 || r.config.thread_count == 1){
+		if(count > 0){
+			f(size_t(0), count);
+		}
+		return;
+	}
+
+	share();
+	auto& team = get_thread_team(r);
+	const auto grain = std::max(k_parallel_min_grain, count / (team.thread_count * k_parallel_chunks_per_thread));
+	task_group_t group;
+	for(size_t start = 0 ; start < count ; start += grain){
+		const auto end = std::min(start + grain, count);
+		spawn_task(team, group, [&f, start, end](){ f(start, end); });
+	}
+	wait_for_tasks(team, group);
+}
+
+
+
+/////////////////////////////////////////		soa vectors
+
+
+//	In soa mode the backend of a vector depends on its element type: [int] is a carray, [pixel_t] is soa.
+//	Makes a carray or soa vector of vec_type from elements, taking over their references.
+static runtime_value_t alloc_vector_from_elements(value_backend_t& backend, const std::vector<runtime_value_t>& elements, type_t vec_type){
+	const auto count = elements.size();
+	if(is_vector_soa(backend.types, backend.config, vec_type)){
+		auto result = alloc_vector_soa(backend, elements.data(), count, vec_type);
+		const auto element_type = lookup_vector_element_type(backend, vec_type);
+		for(const auto& e: elements){
+			release_value(backend, e, element_type);
+		}
+		return result;
+	}
+	else{
+		QUARK_ASSERT(is_vector_carray(backend.types, backend.config, vec_type));
+
+		auto result = alloc_vector_carray(backend.heap, count, count, vec_type);
+		if(count > 0){
+			std::memcpy(result.vector_carray_ptr->get_element_ptr(), elements.data(), count * sizeof(runtime_value_t));
+		}
+		return result;
+	}
+}
+
+//	Calls f(i, element) for each element of an soa vector, with a temporary STRUCT_T for the element.
+template <typename F> static void for_each_soa_element(value_backend_t& backend, runtime_value_t vec, type_t vec_type, size_t start, size_t end, const F& f){
+	const auto element_type = lookup_vector_element_type(backend, vec_type);
+	for(auto i = start ; i < end ; i++){
+		const auto element = load_vector_soa_element(backend, vec, vec_type, i);
+		f(i, element);
+		release_value(backend, element, element_type);
+	}
+}
+
+
+
 /////////////////////////////////////////		map()
 
 
@@ -438,11 +601,27 @@ static runtime_value_t map__carray(floyd_runtime_t* frp, runtime_value_t element
 	const auto f = reinterpret_cast<MAP_F>(f_value.function_ptr);
 
 	const auto count = elements_vec.vector_carray_ptr->get_element_count();
-	auto result_vec = alloc_vector_carray(backend.heap, count, count, type_t(result_vec_type));
-	for(int i = 0 ; i < count ; i++){
-		const auto a = (*f)(frp, elements_vec.vector_carray_ptr->get_element_ptr()[i], context_value);
-		result_vec.vector_carray_ptr->get_element_ptr()[i] = a;
+	if(is_vector_soa(types, backend.config, type_t(result_vec_type))){
+		std::vector<runtime_value_t> results(count);
+		const auto source = elements_vec.vector_carray_ptr->get_element_ptr();
+		const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context_value, context_type); };
+		parallel_for_chunks(r, count, share, [&](size_t start, size_t end){
+			for(auto i = start ; i < end ; i++){
+				results[i] = (*f)(frp, source[i], context_value);
+			}
+		});
+		return alloc_vector_from_elements(backend, results, type_t(result_vec_type));
 	}
+
+	auto result_vec = alloc_vector_carray(backend.heap, count, count, type_t(result_vec_type));
+	const auto source = elements_vec.vector_carray_ptr->get_element_ptr();
+	const auto dest = result_vec.vector_carray_ptr->get_element_ptr();
+	const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context_value, context_type); };
+	parallel_for_chunks(r, count, share, [&](size_t start, size_t end){
+		for(auto i = start ; i < end ; i++){
+			dest[i] = (*f)(frp, source[i], context_value);
+		}
+	});
 	return result_vec;
 }
 //??? Update 1 element in a big hamt will copy the entire hamt, inc RC on all elements in hamt2. This is not needed since most of hamt is shared. Cheaper if we build in RC for leaf in the hamt itself.
@@ -466,14 +645,37 @@ static runtime_value_t map__hamt(floyd_runtime_t* frp, runtime_value_t elements_
 
 	const auto f = reinterpret_cast<MAP_F>(f_value.function_ptr);
 
-	const auto count = elements_vec.vector_hamt_ptr->get_element_count();
-	auto result_vec = alloc_vector_hamt(backend.heap, count, count, type_t(result_vec_type));
-	for(int i = 0 ; i < count ; i++){
-		const auto& element = elements_vec.vector_hamt_ptr->load_element(i);
-		const auto a = (*f)(frp, element, context_value);
-		result_vec.vector_hamt_ptr->store_mutate(i, a);
-	}
-	return result_vec;
+	//	The HAMT can't be written from several threads: collect the results in an array first.
+	const auto& source = elements_vec.vector_hamt_ptr->get_vecref();
+	const auto count = source.size();
+	std::vector<runtime_value_t> results(count);
+	const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context_value, context_type); };
+	parallel_for_chunks(r, count, share, [&](size_t start, size_t end){
+		auto it = source.begin() + start;
+		for(auto i = start ; i < end ; i++, it++){
+			results[i] = (*f)(frp, it->value, context_value);
+		}
+	});
+	return alloc_vector_hamt(backend.heap, results.data(), count, type_t(result_vec_type));
+}
+
+static runtime_value_t map__soa(floyd_runtime_t* frp, runtime_value_t elements_vec, runtime_type_t elements_vec_type, runtime_value_t f_value, runtime_type_t f_type, runtime_value_t context_value, runtime_type_t context_type, runtime_type_t result_vec_type){
+	auto& r = get_floyd_runtime(frp);
+	auto& backend = r.backend;
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(elements_vec_type)));
+
+	const auto f = reinterpret_cast<MAP_F>(f_value.function_ptr);
+
+	const auto count = elements_vec.vector_soa_ptr->get_element_count();
+	std::vector<runtime_value_t> results(count);
+	const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context_value, context_type); };
+	parallel_for_chunks(r, count, share, [&](size_t start, size_t end){
+		for_each_soa_element(backend, elements_vec, type_t(elements_vec_type), start, end, [&](size_t i, runtime_value_t e){
+			results[i] = (*f)(frp, e, context_value);
+		});
+	});
+	return alloc_vector_from_elements(backend, results, type_t(result_vec_type));
 }
 
 //	[R] map([E] elements, func R (E e, C context) f, C context)
@@ -500,7 +702,8 @@ static std::vector<specialization_t> make_map_specializations(llvm::LLVMContext&
 		specialization_t { eresolved_type::k_vector_carray_pod,		{ "map_carray_pod", function_type, reinterpret_cast<void*>(map__carray) } },
 		specialization_t { eresolved_type::k_vector_carray_nonpod,	{ "map_carray_nonpod", function_type, reinterpret_cast<void*>(map__carray) } },
 		specialization_t { eresolved_type::k_vector_hamt_pod,		{ "map_hamt_pod", function_type, reinterpret_cast<void*>(map__hamt) } },
-		specialization_t { eresolved_type::k_vector_hamt_nonpod, 	{ "map_hamt_nonpod", function_type, reinterpret_cast<void*>(map__hamt) } }
+		specialization_t { eresolved_type::k_vector_hamt_nonpod, 	{ "map_hamt_nonpod", function_type, reinterpret_cast<void*>(map__hamt) } },
+		specialization_t { eresolved_type::k_vector_soa,			{ "map_soa", function_type, reinterpret_cast<void*>(map__soa) } }
 	};
 }
 
@@ -594,7 +797,151 @@ static runtime_value_t floyd_llvm_intrinsic__map_string(floyd_runtime_t* frp, ru
 
 typedef runtime_value_t (*map_dag_F)(floyd_runtime_t* frp, runtime_value_t r_value, runtime_value_t r_vec_value, runtime_value_t context_value);
 
-//??? optimize prio 2
+//	Ready elements are handed to the thread team in chunks of this many.
+static const size_t k_map_dag_ready_chunk = 64;
+
+/*
+	Runs map_dag() on the engine's thread team.
+
+	inputs / input_offsets is an adjacency list: the inputs of element e are
+	inputs[input_offsets[e] .. input_offsets[e + 1]), in element order. Each element has an atomic count of unfinished
+	inputs. The thread that completes an element's last input runs that element next, no rescanning of parents.
+
+	make_inputs_vec() makes the [R] passed to f, holding the input results *without* retaining them.
+	dispose_inputs_vec() releases just the vec, **not the elements**.
+
+	The elements and context are shared before the team starts. A result is only handed to the thread running its
+	parent after its own thread is done with it, so results can stay local.
+*/
+template <typename MAKE_INPUTS_VEC, typename DISPOSE_INPUTS_VEC, typename SHARE>
+static std::vector<runtime_value_t> run_map_dag(
+	floyd_runtime_t* frp,
+	const std::vector<runtime_value_t>& elements,
+	const std::vector<int64_t>& parents,
+	map_dag_F f,
+	runtime_value_t context,
+	type_t r_type,
+	const MAKE_INPUTS_VEC& make_inputs_vec,
+	const DISPOSE_INPUTS_VEC& dispose_inputs_vec,
+	const SHARE& share
+){
+	auto& r = get_floyd_runtime(frp);
+	auto& backend = r.backend;
+
+	const auto count = elements.size();
+	if(parents.size() != count) {
+		quark::throw_runtime_error("map_dag() requires elements and parents be the same count.");
+	}
+
+	std::vector<size_t> input_offsets(count + 1, 0);
+	for(const auto parent_index: parents){
+		if(parent_index < -1 || parent_index >= static_cast<int64_t>(count)){
+			quark::throw_runtime_error("map_dag() parent index out of range.");
+		}
+		if(parent_index != -1){
+			input_offsets[parent_index + 1]++;
+		}
+	}
+	for(size_t i = 0 ; i < count ; i++){
+		input_offsets[i + 1] += input_offsets[i];
+	}
+	std::vector<size_t> inputs(input_offsets[count]);
+	{
+		auto write_pos = input_offsets;
+		for(size_t i = 0 ; i < count ; i++){
+			const auto parent_index = parents[i];
+			if(parent_index != -1){
+				inputs[write_pos[parent_index]++] = i;
+			}
+		}
+	}
+
+	std::unique_ptr<std::atomic<int64_t>[]> pending_inputs(new std::atomic<int64_t>[count]);
+	std::vector<size_t> ready;
+	for(size_t i = 0 ; i < count ; i++){
+		const auto input_count = input_offsets[i + 1] - input_offsets[i];
+		pending_inputs[i].store(input_count, std::memory_order_relaxed);
+		if(input_count == 0){
+			ready.push_back(i);
+		}
+	}
+
+	std::vector<runtime_value_t> complete(count, runtime_value_t());
+	std::vector<uint8_t> done(count, 0);
+
+	//	Runs element_index, then keeps going up the chain of parents as long as this thread completed their last input.
+	const auto run_element_chain = [&](size_t element_index){
+		while(true){
+			std::vector<runtime_value_t> solved_deps;
+			for(auto i = input_offsets[element_index] ; i < input_offsets[element_index + 1] ; i++){
+				QUARK_ASSERT(done[inputs[i]] == 1);
+				solved_deps.push_back(complete[inputs[i]]);
+			}
+
+			const auto solved_deps2 = make_inputs_vec(solved_deps);
+			runtime_value_t result1;
+			try {
+				result1 = (*f)(frp, elements[element_index], solved_deps2, context);
+			}
+			catch(...){
+				dispose_inputs_vec(solved_deps2);
+				throw;
+			}
+			dispose_inputs_vec(solved_deps2);
+
+			complete[element_index] = result1;
+			done[element_index] = 1;
+
+			const auto parent_index = parents[element_index];
+			if(parent_index == -1 || pending_inputs[parent_index].fetch_sub(1, std::memory_order_acq_rel) != 1){
+				return;
+			}
+			element_index = parent_index;
+		}
+	};
+
+	share();
+	auto& team = get_thread_team(r);
+	task_group_t group;
+	for(size_t start = 0 ; start < ready.size() ; start += k_map_dag_ready_chunk){
+		const auto end = std::min(start + k_map_dag_ready_chunk, ready.size());
+		spawn_task(team, group, [&ready, &run_element_chain, start, end](){
+			for(auto i = start ; i < end ; i++){
+				run_element_chain(ready[i]);
+			}
+		});
+	}
+
+	//	On errors, the results made so far are never returned: release them.
+	const auto release_done = [&](){
+		if(is_rc_value(peek2(backend.types, r_type))){
+			for(size_t i = 0 ; i < count ; i++){
+				if(done[i] == 1){
+					release_value(backend, complete[i], r_type);
+				}
+			}
+		}
+	};
+
+	//	If f throws, the other tasks still finish. Their results are released here, then the error is rethrown.
+	try {
+		wait_for_tasks(team, group);
+	}
+	catch(...){
+		release_done();
+		throw;
+	}
+
+	//	Elements on a cycle never got all their inputs.
+	if(std::find(done.begin(), done.end(), 0) != done.end()){
+		release_done();
+		quark::throw_runtime_error("map_dag() dependency cycle error.");
+	}
+	return complete;
+}
+
+//	Also handles soa mode, where elements can be an soa vector and the result and the solved dependencies
+//	can be either soa or carray vectors depending on R.
 static runtime_value_t map_dag__carray(
 	floyd_runtime_t* frp,
 	value_backend_t& backend,
@@ -615,12 +962,9 @@ static runtime_value_t map_dag__carray(
 	const auto& type2 = lookup_type_ref(backend, f_value_type);
 //	QUARK_ASSERT(check_map_dag_func_type(type0, type1, type2, lookup_type_ref(backend, context_type)));
 
-	const auto& elements = elements_vec;
 #if DEBUG
 	const auto& e_type = peek2(types, type0).get_vector_element_type(types);
 #endif
-	const auto& parents = depends_on_vec;
-	const auto& f = f_value;
 	const auto& r_type = peek2(types, type2).get_function_return(types);
 
 	QUARK_ASSERT(e_type == peek2(types, type2).get_function_args(types)[0] && r_type == peek2(types, peek2(types, type2).get_function_args(types)[1]).get_vector_element_type(types));
@@ -630,99 +974,69 @@ static runtime_value_t map_dag__carray(
 
 	const auto return_type = make_vector(types, r_type);
 
-	const auto f2 = reinterpret_cast<map_dag_F>(f.function_ptr);
+	const auto f2 = reinterpret_cast<map_dag_F>(f_value.function_ptr);
 
-	const auto elements2 = elements.vector_carray_ptr;
-	const auto parents2 = parents.vector_carray_ptr;
+	const auto parents2 = depends_on_vec.vector_carray_ptr;
 
-	if(elements2->get_element_count() != parents2->get_element_count()) {
-		quark::throw_runtime_error("map_dag() requires elements and parents be the same count.");
-	}
-
-	auto elements_todo = elements2->get_element_count();
-	std::vector<int> rcs(elements2->get_element_count(), 0);
-
-	std::vector<runtime_value_t> complete(elements2->get_element_count(), runtime_value_t());
-
-	for(int i = 0 ; i < parents2->get_element_count() ; i++){
-		const auto& e = parents2->load_element(i);
-		const auto parent_index = e.int_value;
-
-		const auto count = static_cast<int64_t>(elements2->get_element_count());
-		QUARK_ASSERT(parent_index >= -1);
-		QUARK_ASSERT(parent_index < count);
-
-		if(parent_index != -1){
-			rcs[parent_index]++;
+	//	f gets soa elements as STRUCT_T:s. We own them until map_dag is done.
+	const auto elements_are_soa = is_vector_soa(types, backend.config, type0);
+	std::vector<runtime_value_t> elements;
+	if(elements_are_soa){
+		for(uint64_t i = 0 ; i < elements_vec.vector_soa_ptr->get_element_count() ; i++){
+			elements.push_back(load_vector_soa_element(backend, elements_vec, type0, i));
 		}
 	}
-
-	while(elements_todo > 0){
-		//	Find all elements that are free to process -- they are not blocked on a depenency.
-		std::vector<int> pass_ids;
-		for(int i = 0 ; i < elements2->get_element_count() ; i++){
-			const auto rc = rcs[i];
-			if(rc == 0){
-				pass_ids.push_back(i);
-				rcs[i] = -1;
+	else{
+		const auto elements2 = elements_vec.vector_carray_ptr;
+		elements.assign(elements2->get_element_ptr(), elements2->get_element_ptr() + elements2->get_element_count());
+	}
+	const auto release_elements = [&](){
+		if(elements_are_soa){
+			for(const auto& e: elements){
+				release_value(backend, e, lookup_vector_element_type(backend, type0));
 			}
 		}
-		if(pass_ids.empty()){
-			quark::throw_runtime_error("map_dag() dependency cycle error.");
-		}
-
-		for(const auto element_index: pass_ids){
-			const auto& e = elements2->load_element(element_index);
+	};
 
-			//	Make list of the element's inputs -- they must all be complete now.
-			std::vector<runtime_value_t> solved_deps;
-			for(int element_index2 = 0 ; element_index2 < parents2->get_element_count() ; element_index2++){
-				const auto& p = parents2->load_element(element_index2);
-				const auto parent_index = p.int_value;
-				if(parent_index == element_index){
-					QUARK_ASSERT(element_index2 != -1);
-					QUARK_ASSERT(element_index2 >= -1 && element_index2 < elements2->get_element_count());
-					QUARK_ASSERT(rcs[element_index2] == -1);
-
-					const auto& solved = complete[element_index2];
-					solved_deps.push_back(solved);
+	std::vector<int64_t> parents;
+	for(int i = 0 ; i < parents2->get_element_count() ; i++){
+		parents.push_back(parents2->load_element(i).int_value);
+	}
+
+	const auto r_is_rc = is_rc_value(peek2(types, r_type));
+	std::vector<runtime_value_t> complete;
+	try {
+		complete = run_map_dag(
+			frp,
+			elements,
+			parents,
+			f2,
+			context,
+			r_type,
+			[&](const std::vector<runtime_value_t>& solved_deps){
+				//	The vector owns its elements, run_map_dag() keeps its own references.
+				if(r_is_rc){
+					for(const auto& e: solved_deps){
+						retain_value(backend, e, r_type);
+					}
 				}
-			}
-
-			auto solved_deps2 = alloc_vector_carray(backend.heap, solved_deps.size(), solved_deps.size(), return_type);
-			for(int i = 0 ; i < solved_deps.size() ; i++){
-				solved_deps2.vector_carray_ptr->store(i, solved_deps[i]);
-			}
-			runtime_value_t solved_deps3 = solved_deps2;
-
-			const auto result1 = (*f2)(frp, e, solved_deps3, context);
-
-			//	Release just the vec, **not the elements**. The elements are aliases for complete-vector.
-			if(dec_rc(solved_deps2.vector_carray_ptr->alloc) == 0){
-				dispose_vector_carray(solved_deps2);
-			}
-
-			const auto parent_index = parents2->load_element(element_index).int_value;
-			if(parent_index != -1){
-				rcs[parent_index]--;
-			}
-			complete[element_index] = result1;
-			elements_todo--;
-		}
+				return alloc_vector_from_elements(backend, solved_deps, return_type);
+			},
+			[&](runtime_value_t solved_deps2){
+				release_vec(backend, solved_deps2, return_type);
+			},
+			[&](){ share_inputs(backend, elements_vec, elements_vec_type, context, context_type); }
+		);
 	}
-
-	//??? No need to copy all elements -- could store them directly into the VEC_T.
-	const auto count = complete.size();
-	auto result_vec = alloc_vector_carray(backend.heap, count, count, return_type);
-	for(int i = 0 ; i < count ; i++){
-//		retain_value(r, complete[i], r_type);
-		result_vec.vector_carray_ptr->store(i, complete[i]);
+	catch(...){
+		release_elements();
+		throw;
 	}
+	release_elements();
 
-	return result_vec;
+	return alloc_vector_from_elements(backend, complete, return_type);
 }
 
-//??? optimize prio 2
 static runtime_value_t map_dag__hamt(
 	floyd_runtime_t* frp,
 	value_backend_t& backend,
@@ -744,12 +1058,9 @@ static runtime_value_t map_dag__hamt(
 	const auto& type2 = lookup_type_ref(backend, f_value_type);
 //	QUARK_ASSERT(check_map_dag_func_type(type0, type1, type2, lookup_type_ref(backend, context_type)));
 
-	const auto& elements = elements_vec;
 #if DEBUG
 	const auto& e_type = peek2(types, type0).get_vector_element_type(types);
 #endif
-	const auto& parents = depends_on_vec;
-	const auto& f = f_value;
 	const auto& r_type = peek2(types, type2).get_function_return(types);
 
 	QUARK_ASSERT(e_type == peek2(types, type2).get_function_args(types)[0] && r_type == peek2(types, peek2(types, type2).get_function_args(types)[1]).get_vector_element_type(types));
@@ -759,97 +1070,41 @@ static runtime_value_t map_dag__hamt(
 
 	const auto return_type = make_vector(types, r_type);
 
-	const auto f2 = reinterpret_cast<map_dag_F>(f.function_ptr);
+	const auto f2 = reinterpret_cast<map_dag_F>(f_value.function_ptr);
 
-	const auto elements2 = elements.vector_hamt_ptr;
-	const auto parents2 = parents.vector_hamt_ptr;
+	const auto elements2 = elements_vec.vector_hamt_ptr;
+	const auto parents2 = depends_on_vec.vector_hamt_ptr;
 
-	if(elements2->get_element_count() != parents2->get_element_count()) {
-		quark::throw_runtime_error("map_dag() requires elements and parents be the same count.");
+	std::vector<runtime_value_t> elements;
+	for(const auto& e: *elements2){
+		elements.push_back(e.value);
 	}
-
-	auto elements_todo = elements2->get_element_count();
-	std::vector<int> rcs(elements2->get_element_count(), 0);
-
-	std::vector<runtime_value_t> complete(elements2->get_element_count(), runtime_value_t());
-
-	for(int i = 0 ; i < parents2->get_element_count() ; i++){
-		const auto& e = parents2->load_element(i);
-		const auto parent_index = e.int_value;
-
-		//??? remove cast? static_cast<int64_t>()
-		const auto count = static_cast<int64_t>(elements2->get_element_count());
-		QUARK_ASSERT(parent_index >= -1);
-		QUARK_ASSERT(parent_index < count);
-
-		if(parent_index != -1){
-			rcs[parent_index]++;
-		}
+	std::vector<int64_t> parents;
+	for(const auto& e: *parents2){
+		parents.push_back(e.value.int_value);
 	}
 
-	while(elements_todo > 0){
-		//	Find all elements that are free to process -- they are not blocked on a depenency.
-		std::vector<int> pass_ids;
-		for(int i = 0 ; i < elements2->get_element_count() ; i++){
-			const auto rc = rcs[i];
-			if(rc == 0){
-				pass_ids.push_back(i);
-				rcs[i] = -1;
-			}
-		}
-		if(pass_ids.empty()){
-			quark::throw_runtime_error("map_dag() dependency cycle error.");
-		}
-
-		for(const auto element_index: pass_ids){
-			const auto& e = elements2->load_element(element_index);
-
-			//	Make list of the element's inputs -- they must all be complete now.
-			std::vector<runtime_value_t> solved_deps;
-			for(int element_index2 = 0 ; element_index2 < parents2->get_element_count() ; element_index2++){
-				const auto& p = parents2->load_element(element_index2);
-				const auto parent_index = p.int_value;
-				if(parent_index == element_index){
-					QUARK_ASSERT(element_index2 != -1);
-					QUARK_ASSERT(element_index2 >= -1 && element_index2 < elements2->get_element_count());
-					QUARK_ASSERT(rcs[element_index2] == -1);
-
-					const auto& solved = complete[element_index2];
-					solved_deps.push_back(solved);
-				}
-			}
-
-			auto solved_deps2 = alloc_vector_hamt(backend.heap, solved_deps.size(), solved_deps.size(), return_type);
-			for(int i = 0 ; i < solved_deps.size() ; i++){
-				solved_deps2.vector_hamt_ptr->store_mutate(i, solved_deps[i]);
-			}
-			runtime_value_t solved_deps3 = solved_deps2;
-
-			const auto result1 = (*f2)(frp, e, solved_deps3, context);
-
-			//	Release just the vec, **not the elements**. The elements are aliases for complete-vector.
-			if(dec_rc(solved_deps2.vector_hamt_ptr->alloc) == 0){
-				dispose_vector_hamt(solved_deps2);
-			}
-
-			const auto parent_index = parents2->load_element(element_index).int_value;
-			if(parent_index != -1){
-				rcs[parent_index]--;
+	const auto complete = run_map_dag(
+		frp,
+		elements,
+		parents,
+		f2,
+		context,
+		r_type,
+		[&](const std::vector<runtime_value_t>& solved_deps){
+			//	The vector owns its elements, run_map_dag() keeps its own references.
+			for(const auto& e: solved_deps){
+				retain_value(backend, e, r_type);
 			}
-			complete[element_index] = result1;
-			elements_todo--;
-		}
-	}
-
-	//??? No need to copy all elements -- could store them directly into the VEC_T.
-	const auto count = complete.size();
-	auto result_vec = alloc_vector_hamt(backend.heap, count, count, return_type);
-	for(int i = 0 ; i < count ; i++){
-//		retain_value(r, complete[i], r_type);
-		result_vec.vector_hamt_ptr->store_mutate(i, complete[i]);
-	}
+			return alloc_vector_hamt(backend.heap, solved_deps.data(), solved_deps.size(), return_type);
+		},
+		[&](runtime_value_t solved_deps2){
+			release_vec(backend, solved_deps2, return_type);
+		},
+		[&](){ share_inputs(backend, elements_vec, elements_vec_type, context, context_type); }
+	);
 
-	return result_vec;
+	return alloc_vector_hamt(backend.heap, complete.data(), complete.size(), return_type);
 }
 
 // ??? optimize prio 1: check type at compile time, not runtime.
@@ -868,7 +1123,7 @@ static runtime_value_t floyd_llvm_intrinsic__map_dag(
 	auto& r = get_floyd_runtime(frp);
 
 	const auto& type0 = lookup_type_ref(r.backend, elements_vec_type);
-	if(is_vector_carray(r.backend.types, r.backend.config, type_t(elements_vec_type))){
+	if(is_vector_carray(r.backend.types, r.backend.config, type_t(elements_vec_type)) || is_vector_soa(r.backend.types, r.backend.config, type_t(elements_vec_type))){
 		return map_dag__carray(frp, r.backend, elements_vec, elements_vec_type, depends_on_vec, depends_on_vec_type, f_value, f_value_type, context, context_type);
 	}
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(elements_vec_type))){
@@ -888,6 +1143,33 @@ static runtime_value_t floyd_llvm_intrinsic__map_dag(
 
 typedef runtime_value_t (*FILTER_F)(floyd_runtime_t* frp, runtime_value_t element_value, runtime_value_t context);
 
+//	Returns the kept elements in order, each retained once. Chunks are filtered in parallel then concatenated.
+template <typename LOAD_ELEMENT, typename SHARE> static std::vector<runtime_value_t> filter_elements(floyd_runtime_t* frp, size_t count, const LOAD_ELEMENT& load_element, const SHARE& share, FILTER_F f, runtime_value_t context, type_t element_type){
+	auto& r = get_floyd_runtime(frp);
+	const auto is_rc = is_rc_value(peek2(r.backend.types, element_type));
+
+	std::vector<uint8_t> keep_flags(count, 0);
+	parallel_for_chunks(r, count, share, [&](size_t start, size_t end){
+		for(auto i = start ; i < end ; i++){
+			const auto keep = (*f)(frp, load_element(i), context);
+			keep_flags[i] = keep.bool_value != 0 ? 1 : 0;
+		}
+	});
+
+	std::vector<runtime_value_t> acc;
+	for(size_t i = 0 ; i < count ; i++){
+		if(keep_flags[i] != 0){
+			const auto element_value = load_element(i);
+			acc.push_back(element_value);
+
+			if(is_rc){
+				retain_value(r.backend, element_value, element_type);
+			}
+		}
+	}
+	return acc;
+}
+
 //??? optimize prio 1
 static runtime_value_t filter__carray(floyd_runtime_t* frp, value_backend_t& backend, runtime_value_t elements_vec, runtime_type_t elements_vec_type, runtime_value_t f_value, runtime_type_t f_value_type, runtime_value_t context, runtime_type_t context_type){
 	QUARK_ASSERT(backend.check_invariant());
@@ -909,20 +1191,8 @@ static runtime_value_t filter__carray(floyd_runtime_t* frp, value_backend_t& bac
 
 	const auto e_element_itype = lookup_vector_element_type(backend, type_t(elements_vec_type));
 
-	std::vector<runtime_value_t> acc;
-	for(int i = 0 ; i < count ; i++){
-		const auto element_value = vec.get_element_ptr()[i];
-		const auto keep = (*f)(frp, element_value, context);
-		if(keep.bool_value != 0){
-			acc.push_back(element_value);
-
-			if(is_rc_value(peek2(r.backend.types, e_element_itype))){
-				retain_value(r.backend, element_value, e_element_itype);
-			}
-		}
-		else{
-		}
-	}
+	const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context, context_type); };
+	auto acc = filter_elements(frp, count, [&](size_t i){ return vec.get_element_ptr()[i]; }, share, f, context, e_element_itype);
 
 	const auto count2 = acc.size();
 	auto result_vec = alloc_vector_carray(r.backend.heap, count2, count2, return_type);
@@ -955,26 +1225,45 @@ static runtime_value_t filter__hamt(floyd_runtime_t* frp, value_backend_t& backe
 
 	const auto e_element_itype = lookup_vector_element_type(backend, type_t(elements_vec_type));
 
-	std::vector<runtime_value_t> acc;
-	for(int i = 0 ; i < count ; i++){
-		const auto element_value = vec.load_element(i);
-		const auto keep = (*f)(frp, element_value, context);
-		if(keep.bool_value != 0){
-			acc.push_back(element_value);
-
-			if(is_rc_value(peek2(r.backend.types, e_element_itype))){
-				retain_value(r.backend, element_value, e_element_itype);
-			}
-		}
-		else{
-		}
-	}
+	const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context, context_type); };
+	auto acc = filter_elements(frp, count, [&](size_t i){ return vec.load_element(i); }, share, f, context, e_element_itype);
 
 	const auto count2 = acc.size();
 	auto result_vec = alloc_vector_hamt(r.backend.heap, &acc[0], count2, return_type);
 	return result_vec;
 }
 
+//	Only f sees STRUCT_T:s. The kept rows are copied column by column.
+static runtime_value_t filter__soa(floyd_runtime_t* frp, value_backend_t& backend, runtime_value_t elements_vec, runtime_type_t elements_vec_type, runtime_value_t f_value, runtime_type_t f_value_type, runtime_value_t context, runtime_type_t context_type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(elements_vec_type)));
+
+	auto& r = get_floyd_runtime(frp);
+
+	const auto& vec = *elements_vec.vector_soa_ptr;
+	const auto f = reinterpret_cast<FILTER_F>(f_value.function_ptr);
+	const auto count = vec.get_element_count();
+
+	std::vector<uint8_t> keep_flags(count, 0);
+	const auto share = [&](){ share_inputs(backend, elements_vec, elements_vec_type, context, context_type); };
+	parallel_for_chunks(r, count, share, [&](size_t start, size_t end){
+		for_each_soa_element(backend, elements_vec, type_t(elements_vec_type), start, end, [&](size_t i, runtime_value_t e){
+			keep_flags[i] = (*f)(frp, e, context).bool_value != 0 ? 1 : 0;
+		});
+	});
+
+	const auto count2 = std::count(keep_flags.begin(), keep_flags.end(), 1);
+	auto result_vec = alloc_vector_soa(backend.heap, count2, count2, vec.get_member_count(), type_t(elements_vec_type));
+	uint64_t dest_index = 0;
+	for(uint64_t i = 0 ; i < count ; i++){
+		if(keep_flags[i] != 0){
+			copy_vector_soa_rows(*result_vec.vector_soa_ptr, dest_index, vec, i, 1);
+			dest_index++;
+		}
+	}
+	return result_vec;
+}
+
 //??? optimize prio 1: check type at compile time, not runtime.
 //	[E] filter([E] elements, func bool (E e, C context) f, C context)
 static runtime_value_t floyd_llvm_intrinsic__filter(floyd_runtime_t* frp, runtime_value_t elements_vec, runtime_type_t elements_vec_type, runtime_value_t f_value, runtime_type_t f_value_type, runtime_value_t arg2_value, runtime_type_t arg2_type){
@@ -987,6 +1276,9 @@ static runtime_value_t floyd_llvm_intrinsic__filter(floyd_runtime_t* frp, runtim
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(elements_vec_type))){
 		return filter__hamt(frp, r.backend, elements_vec, elements_vec_type, f_value, f_value_type, arg2_value, arg2_type);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(elements_vec_type))){
+		return filter__soa(frp, r.backend, elements_vec, elements_vec_type, f_value, f_value_type, arg2_value, arg2_type);
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -1063,6 +1355,27 @@ static runtime_value_t reduce__hamt(floyd_runtime_t* frp, value_backend_t& backe
 	return acc;
 }
 
+static runtime_value_t reduce__soa(floyd_runtime_t* frp, value_backend_t& backend, runtime_value_t elements_vec, runtime_type_t elements_vec_type, runtime_value_t init_value, runtime_type_t init_value_type, runtime_value_t f_value, runtime_type_t f_type, runtime_value_t context, runtime_type_t context_type){
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(elements_vec_type)));
+
+	const auto f = reinterpret_cast<REDUCE_F>(f_value.function_ptr);
+	const auto acc_is_rc = is_rc_value(peek2(backend.types, type_t(init_value_type)));
+
+	runtime_value_t acc = init_value;
+	retain_value(backend, acc, type_t(init_value_type));
+
+	const auto count = elements_vec.vector_soa_ptr->get_element_count();
+	for_each_soa_element(backend, elements_vec, type_t(elements_vec_type), 0, count, [&](size_t i, runtime_value_t e){
+		const auto acc2 = (*f)(frp, acc, e, context);
+		if(acc_is_rc){
+			release_value(backend, acc, type_t(init_value_type));
+		}
+		acc = acc2;
+	});
+	return acc;
+}
+
 //	R reduce([E] elements, R accumulator_init, func R (R accumulator, E element, C context) f, C context)
 
 //??? optimize prio 1
@@ -1076,6 +1389,9 @@ static runtime_value_t floyd_llvm_intrinsic__reduce(floyd_runtime_t* frp, runtim
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(elements_vec_type))){
 		return reduce__hamt(frp, r.backend, elements_vec, elements_vec_type, init_value, init_value_type, f_value, f_type, context, context_type);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(elements_vec_type))){
+		return reduce__soa(frp, r.backend, elements_vec, elements_vec_type, init_value, init_value_type, f_value, f_type, context, context_type);
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -1089,7 +1405,104 @@ static runtime_value_t floyd_llvm_intrinsic__reduce(floyd_runtime_t* frp, runtim
 
 typedef uint8_t (*stable_sort_F)(floyd_runtime_t* frp, runtime_value_t left_value, runtime_value_t right_value, runtime_value_t context_value);
 
-//??? optimize prio 1
+//	Vectors shorter than this are sorted on the calling thread. Each sort thread gets at least k_parallel_sort_min_chunk elements.
+static const size_t k_parallel_sort_min_count = 1 << 16;
+static const size_t k_parallel_sort_min_chunk = 1 << 14;
+
+//	Calls the Floyd less-function directly on the runtime_value_t:s, no conversion to value_t.
+struct sort_less_t {
+	bool operator() (const runtime_value_t& a, const runtime_value_t& b) const {
+		const uint8_t result = (*f)(frp, a, b, context);
+		return result == 1 ? true : false;
+	}
+
+	floyd_runtime_t* frp;
+	stable_sort_F f;
+	runtime_value_t context;
+};
+
+//	Runs job(0) .. job(job_count - 1) as tasks on the thread team and waits for all of them.
+//	Rethrows the first exception after every job has finished.
+template <typename JOB> static void run_sort_jobs(thread_team_t& team, size_t job_count, const JOB& job){
+	task_group_t group;
+	for(size_t i = 0 ; i < job_count ; i++){
+		spawn_task(team, group, [&job, i](){ job(i); });
+	}
+	wait_for_tasks(team, group);
+}
+
+//	Big inputs: stable_sort() one chunk per team thread then merge neighbouring runs pairwise, in parallel.
+//	std::merge() picks from the left run on ties so the result is still stable.
+//	The less-function is pure so it's safe to call from several threads at once.
+//	share() is called before going parallel.
+template <typename SHARE> static void stable_sort_elements(llvm_execution_engine_t& r, std::vector<runtime_value_t>& elements, const sort_less_t& less, const SHARE& share){
+	const auto count = elements.size();
+	if(count < k_parallel_sort_min_count || r.config.thread_count == 1){
+		std::stable_sort(elements.begin(), elements.end(), less);
+		return;
+	}
+
+	auto& team = get_thread_team(r);
+	const auto thread_count = std::min<size_t>(team.thread_count, count / k_parallel_sort_min_chunk);
+	if(thread_count < 2){
+		std::stable_sort(elements.begin(), elements.end(), less);
+		return;
+	}
+
+	share();
+
+	//	Run i is [bounds[i], bounds[i + 1]).
+	std::vector<size_t> bounds;
+	for(size_t i = 0 ; i <= thread_count ; i++){
+		bounds.push_back(count * i / thread_count);
+	}
+
+	run_sort_jobs(team, thread_count, [&](size_t i){
+		std::stable_sort(elements.begin() + bounds[i], elements.begin() + bounds[i + 1], less);
+	});
+
+	std::vector<runtime_value_t> temp(count);
+	auto source = &elements;
+	auto dest = &temp;
+	while(bounds.size() > 2){
+		const auto run_count = bounds.size() - 1;
+
+		//	An odd run out is merged with an empty run = copied as-is.
+		run_sort_jobs(team, (run_count + 1) / 2, [&](size_t pair_index){
+			const auto a = bounds[pair_index * 2 + 0];
+			const auto mid = bounds[pair_index * 2 + 1];
+			const auto b = bounds[std::min(pair_index * 2 + 2, run_count)];
+			std::merge(
+				source->begin() + a, source->begin() + mid,
+				source->begin() + mid, source->begin() + b,
+				dest->begin() + a,
+				less
+			);
+		});
+
+		std::vector<size_t> bounds2;
+		for(size_t i = 0 ; i < run_count ; i += 2){
+			bounds2.push_back(bounds[i]);
+		}
+		bounds2.push_back(count);
+		bounds.swap(bounds2);
+		std::swap(source, dest);
+	}
+
+	if(source != &elements){
+		elements.swap(temp);
+	}
+}
+
+//	The sorted vector gets its own RC on each element.
+static void retain_sorted_elements(value_backend_t& backend, const std::vector<runtime_value_t>& elements, runtime_type_t vec_type){
+	const auto element_type = lookup_vector_element_type(backend, type_t(vec_type));
+	if(is_rc_value(peek2(backend.types, element_type))){
+		for(const auto& e: elements){
+			retain_value(backend, e, element_type);
+		}
+	}
+}
 
 static runtime_value_t stable_sort__carray(
 	floyd_runtime_t* frp,
@@ -1113,39 +1526,23 @@ static runtime_value_t stable_sort__carray(
 //	QUARK_ASSERT(check_stable_sort_func_type(type0, type1, type2));
 	QUARK_ASSERT(is_vector_carray(types, backend.config, type_t(elements_vec_type)));
 
-	const auto& elements = elements_vec;
-	const auto& f = f_value;
-	const auto& context = context_value;
-
-	const auto elements2 = from_runtime_value2(backend, elements, type0);
-	const auto f2 = reinterpret_cast<stable_sort_F>(f.function_ptr);
-
-	struct sort_functor_r {
-		bool operator() (const value_t &a, const value_t &b) {
-			auto& r = get_floyd_runtime(frp);
-			const auto left = to_runtime_value(r, a);
-			const auto right = to_runtime_value(r, b);
-			uint8_t result = (*f)(frp, left, right, context);
-			return result == 1 ? true : false;
-		}
-
-		floyd_runtime_t* frp;
-		runtime_value_t context;
-		stable_sort_F f;
-	};
-
-	const sort_functor_r sort_functor { frp, context, f2 };
+	const auto& vec = *elements_vec.vector_carray_ptr;
+	const auto f = reinterpret_cast<stable_sort_F>(f_value.function_ptr);
 
-	auto mutate_inplace_elements = elements2.get_vector_value();
-	std::stable_sort(mutate_inplace_elements.begin(), mutate_inplace_elements.end(), sort_functor);
+	const auto count = vec.get_element_count();
+	std::vector<runtime_value_t> elements(vec.get_element_ptr(), vec.get_element_ptr() + count);
+	stable_sort_elements(get_floyd_runtime(frp), elements, sort_less_t { frp, f, context_value }, [&](){
+		share_inputs(backend, elements_vec, elements_vec_type, context_value, context_value_type);
+	});
+	retain_sorted_elements(backend, elements, elements_vec_type);
 
-	//??? optimize
-	const auto result = to_runtime_value2(backend, value_t::make_vector_value(types, peek2(types, type0).get_vector_element_type(types), mutate_inplace_elements));
-	return result;
+	auto result_vec = alloc_vector_carray(backend.heap, count, count, type0);
+	if(count > 0){
+		copy_elements(result_vec.vector_carray_ptr->get_element_ptr(), &elements[0], count);
+	}
+	return result_vec;
 }
 
-//??? optimize prio 1
-
 static runtime_value_t stable_sort__hamt(
 	floyd_runtime_t* frp,
 	value_backend_t& backend,
@@ -1168,35 +1565,51 @@ static runtime_value_t stable_sort__hamt(
 //	QUARK_ASSERT(check_stable_sort_func_type(type0, type1, type2));
 	QUARK_ASSERT(is_vector_hamt(types, backend.config, type_t(elements_vec_type)));
 
-	const auto& elements = elements_vec;
-	const auto& f = f_value;
-	const auto& context = context_value;
-
-	const auto elements2 = from_runtime_value2(backend, elements, type0);
-	const auto f2 = reinterpret_cast<stable_sort_F>(f.function_ptr);
+	const auto& vec = *elements_vec.vector_hamt_ptr;
+	const auto f = reinterpret_cast<stable_sort_F>(f_value.function_ptr);
 
-	struct sort_functor_r {
-		bool operator() (const value_t &a, const value_t &b) {
-			auto& r = get_floyd_runtime(frp);
-			const auto left = to_runtime_value(r, a);
-			const auto right = to_runtime_value(r, b);
-			uint8_t result = (*f)(frp, left, right, context);
-			return result == 1 ? true : false;
-		}
+	std::vector<runtime_value_t> elements;
+	elements.reserve(vec.get_element_count());
+	for(const auto& e: vec){
+		elements.push_back(e.value);
+	}
+	stable_sort_elements(get_floyd_runtime(frp), elements, sort_less_t { frp, f, context_value }, [&](){
+		share_inputs(backend, elements_vec, elements_vec_type, context_value, context_value_type);
+	});
+	retain_sorted_elements(backend, elements, elements_vec_type);
 
-		floyd_runtime_t* frp;
-		runtime_value_t context;
-		stable_sort_F f;
-	};
+	return alloc_vector_hamt(backend.heap, elements.data(), elements.size(), type0);
+}
 
-	const sort_functor_r sort_functor { frp, context, f2 };
+//	Sorts STRUCT_T:s made from the rows, then writes them back as rows of a new soa vector.
+static runtime_value_t stable_sort__soa(
+	floyd_runtime_t* frp,
+	value_backend_t& backend,
+	runtime_value_t elements_vec,
+	runtime_type_t elements_vec_type,
+	runtime_value_t f_value,
+	runtime_type_t f_value_type,
+	runtime_value_t context_value,
+	runtime_type_t context_value_type
+){
+	QUARK_ASSERT(frp != nullptr);
+	QUARK_ASSERT(backend.check_invariant());
+	QUARK_ASSERT(is_vector_soa(backend.types, backend.config, type_t(elements_vec_type)));
 
-	auto mutate_inplace_elements = elements2.get_vector_value();
-	std::stable_sort(mutate_inplace_elements.begin(), mutate_inplace_elements.end(), sort_functor);
+	const auto vec_type = type_t(elements_vec_type);
+	const auto f = reinterpret_cast<stable_sort_F>(f_value.function_ptr);
 
-	//??? optimize
-	const auto result = to_runtime_value2(backend, value_t::make_vector_value(types, peek2(types, type0).get_vector_element_type(types), mutate_inplace_elements));
-	return result;
+	std::vector<runtime_value_t> elements;
+	for(uint64_t i = 0 ; i < elements_vec.vector_soa_ptr->get_element_count() ; i++){
+		elements.push_back(load_vector_soa_element(backend, elements_vec, vec_type, i));
+	}
+	stable_sort_elements(get_floyd_runtime(frp), elements, sort_less_t { frp, f, context_value }, [&](){
+		share_inputs(backend, elements_vec, elements_vec_type, context_value, context_value_type);
+		for(const auto& e: elements){
+			share_value(backend, e, lookup_vector_element_type(backend, vec_type));
+		}
+	});
+	return alloc_vector_from_elements(backend, elements, vec_type);
 }
 
 //	[T] stable_sort([T] elements, bool less(T left, T right, C context), C context)
@@ -1221,6 +1634,9 @@ static runtime_value_t floyd_llvm_intrinsic__stable_sort(
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(elements_vec_type))){
 		return stable_sort__hamt(frp, r.backend, elements_vec, elements_vec_type, f_value, f_value_type, context_value, context_value_type);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(elements_vec_type))){
+		return stable_sort__soa(frp, r.backend, elements_vec, elements_vec_type, f_value, f_value_type, context_value, context_value_type);
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -1239,9 +1655,10 @@ void floyd_llvm_intrinsic__print(floyd_runtime_t* frp, runtime_value_t value, ru
 	auto& r = get_floyd_runtime(frp);
 
 	const auto s = gen_to_string(r, value, value_type);
-	printf("%s", s.c_str());
-
 	const auto lines = split_on_chars(seq_t(s), "\n");
+
+	std::lock_guard<std::mutex> lock(r.print_output_mutex);
+	printf("%s", s.c_str());
 	r._print_output = concat(r._print_output, lines);
 }
 
@@ -1255,6 +1672,9 @@ void floyd_llvm_intrinsic__print(floyd_runtime_t* frp, runtime_value_t value, ru
 //??? Expensive to push_back since all elements in vector needs their RC bumped!
 // Could specialize further, for vector_hamt<string>, vector_hamt<vector<x>> etc. But it's probably better to inline push_back() instead.
 
+//	The push_back functions take over vec's reference, like update(). If it is the only reference, the carray
+//	versions append in place, growing the allocation geometrically, so "a = push_back(a, x)" in a loop is O(n).
+
 static runtime_value_t push_back__string(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t vec_type, runtime_value_t element){
 	auto& r = get_floyd_runtime(frp);
 
@@ -1263,28 +1683,65 @@ static runtime_value_t push_back__string(floyd_runtime_t* frp, runtime_value_t v
 	QUARK_ASSERT(peek2(r.backend.types, type0).is_string());
 #endif
 
-	auto value = from_runtime_string(r, vec);
-	value.push_back((char)element.int_value);
-	const auto result2 = to_runtime_string(r, value);
-	return result2;
+	const auto size = get_vec_string_size(vec);
+	if(is_inline_string(vec)){
+		//	Inline strings have no alloc to take over. Stays inline up to k_inline_string_max characters.
+		std::string value(get_string_view(vec));
+		value.push_back((char)element.int_value);
+		return to_runtime_string(r, value);
+	}
+	else if(is_rc_unique(vec.vector_carray_ptr->alloc)){
+		const auto needed_allocation_count = size_to_allocation_blocks(size + 1);
+		auto vec2 = vec;
+		if(needed_allocation_count > vec.vector_carray_ptr->get_allocation_count()){
+			vec2 = grow_vector_carray(r.backend.heap, vec, needed_allocation_count, type_t(vec_type));
+		}
+		store_string_char(vec2, size, (char)element.int_value);
+		vec2.vector_carray_ptr->alloc.data[0] = size + 1;
+		return vec2;
+	}
+	else{
+		auto value = from_runtime_string(r, vec);
+		value.push_back((char)element.int_value);
+		const auto result2 = to_runtime_string(r, value);
+		release_vec(r.backend, vec, type_t(vec_type));
+		return result2;
+	}
+}
+
+//	Returns a vector with RC 1 and room for one more element. Takes over vec's reference.
+static runtime_value_t prepare_carray_push_back(value_backend_t& backend, runtime_value_t vec, runtime_type_t vec_type, bool nonpod){
+	const auto element_count = vec.vector_carray_ptr->get_element_count();
+	if(is_rc_unique(vec.vector_carray_ptr->alloc)){
+		if(element_count + 1 > vec.vector_carray_ptr->get_allocation_count()){
+			return grow_vector_carray(backend.heap, vec, element_count + 1, type_t(vec_type));
+		}
+		else{
+			return vec;
+		}
+	}
+	else{
+		auto v2 = alloc_vector_carray(backend.heap, element_count + 1, element_count, type_t(vec_type));
+		auto dest_ptr = v2.vector_carray_ptr->get_element_ptr();
+		std::memcpy(dest_ptr, vec.vector_carray_ptr->get_element_ptr(), element_count * sizeof(runtime_value_t));
+		if(nonpod){
+			type_t element_itype = lookup_vector_element_type(backend, type_t(vec_type));
+			for(int i = 0 ; i < element_count ; i++){
+				retain_value(backend, dest_ptr[i], element_itype);
+			}
+		}
+		release_vec(backend, vec, type_t(vec_type));
+		return v2;
+	}
 }
 
-//??? use memcpy()
 static runtime_value_t floydrt_push_back_carray_pod(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t vec_type, runtime_value_t element){
 	auto& r = get_floyd_runtime(frp);
-#if DEBUG
-	(void)r;
-#endif
-
-	const auto element_count = vec.vector_carray_ptr->get_element_count();
-	auto source_ptr = vec.vector_carray_ptr->get_element_ptr();
 
-	auto v2 = alloc_vector_carray(r.backend.heap, element_count + 1, element_count + 1, type_t(vec_type));
-	auto dest_ptr = v2.vector_carray_ptr->get_element_ptr();
-	for(int i = 0 ; i < element_count ; i++){
-		dest_ptr[i] = source_ptr[i];
-	}
-	dest_ptr[element_count] = element;
+	auto v2 = prepare_carray_push_back(r.backend, vec, vec_type, false);
+	const auto element_count = v2.vector_carray_ptr->get_element_count();
+	v2.vector_carray_ptr->store(element_count, element);
+	v2.vector_carray_ptr->alloc.data[0] = element_count + 1;
 	return v2;
 }
 
@@ -1292,43 +1749,72 @@ static runtime_value_t floydrt_push_back_carray_nonpod(floyd_runtime_t* frp, run
 	auto& r = get_floyd_runtime(frp);
 
 	type_t element_itype = lookup_vector_element_type(r.backend, type_t(vec_type));
-	const auto element_count = vec.vector_carray_ptr->get_element_count();
-	auto source_ptr = vec.vector_carray_ptr->get_element_ptr();
-
-	auto v2 = alloc_vector_carray(r.backend.heap, element_count + 1, element_count + 1, type_t(vec_type));
-	auto dest_ptr = v2.vector_carray_ptr->get_element_ptr();
-	for(int i = 0 ; i < element_count ; i++){
-		dest_ptr[i] = source_ptr[i];
-		retain_value(r.backend, dest_ptr[i], element_itype);
-	}
-	dest_ptr[element_count] = element;
-	retain_value(r.backend, dest_ptr[element_count], element_itype);
+	retain_value(r.backend, element, element_itype);
 
+	auto v2 = prepare_carray_push_back(r.backend, vec, vec_type, true);
+	const auto element_count = v2.vector_carray_ptr->get_element_count();
+	v2.vector_carray_ptr->store(element_count, element);
+	v2.vector_carray_ptr->alloc.data[0] = element_count + 1;
 	return v2;
 }
 
 static runtime_value_t floydrt_push_back_hamt_pod(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t vec_type, runtime_value_t element){
-#if DEBUG
 	auto& r = get_floyd_runtime(frp);
-	(void)r;
-#endif
 
-	return push_back_immutable(vec, element);
+	hamt_element_scope_t scope(r.backend, type_t(vec_type));
+
+	//	immer mutates its nodes in place when we move the only reference to them.
+	if(is_rc_unique(vec.vector_hamt_ptr->alloc)){
+		auto& vecref = vec.vector_hamt_ptr->get_vecref_mut();
+		vecref = std::move(vecref).push_back(hamt_element_t(element));
+		return vec;
+	}
+
+	const auto vec2 = push_back_immutable(vec, element);
+	release_vec(r.backend, vec, type_t(vec_type));
+	return vec2;
 }
 
+//	Only retains the new element: vec2 shares all nodes but the tail / last path with vec, which keep owning
+//	their elements. Constant number of RC changes per push_back().
 static runtime_value_t floydrt_push_back_hamt_nonpod(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t vec_type, runtime_value_t element){
 	auto& r = get_floyd_runtime(frp);
 
-	runtime_value_t vec2 = push_back_immutable(vec, element);
-	type_t element_itype = lookup_vector_element_type(r.backend, type_t(vec_type));
+	hamt_element_scope_t scope(r.backend, type_t(vec_type));
+	retain_value(r.backend, element, scope.element_type);
 
-	for(int i = 0 ; i < vec2.vector_hamt_ptr->get_element_count() ; i++){
-		const auto& value = vec2.vector_hamt_ptr->load_element(i);
-		retain_value(r.backend, value, element_itype);
+	if(is_rc_unique(vec.vector_hamt_ptr->alloc)){
+		auto& vecref = vec.vector_hamt_ptr->get_vecref_mut();
+		vecref = std::move(vecref).push_back(hamt_element_t(element));
+		return vec;
 	}
+
+	const auto vec2 = push_back_immutable(vec, element);
+	release_vec(r.backend, vec, type_t(vec_type));
 	return vec2;
 }
 
+//	Copies the members of element into a new row. Appends in place if vec is the only reference.
+static runtime_value_t floydrt_push_back_soa(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t vec_type, runtime_value_t element){
+	auto& r = get_floyd_runtime(frp);
+
+	const auto& soa = *vec.vector_soa_ptr;
+	const auto element_count = soa.get_element_count();
+	auto v2 = vec;
+	if(is_rc_unique(soa.alloc)){
+		if(element_count + 1 > soa.get_capacity()){
+			v2 = grow_vector_soa(r.backend.heap, vec, element_count + 1, type_t(vec_type));
+		}
+	}
+	else{
+		v2 = alloc_vector_soa(r.backend.heap, std::max(element_count * 2, (uint64_t)4), element_count, soa.get_member_count(), type_t(vec_type));
+		copy_vector_soa_rows(*v2.vector_soa_ptr, 0, soa, 0, element_count);
+		release_vec(r.backend, vec, type_t(vec_type));
+	}
+	store_vector_soa_element(r.backend, v2, type_t(vec_type), element_count, element);
+	v2.vector_soa_ptr->alloc.data[0] = element_count + 1;
+	return v2;
+}
 
 static std::vector<specialization_t> make_push_back_specializations(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
 	llvm::FunctionType* function_type = llvm::FunctionType::get(
@@ -1347,7 +1833,8 @@ static std::vector<specialization_t> make_push_back_specializations(llvm::LLVMCo
 		specialization_t { eresolved_type::k_vector_carray_pod,		{ "push_back_carray_pod", function_type, reinterpret_cast<void*>(floydrt_push_back_carray_pod) } },
 		specialization_t { eresolved_type::k_vector_carray_nonpod,	{ "push_back_carray_nonpod", function_type, reinterpret_cast<void*>(floydrt_push_back_carray_nonpod) } },
 		specialization_t { eresolved_type::k_vector_hamt_pod,		{ "push_back_hamt_pod", function_type, reinterpret_cast<void*>(floydrt_push_back_hamt_pod) } },
-		specialization_t { eresolved_type::k_vector_hamt_nonpod, 	{ "push_back_hamt_nonpod", function_type, reinterpret_cast<void*>(floydrt_push_back_hamt_nonpod) } }
+		specialization_t { eresolved_type::k_vector_hamt_nonpod, 	{ "push_back_hamt_nonpod", function_type, reinterpret_cast<void*>(floydrt_push_back_hamt_nonpod) } },
+		specialization_t { eresolved_type::k_vector_soa,			{ "push_back_soa", function_type, reinterpret_cast<void*>(floydrt_push_back_soa) } }
 	};
 }
 
@@ -1414,6 +1901,9 @@ static const runtime_value_t floyd_llvm_intrinsic__replace(floyd_runtime_t* frp,
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(elements_vec_type))){
 		return replace__hamt(r.backend, elements_vec, elements_vec_type, start, end, arg3_value, arg3_type);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(elements_vec_type))){
+		return replace__soa(r.backend, elements_vec, elements_vec_type, start, end, arg3_value, arg3_type);
+	}
 	else{
 		//	No other types allowed.
 		UNSUPPORTED();
@@ -1442,21 +1932,18 @@ static JSON_T* floyd_llvm_intrinsic__parse_json_script(floyd_runtime_t* frp, run
 /////////////////////////////////////////		send()
 
 
-//??? optimize prio 2
-
-static void floyd_llvm_intrinsic__send(floyd_runtime_t* frp, runtime_value_t process_id0, const JSON_T* message_json_ptr){
+//	The message is handed to the target process as-is: no serializing to json and no deep copy.
+static void floyd_llvm_intrinsic__send(floyd_runtime_t* frp, runtime_value_t process_id0, runtime_value_t message, runtime_type_t message_type0){
 	auto& r = get_floyd_runtime(frp);
 
-	QUARK_ASSERT(message_json_ptr != nullptr);
-
 	const auto& process_id = from_runtime_string(r, process_id0);
-	const auto& message_json = message_json_ptr->get_json();
+	const auto message_type = lookup_type_ref(r.backend, message_type0);
 
 	if(k_trace_process_messaging){
-		QUARK_TRACE_SS("send(\"" << process_id << "\"," << json_to_pretty_string(message_json) <<")");
+		QUARK_TRACE_SS("send(\"" << process_id << "\"," << json_to_pretty_string(value_to_ast_json(r.backend.types, from_runtime_value(r, message, message_type))) <<")");
 	}
 
-	r._handler->on_send(process_id, message_json);
+	r._handler->on_send(process_id, message, message_type);
 }
 
 
@@ -1474,7 +1961,7 @@ static int64_t size__string(floyd_runtime_t* frp, runtime_value_t vec, runtime_t
 	QUARK_ASSERT(peek2(r.backend.types, type0).is_string());
 #endif
 
-	return vec.vector_carray_ptr->get_element_count();
+	return get_vec_string_size(vec);
 }
 
 static int64_t size_vector_carray(floyd_runtime_t* frp, runtime_value_t collection, runtime_type_t collection_type){
@@ -1487,6 +1974,11 @@ static int64_t size_vector_hamt(floyd_runtime_t* frp, runtime_value_t collection
 	(void)r;
 	return collection.vector_hamt_ptr->get_element_count();
 }
+static int64_t size_vector_soa(floyd_runtime_t* frp, runtime_value_t collection, runtime_type_t collection_type){
+	auto& r = get_floyd_runtime(frp);
+	(void)r;
+	return collection.vector_soa_ptr->get_element_count();
+}
 static int64_t size_dict_cppmap(floyd_runtime_t* frp, runtime_value_t collection, runtime_type_t collection_type){
 	auto& r = get_floyd_runtime(frp);
 	(void)r;
@@ -1497,6 +1989,11 @@ static int64_t size_dict_hamt(floyd_runtime_t* frp, runtime_value_t collection,
 	(void)r;
 	return collection.dict_hamt_ptr->size();
 }
+static int64_t size_dict_hash(floyd_runtime_t* frp, runtime_value_t collection, runtime_type_t collection_type){
+	auto& r = get_floyd_runtime(frp);
+	(void)r;
+	return collection.dict_hash_ptr->size();
+}
 static int64_t size_json(floyd_runtime_t* frp, runtime_value_t collection, runtime_type_t collection_type){
 	auto& r = get_floyd_runtime(frp);
 	(void)r;
@@ -1553,11 +2050,14 @@ static std::vector<specialization_t> make_size_specializations(llvm::LLVMContext
 		specialization_t { eresolved_type::k_vector_carray_nonpod,		{ "size_vector_carray", function_type1, reinterpret_cast<void*>(size_vector_carray) } },
 		specialization_t { eresolved_type::k_vector_hamt_pod,			{ "size_vector_hamt", function_type1, reinterpret_cast<void*>(size_vector_hamt) } },
 		specialization_t { eresolved_type::k_vector_hamt_nonpod,		{ "size_vector_hamt", function_type1, reinterpret_cast<void*>(size_vector_hamt) } },
+		specialization_t { eresolved_type::k_vector_soa,				{ "size_vector_soa", function_type1, reinterpret_cast<void*>(size_vector_soa) } },
 
 		specialization_t { eresolved_type::k_dict_cppmap_pod,			{ "size_dict_cppmap", function_type2, reinterpret_cast<void*>(size_dict_cppmap) } },
 		specialization_t { eresolved_type::k_dict_cppmap_nonpod,		{ "size_dict_cppmap", function_type2, reinterpret_cast<void*>(size_dict_cppmap) } },
 		specialization_t { eresolved_type::k_dict_hamt_pod,				{ "size_dict_hamt", function_type2, reinterpret_cast<void*>(size_dict_hamt) } },
 		specialization_t { eresolved_type::k_dict_hamt_nonpod,			{ "size_dict_hamt", function_type2, reinterpret_cast<void*>(size_dict_hamt) } },
+		specialization_t { eresolved_type::k_dict_hash_pod,				{ "size_dict_hash", function_type2, reinterpret_cast<void*>(size_dict_hash) } },
+		specialization_t { eresolved_type::k_dict_hash_nonpod,			{ "size_dict_hash", function_type2, reinterpret_cast<void*>(size_dict_hash) } },
 
 		specialization_t { eresolved_type::k_json,						{ "size_json", function_type3, reinterpret_cast<void*>(size_json) } }
 	};
@@ -1601,6 +2101,9 @@ static const runtime_value_t floyd_llvm_intrinsic__subset(floyd_runtime_t* frp,
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(elements_vec_type))){
 		return subset__hamt(r.backend, elements_vec, elements_vec_type, start, end);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(elements_vec_type))){
+		return subset__soa(r.backend, elements_vec, elements_vec_type, start, end);
+	}
 	else{
 		//	No other types allowed.
 		UNSUPPORTED();
@@ -1804,6 +2307,41 @@ static const runtime_value_t update_dict_hamt_nonpod(floyd_runtime_t* frp, runti
 #endif
 	return update__dict_hamt(r.backend, coll_value, coll_type, key_value, value);
 }
+static const runtime_value_t update_dict_hash_pod(floyd_runtime_t* frp, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_type_t key_type, runtime_value_t value, runtime_type_t value_type){
+	auto& r = get_floyd_runtime(frp);
+
+#if DEBUG
+	const auto& type0 = lookup_type_ref(r.backend, coll_type);
+	const auto& type1 = lookup_type_ref(r.backend, key_type);
+	const auto& type2 = lookup_type_ref(r.backend, value_type);
+
+	QUARK_ASSERT(type0.check_invariant());
+	QUARK_ASSERT(type1.check_invariant());
+	QUARK_ASSERT(type2.check_invariant());
+	QUARK_ASSERT(peek2(r.backend.types, type1).is_string());
+#endif
+	return update__dict_hash(r.backend, coll_value, coll_type, key_value, value);
+}
+static const runtime_value_t update_dict_hash_nonpod(floyd_runtime_t* frp, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_type_t key_type, runtime_value_t value, runtime_type_t value_type){
+	auto& r = get_floyd_runtime(frp);
+
+#if DEBUG
+	const auto& type0 = lookup_type_ref(r.backend, coll_type);
+	const auto& type1 = lookup_type_ref(r.backend, key_type);
+	const auto& type2 = lookup_type_ref(r.backend, value_type);
+
+	QUARK_ASSERT(type0.check_invariant());
+	QUARK_ASSERT(type1.check_invariant());
+	QUARK_ASSERT(type2.check_invariant());
+	QUARK_ASSERT(peek2(r.backend.types, type1).is_string());
+#endif
+	return update__dict_hash(r.backend, coll_value, coll_type, key_value, value);
+}
+
+static const runtime_value_t update_vector_soa(floyd_runtime_t* frp, runtime_value_t coll_value, runtime_type_t coll_type, runtime_value_t key_value, runtime_type_t key_type, runtime_value_t value, runtime_type_t value_type){
+	auto& r = get_floyd_runtime(frp);
+	return update__vector_soa(r.backend, coll_value, coll_type, key_value, value);
+}
 
 static std::vector<specialization_t> make_update_specializations(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
 	llvm::FunctionType* function_type1 = llvm::FunctionType::get(
@@ -1844,13 +2382,16 @@ static std::vector<specialization_t> make_update_specializations(llvm::LLVMConte
 
 		specialization_t { eresolved_type::k_vector_carray_pod,			{ "update_vector_carray", function_type1, reinterpret_cast<void*>(update_vector_carray_pod) } },
 		specialization_t { eresolved_type::k_vector_carray_nonpod,		{ "update_vector_carray", function_type1, reinterpret_cast<void*>(update_vector_carray_nonpod) } },
-		specialization_t { eresolved_type::k_vector_hamt_pod,			{ "update_vector_hamt", function_type1, reinterpret_cast<void*>(update_vector_hamt_pod) } },
-		specialization_t { eresolved_type::k_vector_hamt_nonpod,		{ "update_vector_hamt", function_type1, reinterpret_cast<void*>(update_vector_hamt_nonpod) } },
+		specialization_t { eresolved_type::k_vector_hamt_pod,			{ "update_vector_hamt_pod", function_type1, reinterpret_cast<void*>(update_vector_hamt_pod) } },
+		specialization_t { eresolved_type::k_vector_hamt_nonpod,		{ "update_vector_hamt_nonpod", function_type1, reinterpret_cast<void*>(update_vector_hamt_nonpod) } },
+		specialization_t { eresolved_type::k_vector_soa,				{ "update_vector_soa", function_type1, reinterpret_cast<void*>(update_vector_soa) } },
 
 		specialization_t { eresolved_type::k_dict_cppmap_pod,			{ "update_dict_cppmap", function_type2, reinterpret_cast<void*>(update_dict_cppmap_pod) } },
 		specialization_t { eresolved_type::k_dict_cppmap_nonpod,		{ "update_dict_cppmap", function_type2, reinterpret_cast<void*>(update_dict_cppmap_nonpod) } },
 		specialization_t { eresolved_type::k_dict_hamt_pod,				{ "update_dict_hamt", function_type2, reinterpret_cast<void*>(update_dict_hamt_pod) } },
 		specialization_t { eresolved_type::k_dict_hamt_nonpod,			{ "update_dict_hamt", function_type2, reinterpret_cast<void*>(update_dict_hamt_nonpod) } },
+		specialization_t { eresolved_type::k_dict_hash_pod,				{ "update_dict_hash", function_type2, reinterpret_cast<void*>(update_dict_hash_pod) } },
+		specialization_t { eresolved_type::k_dict_hash_nonpod,			{ "update_dict_hash", function_type2, reinterpret_cast<void*>(update_dict_hash_nonpod) } },
 	};
 }
 
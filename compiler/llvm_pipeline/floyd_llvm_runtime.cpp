@@ -21,6 +21,9 @@ static const bool k_trace_function_link_map = false;
 #include "os_process.h"
 #include "compiler_helpers.h"
 #include "format_table.h"
+#include "hardware_caps.h"
+#include "process_inbox.h"
+#include "process_scheduler.h"
 #include "utils.h"
 
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
@@ -414,14 +417,7 @@ static int64_t floyd_llvm_intrinsic__dummy(floyd_runtime_t* frp){
 llvm_execution_engine_t::~llvm_execution_engine_t(){
 	QUARK_ASSERT(check_invariant());
 
-	if(inited){
-		auto f = reinterpret_cast<FLOYD_RUNTIME_INIT>(get_function_ptr(*this, encode_runtime_func_link_name("deinit")));
-		QUARK_ASSERT(f != nullptr);
-
-		int64_t result = (*f)(make_runtime_ptr(this));
-		QUARK_ASSERT(result == 668);
-		inited = false;
-	};
+	deinit_llvm_jit(*this);
 
 //	const auto leaks = heap.count_used();
 //	QUARK_ASSERT(leaks == 0);
@@ -435,6 +431,15 @@ bool llvm_execution_engine_t::check_invariant() const {
 	return true;
 }
 
+thread_team_t& get_thread_team(llvm_execution_engine_t& ee){
+	std::lock_guard<std::mutex> lock(ee.thread_team_mutex);
+	if(!ee.thread_team){
+		const auto thread_count = ee.config.thread_count > 0 ? static_cast<size_t>(ee.config.thread_count) : get_thread_team_size(read_hardware_caps());
+		ee.thread_team = std::make_unique<thread_team_t>(thread_count);
+	}
+	return *ee.thread_team;
+}
+
 static std::vector<std::pair<link_name_t, void*>> collection_native_func_ptrs(llvm::ExecutionEngine& ee, const std::vector<function_link_entry_t>& function_link_map){
 	std::vector<std::pair<link_name_t, void*>> result;
 	for(const auto& e: function_link_map){
@@ -609,6 +614,25 @@ static std::unique_ptr<llvm_execution_engine_t> make_engine_no_init(llvm_instanc
 	return ee2;
 }
 
+//	Globals can be read by any process and by the thread team, mark their values shared once init is done.
+//	Later stores to mutable globals are shared by floydrt_share_global().
+static void share_globals(llvm_execution_engine_t& ee){
+	QUARK_ASSERT(ee.check_invariant());
+
+	for(const auto& e: ee.global_symbols._symbols){
+		if(e.second._symbol_type == symbol_t::symbol_type::named_type){
+			continue;
+		}
+		const auto type = peek2(ee.backend.types, e.second.get_value_type());
+		if(is_rc_value(type)){
+			const auto global_ptr = get_global_ptr(ee, e.first);
+			if(global_ptr != nullptr){
+				share_value(ee.backend, load_via_ptr2(ee.backend.types, global_ptr, type), type);
+			}
+		}
+	}
+}
+
 //	Destroys program, can only run it once!
 //	Automatically runs floyd_runtime_init() to execute Floyd's global functions and initialize global constants.
 std::unique_ptr<llvm_execution_engine_t> init_llvm_jit(llvm_ir_program_t& program_breaks){
@@ -640,6 +664,7 @@ std::unique_ptr<llvm_execution_engine_t> init_llvm_jit(llvm_ir_program_t& progra
 
 
 	QUARK_ASSERT(init_result == 667);
+	share_globals(*ee);
 	ee->inited = true;
 
 	trace_heap(ee->backend.heap);
@@ -649,6 +674,19 @@ std::unique_ptr<llvm_execution_engine_t> init_llvm_jit(llvm_ir_program_t& progra
 	return ee;
 }
 
+void deinit_llvm_jit(llvm_execution_engine_t& ee){
+	QUARK_ASSERT(ee.check_invariant());
+
+	if(ee.inited){
+		auto f = reinterpret_cast<FLOYD_RUNTIME_INIT>(get_function_ptr(ee, encode_runtime_func_link_name("deinit")));
+		QUARK_ASSERT(f != nullptr);
+
+		int64_t result = (*f)(make_runtime_ptr(&ee));
+		QUARK_ASSERT(result == 668);
+		ee.inited = false;
+	}
+}
+
 
 
 
@@ -668,40 +706,51 @@ std::unique_ptr<llvm_execution_engine_t> init_llvm_jit(llvm_ir_program_t& progra
 //	https://en.cppreference.com/w/cpp/thread/condition_variable/wait
 
 
-struct process_interface {
-	virtual ~process_interface(){};
-	virtual void on_message(const json_t& message) = 0;
-	virtual void on_init() = 0;
+//	A message waiting in an inbox. The inbox owns one RC of value.
+struct llvm_message_t {
+	runtime_value_t value;
+	type_t type;
 };
 
-
-//	NOTICE: Each process inbox has its own mutex + condition variable.
+//	NOTICE: Each process inbox is a lock-free queue. The process_scheduler_t decides which thread runs the clock bus next.
 //	No mutex protects cout.
 struct llvm_process_t {
-	std::condition_variable _inbox_condition_variable;
-	std::mutex _inbox_mutex;
-	std::deque<json_t> _inbox;
+	//	Any thread sends, only the thread running the process's clock bus receives.
+	mpsc_queue_t<llvm_message_t> _inbox;
 
 	std::string _name_key;
 	std::string _function_key;
-	std::thread::id _thread_id;
 
 //	std::shared_ptr<interpreter_t> _interpreter;
 	std::shared_ptr<llvm_bind_t> _init_function;
 	std::shared_ptr<llvm_bind_t> _process_function;
 	value_t _process_state;
-	std::shared_ptr<process_interface> _processor;
+
+	//	The type of the message argument of _process_function. json for processes that accept any message.
+	type_t _message_type;
+
+	int _bus_index = -1;
+
+	//	Set after running the process's init function.
+	bool _started = false;
+
+	//	The process's init function or message handler is on the call stack. Synchronous sends can't re-enter it.
+	bool _running = false;
+
+	//	Read by senders on any thread.
+	std::atomic<bool> _stopped { false };
 };
 
 struct llvm_process_runtime_t {
 	container_t _container;
-	std::map<std::string, std::string> _process_infos;
-	std::thread::id _main_thread_id;
 
 	llvm_execution_engine_t* ee;
 
 	std::vector<std::shared_ptr<llvm_process_t>> _processes;
-	std::vector<std::thread> _worker_threads;
+
+	//	Process indexes, one vector per clock bus. The scheduler schedules clock buses, not processes.
+	std::vector<std::vector<int>> _bus_processes;
+	std::unique_ptr<process_scheduler_t> _scheduler;
 };
 
 /*
@@ -709,92 +758,218 @@ struct llvm_process_runtime_t {
 ??? Separate system-interpreter (all processes and many clock busses) vs ONE thread of execution?
 */
 
-static void send_message(llvm_process_runtime_t& runtime, int process_id, const json_t& message){
-	auto& process = *runtime._processes[process_id];
+//	Which clock bus this thread is running right now, if any.
+struct running_bus_t {
+	const llvm_process_runtime_t* runtime;
+	int bus_index;
+};
+static thread_local running_bus_t t_running_bus { nullptr, -1 };
 
-    {
-        std::lock_guard<std::mutex> lk(process._inbox_mutex);
-        process._inbox.push_front(message);
-        if(k_trace_process_messaging){
-        	QUARK_TRACE("Notifying...");
-		}
-    }
-    process._inbox_condition_variable.notify_one();
-//    process._inbox_condition_variable.notify_all();
+static bool is_stop_message(const llvm_execution_engine_t& ee, const llvm_message_t& message){
+	const auto peek = peek2(ee.backend.types, message.type);
+	if(peek.is_string()){
+		return from_runtime_string(ee, message.value) == "stop";
+	}
+	else if(peek.is_json()){
+		const auto& json = message.value.json_ptr->get_json();
+		return json.is_string() && json.get_string() == "stop";
+	}
+	else{
+		return false;
+	}
 }
 
-static void run_process(llvm_process_runtime_t& runtime, int process_id){
-	auto& process = *runtime._processes[process_id];
-	bool stop = false;
-	auto& types = runtime.ee->backend.types;
-
-	const auto thread_name = get_current_thread_name();
-
-	const type_t process_state_type = process._init_function != nullptr ? peek2(types, process._init_function->type).get_function_return(types) : make_undefined();
-
-	if(process._processor){
-		process._processor->on_init();
+static void release_messages(llvm_execution_engine_t& ee, const std::vector<llvm_message_t>& messages, size_t start){
+	for(size_t i = start ; i < messages.size() ; i++){
+		release_value(ee.backend, messages[i].value, messages[i].type);
 	}
+}
+
+static void start_process(llvm_process_runtime_t& runtime, llvm_process_t& process){
+	QUARK_ASSERT(process._started == false);
+	auto& types = runtime.ee->backend.types;
 
 	if(process._init_function != nullptr){
+		const type_t process_state_type = peek2(types, process._init_function->type).get_function_return(types);
+
 		//	!!! This validation should be done earlier in the startup process / compilation process.
 		if(process._init_function->type != make_process_init_type(types, process_state_type)){
 			quark::throw_runtime_error("Invalid function prototype for process-init");
 		}
 
+		process._running = true;
 		auto f = reinterpret_cast<FLOYD_RUNTIME_PROCESS_INIT>(process._init_function->address);
 		const auto result = (*f)(make_runtime_ptr(runtime.ee));
-		process._process_state = from_runtime_value(*runtime.ee, result, peek2(types, process._init_function->type).get_function_return(types));
+		process._process_state = from_runtime_value(*runtime.ee, result, process_state_type);
+		if(is_rc_value(peek2(types, process_state_type))){
+			release_value(runtime.ee->backend, result, process_state_type);
+		}
+		process._running = false;
 	}
+	process._started = true;
+}
 
-	while(stop == false){
-		json_t message;
-		{
-			std::unique_lock<std::mutex> lk(process._inbox_mutex);
+//	Runs the process's message handler. The message is borrowed. Stops the process on "stop".
+static void handle_message(llvm_process_runtime_t& runtime, llvm_process_t& process, const llvm_message_t& message){
+	QUARK_ASSERT(process._started && process._running == false);
+	auto& types = runtime.ee->backend.types;
 
-			if(k_trace_process_messaging){
-        		QUARK_TRACE_SS(thread_name << ": waiting......");
-			}
-			process._inbox_condition_variable.wait(lk, [&]{ return process._inbox.empty() == false; });
-			if(k_trace_process_messaging){
-        		QUARK_TRACE_SS(thread_name << ": continue");
-			}
+	if(k_trace_process_messaging){
+		QUARK_TRACE_SS(get_current_thread_name() << " RECEIVED: " << json_to_pretty_string(value_to_ast_json(types, from_runtime_value(*runtime.ee, message.value, message.type))));
+	}
+
+	if(is_stop_message(*runtime.ee, message)){
+		if(k_trace_process_messaging){
+			QUARK_TRACE_SS(get_current_thread_name() << ": STOP");
+		}
+		process._stopped = true;
+	}
+	else if(process._process_function != nullptr){
+		const type_t process_state_type = process._init_function != nullptr ? peek2(types, process._init_function->type).get_function_return(types) : make_undefined();
 
-			//	Pop message.
-			QUARK_ASSERT(process._inbox.empty() == false);
-			message = process._inbox.back();
-			process._inbox.pop_back();
+		//	!!! This validation should be done earlier in the startup process / compilation process.
+		if(process._process_function->type != make_process_message_handler_type(types, process_state_type, process._message_type)){
+			quark::throw_runtime_error("Invalid function prototype for process message handler");
 		}
 
-		if(k_trace_process_messaging){
-			QUARK_TRACE_SS("RECEIVED: " << json_to_pretty_string(message));
+		process._running = true;
+		auto f = reinterpret_cast<FLOYD_RUNTIME_PROCESS_MESSAGE>(process._process_function->address);
+		const auto state2 = to_runtime_value(*runtime.ee, process._process_state);
+		const auto result = (*f)(make_runtime_ptr(runtime.ee), state2, message.value);
+		process._process_state = from_runtime_value(*runtime.ee, result, peek2(types, process._process_function->type).get_function_return(types));
+
+		//	The handler borrows state2 and returns a new state: release both, _process_state holds a copy.
+		if(is_rc_value(peek2(types, process_state_type))){
+			release_value(runtime.ee->backend, state2, process_state_type);
+			release_value(runtime.ee->backend, result, process_state_type);
 		}
+		process._running = false;
+	}
+}
 
-		if(message.is_string() && message.get_string() == "stop"){
-			stop = true;
-			if(k_trace_process_messaging){
-        		QUARK_TRACE_SS(thread_name << ": STOP");
-			}
+/*
+	message is borrowed from the sender.
+
+	If the sender runs on the receiver's clock bus, the receiver handles the message right away, like a function
+	call. It can't do that if the receiver is busy further up the call stack, hasn't been inited yet or has older
+	messages waiting -- then the message goes into the inbox like any other.
+
+	If the message has the process's message type, the inbox just retains it, no copy. It's marked shared first so
+	both threads use atomic RC on it.
+*/
+static void send_message(llvm_process_runtime_t& runtime, int process_id, runtime_value_t message, const type_t& message_type){
+	auto& process = *runtime._processes[process_id];
+	auto& ee = *runtime.ee;
+	auto& types = ee.backend.types;
+
+	if(process._stopped){
+		return;
+	}
+
+	const bool synchronous =
+		t_running_bus.runtime == &runtime
+		&& t_running_bus.bus_index == process._bus_index
+		&& process._started
+		&& process._running == false
+		&& process._inbox.empty();
+
+	const auto m = llvm_message_t { message, message_type };
+	if(message_type == process._message_type || is_stop_message(ee, m)){
+		if(synchronous){
+			handle_message(runtime, process, m);
+			return;
 		}
-		else{
-			if(process._processor){
-				process._processor->on_message(message);
-			}
 
-			if(process._process_function != nullptr){
-				//	!!! This validation should be done earlier in the startup process / compilation process.
-				if(process._process_function->type != make_process_message_handler_type(types, process_state_type)){
-					quark::throw_runtime_error("Invalid function prototype for process message handler");
-				}
+		//	The sender keeps its reference while the receiver may run on another thread.
+		share_value(ee.backend, message, message_type);
+		retain_value(ee.backend, message, message_type);
+		process._inbox.push(m);
+	}
+	//	Processes that take json get any value converted to json, like send() always did.
+	else if(peek2(types, process._message_type).is_json()){
+		const auto json = value_to_ast_json(types, from_runtime_value(ee, message, message_type));
+		const auto m2 = llvm_message_t { to_runtime_value(ee, value_t::make_json(json)), type_t::make_json() };
+		if(synchronous){
+			handle_message(runtime, process, m2);
+			release_value(ee.backend, m2.value, m2.type);
+			return;
+		}
+		process._inbox.push(m2);
+	}
+	else{
+		quark::throw_runtime_error("send(): message type doesn't match the process's message type.");
+	}
 
-				auto f = reinterpret_cast<FLOYD_RUNTIME_PROCESS_MESSAGE>(process._process_function->address);
-				const auto state2 = to_runtime_value(*runtime.ee, process._process_state);
-				const auto message2 = to_runtime_value(*runtime.ee, value_t::make_json(message));
-				const auto result = (*f)(make_runtime_ptr(runtime.ee), state2, message2);
-				process._process_state = from_runtime_value(*runtime.ee, result, peek2(types, process._process_function->type).get_function_return(types));
-			}
+	if(k_trace_process_messaging){
+		QUARK_TRACE("Notifying...");
+	}
+	notify_process(*runtime._scheduler, process._bus_index);
+}
+
+static bool bus_has_messages(llvm_process_runtime_t& runtime, int bus_index){
+	for(const auto process_id: runtime._bus_processes[bus_index]){
+		const auto& process = *runtime._processes[process_id];
+		if(process._stopped == false && process._inbox.empty() == false){
+			return true;
+		}
+	}
+	return false;
+}
+
+//	Messages sent to processes that had already stopped.
+static void release_inboxes(llvm_process_runtime_t& runtime){
+	for(auto& process: runtime._processes){
+		llvm_message_t message;
+		while(process->_inbox.pop(message)){
+			release_value(runtime.ee->backend, message.value, message.type);
+		}
+	}
+}
+
+//	Handles a batch of the process's messages.
+static void run_process_slice(llvm_process_runtime_t& runtime, llvm_process_t& process){
+	//	Drain one slice worth of messages in one go.
+	std::vector<llvm_message_t> messages;
+	process._inbox.pop_batch(messages, k_process_slice_message_count);
+	for(size_t i = 0 ; i < messages.size() ; i++){
+		handle_message(runtime, process, messages[i]);
+		release_value(runtime.ee->backend, messages[i].value, messages[i].type);
+		if(process._stopped){
+			release_messages(*runtime.ee, messages, i + 1);
+			return;
+		}
+	}
+}
+
+/*
+	Runs one slice of every process on the clock bus. Only the scheduler thread running the bus gets here.
+	The first slice inits all the bus's processes. Returns true when all of them have stopped.
+*/
+static bool run_bus_slice(llvm_process_runtime_t& runtime, int bus_index){
+	struct running_bus_scope_t {
+		running_bus_scope_t(const running_bus_t& bus) : prev(t_running_bus) { t_running_bus = bus; }
+		~running_bus_scope_t(){ t_running_bus = prev; }
+		running_bus_t prev;
+	};
+	running_bus_scope_t scope(running_bus_t { &runtime, bus_index });
+
+	const auto& process_ids = runtime._bus_processes[bus_index];
+	for(const auto process_id: process_ids){
+		auto& process = *runtime._processes[process_id];
+		if(process._started == false){
+			start_process(runtime, process);
 		}
 	}
+
+	bool all_stopped = true;
+	for(const auto process_id: process_ids){
+		auto& process = *runtime._processes[process_id];
+		if(process._stopped == false){
+			run_process_slice(runtime, process);
+		}
+		all_stopped = all_stopped && process._stopped;
+	}
+	return all_stopped;
 }
 
 
@@ -804,25 +979,18 @@ static std::map<std::string, value_t> run_processes(llvm_execution_engine_t& ee)
 	}
 	else{
 		llvm_process_runtime_t runtime;
-		runtime._main_thread_id = std::this_thread::get_id();
 		runtime.ee = &ee;
 
 		runtime._container = ee.container_def;
 
-		runtime._process_infos = reduce(runtime._container._clock_busses, std::map<std::string, std::string>(), [](const std::map<std::string, std::string>& acc, const std::pair<std::string, clock_bus_t>& e){
-			auto acc2 = acc;
-			acc2.insert(e.second._processes.begin(), e.second._processes.end());
-			return acc2;
-		});
-
-		struct my_interpreter_handler_t : public runtime_handler_i {
+		struct my_interpreter_handler_t : public llvm_runtime_handler_i {
 			my_interpreter_handler_t(llvm_process_runtime_t& runtime) : _runtime(runtime) {}
 
-			virtual void on_send(const std::string& process_id, const json_t& message){
+			virtual void on_send(const std::string& process_id, runtime_value_t message, const type_t& message_type){
 				const auto it = std::find_if(_runtime._processes.begin(), _runtime._processes.end(), [&](const std::shared_ptr<llvm_process_t>& process){ return process->_name_key == process_id; });
 				if(it != _runtime._processes.end()){
 					const auto process_index = it - _runtime._processes.begin();
-					send_message(_runtime, static_cast<int>(process_index), message);
+					send_message(_runtime, static_cast<int>(process_index), message, message_type);
 				}
 			}
 
@@ -834,41 +1002,45 @@ static std::map<std::string, value_t> run_processes(llvm_execution_engine_t& ee)
 
 		ee._handler = &my_interpreter_handler;
 
-		for(const auto& t: runtime._process_infos){
-			auto process = std::make_shared<llvm_process_t>();
-			process->_name_key = t.first;
-			process->_function_key = t.second;
-	//		process->_interpreter = std::make_shared<interpreter_t>(program, &my_interpreter_handler);
+		for(const auto& bus: runtime._container._clock_busses){
+			const auto bus_index = static_cast<int>(runtime._bus_processes.size());
+			runtime._bus_processes.push_back({});
 
-			process->_init_function = std::make_shared<llvm_bind_t>(bind_function2(*runtime.ee, encode_floyd_func_link_name(t.second + "__init")));
-			process->_process_function = std::make_shared<llvm_bind_t>(bind_function2(*runtime.ee, encode_floyd_func_link_name(t.second)));
+			for(const auto& t: bus.second._processes){
+				auto process = std::make_shared<llvm_process_t>();
+				process->_name_key = t.first;
+				process->_function_key = t.second;
+				process->_bus_index = bus_index;
+		//		process->_interpreter = std::make_shared<interpreter_t>(program, &my_interpreter_handler);
 
-			runtime._processes.push_back(process);
-		}
-
-		//	Remember that current thread (main) is also a thread, no need to create a worker thread for one process.
-		runtime._processes[0]->_thread_id = runtime._main_thread_id;
-
-		for(int process_id = 1 ; process_id < runtime._processes.size() ; process_id++){
-			runtime._worker_threads.push_back(std::thread([&](int process_id){
-
-	//			const auto native_thread = thread::native_handle();
+				process->_init_function = std::make_shared<llvm_bind_t>(bind_function2(*runtime.ee, encode_floyd_func_link_name(t.second + "__init")));
+				process->_process_function = std::make_shared<llvm_bind_t>(bind_function2(*runtime.ee, encode_floyd_func_link_name(t.second)));
 
-				std::stringstream thread_name;
-				thread_name << std::string() << "process " << process_id << " thread";
-	#if QUARK_MAC
-				pthread_setname_np(/*pthread_self(),*/ thread_name.str().c_str());
-	#endif
+				const auto process_args = peek2(ee.backend.types, process->_process_function->type).get_function_args(ee.backend.types);
+				process->_message_type = process_args.size() == 2 ? process_args[1] : type_t::make_json();
 
-				run_process(runtime, process_id);
-			}, process_id));
+				runtime._bus_processes.back().push_back(static_cast<int>(runtime._processes.size()));
+				runtime._processes.push_back(process);
+			}
 		}
 
-		run_process(runtime, 0);
-
-		for(auto &t: runtime._worker_threads){
-			t.join();
+		//	M:N -- all clock buses share a few OS threads. The current thread (main) is one of them.
+		const auto bus_count = runtime._bus_processes.size();
+		const auto max_threads = ee.config.thread_count > 0 ? static_cast<size_t>(ee.config.thread_count) : get_thread_team_size(read_hardware_caps());
+		runtime._scheduler = std::make_unique<process_scheduler_t>(bus_count);
+		try {
+			run_process_scheduler(
+				*runtime._scheduler,
+				std::min(bus_count, max_threads),
+				[&](int bus_index){ return run_bus_slice(runtime, bus_index); },
+				[&](int bus_index){ return bus_has_messages(runtime, bus_index); }
+			);
+		}
+		catch(...){
+			release_inboxes(runtime);
+			throw;
 		}
+		release_inboxes(runtime);
 
 		return {};
 	}
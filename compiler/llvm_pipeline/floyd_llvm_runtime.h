@@ -12,6 +12,7 @@
 #include "value_backend.h"
 #include "floyd_llvm_types.h"
 #include "value_thunking.h"
+#include "thread_team.h"
 #include <llvm/IR/IRBuilder.h>
 
 #include <string>
@@ -26,7 +27,6 @@ namespace llvm {
 namespace floyd {
 
 struct llvm_ir_program_t;
-struct runtime_handler_i;
 struct run_output_t;
 struct floyd_runtime_t;
 struct llvm_instance_t;
@@ -45,6 +45,20 @@ struct llvm_bind_t {
 
 
 
+////////////////////////////////		llvm_runtime_handler_i
+
+/*
+	Hosts the processes. send() ends up here.
+*/
+struct llvm_runtime_handler_i {
+	virtual ~llvm_runtime_handler_i(){};
+
+	//	message is owned by the caller: retain it to keep it. It's immutable, so no copy is needed.
+	virtual void on_send(const std::string& process_id, runtime_value_t message, const type_t& message_type) = 0;
+};
+
+
+
 ////////////////////////////////		function_bind_t
 
 
@@ -117,7 +131,7 @@ struct llvm_execution_engine_t {
 	std::vector<function_link_entry_t> function_link_map;
 	public: std::vector<std::string> _print_output;
 
-	public: runtime_handler_i* _handler;
+	public: llvm_runtime_handler_i* _handler;
 
 	public: const std::chrono::time_point<std::chrono::high_resolution_clock> _start_time;
 
@@ -125,8 +139,19 @@ struct llvm_execution_engine_t {
 	llvm_bind_t main_function;
 	bool inited;
 	config_t config;
+
+	//	print() and assert() run on the thread team inside map() / map_dag() callbacks and on process threads.
+	//	Hold this to write _print_output.
+	std::mutex print_output_mutex;
+
+	//	Worker threads for map_dag() etc. Created on first use by get_thread_team().
+	std::mutex thread_team_mutex;
+	std::unique_ptr<thread_team_t> thread_team;
 };
 
+//	Thread-safe: processes may call map_dag() at the same time.
+thread_team_t& get_thread_team(llvm_execution_engine_t& ee);
+
 
 
 ////////////////////////////////		FUNCTION POINTERS
@@ -222,6 +247,10 @@ int64_t llvm_call_main(llvm_execution_engine_t& ee, const llvm_bind_t& f, const
 //	Calls init() and will perform deinit() when engine is destructed later.
 std::unique_ptr<llvm_execution_engine_t> init_llvm_jit(llvm_ir_program_t& program);
 
+//	Runs deinit(), which releases the globals. Only runs it once, the engine's destructor skips it afterwards.
+//	After this all allocs of the heap should be disposed.
+void deinit_llvm_jit(llvm_execution_engine_t& ee);
+
 
 //	Calls main() if it exists, else runs the floyd processes. Returns when execution is done.
 run_output_t run_program(llvm_execution_engine_t& ee, const std::vector<std::string>& main_args);
@@ -83,6 +83,14 @@ static runtime_value_t floydrt_allocate_vector_hamt(floyd_runtime_t* frp, runtim
 	return alloc_vector_hamt(r.backend.heap, element_count, element_count, type_t(type));
 }
 
+//	All members of all elements are zero.
+static runtime_value_t floydrt_allocate_vector_soa(floyd_runtime_t* frp, runtime_type_t type, uint64_t element_count){
+	auto& r = get_floyd_runtime(frp);
+	const auto element_type = lookup_vector_element_type(r.backend, type_t(type));
+	const auto member_count = peek2(r.backend.types, element_type).get_struct(r.backend.types)._members.size();
+	return alloc_vector_soa(r.backend.heap, element_count, element_count, member_count, type_t(type));
+}
+
 static std::vector<function_bind_t> floydrt_allocate_vector__make(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
 	llvm::FunctionType* function_type = llvm::FunctionType::get(
 		make_generic_vec_type_byvalue(type_lookup)->getPointerTo(),
@@ -96,7 +104,8 @@ static std::vector<function_bind_t> floydrt_allocate_vector__make(llvm::LLVMCont
 
 	return {
 		{ "allocate_vector_carray", function_type, reinterpret_cast<void*>(floydrt_allocate_vector_carray) },
-		{ "allocate_vector_hamt", function_type, reinterpret_cast<void*>(floydrt_allocate_vector_hamt) }
+		{ "allocate_vector_hamt", function_type, reinterpret_cast<void*>(floydrt_allocate_vector_hamt) },
+		{ "allocate_vector_soa", function_type, reinterpret_cast<void*>(floydrt_allocate_vector_soa) }
 		};
 }
 
@@ -118,6 +127,9 @@ llvm::Value* generate_allocate_vector(llvm_function_generator_t& gen_acc, const
 	else if(vector_backend == vector_backend::hamt){
 		n = "allocate_vector_hamt";
 	}
+	else if(vector_backend == vector_backend::soa){
+		n = "allocate_vector_soa";
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -150,6 +162,9 @@ static runtime_value_t floydrt_allocate_vector_fill(floyd_runtime_t* frp, runtim
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(type))){
 		return alloc_vector_hamt(r.backend.heap, element_count, element_count, type_t(type));
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(type))){
+		return floydrt_allocate_vector_soa(frp, type, element_count);
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -187,6 +202,15 @@ static void floydrt_store_vector_element_hamt_mutable(floyd_runtime_t* frp, runt
 	vec.vector_hamt_ptr->store_mutate(index, element);
 }
 
+//	Takes over element's reference: its members are copied into the columns and the STRUCT_T is released.
+static void floydrt_store_vector_element_soa_mutable(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t type, uint64_t index, runtime_value_t element){
+	auto& r = get_floyd_runtime(frp);
+
+	QUARK_ASSERT(is_vector_soa(r.backend.types, r.backend.config, type_t(type)));
+	store_vector_soa_element(r.backend, vec, type_t(type), index, element);
+	release_value(r.backend, element, lookup_vector_element_type(r.backend, type_t(type)));
+}
+
 static std::vector<function_bind_t> floydrt_store_vector_element_mutable__make(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
 	llvm::FunctionType* function_type = llvm::FunctionType::get(
 		llvm::Type::getVoidTy(context),
@@ -199,7 +223,10 @@ static std::vector<function_bind_t> floydrt_store_vector_element_mutable__make(l
 		},
 		false
 	);
-	return {{ "store_vector_element_hamt_mutable", function_type, reinterpret_cast<void*>(floydrt_store_vector_element_hamt_mutable) }};
+	return {
+		{ "store_vector_element_hamt_mutable", function_type, reinterpret_cast<void*>(floydrt_store_vector_element_hamt_mutable) },
+		{ "store_vector_element_soa_mutable", function_type, reinterpret_cast<void*>(floydrt_store_vector_element_soa_mutable) }
+	};
 }
 
 
@@ -224,6 +251,9 @@ static runtime_value_t floydrt_concatunate_vectors(floyd_runtime_t* frp, runtime
 	else if(is_vector_hamt(r.backend.types, r.backend.config, type_t(type))){
 		return concat_vector_hamt(r.backend, type0, lhs, rhs);
 	}
+	else if(is_vector_soa(r.backend.types, r.backend.config, type_t(type))){
+		return concat_vector_soa(r.backend, type0, lhs, rhs);
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -265,6 +295,22 @@ static runtime_value_t floydrt_load_vector_element_hamt(floyd_runtime_t* frp, ru
 	return vec.vector_hamt_ptr->load_element(index);
 }
 
+//	Returns a new STRUCT_T made from the row, the caller owns it.
+static runtime_value_t floydrt_load_vector_element_soa(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t type, uint64_t index){
+	auto& r = get_floyd_runtime(frp);
+
+	QUARK_ASSERT(is_vector_soa(r.backend.types, r.backend.config, type_t(type)));
+
+	const auto size = vec.vector_soa_ptr->get_element_count();
+	if(index >= size){
+		std::stringstream what;
+		what << "Bounds error. Read vector index " << index << ", vector size: " << size << ".";
+		throw std::out_of_range(what.str());
+	}
+
+	return load_vector_soa_element(r.backend, vec, type_t(type), index);
+}
+
 static std::vector<function_bind_t> floydrt_load_vector_element__make(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
 	llvm::FunctionType* function_type = llvm::FunctionType::get(
 		make_runtime_value_type(type_lookup),
@@ -276,7 +322,10 @@ static std::vector<function_bind_t> floydrt_load_vector_element__make(llvm::LLVM
 		},
 		false
 	);
-	return {{ "load_vector_element_hamt", function_type, reinterpret_cast<void*>(floydrt_load_vector_element_hamt) }};
+	return {
+		{ "load_vector_element_hamt", function_type, reinterpret_cast<void*>(floydrt_load_vector_element_hamt) },
+		{ "load_vector_element_soa", function_type, reinterpret_cast<void*>(floydrt_load_vector_element_soa) }
+	};
 }
 
 
@@ -306,6 +355,9 @@ static const runtime_value_t floydrt_allocate_dict(floyd_runtime_t* frp, runtime
 	else if(is_dict_hamt(r.backend.types, r.backend.config, type_t(type))){
 		return alloc_dict_hamt(r.backend.heap, type_t(type));
 	}
+	else if(is_dict_hash(r.backend.types, r.backend.config, type_t(type))){
+		return alloc_dict_hash(r.backend.heap, type_t(type));
+	}
 	else{
 		QUARK_ASSERT(false);
 		throw std::exception();
@@ -337,8 +389,7 @@ static runtime_value_t floydrt_lookup_dict_cppmap(floyd_runtime_t* frp, runtime_
 	QUARK_ASSERT(is_dict_cppmap(r.backend.types, r.backend.config, type_t(type)));
 
 	const auto& m = dict.dict_cppmap_ptr->get_map();
-	const auto key_string = from_runtime_string(r, s);
-	const auto it = m.find(key_string);
+	const auto it = m.find(make_string_key(s).chars);
 	if(it == m.end()){
 		throw std::exception();
 	}
@@ -347,7 +398,6 @@ static runtime_value_t floydrt_lookup_dict_cppmap(floyd_runtime_t* frp, runtime_
 	}
 }
 
-//??? make faster key without creating std::string.
 static runtime_value_t floydrt_lookup_dict_hamt(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type, runtime_value_t s){
 	auto& r = get_floyd_runtime(frp);
 
@@ -355,8 +405,23 @@ static runtime_value_t floydrt_lookup_dict_hamt(floyd_runtime_t* frp, runtime_va
 	QUARK_ASSERT(is_dict_hamt(r.backend.types, r.backend.config, type_t(type)));
 
 	const auto& m = dict.dict_hamt_ptr->get_map();
-	const auto key_string = from_runtime_string(r, s);
-	const auto it = m.find(key_string);
+	const auto it = m.find(make_string_key(s));
+	if(it == nullptr){
+		throw std::exception();
+	}
+	else{
+		return *it;
+	}
+}
+
+static runtime_value_t floydrt_lookup_dict_hash(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type, runtime_value_t s){
+	auto& r = get_floyd_runtime(frp);
+
+	QUARK_ASSERT(is_dict_hash(r.backend.types, r.backend.config, type_t(type)));
+
+	const auto& m = dict.dict_hash_ptr->get_map();
+	const auto key = make_string_key(s);
+	const auto it = m.find(key.chars, key.hash);
 	if(it == nullptr){
 		throw std::exception();
 	}
@@ -391,6 +456,19 @@ static std::vector<function_bind_t> floydrt_lookup_dict_hamt__make(llvm::LLVMCon
 	);
 	return {{ "lookup_dict_hamt", function_type, reinterpret_cast<void*>(floydrt_lookup_dict_hamt) }};
 }
+static std::vector<function_bind_t> floydrt_lookup_dict_hash__make(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
+	llvm::FunctionType* function_type = llvm::FunctionType::get(
+		make_runtime_value_type(type_lookup),
+		{
+			make_frp_type(type_lookup),
+			make_generic_dict_type_byvalue(type_lookup)->getPointerTo(),
+			make_runtime_type_type(type_lookup),
+			get_llvm_type_as_arg(type_lookup, type_t::make_string())
+		},
+		false
+	);
+	return {{ "lookup_dict_hash", function_type, reinterpret_cast<void*>(floydrt_lookup_dict_hash) }};
+}
 
 
 llvm::Value* generate_lookup_dict(llvm_function_generator_t& gen_acc, llvm::Value& dict_reg, const type_t& dict_type, llvm::Value& key_reg, dict_backend dict_mode){
@@ -398,9 +476,12 @@ llvm::Value* generate_lookup_dict(llvm_function_generator_t& gen_acc, llvm::Valu
 	QUARK_ASSERT(dict_type.check_invariant());
 
 	const auto& types = gen_acc.gen.type_lookup.state.types;
-	QUARK_ASSERT(is_dict_cppmap(types, gen_acc.gen.settings.config, dict_type) || is_dict_hamt(types, gen_acc.gen.settings.config, dict_type));
+	QUARK_ASSERT(peek2(types, dict_type).is_dict());
 
-	const auto res = resolve_func(gen_acc.gen.link_map, dict_mode == dict_backend::hamt ? "lookup_dict_hamt" : "lookup_dict_cppmap");
+	const auto res = resolve_func(
+		gen_acc.gen.link_map,
+		dict_mode == dict_backend::hamt ? "lookup_dict_hamt" : dict_mode == dict_backend::hash ? "lookup_dict_hash" : "lookup_dict_cppmap"
+	);
 
 	const auto dict_peek = peek2(types, dict_type);
 	const auto element_type0 = dict_peek.get_dict_value_type(types);
@@ -442,6 +523,14 @@ static void floydrt_store_dict_mutable_hamt(floyd_runtime_t* frp, runtime_value_
 	const auto key_string = from_runtime_string(r, key);
 	dict.dict_hamt_ptr->get_map_mut() = dict.dict_hamt_ptr->get_map_mut().set(key_string, element_value);
 }
+static void floydrt_store_dict_mutable_hash(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type, runtime_value_t key, runtime_value_t element_value){
+	auto& r = get_floyd_runtime(frp);
+
+	const auto& types = r.backend.types;
+	QUARK_ASSERT(is_dict_hash(types, r.backend.config, type_t(type)));
+	const auto key_string = from_runtime_string(r, key);
+	dict.dict_hash_ptr->get_map_mut().insert_or_assign(key_string, element_value);
+}
 
 static std::vector<function_bind_t> floydrt_store_dict_mutable__make(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
 	llvm::FunctionType* function_type = llvm::FunctionType::get(
@@ -457,7 +546,8 @@ static std::vector<function_bind_t> floydrt_store_dict_mutable__make(llvm::LLVMC
 	);
 	return {
 		{ "store_dict_mutable_cppmap", function_type, reinterpret_cast<void*>(floydrt_store_dict_mutable_cppmap) },
-		{ "store_dict_mutable_hamt", function_type, reinterpret_cast<void*>(floydrt_store_dict_mutable_hamt) }
+		{ "store_dict_mutable_hamt", function_type, reinterpret_cast<void*>(floydrt_store_dict_mutable_hamt) },
+		{ "store_dict_mutable_hash", function_type, reinterpret_cast<void*>(floydrt_store_dict_mutable_hash) }
 	};
 }
 
@@ -466,9 +556,12 @@ void generate_store_dict_mutable(llvm_function_generator_t& gen_acc, llvm::Value
 	QUARK_ASSERT(dict_type.check_invariant());
 
 	const auto& types = gen_acc.gen.type_lookup.state.types;
-	QUARK_ASSERT(is_dict_cppmap(types, gen_acc.gen.settings.config, dict_type) || is_dict_hamt(types, gen_acc.gen.settings.config, dict_type));
+	QUARK_ASSERT(peek2(types, dict_type).is_dict());
 
-	const auto res = resolve_func(gen_acc.gen.link_map, dict_mode == dict_backend::hamt ? "store_dict_mutable_hamt" : "store_dict_mutable_cppmap");
+	const auto res = resolve_func(
+		gen_acc.gen.link_map,
+		dict_mode == dict_backend::hamt ? "store_dict_mutable_hamt" : dict_mode == dict_backend::hash ? "store_dict_mutable_hash" : "store_dict_mutable_cppmap"
+	);
 	const auto dict_peek = peek2(types, dict_type);
 
 	const auto& element_type0 = dict_peek.get_dict_value_type(types);
@@ -920,6 +1013,35 @@ static std::vector<function_bind_t> floydrt_compare_values__make(llvm::LLVMConte
 
 
 
+
+////////////////////////////////		share_global()
+
+
+
+//	Stores to globals made after init. The globals' initial values are shared by init_llvm_jit(). Before that
+//	only init runs, so keep the values local and let init's loops mutate them in place.
+static void floydrt_share_global(floyd_runtime_t* frp, runtime_value_t value, runtime_type_t type){
+	auto& r = get_floyd_runtime(frp);
+	if(r.inited){
+		share_value(r.backend, value, type_t(type));
+	}
+}
+
+static std::vector<function_bind_t> floydrt_share_global__make(llvm::LLVMContext& context, const llvm_type_lookup& type_lookup){
+	llvm::FunctionType* function_type = llvm::FunctionType::get(
+		llvm::Type::getVoidTy(context),
+		{
+			make_frp_type(type_lookup),
+			make_runtime_value_type(type_lookup),
+			make_runtime_type_type(type_lookup)
+		},
+		false
+	);
+	return {{ "share_global", function_type, reinterpret_cast<void*>(floydrt_share_global) }};
+}
+
+
+
 static int64_t floydrt_get_profile_time(floyd_runtime_t* frp){
 	get_floyd_runtime(frp);
 
@@ -1014,6 +1136,13 @@ static void floydrt_retain_vector_hamt(floyd_runtime_t* frp, runtime_value_t vec
 }
 
 
+static void floydrt_retain_vector_soa(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t type0){
+	auto& r = get_floyd_runtime(frp);
+	QUARK_ASSERT(is_vector_soa(r.backend.types, r.backend.config, type_t(type0)));
+
+	retain_vector_soa(r.backend, vec, type_t(type0));
+}
+
 
 static void floydrt_retain_dict_cppmap(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type0){
 	auto& r = get_floyd_runtime(frp);
@@ -1037,6 +1166,17 @@ static void floydrt_retain_dict_hamt(floyd_runtime_t* frp, runtime_value_t dict,
 
 	retain_dict_hamt(r.backend, dict, type_t(type0));
 }
+static void floydrt_retain_dict_hash(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type0){
+	auto& r = get_floyd_runtime(frp);
+#if DEBUG
+	const auto& type = lookup_type_ref(r.backend, type0);
+	QUARK_ASSERT(is_rc_value(peek2(r.backend.types, type)));
+	QUARK_ASSERT(peek2(r.backend.types, type).is_dict());
+	QUARK_ASSERT(is_dict_hash(r.backend.types, r.backend.config, type));
+#endif
+
+	retain_dict_hash(r.backend, dict, type_t(type0));
+}
 
 
 
@@ -1072,6 +1212,75 @@ const auto& type = lookup_type_ref(r.backend, type0);
 
 
 
+//	Emits the common RC change inline, straight on heap_alloc_64_t::rc, and only calls the runtime function
+//	for shared allocs (atomic RC) and, on release, when the RC is about to become 0 and the value is disposed.
+//	nullptr values (unwinding locals, destructed globals) and inline strings have no alloc and are skipped.
+//	The runtime functions do the full job themselves so the slow path just calls them with the original value.
+static void generate_inline_rc_change(
+	llvm_function_generator_t& gen_acc,
+	const function_link_entry_t& res,
+	llvm::Value& arg_reg,
+	llvm::Value& itype_reg,
+	bool is_string,
+	bool is_retain
+){
+	QUARK_ASSERT(gen_acc.check_invariant());
+
+	auto& frp_reg = *gen_acc.get_callers_fcp();
+	auto& builder = gen_acc.get_builder();
+	auto& context = builder.getContext();
+
+	llvm::Function* parent_function = builder.GetInsertBlock()->getParent();
+	llvm::BasicBlock* alloc_bb = llvm::BasicBlock::Create(context, "rc-alloc", parent_function);
+	llvm::BasicBlock* local_bb = llvm::BasicBlock::Create(context, "rc-local", parent_function);
+	llvm::BasicBlock* runtime_bb = llvm::BasicBlock::Create(context, "rc-runtime", parent_function);
+	llvm::BasicBlock* join_bb = llvm::BasicBlock::Create(context, "rc-join", parent_function);
+
+	auto bits_reg = builder.CreatePtrToInt(&arg_reg, builder.getInt64Ty(), "rc_bits");
+	llvm::Value* skip_reg = builder.CreateICmpEQ(bits_reg, builder.getInt64(0), "is_null");
+	if(is_string){
+		auto tag_reg = builder.CreateAnd(bits_reg, builder.getInt64(1), "");
+		skip_reg = builder.CreateOr(skip_reg, builder.CreateICmpNE(tag_reg, builder.getInt64(0), "is_inline_string"), "");
+	}
+	builder.CreateCondBr(skip_reg, join_bb, alloc_bb);
+
+	//	Every RC value points to a struct that starts with its heap_alloc_64_t.
+	builder.SetInsertPoint(alloc_bb);
+	auto alloc_reg = builder.CreateBitCast(&arg_reg, builder.getInt8PtrTy(), "alloc");
+	auto shared_ptr_reg = builder.CreateGEP(builder.getInt8Ty(), alloc_reg, builder.getInt64(heap_alloc_64_t::k_shared_offset), "");
+	auto shared_reg = builder.CreateLoad(builder.getInt8Ty(), shared_ptr_reg, "shared");
+	auto is_shared_reg = builder.CreateICmpNE(shared_reg, builder.getInt8(0), "is_shared");
+	builder.CreateCondBr(is_shared_reg, runtime_bb, local_bb);
+
+	builder.SetInsertPoint(local_bb);
+	auto rc_ptr_reg = builder.CreateBitCast(
+		builder.CreateGEP(builder.getInt8Ty(), alloc_reg, builder.getInt64(heap_alloc_64_t::k_rc_offset), ""),
+		builder.getInt32Ty()->getPointerTo(),
+		"rc_ptr"
+	);
+	auto rc_reg = builder.CreateLoad(builder.getInt32Ty(), rc_ptr_reg, "rc");
+	if(is_retain){
+		builder.CreateStore(builder.CreateAdd(rc_reg, builder.getInt32(1), ""), rc_ptr_reg);
+		builder.CreateBr(join_bb);
+	}
+	else{
+		llvm::BasicBlock* dec_bb = llvm::BasicBlock::Create(context, "rc-dec", parent_function);
+		auto is_last_reg = builder.CreateICmpEQ(rc_reg, builder.getInt32(1), "is_last");
+		builder.CreateCondBr(is_last_reg, runtime_bb, dec_bb);
+
+		builder.SetInsertPoint(dec_bb);
+		builder.CreateStore(builder.CreateSub(rc_reg, builder.getInt32(1), ""), rc_ptr_reg);
+		builder.CreateBr(join_bb);
+	}
+
+	builder.SetInsertPoint(runtime_bb);
+	builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &arg_reg, &itype_reg }, "");
+	builder.CreateBr(join_bb);
+
+	builder.SetInsertPoint(join_bb);
+}
+
+
 void generate_retain(llvm_function_generator_t& gen_acc, llvm::Value& value_reg, const type_t& type0){
 	QUARK_ASSERT(gen_acc.gen.type_lookup.check_invariant());
 	QUARK_ASSERT(type0.check_invariant());
@@ -1079,23 +1288,26 @@ void generate_retain(llvm_function_generator_t& gen_acc, llvm::Value& value_reg,
 	const auto& types = gen_acc.gen.type_lookup.state.types;
 	const auto type_peek = peek2(types, type0);
 
-	auto& frp_reg = *gen_acc.get_callers_fcp();
 	auto& itype_reg = *generate_itype_constant(gen_acc.gen, type_peek);
 	auto& builder = gen_acc.get_builder();
 
 	if(is_rc_value(type_peek)){
 		if(type_peek.is_string()){
 			const auto res = resolve_func(gen_acc.gen.link_map, "retain_vector_carray");
-			builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg }, "");
+			generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, true, true);
 		}
 		else if(type_peek.is_vector()){
 			if(is_vector_carray(types, gen_acc.gen.settings.config, type0)){
 				const auto res = resolve_func(gen_acc.gen.link_map, "retain_vector_carray");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg }, "");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
 			}
 			else if(is_vector_hamt(types, gen_acc.gen.settings.config, type0)){
 				const auto res = resolve_func(gen_acc.gen.link_map, "retain_vector_hamt");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg }, "");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
+			}
+			else if(is_vector_soa(types, gen_acc.gen.settings.config, type0)){
+				const auto res = resolve_func(gen_acc.gen.link_map, "retain_vector_soa");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
 			}
 			else{
 				QUARK_ASSERT(false);
@@ -1104,11 +1316,15 @@ void generate_retain(llvm_function_generator_t& gen_acc, llvm::Value& value_reg,
 		else if(type_peek.is_dict()){
 			if(is_dict_cppmap(types, gen_acc.gen.settings.config, type0)){
 				const auto res = resolve_func(gen_acc.gen.link_map, "retain_dict_cppmap");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg }, "");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
 			}
 			else if(is_dict_hamt(types, gen_acc.gen.settings.config, type0)){
 				const auto res = resolve_func(gen_acc.gen.link_map, "retain_dict_hamt");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg }, "");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
+			}
+			else if(is_dict_hash(types, gen_acc.gen.settings.config, type0)){
+				const auto res = resolve_func(gen_acc.gen.link_map, "retain_dict_hash");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
 			}
 			else{
 				QUARK_ASSERT(false);
@@ -1116,12 +1332,12 @@ void generate_retain(llvm_function_generator_t& gen_acc, llvm::Value& value_reg,
 		}
 		else if(type_peek.is_json()){
 			const auto res = resolve_func(gen_acc.gen.link_map, "retain_json");
-			builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg }, "");
+			generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, true);
 		}
 		else if(type_peek.is_struct()){
 			auto generic_vec_reg = builder.CreateCast(llvm::Instruction::CastOps::BitCast, &value_reg, get_generic_struct_type_byvalue(gen_acc.gen.type_lookup)->getPointerTo(), "");
 			const auto res = resolve_func(gen_acc.gen.link_map, "retain_struct");
-			builder.CreateCall(res.llvm_codegen_f, { &frp_reg, generic_vec_reg, &itype_reg }, "");
+			generate_inline_rc_change(gen_acc, res, *generic_vec_reg, itype_reg, false, true);
 		}
 		else{
 			QUARK_ASSERT(false);
@@ -1146,8 +1362,10 @@ std::vector<function_bind_t> retain_funcs(llvm::LLVMContext& context, const llvm
 	return std::vector<function_bind_t> {
 		function_bind_t{ "retain_vector_carray", make_retain(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_vector_carray) },
 		function_bind_t{ "retain_vector_hamt", make_retain(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_vector_hamt) },
+		function_bind_t{ "retain_vector_soa", make_retain(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_vector_soa) },
 		function_bind_t{ "retain_dict_cppmap", make_retain(context, type_lookup, *make_generic_dict_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_dict_cppmap) },
 		function_bind_t{ "retain_dict_hamt", make_retain(context, type_lookup, *make_generic_dict_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_dict_hamt) },
+		function_bind_t{ "retain_dict_hash", make_retain(context, type_lookup, *make_generic_dict_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_dict_hash) },
 		function_bind_t{ "retain_json", make_retain(context, type_lookup, *get_llvm_type_as_arg(type_lookup, type_t::make_json())), reinterpret_cast<void*>(floydrt_retain_json) },
 		function_bind_t{ "retain_struct", make_retain(context, type_lookup, *get_generic_struct_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_retain_struct) }
 	};
@@ -1221,6 +1439,17 @@ static void floydrt_release_vector_hamt_nonpod(floyd_runtime_t* frp, runtime_val
 	}
 }
 
+static void floydrt_release_vector_soa(floyd_runtime_t* frp, runtime_value_t vec, runtime_type_t type0){
+	auto& r = get_floyd_runtime(frp);
+	const auto& type = lookup_type_ref(r.backend, type0);
+	QUARK_ASSERT(is_vector_soa(r.backend.types, r.backend.config, type));
+
+	//	Check really only required when unwinding locals.
+	if(vec.vector_soa_ptr != nullptr){
+		release_vector_soa(r.backend, vec, type);
+	}
+}
+
 
 static void floydrt_release_dict_cppmap(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type0){
 	auto& r = get_floyd_runtime(frp);
@@ -1246,6 +1475,18 @@ const auto& type = lookup_type_ref(r.backend, type0);
 		release_dict_hamt(r.backend, dict, type);
 	}
 }
+static void floydrt_release_dict_hash(floyd_runtime_t* frp, runtime_value_t dict, runtime_type_t type0){
+	auto& r = get_floyd_runtime(frp);
+	const auto& type = lookup_type_ref(r.backend, type0);
+#if DEBUG
+	QUARK_ASSERT(is_dict_hash(r.backend.types, r.backend.config, type));
+#endif
+
+	//	Check really only required when unwinding locals.
+	if(dict.dict_hash_ptr != nullptr){
+		release_dict_hash(r.backend, dict, type);
+	}
+}
 
 
 
@@ -1297,8 +1538,10 @@ std::vector<function_bind_t> release_funcs(llvm::LLVMContext& context, const llv
 		function_bind_t{ "release_vector_carray_nonpod", make_release(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_vector_carray_nonpod) },
 		function_bind_t{ "release_vector_hamt_pod", make_release(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_vector_hamt_pod) },
 		function_bind_t{ "release_vector_hamt_nonpod", make_release(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_vector_hamt_nonpod) },
+		function_bind_t{ "release_vector_soa", make_release(context, type_lookup, *make_generic_vec_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_vector_soa) },
 		function_bind_t{ "release_dict_cppmap", make_release(context, type_lookup, *make_generic_dict_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_dict_cppmap) },
 		function_bind_t{ "release_dict_hamt", make_release(context, type_lookup, *make_generic_dict_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_dict_hamt) },
+		function_bind_t{ "release_dict_hash", make_release(context, type_lookup, *make_generic_dict_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_dict_hash) },
 		function_bind_t{ "release_json", make_release(context, type_lookup, *get_llvm_type_as_arg(type_lookup, type_t::make_json())), reinterpret_cast<void*>(floydrt_release_json) },
 		function_bind_t{ "release_struct", make_release(context, type_lookup, *get_generic_struct_type_byvalue(type_lookup)->getPointerTo()), reinterpret_cast<void*>(floydrt_release_struct) }
 	};
@@ -1308,35 +1551,37 @@ void generate_release(llvm_function_generator_t& gen_acc, llvm::Value& value_reg
 	QUARK_ASSERT(gen_acc.check_invariant());
 	QUARK_ASSERT(type.check_invariant());
 
-	auto& frp_reg = *gen_acc.get_callers_fcp();
 	auto& itype_reg = *generate_itype_constant(gen_acc.gen, type);
-	auto& builder = gen_acc.get_builder();
 	const auto& types = gen_acc.gen.type_lookup.state.types;
 	const auto peek = peek2(types, type);
 
 	if(is_rc_value(peek)){
 		if(peek.is_string()){
 			const auto res = resolve_func(gen_acc.gen.link_map, "release_vector_carray_pod");
-			builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+			generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, true, false);
 		}
 		else if(peek.is_vector()){
 			const bool is_element_pod = is_rc_value(peek2(types, peek.get_vector_element_type(types))) ? false : true;
 
 			if(is_vector_carray(types, gen_acc.gen.settings.config, type) && is_element_pod == true){
 				const auto res = resolve_func(gen_acc.gen.link_map, "release_vector_carray_pod");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 			}
 			else if(is_vector_carray(types, gen_acc.gen.settings.config, type) && is_element_pod == false){
 				const auto res = resolve_func(gen_acc.gen.link_map, "release_vector_carray_nonpod");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 			}
 			else if(is_vector_hamt(types, gen_acc.gen.settings.config, type) && is_element_pod == true){
 				const auto res = resolve_func(gen_acc.gen.link_map, "release_vector_hamt_pod");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 			}
 			else if(is_vector_hamt(types, gen_acc.gen.settings.config, type) && is_element_pod == false){
 				const auto res = resolve_func(gen_acc.gen.link_map, "release_vector_hamt_nonpod");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
+			}
+			else if(is_vector_soa(types, gen_acc.gen.settings.config, type)){
+				const auto res = resolve_func(gen_acc.gen.link_map, "release_vector_soa");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 			}
 			else{
 				QUARK_ASSERT(false);
@@ -1345,11 +1590,15 @@ void generate_release(llvm_function_generator_t& gen_acc, llvm::Value& value_reg
 		else if(peek.is_dict()){
 			if(is_dict_cppmap(types, gen_acc.gen.settings.config, type)){
 				const auto res = resolve_func(gen_acc.gen.link_map, "release_dict_cppmap");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 			}
 			else if(is_dict_hamt(types, gen_acc.gen.settings.config, type)){
 				const auto res = resolve_func(gen_acc.gen.link_map, "release_dict_hamt");
-				builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
+			}
+			else if(is_dict_hash(types, gen_acc.gen.settings.config, type)){
+				const auto res = resolve_func(gen_acc.gen.link_map, "release_dict_hash");
+				generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 			}
 			else{
 				QUARK_ASSERT(false);
@@ -1357,11 +1606,11 @@ void generate_release(llvm_function_generator_t& gen_acc, llvm::Value& value_reg
 		}
 		else if(peek.is_json()){
 			const auto res = resolve_func(gen_acc.gen.link_map, "release_json");
-			builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+			generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 		}
 		else if(peek.is_struct()){
 			const auto res = resolve_func(gen_acc.gen.link_map, "release_struct");
-			builder.CreateCall(res.llvm_codegen_f, { &frp_reg, &value_reg, &itype_reg });
+			generate_inline_rc_change(gen_acc, res, value_reg, itype_reg, false, false);
 		}
 		else{
 			QUARK_ASSERT(false);
@@ -1391,6 +1640,7 @@ std::vector<function_bind_t> get_runtime_function_binds(llvm::LLVMContext& conte
 		floydrt_allocate_dict__make(context, type_lookup),
 		floydrt_lookup_dict_cppmap__make(context, type_lookup),
 		floydrt_lookup_dict_hamt__make(context, type_lookup),
+		floydrt_lookup_dict_hash__make(context, type_lookup),
 		floydrt_store_dict_mutable__make(context, type_lookup),
 
 		floydrt_allocate_json__make(context, type_lookup),
@@ -1401,6 +1651,7 @@ std::vector<function_bind_t> get_runtime_function_binds(llvm::LLVMContext& conte
 		floydrt_update_struct_member__make(context, type_lookup),
 
 		floydrt_compare_values__make(context, type_lookup),
+		floydrt_share_global__make(context, type_lookup),
 		floydrt_get_profile_time__make(context, type_lookup),
 		floydrt_analyse_benchmark_samples__make(context, type_lookup),
 
@@ -1434,6 +1685,8 @@ runtime_functions_t::runtime_functions_t(const std::vector<function_link_entry_t
 	floydrt_store_vector_element_hamt_mutable(resolve_func(function_defs, "store_vector_element_hamt_mutable")),
 	floydrt_concatunate_vectors(resolve_func(function_defs, "concatunate_vectors")),
 	floydrt_load_vector_element_hamt(resolve_func(function_defs, "load_vector_element_hamt")),
+	floydrt_store_vector_element_soa_mutable(resolve_func(function_defs, "store_vector_element_soa_mutable")),
+	floydrt_load_vector_element_soa(resolve_func(function_defs, "load_vector_element_soa")),
 
 
 	floydrt_allocate_dict(resolve_func(function_defs, "allocate_dict")),
@@ -1447,6 +1700,7 @@ runtime_functions_t::runtime_functions_t(const std::vector<function_link_entry_t
 	floydrt_allocate_struct(resolve_func(function_defs, "allocate_struct")),
 
 	floydrt_compare_values(resolve_func(function_defs, "compare_values")),
+	floydrt_share_global(resolve_func(function_defs, "share_global")),
 
 
 	floydrt_get_profile_time(resolve_func(function_defs, "get_profile_time")),
@@ -41,6 +41,8 @@ struct runtime_functions_t {
 	const function_link_entry_t floydrt_store_vector_element_hamt_mutable;
 	const function_link_entry_t floydrt_concatunate_vectors;
 	const function_link_entry_t floydrt_load_vector_element_hamt;
+	const function_link_entry_t floydrt_store_vector_element_soa_mutable;
+	const function_link_entry_t floydrt_load_vector_element_soa;
 	
 	const function_link_entry_t floydrt_allocate_dict;
 
@@ -51,6 +53,7 @@ struct runtime_functions_t {
 	const function_link_entry_t floydrt_allocate_struct;
 
 	const function_link_entry_t floydrt_compare_values;
+	const function_link_entry_t floydrt_share_global;
 
 	const function_link_entry_t floydrt_get_profile_time;
 	const function_link_entry_t floydrt_analyse_benchmark_samples;
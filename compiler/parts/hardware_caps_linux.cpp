@@ -191,7 +191,7 @@ std::string str_value(std::string in_string) {
 // /sys/devices/system/cpu/cpu0/cache/index0/size
 static hardware_caps_t read_caps_linux()
 {
-	hardware_caps_t ret;
+	hardware_caps_t ret {};
 	std::ifstream fileStat("/proc/cpuinfo");
 	//std::ifstream fileStat("/sys/devices/system/cpu/cpu0/cache/index0/size");
 
@@ -253,6 +253,7 @@ static hardware_caps_t read_caps_linux()
     ret._hw_mem_size= pages * page_size;
 	ret._hw_page_size= sysconf(_SC_PAGE_SIZE);
 	ret._hw_physical_processor_count=sysconf(_SC_NPROCESSORS_ONLN);
+	ret._hw_logical_processor_count=sysconf(_SC_NPROCESSORS_ONLN);
 
 	//ret._hw_scalar_align = alignof(std::max_align_t);
 
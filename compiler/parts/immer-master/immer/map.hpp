@@ -114,6 +114,10 @@ class map
 
         auto operator() (const K& v)
         { return Hash{}(v); }
+
+        template <typename Key>
+        auto operator() (const Key& v)
+        { return Hash{}(v); }
     };
 
     struct equal_key
@@ -123,6 +127,10 @@ class map
 
         auto operator() (const value_t& a, const K& b)
         { return Equal{}(a.first, b); }
+
+        template <typename Key>
+        auto operator() (const value_t& a, const Key& b)
+        { return Equal{}(a.first, b); }
     };
 
     struct equal_value
@@ -237,6 +245,17 @@ public:
     { return impl_.template get<project_value_ptr,
                                 detail::constantly<const T*, nullptr>>(k); }
 
+    /*!
+     * Like find() but takes any key type that `Hash` and `Equal` accept,
+     * when `Hash::is_transparent` is defined. No `K` is constructed.
+     */
+    template <typename Key,
+              typename U = Hash,
+              typename   = typename U::is_transparent>
+    IMMER_NODISCARD const T* find(const Key& k) const
+    { return impl_.template get<project_value_ptr,
+                                detail::constantly<const T*, nullptr>>(k); }
+
     /*!
      * Returns whether the sets are equal.
      */
@@ -53,6 +53,17 @@ struct lexical_scope_t {
 
 
 
+//////////////////////////////////////		send_site_t
+
+//	A send() to a process key that is a string literal. Its message type is checked against the process's
+//	message type once all globals are known, see check_send_message_types().
+struct send_site_t {
+	location_t location;
+	std::string process_key;
+	type_t message_type;
+};
+
+
 //////////////////////////////////////		analyser_t
 
 
@@ -79,6 +90,7 @@ struct analyser_t {
 	public: container_t _container_def;
 
 	public: std::vector<expression_t> benchmark_defs;
+	public: std::vector<send_site_t> _send_sites;
 
 	public: int scope_id_generator;
 };
@@ -2102,6 +2114,65 @@ static std::pair<analyser_t, expression_t> analyse_intrinsic_fallthrough_express
 	};
 }
 
+//	send()'s message argument is any-type. Remember calls to a known process so check_send_message_types() can
+//	report the wrong message type at compile time instead of when the message arrives.
+static std::pair<analyser_t, expression_t> analyse_intrinsic_send_expression(const analyser_t& a, const statement_t& parent, const std::vector<expression_t>& call_args){
+	QUARK_ASSERT(a.check_invariant());
+	QUARK_ASSERT(parent.check_invariant());
+
+	auto result = analyse_intrinsic_fallthrough_expression(a, parent, call_args, a._imm->intrinsic_signatures.send);
+	auto& a_acc = result.first;
+
+	const auto& args = std::get<expression_t::intrinsic_t>(result.second._expression_variant).args;
+	QUARK_ASSERT(args.size() == 2);
+	if(std::holds_alternative<expression_t::literal_exp_t>(args[0]._expression_variant)){
+		const auto& process_key = args[0].get_literal().get_string_value();
+		a_acc._send_sites.push_back(send_site_t{ parent.location, process_key, analyze_expr_output_type(a_acc, args[1]) });
+	}
+	return result;
+}
+
+//	Mirrors the runtime check in send(): a process whose function takes a json message accepts any value,
+//	otherwise the message must have the type of the function's message argument. Strings and json values are
+//	left to the runtime since they can be "stop", which any process accepts.
+static void check_send_message_types(const analyser_t& a){
+	QUARK_ASSERT(a.check_invariant());
+
+	for(const auto& site: a._send_sites){
+		const auto message_peek = peek2(a._types, site.message_type);
+		if(message_peek.is_string() || message_peek.is_json()){
+			continue;
+		}
+
+		for(const auto& bus: a._container_def._clock_busses){
+			const auto it = bus.second._processes.find(site.process_key);
+			if(it == bus.second._processes.end()){
+				continue;
+			}
+
+			const auto symbol_ptr = find_symbol_by_name(a, it->second);
+			if(symbol_ptr.first == nullptr){
+				continue;
+			}
+			const auto function_peek = peek2(a._types, symbol_ptr.first->get_value_type());
+			if(function_peek.is_function() == false){
+				continue;
+			}
+			const auto process_args = function_peek.get_function_args(a._types);
+			if(process_args.size() != 2 || peek2(a._types, process_args[1]).is_json() || process_args[1] == site.message_type){
+				continue;
+			}
+
+			std::stringstream what;
+			what << "send(): process \"" << site.process_key << "\" takes messages of type "
+			<< type_to_compact_string(a._types, process_args[1])
+			<< ", cannot send "
+			<< type_to_compact_string(a._types, site.message_type) << ".";
+			throw_compiler_error(site.location, what.str());
+		}
+	}
+}
+
 /*
 	There are several types of calls in the input AST.
 
@@ -2233,7 +2304,7 @@ std::pair<analyser_t, expression_t> analyse_call_expression(const analyser_t& a0
 					return analyse_intrinsic_fallthrough_expression(a_acc, parent, details.args, intrinsic_signatures.print);
 				}
 				else if(s == intrinsic_signatures.send.name){
-					return analyse_intrinsic_fallthrough_expression(a_acc, parent, details.args, intrinsic_signatures.send);
+					return analyse_intrinsic_send_expression(a_acc, parent, details.args);
 				}
 
 
@@ -2759,6 +2830,8 @@ const body_t make_global_body(analyser_t& a){
 	const auto result = analyse_statements(a, global_body._statements, type_t::make_void());
 	a = result.first;
 
+	check_send_message_types(a);
+
 	const auto body2 = body_t(result.second, result.first._lexical_scope_stack.back().symbols);
 
 	if(false) trace_analyser(a);
@@ -0,0 +1,139 @@
+//
+//  bytecode_dispatch_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-11-12.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "floyd_interpreter.h"
+#include "bytecode_interpreter.h"
+#include "compiler_helpers.h"
+#include "ast_value.h"
+#include "json_support.h"
+
+#include <string>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+/*
+	Measures execute_instructions() in the build's dispatch mode, see BC_THREADED_DISPATCH.
+	Build once with -DBC_THREADED_DISPATCH=0 and once with -DBC_THREADED_DISPATCH=1 to compare.
+	Build with -DBC_OPCODE_HISTOGRAM=1 to trace which instructions and pairs of instructions each benchmark runs.
+	The bytecode backend doesn't run benchmark-def, so the workloads from examples/benchmarks.floyd are plain
+	functions here.
+*/
+
+static const char* get_dispatch_label(){
+	return BC_THREADED_DISPATCH ? "threaded" : "switch";
+}
+
+//	Compiles floyd_program once, then calls its f() once per iteration.
+static void run_floyd_f(benchmark::State& state, const std::string& floyd_program){
+	const auto cu = make_compilation_unit_nolib(floyd_program, "");
+	const auto program = compile_to_bytecode(cu);
+	interpreter_t vm(program);
+	const auto f = find_global_symbol(vm, "f");
+
+	for (auto _ : state) {
+		(void)_;
+
+		const auto result = call_function(vm, f, {});
+		benchmark::DoNotOptimize(result);
+	}
+	state.SetLabel(get_dispatch_label());
+
+#if BC_OPCODE_HISTOGRAM
+	QUARK_TRACE_SS(json_to_pretty_string(opcode_histogram_to_json(vm._opcode_histogram, 20)));
+#endif
+}
+
+
+////////////////////////////////		BENCHMARK -- examples/benchmarks.floyd
+
+
+//	"hello"
+static void BM_bc_dispatch_hello(benchmark::State& state) {
+	run_floyd_f(state, R"(
+		func void hello_test(int count){
+			for(e in 0 ... count){
+				let a = "hello, world!"
+			}
+		}
+
+		func int f(){
+			hello_test(100000)
+			return 0
+		}
+	)");
+}
+BENCHMARK(BM_bc_dispatch_hello)->Unit(benchmark::kMillisecond);
+
+//	"Linear veq", the largest instance.
+static void BM_bc_dispatch_linear_veq(benchmark::State& state) {
+	run_floyd_f(state, R"(
+		func int f(){
+			mutable acc = 0
+			for(a in 0 ..< 100000){
+				acc = acc + 1
+			}
+			return acc
+		}
+	)");
+}
+BENCHMARK(BM_bc_dispatch_linear_veq)->Unit(benchmark::kMillisecond);
+
+
+////////////////////////////////		BENCHMARK -- calls
+
+
+//	Mostly k_call / k_return: shows the cost of recursing into execute_instructions() per call.
+static void BM_bc_dispatch_fibonacci(benchmark::State& state) {
+	run_floyd_f(state, R"(
+		func int fibonacci(int n) {
+			if (n <= 1){
+				return n
+			}
+			return fibonacci(n - 2) + fibonacci(n - 1)
+		}
+
+		func int f(){
+			return fibonacci(20)
+		}
+	)");
+}
+BENCHMARK(BM_bc_dispatch_fibonacci)->Unit(benchmark::kMillisecond);
+
+
+////////////////////////////////		BENCHMARK -- branches
+
+
+//	Mostly integer compares and branches: k_logical_equal_int + k_branch_false_bool, while-loops.
+static void BM_bc_dispatch_count_primes(benchmark::State& state) {
+	run_floyd_f(state, R"(
+		func int f(){
+			mutable count = 0
+			for(n in 2 ..< 5000){
+				mutable prime = true
+				mutable d = 2
+				while(d * d <= n && prime){
+					if(n % d == 0){
+						prime = false
+					}
+					d = d + 1
+				}
+				if(prime){
+					count = count + 1
+				}
+			}
+			return count
+		}
+	)");
+}
+BENCHMARK(BM_bc_dispatch_count_primes)->Unit(benchmark::kMillisecond);
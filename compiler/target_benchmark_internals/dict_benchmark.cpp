@@ -0,0 +1,231 @@
+//
+//  dict_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-06.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "value_backend.h"
+#include "value_features.h"
+#include "value_thunking.h"
+
+#include <string>
+#include <vector>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+static std::vector<std::string> make_keys(int64_t count){
+	std::vector<std::string> result;
+	for(int64_t i = 0 ; i < count ; i++){
+		result.push_back("key_" + std::to_string(i * 7919));
+	}
+	return result;
+}
+
+
+
+////////////////////////////////		BENCHMARK -- lookup, cppmap vs hamt vs hash
+
+
+//	Looks up every key once, like dict[key] does after from_runtime_string().
+template <typename MAP, typename FIND> void run_dict_lookup(benchmark::State& state, MAP& m, FIND find){
+	const auto count = state.range(0);
+	const auto keys = make_keys(count);
+	for(int64_t i = 0 ; i < count ; i++){
+		m.insert_or_assign(keys[i], make_runtime_int(i));
+	}
+
+	for (auto _ : state) {
+		(void)_;
+
+		int64_t sum = 0;
+		for(const auto& key: keys){
+			sum += find(m, key).int_value;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_dict_lookup_cppmap(benchmark::State& state) {
+	CPPMAP m;
+	run_dict_lookup(state, m, [](const CPPMAP& m, const std::string& key){ return m.find(key)->second; });
+}
+BENCHMARK(BM_dict_lookup_cppmap)->Arg(16)->Arg(1024)->Arg(65536);
+
+//	immer::map has no insert_or_assign(), wrap it.
+struct hamt_builder_t {
+	void insert_or_assign(const std::string& key, runtime_value_t value){
+		m = m.set(key, value);
+	}
+	HAMT_MAP m;
+};
+
+static void BM_dict_lookup_hamt(benchmark::State& state) {
+	hamt_builder_t m;
+	run_dict_lookup(state, m, [](const hamt_builder_t& m, const std::string& key){ return *m.m.find(key); });
+}
+BENCHMARK(BM_dict_lookup_hamt)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_dict_lookup_hash(benchmark::State& state) {
+	HASH_MAP m;
+	run_dict_lookup(state, m, [](const HASH_MAP& m, const std::string& key){ return *m.find(key); });
+}
+BENCHMARK(BM_dict_lookup_hash)->Arg(16)->Arg(1024)->Arg(65536);
+
+
+
+////////////////////////////////		BENCHMARK -- dict[key] with runtime string keys
+
+
+//	Looks up runtime strings like floydrt_lookup_dict_xxx() does. make_key = false copies each key into a
+//	std::string first, like before string_key_t.
+template <typename MAP, typename FIND> void run_runtime_key_lookup(benchmark::State& state, MAP& m, bool make_key, FIND find){
+	const auto count = state.range(0);
+
+	types_t types;
+	value_backend_t backend({}, {}, types, make_default_config());
+
+	const auto key_strings = make_keys(count);
+	std::vector<runtime_value_t> keys;
+	for(int64_t i = 0 ; i < count ; i++){
+		m.insert_or_assign(key_strings[i], make_runtime_int(i));
+		keys.push_back(to_runtime_string2(backend, key_strings[i]));
+	}
+
+	for (auto _ : state) {
+		(void)_;
+
+		int64_t sum = 0;
+		for(const auto& key: keys){
+			if(make_key){
+				sum += find(m, make_string_key(key)).int_value;
+			}
+			else{
+				const auto s = from_runtime_string2(backend, key);
+				sum += find(m, string_key_t { s, std::hash<std::string_view>{}(s) }).int_value;
+			}
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+
+	for(const auto& key: keys){
+		release_value(backend, key, type_t::make_string());
+	}
+}
+
+static const auto find_cppmap = [](const CPPMAP& m, const string_key_t& key){ return m.find(key.chars)->second; };
+static const auto find_hamt = [](const hamt_builder_t& m, const string_key_t& key){ return *m.m.find(key); };
+static const auto find_hash = [](const HASH_MAP& m, const string_key_t& key){ return *m.find(key.chars, key.hash); };
+
+static void BM_dict_runtime_key_cppmap_std_string(benchmark::State& state) {
+	CPPMAP m;
+	run_runtime_key_lookup(state, m, false, find_cppmap);
+}
+BENCHMARK(BM_dict_runtime_key_cppmap_std_string)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_dict_runtime_key_cppmap_string_key(benchmark::State& state) {
+	CPPMAP m;
+	run_runtime_key_lookup(state, m, true, find_cppmap);
+}
+BENCHMARK(BM_dict_runtime_key_cppmap_string_key)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_dict_runtime_key_hamt_std_string(benchmark::State& state) {
+	hamt_builder_t m;
+	run_runtime_key_lookup(state, m, false, find_hamt);
+}
+BENCHMARK(BM_dict_runtime_key_hamt_std_string)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_dict_runtime_key_hamt_string_key(benchmark::State& state) {
+	hamt_builder_t m;
+	run_runtime_key_lookup(state, m, true, find_hamt);
+}
+BENCHMARK(BM_dict_runtime_key_hamt_string_key)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_dict_runtime_key_hash_std_string(benchmark::State& state) {
+	HASH_MAP m;
+	run_runtime_key_lookup(state, m, false, find_hash);
+}
+BENCHMARK(BM_dict_runtime_key_hash_std_string)->Arg(16)->Arg(1024)->Arg(65536);
+
+static void BM_dict_runtime_key_hash_string_key(benchmark::State& state) {
+	HASH_MAP m;
+	run_runtime_key_lookup(state, m, true, find_hash);
+}
+BENCHMARK(BM_dict_runtime_key_hash_string_key)->Arg(16)->Arg(1024)->Arg(65536);
+
+
+
+////////////////////////////////		BENCHMARK -- d = update(d, key, value), cppmap vs hamt vs hash
+
+
+//	Builds a dict with count keys using update(), one key at a time. Nobody else holds the dict so it can be mutated in place.
+static void run_dict_update(benchmark::State& state, dict_backend mode){
+	const auto count = state.range(0);
+
+	types_t types;
+	const auto dict_type = make_dict(types, type_t::make_int());
+	auto config = make_default_config();
+	config.dict_backend_mode = mode;
+	value_backend_t backend({}, {}, types, config);
+
+	std::vector<runtime_value_t> keys;
+	for(const auto& key: make_keys(count)){
+		keys.push_back(to_runtime_string2(backend, key));
+	}
+
+	for (auto _ : state) {
+		(void)_;
+
+		//	update__dict_xxx() takes over the old dict's reference, like "d = update(d, key, value)" in Floyd.
+		auto dict = mode == dict_backend::cppmap
+			? alloc_dict_cppmap(backend.heap, dict_type)
+			: mode == dict_backend::hamt ? alloc_dict_hamt(backend.heap, dict_type) : alloc_dict_hash(backend.heap, dict_type);
+		for(int64_t i = 0 ; i < count ; i++){
+			if(mode == dict_backend::cppmap){
+				dict = update__dict_cppmap(backend, dict, dict_type.get_data(), keys[i], make_runtime_int(i));
+			}
+			else if(mode == dict_backend::hamt){
+				dict = update__dict_hamt(backend, dict, dict_type.get_data(), keys[i], make_runtime_int(i));
+			}
+			else{
+				dict = update__dict_hash(backend, dict, dict_type.get_data(), keys[i], make_runtime_int(i));
+			}
+		}
+		release_dict(backend, dict, dict_type);
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+
+	for(const auto& key: keys){
+		release_value(backend, key, type_t::make_string());
+	}
+}
+
+static void BM_dict_update_cppmap(benchmark::State& state) {
+	//	libstdc++'s std::map is 48 bytes and doesn't fit inside DICT_CPPMAP_T.
+	if(sizeof(CPPMAP) > heap_alloc_64_t::k_data_bytes){
+		state.SkipWithError("std::map is too big for heap_alloc_64_t::data on this platform");
+		return;
+	}
+	run_dict_update(state, dict_backend::cppmap);
+}
+BENCHMARK(BM_dict_update_cppmap)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_dict_update_hamt(benchmark::State& state) {
+	run_dict_update(state, dict_backend::hamt);
+}
+BENCHMARK(BM_dict_update_hamt)->Arg(16)->Arg(256)->Arg(4096);
+
+static void BM_dict_update_hash(benchmark::State& state) {
+	run_dict_update(state, dict_backend::hash);
+}
+BENCHMARK(BM_dict_update_hash)->Arg(16)->Arg(256)->Arg(4096);
@@ -0,0 +1,100 @@
+//
+//  heap_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-02.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "value_backend.h"
+
+#include <vector>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+////////////////////////////////		BENCHMARK -- alloc_64() using malloc() vs size-class pools
+
+
+//	Allocates a batch of small allocs then disposes them all, like building and dropping a vector of strings.
+static void run_alloc_dispose_batch(benchmark::State& state, heap_backend backend_mode){
+	const auto batch_size = state.range(0);
+	const auto word_count = state.range(1);
+
+	heap_t heap(false, backend_mode);
+	std::vector<heap_alloc_64_t*> allocs(batch_size, nullptr);
+
+	for (auto _ : state) {
+		(void)_;
+
+		for(int i = 0 ; i < batch_size ; i++){
+			allocs[i] = alloc_64(heap, word_count, make_undefined(), "bench");
+		}
+		benchmark::DoNotOptimize(allocs.data());
+		for(int i = 0 ; i < batch_size ; i++){
+			if(dec_rc(*allocs[i]) == 0){
+				dispose_alloc(*allocs[i]);
+			}
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+static void BM_alloc_64_malloc(benchmark::State& state) {
+	run_alloc_dispose_batch(state, heap_backend::malloc);
+}
+BENCHMARK(BM_alloc_64_malloc)->Ranges({ { 1 << 4, 1 << 14 }, { 0, 8 } });
+
+static void BM_alloc_64_pool(benchmark::State& state) {
+	run_alloc_dispose_batch(state, heap_backend::pool);
+}
+BENCHMARK(BM_alloc_64_pool)->Ranges({ { 1 << 4, 1 << 14 }, { 0, 8 } });
+
+
+
+//	Interleaved alloc / dispose with a sliding window of live allocs, mixed sizes. Closer to a running program.
+static void run_alloc_churn(benchmark::State& state, heap_backend backend_mode){
+	const auto live_count = state.range(0);
+
+	heap_t heap(false, backend_mode);
+	std::vector<heap_alloc_64_t*> live(live_count, nullptr);
+	for(int i = 0 ; i < live_count ; i++){
+		live[i] = alloc_64(heap, i & 7, make_undefined(), "bench");
+	}
+
+	int64_t pos = 0;
+	for (auto _ : state) {
+		(void)_;
+
+		const auto index = pos % live_count;
+		if(dec_rc(*live[index]) == 0){
+			dispose_alloc(*live[index]);
+		}
+		live[index] = alloc_64(heap, pos & 7, make_undefined(), "bench");
+		benchmark::DoNotOptimize(live[index]);
+		pos++;
+	}
+
+	for(auto a: live){
+		if(dec_rc(*a) == 0){
+			dispose_alloc(*a);
+		}
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_alloc_64_churn_malloc(benchmark::State& state) {
+	run_alloc_churn(state, heap_backend::malloc);
+}
+BENCHMARK(BM_alloc_64_churn_malloc)->Range(1 << 6, 1 << 16);
+
+static void BM_alloc_64_churn_pool(benchmark::State& state) {
+	run_alloc_churn(state, heap_backend::pool);
+}
+BENCHMARK(BM_alloc_64_churn_pool)->Range(1 << 6, 1 << 16);
@@ -0,0 +1,182 @@
+//
+//  process_inbox_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-04.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "process_inbox.h"
+#include "process_scheduler.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+////////////////////////////////		BENCHMARK -- message throughput, mutex + deque vs mpsc_queue_t
+
+
+//	The inbox processes used to have: every send locks, pushes and signals. The receiver pops one message per lock.
+struct locked_inbox_t {
+	void push(int64_t message){
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			messages.push_front(message);
+		}
+		condition.notify_one();
+	}
+
+	int64_t pop_wait(){
+		std::unique_lock<std::mutex> lk(mutex);
+		condition.wait(lk, [&](){ return messages.empty() == false; });
+		const auto result = messages.back();
+		messages.pop_back();
+		return result;
+	}
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::deque<int64_t> messages;
+};
+
+static const int64_t k_messages_per_producer = 1 << 14;
+
+static void BM_inbox_mutex_deque(benchmark::State& state) {
+	const auto producer_count = state.range(0);
+
+	for (auto _ : state) {
+		(void)_;
+
+		locked_inbox_t inbox;
+		std::vector<std::thread> producers;
+		for(int64_t p = 0 ; p < producer_count ; p++){
+			producers.push_back(std::thread([&inbox](){
+				for(int64_t i = 0 ; i < k_messages_per_producer ; i++){
+					inbox.push(i);
+				}
+			}));
+		}
+
+		int64_t sum = 0;
+		for(int64_t i = 0 ; i < producer_count * k_messages_per_producer ; i++){
+			sum += inbox.pop_wait();
+		}
+		benchmark::DoNotOptimize(sum);
+
+		for(auto& t: producers){
+			t.join();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * producer_count * k_messages_per_producer);
+}
+BENCHMARK(BM_inbox_mutex_deque)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+static void BM_inbox_mpsc(benchmark::State& state) {
+	const auto producer_count = state.range(0);
+
+	std::vector<int64_t> batch;
+	for (auto _ : state) {
+		(void)_;
+
+		mpsc_queue_t<int64_t> inbox;
+		std::vector<std::thread> producers;
+		for(int64_t p = 0 ; p < producer_count ; p++){
+			producers.push_back(std::thread([&inbox](){
+				for(int64_t i = 0 ; i < k_messages_per_producer ; i++){
+					inbox.push(i);
+				}
+			}));
+		}
+
+		int64_t sum = 0;
+		int64_t received = 0;
+		while(received < producer_count * k_messages_per_producer){
+			batch.clear();
+			const auto count = inbox.pop_batch(batch, k_process_slice_message_count);
+			for(const auto e: batch){
+				sum += e;
+			}
+			received += count;
+			if(count == 0){
+				std::this_thread::yield();
+			}
+		}
+		benchmark::DoNotOptimize(sum);
+
+		for(auto& t: producers){
+			t.join();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * producer_count * k_messages_per_producer);
+}
+BENCHMARK(BM_inbox_mpsc)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+
+
+////////////////////////////////		BENCHMARK -- processes passing messages through the scheduler
+
+
+//	64 processes, each forwards every message it gets to the next process. 8 messages circulate at once.
+static void BM_process_ring_messages(benchmark::State& state) {
+	const auto thread_count = state.range(0);
+	const int process_count = 64;
+	const int token_count = 8;
+	const int64_t hop_count = 20000;
+
+	for (auto _ : state) {
+		(void)_;
+
+		process_scheduler_t scheduler(process_count);
+		std::vector<std::unique_ptr<mpsc_queue_t<int64_t>>> inboxes;
+		for(int i = 0 ; i < process_count ; i++){
+			inboxes.push_back(std::make_unique<mpsc_queue_t<int64_t>>());
+		}
+		std::vector<uint8_t> started(process_count, 0);
+
+		const auto send = [&](int process_id, int64_t message){
+			inboxes[process_id]->push(message);
+			notify_process(scheduler, process_id);
+		};
+
+		const auto run_slice = [&](int process_id){
+			if(started[process_id] == 0){
+				started[process_id] = 1;
+				if(process_id < token_count){
+					send((process_id + 1) % process_count, 0);
+				}
+			}
+
+			std::vector<int64_t> batch;
+			inboxes[process_id]->pop_batch(batch, k_process_slice_message_count);
+			for(const auto hops: batch){
+				if(hops == -1){
+					return true;
+				}
+				else if(hops < hop_count){
+					send((process_id + 1) % process_count, hops + 1);
+				}
+				else{
+					for(int p = 0 ; p < process_count ; p++){
+						send(p, -1);
+					}
+				}
+			}
+			return false;
+		};
+
+		run_process_scheduler(scheduler, thread_count, run_slice, [&](int process_id){ return inboxes[process_id]->empty() == false; });
+	}
+	state.SetItemsProcessed(state.iterations() * hop_count);
+}
+BENCHMARK(BM_process_ring_messages)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
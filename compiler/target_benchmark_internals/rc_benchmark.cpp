@@ -0,0 +1,124 @@
+//
+//  rc_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-27.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "value_backend.h"
+#include "value_features.h"
+#include "value_thunking.h"
+
+#include <string>
+#include <vector>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+//	count strings, long enough to live on the heap.
+static std::vector<runtime_value_t> make_strings(value_backend_t& backend, int64_t count){
+	std::vector<runtime_value_t> result;
+	for(int64_t i = 0 ; i < count ; i++){
+		result.push_back(to_runtime_string2(backend, "element_" + std::to_string(i)));
+	}
+	return result;
+}
+
+
+
+////////////////////////////////		BENCHMARK -- retain + release, local vs shared
+
+
+//	Retains then releases every string, like copying a [string] and dropping the copy does.
+//	shared = true: the strings were handed to another thread, every RC change is an atomic instruction.
+static void run_retain_release(benchmark::State& state, bool shared){
+	const auto count = state.range(0);
+	auto backend = make_test_value_backend();
+	const auto string_type = type_t::make_string();
+
+	const auto strings = make_strings(backend, count);
+	if(shared){
+		for(const auto& e: strings){
+			share_value(backend, e, string_type);
+		}
+	}
+
+	for (auto _ : state) {
+		(void)_;
+
+		for(const auto& e: strings){
+			retain_value(backend, e, string_type);
+		}
+		for(const auto& e: strings){
+			release_value(backend, e, string_type);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+
+	for(const auto& e: strings){
+		release_value(backend, e, string_type);
+	}
+}
+
+static void BM_rc_retain_release_local(benchmark::State& state) {
+	run_retain_release(state, false);
+}
+BENCHMARK(BM_rc_retain_release_local)->Arg(64)->Arg(4096);
+
+static void BM_rc_retain_release_shared(benchmark::State& state) {
+	run_retain_release(state, true);
+}
+BENCHMARK(BM_rc_retain_release_shared)->Arg(64)->Arg(4096);
+
+
+
+////////////////////////////////		BENCHMARK -- b = a + a on a [string], local vs shared
+
+
+//	concat_vector_carray() copies the elements and retains each of them.
+static void run_concat(benchmark::State& state, bool shared){
+	const auto count = state.range(0);
+
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	auto config = make_default_config();
+	config.vector_backend_mode = vector_backend::carray;
+	value_backend_t backend({}, {}, types, config);
+
+	const auto strings = make_strings(backend, count);
+	auto a = alloc_vector_carray(backend.heap, count, count, vec_type);
+	for(int64_t i = 0 ; i < count ; i++){
+		a.vector_carray_ptr->store(i, strings[i]);
+	}
+	if(shared){
+		share_value(backend, a, vec_type);
+	}
+
+	for (auto _ : state) {
+		(void)_;
+
+		const auto b = concat_vector_carray(backend, vec_type, a, a);
+		benchmark::DoNotOptimize(b);
+		release_vec(backend, b, vec_type);
+	}
+	state.SetItemsProcessed(state.iterations() * count * 2);
+
+	release_vec(backend, a, vec_type);
+}
+
+static void BM_rc_concat_local(benchmark::State& state) {
+	run_concat(state, false);
+}
+BENCHMARK(BM_rc_concat_local)->Arg(64)->Arg(4096);
+
+static void BM_rc_concat_shared(benchmark::State& state) {
+	run_concat(state, true);
+}
+BENCHMARK(BM_rc_concat_shared)->Arg(64)->Arg(4096);
@@ -0,0 +1,147 @@
+//
+//  string_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-20.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "value_backend.h"
+#include "value_features.h"
+#include "value_thunking.h"
+
+#include <string>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+static std::string make_text(int64_t count){
+	std::string result;
+	while(result.size() < count){
+		result += "the quick brown fox jumps over the lazy dog ";
+	}
+	result.resize(count);
+	return result;
+}
+
+
+
+////////////////////////////////		BENCHMARK -- find(), subset(), replace() on runtime strings
+
+
+//	round_trip = true copies the strings into std::strings and back, like these functions did before.
+static void run_find(benchmark::State& state, bool round_trip){
+	const auto count = state.range(0);
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+
+	const auto s = to_runtime_string2(backend, make_text(count) + "needle!!");
+	const auto wanted = to_runtime_string2(backend, "needle!!");
+
+	for (auto _ : state) {
+		(void)_;
+
+		if(round_trip){
+			const auto pos = from_runtime_string2(backend, s).find(from_runtime_string2(backend, wanted));
+			benchmark::DoNotOptimize(pos);
+		}
+		else{
+			const auto pos = find__string(backend, s, itype, wanted, itype);
+			benchmark::DoNotOptimize(pos);
+		}
+	}
+	state.SetBytesProcessed(state.iterations() * count);
+
+	release_value(backend, wanted, type_t::make_string());
+	release_value(backend, s, type_t::make_string());
+}
+
+static void BM_string_find_round_trip(benchmark::State& state) {
+	run_find(state, true);
+}
+BENCHMARK(BM_string_find_round_trip)->Arg(64)->Arg(4096)->Arg(262144);
+
+static void BM_string_find(benchmark::State& state) {
+	run_find(state, false);
+}
+BENCHMARK(BM_string_find)->Arg(64)->Arg(4096)->Arg(262144);
+
+
+//	Takes the middle half of the string.
+static void run_subset(benchmark::State& state, bool round_trip){
+	const auto count = state.range(0);
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+
+	const auto s = to_runtime_string2(backend, make_text(count));
+
+	for (auto _ : state) {
+		(void)_;
+
+		const auto result = round_trip
+			? to_runtime_string2(backend, from_runtime_string2(backend, s).substr(count / 4, count / 2))
+			: subset__string(backend, s, itype, count / 4, count / 4 + count / 2);
+		benchmark::DoNotOptimize(result);
+		release_value(backend, result, type_t::make_string());
+	}
+	state.SetBytesProcessed(state.iterations() * count / 2);
+
+	release_value(backend, s, type_t::make_string());
+}
+
+static void BM_string_subset_round_trip(benchmark::State& state) {
+	run_subset(state, true);
+}
+BENCHMARK(BM_string_subset_round_trip)->Arg(64)->Arg(4096)->Arg(262144);
+
+static void BM_string_subset(benchmark::State& state) {
+	run_subset(state, false);
+}
+BENCHMARK(BM_string_subset)->Arg(64)->Arg(4096)->Arg(262144);
+
+
+//	Replaces a word in the middle of the string.
+static void run_replace(benchmark::State& state, bool round_trip){
+	const auto count = state.range(0);
+	auto backend = make_test_value_backend();
+	const auto itype = type_t::make_string().get_data();
+
+	const auto s = to_runtime_string2(backend, make_text(count));
+	const auto r = to_runtime_string2(backend, "replacement");
+
+	for (auto _ : state) {
+		(void)_;
+
+		runtime_value_t result;
+		if(round_trip){
+			auto temp = from_runtime_string2(backend, s);
+			temp.replace(count / 2, 5, from_runtime_string2(backend, r));
+			result = to_runtime_string2(backend, temp);
+		}
+		else{
+			result = replace__string(backend, s, itype, count / 2, count / 2 + 5, r, itype);
+		}
+		benchmark::DoNotOptimize(result);
+		release_value(backend, result, type_t::make_string());
+	}
+	state.SetBytesProcessed(state.iterations() * count);
+
+	release_value(backend, r, type_t::make_string());
+	release_value(backend, s, type_t::make_string());
+}
+
+static void BM_string_replace_round_trip(benchmark::State& state) {
+	run_replace(state, true);
+}
+BENCHMARK(BM_string_replace_round_trip)->Arg(64)->Arg(4096)->Arg(262144);
+
+static void BM_string_replace(benchmark::State& state) {
+	run_replace(state, false);
+}
+BENCHMARK(BM_string_replace)->Arg(64)->Arg(4096)->Arg(262144);
@@ -0,0 +1,84 @@
+//
+//  types_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-11-03.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "types.h"
+#include "compiler_helpers.h"
+#include "semantic_ast.h"
+
+#include <string>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+////////////////////////////////		BENCHMARK -- interning types
+
+
+//	Makes count different struct types and a vector and dict of each, then makes them all again.
+//	The second round only finds existing types.
+static void BM_types_intern_structs(benchmark::State& state) {
+	const auto count = state.range(0);
+
+	for (auto _ : state) {
+		(void)_;
+
+		types_t types;
+		for(int round = 0 ; round < 2 ; round++){
+			for(int64_t i = 0 ; i < count ; i++){
+				const auto s = make_struct(
+					types,
+					struct_type_desc_t({
+						member_t(type_t::make_int(), "a" + std::to_string(i)),
+						member_t(type_t::make_string(), "b")
+					})
+				);
+				make_vector(types, s);
+				make_dict(types, s);
+			}
+		}
+		benchmark::DoNotOptimize(types.nodes.size());
+	}
+	state.SetItemsProcessed(state.iterations() * count * 2);
+}
+BENCHMARK(BM_types_intern_structs)->Arg(256)->Arg(2048)->Arg(8192);
+
+
+
+////////////////////////////////		BENCHMARK -- semantic analysis of a program with many struct types
+
+
+//	Each struct gets a function that takes it and returns a vector of it. Semantic analysis copies its state,
+//	including types_t, for each expression so it grows quadratically with the program. Keep the programs small.
+static std::string make_struct_program(int64_t count){
+	std::string result;
+	for(int64_t i = 0 ; i < count ; i++){
+		const auto n = std::to_string(i);
+		result += "struct s" + n + "_t { int a; string b" + n + "; }\n";
+		result += "func [s" + n + "_t] f" + n + "(s" + n + "_t v){ return [v, v] }\n";
+	}
+	return result;
+}
+
+static void BM_types_compile_structs(benchmark::State& state) {
+	const auto count = state.range(0);
+	const auto cu = make_compilation_unit_nolib(make_struct_program(count), "");
+
+	for (auto _ : state) {
+		(void)_;
+
+		const auto sem_ast = compile_to_sematic_ast__errors(cu);
+		benchmark::DoNotOptimize(sem_ast._tree._types.nodes.size());
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_types_compile_structs)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,101 @@
+//
+//  vector_hamt_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-10-12.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "value_backend.h"
+#include "value_features.h"
+#include "value_thunking.h"
+
+#include <string>
+#include <vector>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+//	A [string] with count elements. Strings are RC values so every element copy costs a retain.
+static runtime_value_t make_string_vector(value_backend_t& backend, const type_t& vec_type, int64_t count){
+	std::vector<runtime_value_t> elements;
+	for(int64_t i = 0 ; i < count ; i++){
+		elements.push_back(to_runtime_string2(backend, "element_" + std::to_string(i)));
+	}
+	return alloc_vector_hamt(backend.heap, elements.data(), elements.size(), vec_type);
+}
+
+
+
+////////////////////////////////		BENCHMARK -- b = push_back(a, s), a is kept
+
+
+//	The cost per push_back() should stay the same for all sizes: only the tail node's elements are retained.
+static void BM_vector_hamt_push_back_shared(benchmark::State& state) {
+	const auto count = state.range(0);
+
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_default_config());
+
+	const auto a = make_string_vector(backend, vec_type, count);
+	const auto s = to_runtime_string2(backend, "new");
+
+	for (auto _ : state) {
+		(void)_;
+
+		runtime_value_t b;
+		{
+			hamt_element_scope_t scope(backend, vec_type);
+			retain_value(backend, s, scope.element_type);
+			b = push_back_immutable(a, s);
+		}
+		benchmark::DoNotOptimize(b);
+		release_vec(backend, b, vec_type);
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	release_value(backend, s, type_t::make_string());
+	release_vec(backend, a, vec_type);
+}
+BENCHMARK(BM_vector_hamt_push_back_shared)->Arg(1024)->Arg(65536);
+
+
+
+////////////////////////////////		BENCHMARK -- b = update(a, i, s), a is kept
+
+
+static void BM_vector_hamt_update_shared(benchmark::State& state) {
+	const auto count = state.range(0);
+
+	types_t types;
+	const auto vec_type = make_vector(types, type_t::make_string());
+	value_backend_t backend({}, {}, types, make_default_config());
+
+	const auto a = make_string_vector(backend, vec_type, count);
+	const auto s = to_runtime_string2(backend, "new");
+
+	int64_t index = 0;
+	for (auto _ : state) {
+		(void)_;
+
+		//	update__vector_hamt_nonpod() takes over one reference to a.
+		inc_rc(a.vector_hamt_ptr->alloc);
+		const auto b = update__vector_hamt_nonpod(backend, a, vec_type.get_data(), make_runtime_int(index), s);
+		benchmark::DoNotOptimize(b);
+		release_vec(backend, b, vec_type);
+
+		index = (index + 7919) % count;
+	}
+	state.SetItemsProcessed(state.iterations());
+
+	release_value(backend, s, type_t::make_string());
+	release_vec(backend, a, vec_type);
+}
+BENCHMARK(BM_vector_hamt_update_shared)->Arg(1024)->Arg(65536);
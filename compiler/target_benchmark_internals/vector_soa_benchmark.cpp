@@ -0,0 +1,178 @@
+//
+//  vector_soa_benchmark.cpp
+//  Floyd
+//
+//  Created by Marcus Zetterquist on 2019-11-05.
+//  Copyright © 2019 Marcus Zetterquist. All rights reserved.
+//
+
+#include "benchmark/benchmark.h"
+
+#include "value_backend.h"
+
+#include <vector>
+
+#include "quark.h"
+
+
+using namespace floyd;
+
+
+
+//	struct particle_t { double x; double y; double z; double mass; }
+struct particles_t {
+	particles_t(vector_backend mode) :
+		types(),
+		element_type(make_struct(types, struct_type_desc_t({
+			member_t(type_t::make_double(), "x"),
+			member_t(type_t::make_double(), "y"),
+			member_t(type_t::make_double(), "z"),
+			member_t(type_t::make_double(), "mass")
+		}))),
+		vec_type(make_vector(types, element_type)),
+		backend(
+			{},
+			{ { element_type, struct_layout_t{ {
+				member_info_t{ 0, type_t::make_double() },
+				member_info_t{ 8, type_t::make_double() },
+				member_info_t{ 16, type_t::make_double() },
+				member_info_t{ 24, type_t::make_double() }
+			}, 32 } } },
+			types,
+			make_config(mode)
+		)
+	{
+	}
+
+	static config_t make_config(vector_backend mode){
+		auto config = make_default_config();
+		config.vector_backend_mode = mode;
+		return config;
+	}
+
+	//	Vector of count particles: a carray of STRUCT_T:s or an soa vector, depending on the mode.
+	runtime_value_t make_vec(int64_t count){
+		std::vector<runtime_value_t> structs;
+		for(int64_t i = 0 ; i < count ; i++){
+			auto s = alloc_struct(backend.heap, 32, element_type);
+			for(int m = 0 ; m < 4 ; m++){
+				store_via_ptr2(backend.types, s->get_data_ptr() + m * 8, type_t::make_double(), make_runtime_double(double(i + m)));
+			}
+			structs.push_back(make_runtime_struct(s));
+		}
+
+		if(is_vector_soa(backend.types, backend.config, vec_type)){
+			const auto result = alloc_vector_soa(backend, structs.data(), count, vec_type);
+			for(const auto& e: structs){
+				release_value(backend, e, element_type);
+			}
+			return result;
+		}
+		else{
+			auto result = alloc_vector_carray(backend.heap, count, count, vec_type);
+			for(int64_t i = 0 ; i < count ; i++){
+				result.vector_carray_ptr->store(i, structs[i]);
+			}
+			return result;
+		}
+	}
+
+	types_t types;
+	type_t element_type;
+	type_t vec_type;
+	value_backend_t backend;
+};
+
+
+
+////////////////////////////////		BENCHMARK -- sum one member of every element
+
+
+//	Like reduce(particles, 0.0, func(acc, p){ return acc + p.x }): touches one member of each element.
+//	carray: follows one pointer per element and reads 8 bytes of its 64 + 32 byte allocation.
+//	soa: reads the x column front to back.
+static void BM_vector_sum_member__carray_structs(benchmark::State& state) {
+	const auto count = state.range(0);
+	particles_t p(vector_backend::carray);
+	const auto vec = p.make_vec(count);
+
+	for (auto _ : state) {
+		(void)_;
+
+		double sum = 0.0;
+		const auto elements = vec.vector_carray_ptr->get_element_ptr();
+		for(int64_t i = 0 ; i < count ; i++){
+			sum += load_via_ptr2(p.backend.types, elements[i].struct_ptr->get_data_ptr() + 0, type_t::make_double()).double_value;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	release_value(p.backend, vec, p.vec_type);
+}
+BENCHMARK(BM_vector_sum_member__carray_structs)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+static void BM_vector_sum_member__soa(benchmark::State& state) {
+	const auto count = state.range(0);
+	particles_t p(vector_backend::soa);
+	const auto vec = p.make_vec(count);
+
+	for (auto _ : state) {
+		(void)_;
+
+		double sum = 0.0;
+		const auto column = vec.vector_soa_ptr->get_column_ptr(0);
+		for(int64_t i = 0 ; i < count ; i++){
+			sum += column[i].double_value;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	release_value(p.backend, vec, p.vec_type);
+}
+BENCHMARK(BM_vector_sum_member__soa)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+
+
+////////////////////////////////		BENCHMARK -- load whole elements
+
+
+//	What map() / filter() / reduce() pay when the callback gets the whole element: soa has to make a STRUCT_T
+//	per element, carray only retains and releases the existing one.
+static void BM_vector_load_element__carray_structs(benchmark::State& state) {
+	const auto count = state.range(0);
+	particles_t p(vector_backend::carray);
+	const auto vec = p.make_vec(count);
+
+	for (auto _ : state) {
+		(void)_;
+
+		const auto elements = vec.vector_carray_ptr->get_element_ptr();
+		for(int64_t i = 0 ; i < count ; i++){
+			retain_value(p.backend, elements[i], p.element_type);
+			benchmark::DoNotOptimize(elements[i].struct_ptr);
+			release_value(p.backend, elements[i], p.element_type);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	release_value(p.backend, vec, p.vec_type);
+}
+BENCHMARK(BM_vector_load_element__carray_structs)->Arg(1000)->Arg(100000);
+
+static void BM_vector_load_element__soa(benchmark::State& state) {
+	const auto count = state.range(0);
+	particles_t p(vector_backend::soa);
+	const auto vec = p.make_vec(count);
+
+	for (auto _ : state) {
+		(void)_;
+
+		for(int64_t i = 0 ; i < count ; i++){
+			const auto e = load_vector_soa_element(p.backend, vec, p.vec_type, i);
+			benchmark::DoNotOptimize(e.struct_ptr);
+			release_value(p.backend, e, p.element_type);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	release_value(p.backend, vec, p.vec_type);
+}
+BENCHMARK(BM_vector_load_element__soa)->Arg(1000)->Arg(100000);
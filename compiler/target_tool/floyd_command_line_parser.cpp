@@ -69,8 +69,11 @@ FLAGS
 | -l       | floyd bench returns a list of all benchmarks
 | -vcarray | Force vectors to use carray backend
 | -vhamt   | Force vectors to use HAMT backend (this is default)
+| -vsoa    | Like -vcarray, but vectors of structs without strings, vectors, dicts or json store each member in its own array
 | -dcppmap | Force dictionaries to use c++ map as backend
 | -dhamt   | Force dictionaries to use HAMT backend (this is default)
+| -dhash   | Force dictionaries to use open addressing hash table as backend
+| -j4      | Use 4 threads for map(), filter(), map_dag(), stable_sort() and processes. Default is one per logical processor
 
 MORE EXAMPLES
 
@@ -230,7 +233,7 @@ eoutput_type get_output_type(const command_line_args_t& args){
 }
 
 
-const std::string k_flags = "tlpaiogO:v:d:";
+const std::string k_flags = "tlpaiogO:v:d:j:";
 
 
 struct compile_more_t {
@@ -273,6 +276,9 @@ static vector_backend get_vector_backend(const std::map<std::string, flag_info_t
 		else if(it->second == flag_info_t { flag_info_t::etype::flag_with_parameter, "carray"} ){
 			return vector_backend::carray;
 		}
+		else if(it->second == flag_info_t { flag_info_t::etype::flag_with_parameter, "soa"} ){
+			return vector_backend::soa;
+		}
 		else{
 			throw std::exception();
 		}
@@ -290,6 +296,9 @@ static dict_backend get_dict_backend(const std::map<std::string, flag_info_t>& f
 		else if(it->second == flag_info_t { flag_info_t::etype::flag_with_parameter, "cppmap"} ){
 			return dict_backend::cppmap;
 		}
+		else if(it->second == flag_info_t { flag_info_t::etype::flag_with_parameter, "hash"} ){
+			return dict_backend::hash;
+		}
 		else{
 			throw std::exception();
 		}
@@ -299,12 +308,31 @@ static dict_backend get_dict_backend(const std::map<std::string, flag_info_t>& f
 	}
 }
 
+static int64_t get_thread_count(const std::map<std::string, flag_info_t>& flags){
+	const auto it = flags.find("j");
+	if(it != flags.end()){
+		const auto& s = it->second.parameter;
+		if(s.empty() || s.find_first_not_of("0123456789") != std::string::npos){
+			throw std::exception();
+		}
+		const auto count = std::stoll(s);
+		if(count < 1){
+			throw std::exception();
+		}
+		return count;
+	}
+	else{
+		return 0;
+	}
+}
+
 static compiler_settings_t get_compiler_settings(const std::map<std::string, flag_info_t>& flags){
 	const auto optimization_level = get_optimization_level(flags);
 	const auto vector_backend = get_vector_backend(flags);
 	const auto dict_backend = get_dict_backend(flags);
+	const auto thread_count = get_thread_count(flags);
 
-	return compiler_settings_t { { vector_backend, dict_backend, false }, optimization_level }; 
+	return compiler_settings_t { { vector_backend, dict_backend, false, heap_backend::pool, thread_count }, optimization_level }; 
 }
 
 compile_more_t parse_floyd_compile_command_more(const command_line_args_t& command_line_args){
@@ -641,6 +669,27 @@ QUARK_TEST("", "parse_floyd_command_line()", "floyd compile", ""){
 	QUARK_VERIFY(r2.trace == false);
 }
 
+QUARK_TEST("", "parse_floyd_command_line()", "floyd compile -vsoa", ""){
+	const auto r = parse_floyd_command_line(string_to_args("floyd compile -vsoa mygame.floyd"));
+	const auto& r2 = std::get<command_t::compile_t>(r._contents);
+	QUARK_VERIFY(r2.source_paths == std::vector<std::string>{ "mygame.floyd" });
+	QUARK_VERIFY(r2.compiler_settings == (compiler_settings_t { config_t{ vector_backend::soa, dict_backend::hamt, false }, eoptimization_level::O2_enable_default_optimizations }));
+}
+
+QUARK_TEST("", "parse_floyd_command_line()", "floyd compile -dhash", ""){
+	const auto r = parse_floyd_command_line(string_to_args("floyd compile -dhash mygame.floyd"));
+	const auto& r2 = std::get<command_t::compile_t>(r._contents);
+	QUARK_VERIFY(r2.source_paths == std::vector<std::string>{ "mygame.floyd" });
+	QUARK_VERIFY(r2.compiler_settings == (compiler_settings_t { config_t{ vector_backend::hamt, dict_backend::hash, false }, eoptimization_level::O2_enable_default_optimizations }));
+}
+
+QUARK_TEST("", "parse_floyd_command_line()", "floyd compile -j4", ""){
+	const auto r = parse_floyd_command_line(string_to_args("floyd compile -j4 mygame.floyd"));
+	const auto& r2 = std::get<command_t::compile_t>(r._contents);
+	QUARK_VERIFY(r2.source_paths == std::vector<std::string>{ "mygame.floyd" });
+	QUARK_VERIFY(r2.compiler_settings == (compiler_settings_t { config_t{ vector_backend::hamt, dict_backend::hamt, false, heap_backend::pool, 4 }, eoptimization_level::O2_enable_default_optimizations }));
+}
+
 
 
 
@@ -288,7 +288,7 @@ static int do_run(const command_t& command, const command_t::compile_and_run_t&
 		const auto cu = floyd::make_compilation_unit_lib(source, command2.source_path);
 		auto program = floyd::compile_to_bytecode(cu);
 		auto interpreter = floyd::interpreter_t(program);
-		const auto result = floyd::run_program_bc(interpreter, command2.floyd_main_args);
+		const auto result = floyd::run_program_bc(interpreter, command2.floyd_main_args, command2.compiler_settings.config);
 		if(result.process_results.size() == 0){
 			return static_cast<int>(result.main_result);
 		}
@@ -729,7 +729,7 @@ json_t handle_server_request(const json_t& request) {
 				auto program = floyd::compile_to_bytecode(cu);
 				auto interpreter = floyd::interpreter_t(program);
 
-				const auto result = floyd::run_program_bc(interpreter, {});
+				const auto result = floyd::run_program_bc(interpreter, {}, floyd::make_default_config());
 				if(result.process_results.size() == 0){
 					const auto output_value = static_cast<int>(result.main_result);
 					return json_t::make_object({{ "output", json_t(output_value) }});